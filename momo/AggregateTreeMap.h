@@ -0,0 +1,662 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/AggregateTreeMap.h
+
+  namespace momo:
+    class AggregateTreeMonoid
+    class AggregateTreeMapSettings
+    class AggregateTreeMap
+
+  `AggregateTreeMap` is a B+ tree, in which internal nodes keep
+  an aggregated value of each child subtree. Aggregates are computed
+  by user-supplied monoid (`GetIdentity`, `GetAggregate`, `Combine`)
+  and are updated along the path on insertion and removal.
+  Function `GetAggregate(lowKey, highKey)` returns the aggregate
+  over the key range [lowKey, highKey) in O(log n) time.
+
+  Monoid functions and copying of `Aggregate` must not throw exceptions.
+  Values are accessible only for reading, use `InsertOrAssign` to
+  change them.
+
+\**********************************************************/
+
+#pragma once
+
+#include "TreeTraits.h"
+#include "details/TreeCore.h"
+#include "SetUtility.h"
+
+namespace momo
+{
+
+namespace internal
+{
+	template<typename TMemManager, typename TMemPoolParams>
+	class AggregateTreeNodeParams
+	{
+	public:
+		typedef TMemManager MemManager;
+		typedef TMemPoolParams MemPoolParams;
+
+	private:
+		typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+
+		typedef momo::MemPool<MemPoolParams, MemManagerPtr, NestedMemPoolSettings> MemPool;
+
+	public:
+		explicit AggregateTreeNodeParams(MemManager& memManager, size_t leafNodeSize,
+			size_t internalNodeSize)
+			: mLeafMemPool(MemPoolParams(leafNodeSize), MemManagerPtr(memManager)),
+			mInternalMemPool(MemPoolParams(internalNodeSize), MemManagerPtr(memManager))
+		{
+		}
+
+		AggregateTreeNodeParams(const AggregateTreeNodeParams&) = delete;
+
+		~AggregateTreeNodeParams() noexcept
+		{
+		}
+
+		AggregateTreeNodeParams& operator=(const AggregateTreeNodeParams&) = delete;
+
+		void* Allocate(bool isLeaf)
+		{
+			return pvGetMemPool(isLeaf).Allocate();
+		}
+
+		void Deallocate(void* ptr, bool isLeaf) noexcept
+		{
+			pvGetMemPool(isLeaf).Deallocate(ptr);
+		}
+
+	private:
+		MemPool& pvGetMemPool(bool isLeaf) noexcept
+		{
+			return isLeaf ? mLeafMemPool : mInternalMemPool;
+		}
+
+	private:
+		MemPool mLeafMemPool;
+		MemPool mInternalMemPool;
+	};
+}
+
+template<typename TValue,
+	typename TCombineFunc = std::plus<TValue>>
+class AggregateTreeMonoid
+{
+public:
+	typedef TValue Value;
+	typedef TCombineFunc CombineFunc;
+
+	typedef Value Aggregate;
+
+public:
+	explicit AggregateTreeMonoid(const Value& identity = Value(),
+		const CombineFunc& combineFunc = CombineFunc())
+		: mIdentity(identity),
+		mCombineFunc(combineFunc)
+	{
+	}
+
+	const Aggregate& GetIdentity() const noexcept
+	{
+		return mIdentity;
+	}
+
+	template<typename Key>
+	const Aggregate& GetAggregate(const Key& /*key*/, const Value& value) const noexcept
+	{
+		return value;
+	}
+
+	Aggregate Combine(const Aggregate& aggregate1, const Aggregate& aggregate2) const
+	{
+		return mCombineFunc(aggregate1, aggregate2);
+	}
+
+private:
+	Value mIdentity;
+	CombineFunc mCombineFunc;
+};
+
+class AggregateTreeMapSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+	static const ExtraCheckMode extraCheckMode = ExtraCheckMode::bydefault;
+};
+
+template<typename TKey, typename TValue,
+	typename TMonoid = AggregateTreeMonoid<TValue>,
+	typename TTreeTraits = TreeTraits<TKey>,
+	typename TMemManager = MemManagerDefault,
+	typename TSettings = AggregateTreeMapSettings>
+class AggregateTreeMap
+{
+public:
+	typedef TKey Key;
+	typedef TValue Value;
+	typedef TMonoid Monoid;
+	typedef TTreeTraits TreeTraits;
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+	typedef typename Monoid::Aggregate Aggregate;
+
+	MOMO_STATIC_ASSERT(!TreeTraits::multiKey);
+
+private:
+	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	typedef internal::SetCrew<TreeTraits, MemManager, false> Crew;
+
+	MOMO_STATIC_ASSERT(std::is_nothrow_move_constructible<Monoid>::value);
+
+	typedef typename TreeTraits::TreeNode TreeNode;
+
+	static const size_t nodeCapacity = TreeNode::maxCapacity;
+
+	typedef internal::TreeCoreNode<Key, nodeCapacity, internal::TreeCoreEmptyHeader> Node;
+	typedef internal::TreeCoreLeafNode<Node, Value> LeafNode;
+	typedef internal::TreeCoreInternalNode<Node, Aggregate> InternalNode;
+
+	typedef internal::TreeCore<LeafNode, InternalNode, TreeTraits, MemManager> TreeCore;
+
+	typedef internal::AggregateTreeNodeParams<MemManager,
+		typename TreeNode::MemPoolParams> NodeParams;
+
+public:
+	AggregateTreeMap()
+		: AggregateTreeMap(Monoid())
+	{
+	}
+
+	explicit AggregateTreeMap(const Monoid& monoid, const TreeTraits& treeTraits = TreeTraits(),
+		MemManager&& memManager = MemManager())
+		: mCrew(treeTraits, std::move(memManager)),
+		mMonoid(monoid),
+		mNodeParams(nullptr),
+		mRootNode(nullptr),
+		mCount(0)
+	{
+	}
+
+	AggregateTreeMap(AggregateTreeMap&& treeMap) noexcept
+		: mCrew(std::move(treeMap.mCrew)),
+		mMonoid(std::move(treeMap.mMonoid)),
+		mNodeParams(treeMap.mNodeParams),
+		mRootNode(treeMap.mRootNode),
+		mCount(treeMap.mCount)
+	{
+		treeMap.mNodeParams = nullptr;
+		treeMap.mRootNode = nullptr;
+		treeMap.mCount = 0;
+	}
+
+	AggregateTreeMap(const AggregateTreeMap& treeMap)
+		: AggregateTreeMap(treeMap.mMonoid, treeMap.GetTreeTraits(),
+			MemManager(treeMap.GetMemManager()))
+	{
+		if (treeMap.mRootNode == nullptr)
+			return;
+		pvCreateNodeParams();
+		mRootNode = pvCopy(treeMap.mRootNode);
+		mCount = treeMap.mCount;
+	}
+
+	~AggregateTreeMap() noexcept
+	{
+		pvDestroy();
+	}
+
+	AggregateTreeMap& operator=(AggregateTreeMap&& treeMap) noexcept
+	{
+		AggregateTreeMap(std::move(treeMap)).Swap(*this);
+		return *this;
+	}
+
+	AggregateTreeMap& operator=(const AggregateTreeMap& treeMap)
+	{
+		if (this != &treeMap)
+			AggregateTreeMap(treeMap).Swap(*this);
+		return *this;
+	}
+
+	void Swap(AggregateTreeMap& treeMap) noexcept
+	{
+		mCrew.Swap(treeMap.mCrew);
+		std::swap(mMonoid, treeMap.mMonoid);
+		std::swap(mNodeParams, treeMap.mNodeParams);
+		std::swap(mRootNode, treeMap.mRootNode);
+		std::swap(mCount, treeMap.mCount);
+	}
+
+	MOMO_FRIEND_SWAP(AggregateTreeMap)
+
+	const TreeTraits& GetTreeTraits() const noexcept
+	{
+		return mCrew.GetContainerTraits();
+	}
+
+	const Monoid& GetMonoid() const noexcept
+	{
+		return mMonoid;
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mCrew.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mCrew.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mCount;
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return mCount == 0;
+	}
+
+	void Clear() noexcept
+	{
+		if (mRootNode != nullptr)
+			pvDestroy(mRootNode);
+		mRootNode = nullptr;
+		mCount = 0;
+	}
+
+	const Value* Find(const Key& key) const
+	{
+		return TreeCore::Find(GetTreeTraits(), mRootNode, key);
+	}
+
+	bool ContainsKey(const Key& key) const
+	{
+		return Find(key) != nullptr;
+	}
+
+	bool Insert(const Key& key, const Value& value)
+	{
+		return pvInsert<false>(key, value);
+	}
+
+	bool InsertOrAssign(const Key& key, const Value& value)
+	{
+		return pvInsert<true>(key, value);
+	}
+
+	bool Remove(const Key& key)
+	{
+		if (mRootNode == nullptr || !pvRemove(mRootNode, key))
+			return false;
+		if (mRootNode->GetCount() == 0)
+		{
+			Node* rootNode = mRootNode;
+			mRootNode = rootNode->IsLeaf() ? nullptr
+				: static_cast<InternalNode*>(rootNode)->GetChild(0);
+			pvFreeNode(rootNode);
+		}
+		--mCount;
+		return true;
+	}
+
+	Aggregate GetAggregate() const
+	{
+		if (mRootNode == nullptr)
+			return mMonoid.GetIdentity();
+		return pvGetAggregate(mRootNode);
+	}
+
+	// aggregate over keys from the range [lowKey, highKey)
+	Aggregate GetAggregate(const Key& lowKey, const Key& highKey) const
+	{
+		if (mRootNode == nullptr || !pvIsLess(lowKey, highKey))
+			return mMonoid.GetIdentity();
+		return pvGetAggregate(mRootNode, std::addressof(lowKey), std::addressof(highKey));
+	}
+
+	// pairVisitor(const Key&, const Value&) returns `false` to stop the scan
+	template<typename PairVisitor>
+	void Scan(const PairVisitor& pairVisitor) const
+	{
+		if (mRootNode != nullptr)
+			TreeCore::Scan(GetTreeTraits(), mRootNode, nullptr, pairVisitor);
+	}
+
+	template<typename PairVisitor>
+	void Scan(const Key& lowKey, const PairVisitor& pairVisitor) const
+	{
+		if (mRootNode != nullptr)
+			TreeCore::Scan(GetTreeTraits(), mRootNode, std::addressof(lowKey), pairVisitor);
+	}
+
+private:
+	void pvCreateNodeParams()
+	{
+		if (mNodeParams != nullptr)
+			return;
+		MemManager& memManager = GetMemManager();
+		mNodeParams = MemManagerProxy::template Allocate<NodeParams>(memManager,
+			sizeof(NodeParams));
+		try
+		{
+			::new(static_cast<void*>(mNodeParams)) NodeParams(memManager,
+				sizeof(LeafNode), sizeof(InternalNode));
+		}
+		catch (...)
+		{
+			MemManagerProxy::Deallocate(memManager, mNodeParams, sizeof(NodeParams));
+			mNodeParams = nullptr;
+			throw;
+		}
+	}
+
+	void pvDestroy() noexcept
+	{
+		Clear();
+		if (mNodeParams != nullptr)
+		{
+			mNodeParams->~NodeParams();
+			MemManagerProxy::Deallocate(GetMemManager(), mNodeParams, sizeof(NodeParams));
+			mNodeParams = nullptr;
+		}
+	}
+
+	template<typename KeyArg1, typename KeyArg2>
+	bool pvIsLess(const KeyArg1& key1, const KeyArg2& key2) const
+	{
+		return GetTreeTraits().IsLess(key1, key2);
+	}
+
+	size_t pvGetLowerBound(const Node* node, const Key& key) const
+	{
+		return TreeCore::GetLowerBound(GetTreeTraits(), node, key);
+	}
+
+	size_t pvGetUpperBound(const Node* node, const Key& key) const
+	{
+		return TreeCore::GetUpperBound(GetTreeTraits(), node, key);
+	}
+
+	Node* pvCreateNode(bool isLeaf)
+	{
+		pvCreateNodeParams();
+		void* ptr = mNodeParams->Allocate(isLeaf);
+		if (isLeaf)
+			return ::new(ptr) LeafNode();
+		try
+		{
+			return ::new(ptr) InternalNode();
+		}
+		catch (...)
+		{
+			mNodeParams->Deallocate(ptr, false);
+			throw;
+		}
+	}
+
+	void pvFreeNode(Node* node) noexcept
+	{
+		bool isLeaf = node->IsLeaf();
+		if (isLeaf)
+			static_cast<LeafNode*>(node)->~LeafNode();
+		else
+			static_cast<InternalNode*>(node)->~InternalNode();
+		mNodeParams->Deallocate(node, isLeaf);
+	}
+
+	void pvDestroy(Node* node) noexcept
+	{
+		TreeCore::DestroyItems(GetMemManager(), node);
+		if (!node->IsLeaf())
+		{
+			InternalNode* internalNode = static_cast<InternalNode*>(node);
+			size_t count = node->GetCount();
+			for (size_t i = 0; i <= count; ++i)
+				pvDestroy(internalNode->GetChild(i));
+		}
+		pvFreeNode(node);
+	}
+
+	Node* pvCopy(const Node* node)
+	{
+		MemManager& memManager = GetMemManager();
+		Node* newNode = pvCreateNode(node->IsLeaf());
+		try
+		{
+			TreeCore::CopyItems(memManager, node, newNode);
+		}
+		catch (...)
+		{
+			pvFreeNode(newNode);
+			throw;
+		}
+		if (node->IsLeaf())
+			return newNode;
+		const InternalNode* internalNode = static_cast<const InternalNode*>(node);
+		InternalNode* newInternalNode = static_cast<InternalNode*>(newNode);
+		size_t count = node->GetCount();
+		size_t childIndex = 0;
+		try
+		{
+			for (; childIndex <= count; ++childIndex)
+			{
+				newInternalNode->SetChild(childIndex, pvCopy(internalNode->GetChild(childIndex)));
+				newInternalNode->SetChildData(childIndex, internalNode->GetChildData(childIndex));
+			}
+		}
+		catch (...)
+		{
+			for (size_t i = 0; i < childIndex; ++i)
+				pvDestroy(newInternalNode->GetChild(i));
+			TreeCore::DestroyItems(memManager, newNode);
+			pvFreeNode(newNode);
+			throw;
+		}
+		return newNode;
+	}
+
+	Aggregate pvGetAggregate(const Node* node) const noexcept
+	{
+		size_t count = node->GetCount();
+		Aggregate aggregate = mMonoid.GetIdentity();
+		if (node->IsLeaf())
+		{
+			const LeafNode* leafNode = static_cast<const LeafNode*>(node);
+			for (size_t i = 0; i < count; ++i)
+			{
+				aggregate = mMonoid.Combine(aggregate,
+					mMonoid.GetAggregate(*leafNode->GetKeyPtr(i), *leafNode->GetValuePtr(i)));
+			}
+		}
+		else
+		{
+			const InternalNode* internalNode = static_cast<const InternalNode*>(node);
+			for (size_t i = 0; i <= count; ++i)
+				aggregate = mMonoid.Combine(aggregate, internalNode->GetChildData(i));
+		}
+		return aggregate;
+	}
+
+	Aggregate pvGetAggregate(const Node* node, const Key* lowKey, const Key* highKey) const
+	{
+		size_t count = node->GetCount();
+		if (node->IsLeaf())
+		{
+			const LeafNode* leafNode = static_cast<const LeafNode*>(node);
+			size_t beginIndex = (lowKey != nullptr) ? pvGetLowerBound(leafNode, *lowKey) : 0;
+			size_t endIndex = (highKey != nullptr) ? pvGetLowerBound(leafNode, *highKey) : count;
+			Aggregate aggregate = mMonoid.GetIdentity();
+			for (size_t i = beginIndex; i < endIndex; ++i)
+			{
+				aggregate = mMonoid.Combine(aggregate,
+					mMonoid.GetAggregate(*leafNode->GetKeyPtr(i), *leafNode->GetValuePtr(i)));
+			}
+			return aggregate;
+		}
+		const InternalNode* internalNode = static_cast<const InternalNode*>(node);
+		size_t beginIndex = (lowKey != nullptr) ? pvGetUpperBound(internalNode, *lowKey) : 0;
+		size_t endIndex = (highKey != nullptr) ? pvGetUpperBound(internalNode, *highKey) : count;
+		if (beginIndex == endIndex)
+			return pvGetAggregate(internalNode->GetChild(beginIndex), lowKey, highKey);
+		Aggregate aggregate = (lowKey != nullptr)
+			? pvGetAggregate(internalNode->GetChild(beginIndex), lowKey, nullptr)
+			: internalNode->GetChildData(beginIndex);
+		for (size_t i = beginIndex + 1; i < endIndex; ++i)
+			aggregate = mMonoid.Combine(aggregate, internalNode->GetChildData(i));
+		if (highKey != nullptr)
+		{
+			aggregate = mMonoid.Combine(aggregate,
+				pvGetAggregate(internalNode->GetChild(endIndex), nullptr, highKey));
+		}
+		else
+		{
+			aggregate = mMonoid.Combine(aggregate, internalNode->GetChildData(endIndex));
+		}
+		return aggregate;
+	}
+
+	void pvUpdateAggregate(InternalNode* node, size_t index) noexcept
+	{
+		node->SetChildData(index, pvGetAggregate(node->GetChild(index)));
+	}
+
+	template<bool assign>
+	bool pvInsert(const Key& key, const Value& value)
+	{
+		if (mRootNode == nullptr)
+			mRootNode = pvCreateNode(true);
+		if (mRootNode->GetCount() == nodeCapacity)
+		{
+			InternalNode* newRootNode = static_cast<InternalNode*>(pvCreateNode(false));
+			newRootNode->SetChild(0, mRootNode);
+			try
+			{
+				pvSplitChild(newRootNode, 0);
+			}
+			catch (...)
+			{
+				pvFreeNode(newRootNode);
+				throw;
+			}
+			mRootNode = newRootNode;
+		}
+		if (!pvInsert<assign>(mRootNode, key, value))
+			return false;
+		++mCount;
+		return true;
+	}
+
+	template<bool assign>
+	bool pvInsert(Node* node, const Key& key, const Value& value)
+	{
+		if (node->IsLeaf())
+			return pvInsert<assign>(static_cast<LeafNode*>(node), key, value);
+		InternalNode* internalNode = static_cast<InternalNode*>(node);
+		size_t index = pvGetUpperBound(internalNode, key);
+		if (internalNode->GetChild(index)->GetCount() == nodeCapacity)
+		{
+			pvSplitChild(internalNode, index);
+			if (!pvIsLess(key, *internalNode->GetKeyPtr(index)))
+				++index;
+		}
+		bool res;
+		try
+		{
+			res = pvInsert<assign>(internalNode->GetChild(index), key, value);
+		}
+		catch (...)
+		{
+			pvUpdateAggregate(internalNode, index);	// assignment may change the value partially
+			throw;
+		}
+		pvUpdateAggregate(internalNode, index);
+		return res;
+	}
+
+	template<bool assign>
+	bool pvInsert(LeafNode* leafNode, const Key& key, const Value& value)
+	{
+		size_t index;
+		if (TreeCore::FindItem(GetTreeTraits(), leafNode, key, index))
+		{
+			if (assign)
+				*leafNode->GetValuePtr(index) = value;
+			return false;
+		}
+		TreeCore::InsertItem(GetMemManager(), leafNode, index, key, value);
+		return true;
+	}
+
+	void pvSplitChild(InternalNode* node, size_t index)
+	{
+		Node* newNode = pvCreateNode(node->GetChild(index)->IsLeaf());
+		try
+		{
+			TreeCore::SplitChild(GetMemManager(), node, index, newNode);
+		}
+		catch (...)
+		{
+			pvFreeNode(newNode);
+			throw;
+		}
+		pvUpdateAggregate(node, index);
+		pvUpdateAggregate(node, index + 1);
+	}
+
+	bool pvRemove(Node* node, const Key& key)
+	{
+		if (node->IsLeaf())
+		{
+			LeafNode* leafNode = static_cast<LeafNode*>(node);
+			size_t index;
+			if (!TreeCore::FindItem(GetTreeTraits(), leafNode, key, index))
+				return false;
+			TreeCore::RemoveItem(GetMemManager(), leafNode, index);
+			return true;
+		}
+		InternalNode* internalNode = static_cast<InternalNode*>(node);
+		size_t index = pvGetUpperBound(internalNode, key);
+		if (!pvRemove(internalNode->GetChild(index), key))
+			return false;
+		pvUpdateAggregate(internalNode, index);
+		if (internalNode->GetChild(index)->GetCount() < TreeCore::minCount)
+		{
+			if (!(index > 0 && pvMergeChildren(internalNode, index - 1))
+				&& index < internalNode->GetCount())
+			{
+				pvMergeChildren(internalNode, index);
+			}
+		}
+		return true;
+	}
+
+	bool pvMergeChildren(InternalNode* node, size_t index) noexcept
+	{
+		Node* freeNode = TreeCore::MergeChildren(GetMemManager(), node, index);
+		if (freeNode == nullptr)
+			return false;
+		pvFreeNode(freeNode);
+		pvUpdateAggregate(node, index);
+		return true;
+	}
+
+private:
+	Crew mCrew;
+	Monoid mMonoid;
+	NodeParams* mNodeParams;
+	Node* mRootNode;
+	size_t mCount;
+};
+
+} // namespace momo
@@ -15,11 +15,17 @@
 
   All `Array` functions and constructors have strong exception safety,
   but not the following cases:
-  1. Functions `Insert`, `InsertVar`, `InsertCrt`, `Remove` have
-    basic exception safety.
+  1. Functions `Insert`, `InsertVar`, `InsertCrt`, `Remove`, `RemoveIf`,
+    `InsertSorted`, `ApplyEdits` have basic exception safety.
   2. If any constructor throws exception, input argument `memManager`
     may be changed.
 
+  Functions `RemoveIf`, `InsertSorted` and `ApplyEdits` remove and insert
+  many items at arbitrary positions in one pass. Nothrow relocatable items
+  are moved at most twice (whole runs via `memmove` if they are trivially
+  relocatable). Other items are inserted by a backward merge, which
+  move-constructs the new tail and move-assigns the rest.
+
 \**********************************************************/
 
 #pragma once
@@ -272,6 +278,16 @@ private:
 				internal::BoolConstant<MemManagerProxy::canReallocateInplace>());
 		}
 
+		bool SetCapacityInplace(size_t capacity) noexcept
+		{
+			if (GetCapacity() == internalCapacity || capacity <= internalCapacity)
+				return false;
+			if (capacity > SIZE_MAX / sizeof(Item))
+				return false;
+			return pvSetCapacity(capacity, std::false_type(),
+				internal::BoolConstant<MemManagerProxy::canReallocateInplace>());
+		}
+
 		size_t GetCount() const noexcept
 		{
 			return mCount;
@@ -388,6 +404,11 @@ private:
 		bool pvSetCapacity(size_t capacity, std::true_type /*canReallocate*/,
 			internal::BoolConstant<canReallocateInplace>)
 		{
+			if (pvSetCapacity(capacity, std::false_type(),
+				internal::BoolConstant<canReallocateInplace>()))
+			{
+				return true;
+			}
 			mItems = MemManagerProxy::template Reallocate<Item>(GetMemManager(),
 				mItems, mCapacity * sizeof(Item), capacity * sizeof(Item));
 			mCapacity = capacity;
@@ -449,6 +470,12 @@ private:
 	typedef internal::ArrayShifter<Array> ArrayShifter;
 	typedef typename internal::ArrayIteratorSelector<Array> IteratorSelector;
 
+	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+
+	typedef Array<size_t, MemManagerPtr> Positions;
+
 	typedef internal::UIntMath<> SMath;
 
 public:
@@ -612,7 +639,8 @@ public:
 		{
 			pvRemoveBack(initCount - newCount);
 		}
-		else if (newCount <= initCapacity)
+		else if (newCount <= initCapacity || mData.SetCapacityInplace(
+			pvGrowCapacity(initCapacity, newCount, ArrayGrowCause::reserve, true)))
 		{
 			Item* items = GetItems();
 			size_t index = initCount;
@@ -884,6 +912,132 @@ public:
 		ArrayShifter::Remove(*this, index, count);
 	}
 
+	template<typename Predicate>
+	size_t RemoveIf(const Predicate& pred)
+	{
+		const Item* items = GetItems();
+		auto indexPred = [&pred, items] (size_t index) { return pred(items[index]); };
+		return pvRemove(indexPred, internal::BoolConstant<ItemTraits::isNothrowRelocatable>());
+	}
+
+	// The array must be sorted by `lessFunc`. Inserted items follow the equal ones.
+	template<typename ArgIterator,
+		typename LessFunc = std::less<Item>,
+		typename = typename std::iterator_traits<ArgIterator>::iterator_category>
+	void InsertSorted(ArgIterator begin, ArgIterator end, const LessFunc& lessFunc = LessFunc())
+	{
+		MOMO_ASSERT(begin == end || !pvIsInside(*begin));	//?
+		size_t initCount = GetCount();
+		try
+		{
+			if (internal::IsForwardIterator<ArgIterator>::value)
+			{
+				size_t newCount = initCount + SMath::Dist(begin, end);
+				if (newCount > GetCapacity())
+					pvGrow(newCount, ArrayGrowCause::add);
+			}
+			pvFill(begin, end);
+			Item* items = GetItems();
+			std::sort(items + initCount, items + GetCount(), lessFunc);
+		}
+		catch (...)
+		{
+			pvRemoveBack(GetCount() - initCount);
+			throw;
+		}
+		InsertSorted(GetCount() - initCount, lessFunc);
+	}
+
+	// The array must be sorted by `lessFunc` except for the last `backCount` items,
+	// which must be sorted by `lessFunc` separately. These items are moved to their
+	// places after the equal ones. If an exception is thrown before any item
+	// is moved, the last `backCount` items are removed.
+	template<typename LessFunc = std::less<Item>>
+	void InsertSorted(size_t backCount, const LessFunc& lessFunc = LessFunc())
+	{
+		MOMO_CHECK(backCount <= GetCount());
+		Positions positions((MemManagerPtr(GetMemManager())));
+		try
+		{
+			positions.Reserve(backCount);
+			const Item* items = GetItems();
+			size_t count = GetCount();
+			size_t initCount = count - backCount;
+			const Item* position = items;
+			for (size_t i = initCount; i < count; ++i)
+			{
+				position = std::upper_bound(position, items + initCount, items[i], lessFunc);
+				positions.AddBackNogrow(SMath::Dist(items, position));
+			}
+		}
+		catch (...)
+		{
+			pvRemoveBack(backCount);
+			throw;
+		}
+		pvInsertBack(positions, internal::BoolConstant<ItemTraits::isNothrowRelocatable>());
+	}
+
+	// Removes the items with indexes from the strictly ascending range
+	// [`removeBegin`, `removeEnd`) and inserts the items from the range
+	// [`insertBegin`, `insertEnd`) of pairs (`index`, `item`), ordered by `index`.
+	// Each `item` is inserted before the item which had this `index` in the array.
+	template<typename RemoveIterator, typename InsertIterator>
+	void ApplyEdits(RemoveIterator removeBegin, RemoveIterator removeEnd,
+		InsertIterator insertBegin, InsertIterator insertEnd)
+	{
+		typedef decltype((std::declval<typename std::iterator_traits<
+			InsertIterator>::reference>().second)) ItemArg;
+		typedef typename ItemTraits::template Creator<ItemArg> IterCreator;
+		size_t initCount = GetCount();
+		size_t minRemoveIndex = 0;
+		for (RemoveIterator iter = removeBegin; iter != removeEnd; ++iter)
+		{
+			size_t index = static_cast<size_t>(*iter);
+			MOMO_CHECK(minRemoveIndex <= index && index < initCount);
+			minRemoveIndex = index + 1;
+		}
+		Positions positions((MemManagerPtr(GetMemManager())));
+		try
+		{
+			if (internal::IsForwardIterator<InsertIterator>::value)
+			{
+				size_t newCount = initCount + SMath::Dist(insertBegin, insertEnd);
+				if (newCount > GetCapacity())
+					pvGrow(newCount, ArrayGrowCause::add);
+			}
+			MemManager& memManager = GetMemManager();
+			RemoveIterator removeIter = removeBegin;
+			size_t removeCount = 0;
+			size_t prevIndex = 0;
+			for (InsertIterator iter = insertBegin; iter != insertEnd; ++iter)
+			{
+				size_t index = static_cast<size_t>((*iter).first);
+				MOMO_CHECK(prevIndex <= index && index <= initCount);
+				prevIndex = index;
+				for (; removeIter != removeEnd && static_cast<size_t>(*removeIter) < index; ++removeIter)
+					++removeCount;
+				positions.AddBack(index - removeCount);
+				AddBackCrt(IterCreator(memManager, std::forward<ItemArg>((*iter).second)));
+			}
+		}
+		catch (...)
+		{
+			pvRemoveBack(GetCount() - initCount);
+			throw;
+		}
+		RemoveIterator removeIter = removeBegin;
+		auto indexPred = [&removeIter, removeEnd] (size_t index)
+		{
+			if (removeIter == removeEnd || static_cast<size_t>(*removeIter) != index)
+				return false;
+			++removeIter;
+			return true;
+		};
+		pvRemove(indexPred, internal::BoolConstant<ItemTraits::isNothrowRelocatable>());
+		pvInsertBack(positions, internal::BoolConstant<ItemTraits::isNothrowRelocatable>());
+	}
+
 	template<typename ItemArg,
 		typename Predicate = internal::Equaler<ItemArg, Item>>
 	bool Contains(const ItemArg& itemArg, const Predicate& pred = Predicate()) const
@@ -970,7 +1124,14 @@ private:
 	{
 		size_t initCount = GetCount();
 		size_t newCount = initCount + 1;
-		size_t newCapacity = pvGrowCapacity(GetCapacity(), newCount, ArrayGrowCause::add, false);
+		size_t initCapacity = GetCapacity();
+		// the items stay in place, so the creator can refer to them
+		if (mData.SetCapacityInplace(
+			pvGrowCapacity(initCapacity, newCount, ArrayGrowCause::add, true)))
+		{
+			return pvAddBackNogrow(std::forward<ItemCreator>(itemCreator));
+		}
+		size_t newCapacity = pvGrowCapacity(initCapacity, newCount, ArrayGrowCause::add, false);
 		auto relocateFunc = [this, initCount, &itemCreator] (Item* newItems)
 		{
 			ItemTraits::RelocateCreate(GetMemManager(), GetItems(), newItems, initCount,
@@ -1034,6 +1195,192 @@ private:
 		pvAddBackGrow(typename ItemTraits::template Creator<const Item&>(GetMemManager(), item));
 	}
 
+	template<typename IndexPredicate>
+	size_t pvRemove(const IndexPredicate& indexPred, std::true_type /*isNothrowRelocatable*/)
+	{
+		MemManager& memManager = GetMemManager();
+		Item* items = GetItems();
+		size_t initCount = GetCount();
+		size_t newCount = 0;
+		size_t runBegin = 0;	// items from `runBegin` are not moved yet
+		try
+		{
+			for (size_t index = 0; index < initCount; ++index)
+			{
+				if (!indexPred(index))
+					continue;
+				pvRelocate(items + runBegin, items + newCount, index - runBegin);
+				newCount += index - runBegin;
+				ItemTraits::Destroy(memManager, items + index, 1);
+				runBegin = index + 1;
+			}
+		}
+		catch (...)
+		{
+			pvRelocate(items + runBegin, items + newCount, initCount - runBegin);
+			mData.SetCount(newCount + initCount - runBegin);
+			throw;
+		}
+		pvRelocate(items + runBegin, items + newCount, initCount - runBegin);
+		newCount += initCount - runBegin;
+		mData.SetCount(newCount);
+		return initCount - newCount;
+	}
+
+	template<typename IndexPredicate>
+	size_t pvRemove(const IndexPredicate& indexPred, std::false_type /*isNothrowRelocatable*/)
+	{
+		MemManager& memManager = GetMemManager();
+		Item* items = GetItems();
+		size_t initCount = GetCount();
+		size_t newCount = 0;
+		for (size_t index = 0; index < initCount; ++index)
+		{
+			if (indexPred(index))
+				continue;
+			if (newCount != index)
+				ItemTraits::Assign(memManager, std::move(items[index]), items[newCount]);
+			++newCount;
+		}
+		pvRemoveBack(initCount - newCount);
+		return initCount - newCount;
+	}
+
+	// The last `positions.GetCount()` items are moved to `positions[i] + i`
+	void pvInsertBack(const Positions& positions, std::true_type /*isNothrowRelocatable*/)
+	{
+		MemManager& memManager = GetMemManager();
+		size_t addCount = positions.GetCount();
+		size_t initCount = GetCount() - addCount;
+		if (addCount == 0 || positions[0] == initCount)
+			return;
+		Item* addItems;
+		try
+		{
+			addItems = MemManagerProxy::template Allocate<Item>(memManager,
+				addCount * sizeof(Item));
+		}
+		catch (...)
+		{
+			pvRemoveBack(addCount);
+			throw;
+		}
+		Item* items = GetItems();
+		ItemTraits::Relocate(memManager, items + initCount, addItems, addCount);
+		size_t srcIndex = initCount;
+		size_t dstIndex = initCount + addCount;
+		for (size_t i = addCount; i > 0; --i)
+		{
+			size_t position = positions[i - 1];
+			size_t runCount = srcIndex - position;
+			dstIndex -= runCount;
+			pvRelocate(items + position, items + dstIndex, runCount);
+			srcIndex = position;
+			--dstIndex;
+			ItemTraits::Relocate(memManager, addItems + i - 1, items + dstIndex, 1);
+		}
+		MemManagerProxy::Deallocate(memManager, addItems, addCount * sizeof(Item));
+	}
+
+	void pvInsertBack(const Positions& positions, std::false_type /*isNothrowRelocatable*/)
+	{
+		MemManager& memManager = GetMemManager();
+		size_t addCount = positions.GetCount();
+		size_t initCount = GetCount() - addCount;
+		if (addCount == 0 || positions[0] == initCount)
+			return;
+		Item* addItems;
+		try
+		{
+			addItems = MemManagerProxy::template Allocate<Item>(memManager,
+				addCount * sizeof(Item));
+		}
+		catch (...)
+		{
+			pvRemoveBack(addCount);
+			throw;
+		}
+		Item* items = GetItems();
+		try
+		{
+			ItemTraits::Relocate(memManager, items + initCount, addItems, addCount);
+		}
+		catch (...)
+		{
+			MemManagerProxy::Deallocate(memManager, addItems, addCount * sizeof(Item));
+			pvRemoveBack(addCount);
+			throw;
+		}
+		// backward merge: the empty tail is move-constructed, the rest is move-assigned
+		size_t srcIndex = initCount;
+		size_t dstIndex = initCount + addCount;
+		try
+		{
+			for (size_t i = addCount; i > 0; --i)
+			{
+				size_t position = positions[i - 1];
+				while (srcIndex > position)
+				{
+					--srcIndex;
+					--dstIndex;
+					pvMoveItem(items[srcIndex], items, dstIndex, initCount);
+				}
+				--dstIndex;
+				pvMoveItem(addItems[i - 1], items, dstIndex, initCount);
+			}
+		}
+		catch (...)
+		{
+			if (dstIndex >= initCount)
+			{
+				size_t tailIndex = dstIndex + 1;
+				ItemTraits::Destroy(memManager, items + tailIndex,
+					initCount + addCount - tailIndex);
+				mData.SetCount(initCount);
+			}
+			ItemTraits::Destroy(memManager, addItems, addCount);
+			MemManagerProxy::Deallocate(memManager, addItems, addCount * sizeof(Item));
+			throw;
+		}
+		ItemTraits::Destroy(memManager, addItems, addCount);
+		MemManagerProxy::Deallocate(memManager, addItems, addCount * sizeof(Item));
+	}
+
+	void pvMoveItem(Item& srcItem, Item* items, size_t dstIndex, size_t initCount)
+	{
+		MemManager& memManager = GetMemManager();
+		if (dstIndex >= initCount)
+		{
+			typename ItemTraits::template Creator<Item&&>(memManager,
+				std::move(srcItem))(items + dstIndex);
+		}
+		else
+		{
+			ItemTraits::Assign(memManager, std::move(srcItem), items[dstIndex]);
+		}
+	}
+
+	void pvRelocate(Item* srcItems, Item* dstItems, size_t count) noexcept
+	{
+		if (count == 0 || srcItems == dstItems)
+			return;
+		if (ItemTraits::isTriviallyRelocatable)
+		{
+			memmove(static_cast<void*>(dstItems), static_cast<const void*>(srcItems),
+				count * sizeof(Item));
+		}
+		else if (dstItems < srcItems)
+		{
+			for (size_t i = 0; i < count; ++i)
+				ItemTraits::Relocate(GetMemManager(), srcItems + i, dstItems + i, 1);
+		}
+		else
+		{
+			for (size_t i = count; i > 0; --i)
+				ItemTraits::Relocate(GetMemManager(), srcItems + i - 1, dstItems + i - 1, 1);
+		}
+	}
+
 	void pvRemoveBack(size_t count) noexcept
 	{
 		size_t initCount = GetCount();
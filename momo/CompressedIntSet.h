@@ -0,0 +1,1227 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/CompressedIntSet.h
+
+  namespace momo:
+    class CompressedIntSetSettings
+    class CompressedIntSet
+
+  `CompressedIntSet` is a set of `uint32_t` values in the layout of
+  Roaring bitmaps. Values are split into chunks by their high 16 bits.
+  The directory of chunks is an `Array` sorted by these bits, and each
+  chunk keeps the low 16 bits of its values in one of the containers:
+  1. Sorted array of `uint16_t` (up to 4096 values).
+  2. Bitmap of 1024 64-bit words (more than 4096 values).
+  3. Sorted array of runs `[first, last]`. Runs are made only by
+    function `Optimize`, where they are smaller than the other forms,
+    and are unpacked when the chunk is changed.
+  Functions `Intersect`, `Unite` and `Subtract` combine two bitmaps
+  word by word in loops with constant bounds, which the compiler
+  vectorizes with SSE2. Two arrays are merged without branches on the
+  values, or, if one of them is much shorter, it is searched in the
+  other one. An array is probed against a bitmap or runs value by
+  value.
+  Functions `GetRank` and `GetItem` (select) skip the whole chunks by
+  their counts.
+
+  All `CompressedIntSet` functions and constructors have strong
+  exception safety, but not the following case:
+  1. If any constructor throws exception, input argument `memManager`
+    may be changed.
+
+\**********************************************************/
+
+#pragma once
+
+#include "Array.h"
+
+namespace momo
+{
+
+class CompressedIntSetSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+};
+
+namespace internal
+{
+	class CompressedIntChunk
+	{
+	public:
+		enum class Type : uint8_t
+		{
+			array = 0,
+			bitmap = 1,
+			run = 2,
+		};
+
+		static const size_t maxArrayCount = 4096;
+		static const size_t wordCount = 1024;
+
+	public:
+		uint16_t* GetValues() const noexcept
+		{
+			return static_cast<uint16_t*>(data);
+		}
+
+		uint64_t* GetWords() const noexcept
+		{
+			return static_cast<uint64_t*>(data);
+		}
+
+		uint16_t* GetRuns() const noexcept
+		{
+			return static_cast<uint16_t*>(data);
+		}
+
+		size_t GetDataSize() const noexcept
+		{
+			switch (type)
+			{
+			case Type::array:
+				return size_t{capacity} * sizeof(uint16_t);
+			case Type::bitmap:
+				return wordCount * sizeof(uint64_t);
+			default:
+				return size_t{capacity} * 2 * sizeof(uint16_t);
+			}
+		}
+
+		bool Contains(uint16_t low) const noexcept
+		{
+			switch (type)
+			{
+			case Type::array:
+				return std::binary_search(GetValues(), GetValues() + size, low);
+			case Type::bitmap:
+				return ((GetWords()[low / 64] >> (low % 64)) & 1) != 0;
+			default:
+				{
+					size_t runIndex = pvFindRun(low);
+					return runIndex < size && GetRuns()[2 * runIndex] <= low;
+				}
+			}
+		}
+
+		// number of values less than `low`
+		size_t GetRank(uint16_t low) const noexcept
+		{
+			switch (type)
+			{
+			case Type::array:
+				return static_cast<size_t>(
+					std::lower_bound(GetValues(), GetValues() + size, low) - GetValues());
+			case Type::bitmap:
+				{
+					const uint64_t* words = GetWords();
+					size_t rank = 0;
+					for (size_t i = 0; i < size_t{low} / 64; ++i)
+						rank += GetPopCount(words[i]);
+					if (low % 64 != 0)
+						rank += GetPopCount(words[low / 64] & ((uint64_t{1} << (low % 64)) - 1));
+					return rank;
+				}
+			default:
+				{
+					const uint16_t* runs = GetRuns();
+					size_t runIndex = pvFindRun(low);
+					size_t rank = 0;
+					for (size_t i = 0; i < runIndex; ++i)
+						rank += size_t{runs[2 * i + 1]} - size_t{runs[2 * i]} + 1;
+					if (runIndex < size && runs[2 * runIndex] < low)
+						rank += size_t{low} - size_t{runs[2 * runIndex]};
+					return rank;
+				}
+			}
+		}
+
+		uint16_t GetItem(size_t index) const noexcept
+		{
+			MOMO_ASSERT(index < count);
+			switch (type)
+			{
+			case Type::array:
+				return GetValues()[index];
+			case Type::bitmap:
+				{
+					const uint64_t* words = GetWords();
+					size_t wordIndex = 0;
+					while (true)
+					{
+						size_t popCount = GetPopCount(words[wordIndex]);
+						if (index < popCount)
+							break;
+						index -= popCount;
+						++wordIndex;
+					}
+					uint64_t word = words[wordIndex];
+					for (; index > 0; --index)
+						word &= word - 1;
+					return static_cast<uint16_t>(wordIndex * 64 + CountTrailingZeros(word));
+				}
+			default:
+				{
+					const uint16_t* runs = GetRuns();
+					size_t runIndex = 0;
+					while (true)
+					{
+						size_t runCount = size_t{runs[2 * runIndex + 1]} - size_t{runs[2 * runIndex]} + 1;
+						if (index < runCount)
+							break;
+						index -= runCount;
+						++runIndex;
+					}
+					return static_cast<uint16_t>(runs[2 * runIndex] + index);
+				}
+			}
+		}
+
+		// `words` must be initialized, the bits of the chunk are added to them
+		void FillWords(uint64_t* words) const noexcept
+		{
+			switch (type)
+			{
+			case Type::array:
+				{
+					const uint16_t* values = GetValues();
+					for (size_t i = 0; i < size; ++i)
+						words[values[i] / 64] |= uint64_t{1} << (values[i] % 64);
+				}
+				break;
+			case Type::bitmap:
+				{
+					const uint64_t* chunkWords = GetWords();
+					for (size_t i = 0; i < wordCount; ++i)
+						words[i] |= chunkWords[i];
+				}
+				break;
+			default:
+				{
+					const uint16_t* runs = GetRuns();
+					for (size_t i = 0; i < size; ++i)
+						pvFillWords(words, runs[2 * i], runs[2 * i + 1]);
+				}
+			}
+		}
+
+		void CopyValues(uint16_t* values) const noexcept
+		{
+			switch (type)
+			{
+			case Type::array:
+				std::copy_n(GetValues(), size, values);
+				break;
+			case Type::bitmap:
+				{
+					const uint64_t* words = GetWords();
+					for (size_t i = 0; i < wordCount; ++i)
+					{
+						for (uint64_t word = words[i]; word != 0; word &= word - 1)
+							*values++ = static_cast<uint16_t>(i * 64 + CountTrailingZeros(word));
+					}
+				}
+				break;
+			default:
+				{
+					const uint16_t* runs = GetRuns();
+					for (size_t i = 0; i < size; ++i)
+					{
+						for (size_t low = runs[2 * i]; low <= size_t{runs[2 * i + 1]}; ++low)
+							*values++ = static_cast<uint16_t>(low);
+					}
+				}
+			}
+		}
+
+		size_t GetRunCount() const noexcept
+		{
+			switch (type)
+			{
+			case Type::array:
+				{
+					const uint16_t* values = GetValues();
+					size_t runCount = 1;
+					for (size_t i = 1; i < size; ++i)
+						runCount += (values[i] != values[i - 1] + 1) ? 1 : 0;
+					return runCount;
+				}
+			case Type::bitmap:
+				{
+					// a run begins at a set bit, which follows a zero bit
+					const uint64_t* words = GetWords();
+					size_t runCount = 0;
+					uint64_t prevHighBit = 0;
+					for (size_t i = 0; i < wordCount; ++i)
+					{
+						uint64_t word = words[i];
+						runCount += GetPopCount(word & ~((word << 1) | prevHighBit));
+						prevHighBit = word >> 63;
+					}
+					return runCount;
+				}
+			default:
+				return size;
+			}
+		}
+
+		void CopyRuns(uint16_t* runs) const noexcept
+		{
+			size_t runCount = 0;
+			size_t first = 0;
+			size_t last = 0;
+			auto valueFunc = [runs, &runCount, &first, &last] (size_t low)
+			{
+				if (runCount > 0 && low == last + 1)
+				{
+					last = low;
+					return;
+				}
+				if (runCount > 0)
+				{
+					runs[2 * runCount - 2] = static_cast<uint16_t>(first);
+					runs[2 * runCount - 1] = static_cast<uint16_t>(last);
+				}
+				++runCount;
+				first = low;
+				last = low;
+			};
+			if (type == Type::array)
+			{
+				const uint16_t* values = GetValues();
+				for (size_t i = 0; i < size; ++i)
+					valueFunc(values[i]);
+			}
+			else
+			{
+				MOMO_ASSERT(type == Type::bitmap);
+				const uint64_t* words = GetWords();
+				for (size_t i = 0; i < wordCount; ++i)
+				{
+					for (uint64_t word = words[i]; word != 0; word &= word - 1)
+						valueFunc(i * 64 + CountTrailingZeros(word));
+				}
+			}
+			MOMO_ASSERT(runCount > 0);
+			runs[2 * runCount - 2] = static_cast<uint16_t>(first);
+			runs[2 * runCount - 1] = static_cast<uint16_t>(last);
+		}
+
+		static size_t GetPopCount(uint64_t word) noexcept
+		{
+#ifdef MOMO_POPCOUNT64
+			return static_cast<size_t>(MOMO_POPCOUNT64(word));
+#else
+			word -= (word >> 1) & 0x5555555555555555;
+			word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+			word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0F;
+			return static_cast<size_t>((word * 0x0101010101010101) >> 56);
+#endif
+		}
+
+		static size_t CountTrailingZeros(uint64_t word) noexcept
+		{
+			MOMO_ASSERT(word != 0);
+#ifdef MOMO_CTZ64
+			return static_cast<size_t>(MOMO_CTZ64(word));
+#else
+			size_t index = 0;
+			for (; (word & 1) == 0; word >>= 1)
+				++index;
+			return index;
+#endif
+		}
+
+	private:
+		// index of the first run with `last >= low`
+		size_t pvFindRun(uint16_t low) const noexcept
+		{
+			const uint16_t* runs = GetRuns();
+			size_t left = 0;
+			size_t right = size;
+			while (left < right)
+			{
+				size_t middle = left + (right - left) / 2;
+				if (runs[2 * middle + 1] < low)
+					left = middle + 1;
+				else
+					right = middle;
+			}
+			return left;
+		}
+
+		static void pvFillWords(uint64_t* words, size_t first, size_t last) noexcept
+		{
+			size_t firstWord = first / 64;
+			size_t lastWord = last / 64;
+			uint64_t firstMask = ~uint64_t{0} << (first % 64);
+			uint64_t lastMask = ~uint64_t{0} >> (63 - last % 64);
+			if (firstWord == lastWord)
+			{
+				words[firstWord] |= firstMask & lastMask;
+				return;
+			}
+			words[firstWord] |= firstMask;
+			for (size_t i = firstWord + 1; i < lastWord; ++i)
+				words[i] = ~uint64_t{0};
+			words[lastWord] |= lastMask;
+		}
+
+	public:
+		void* data;
+		uint32_t count;		// number of values
+		uint32_t size;		// number of array values or runs
+		uint32_t capacity;	// capacity of array values or runs
+		uint16_t key;		// high bits of values
+		Type type;
+	};
+
+	class CompressedIntSetIterator
+	{
+	private:
+		typedef CompressedIntChunk Chunk;
+
+	public:
+		typedef uint32_t Reference;
+		typedef void Pointer;
+
+		typedef CompressedIntSetIterator ConstIterator;
+
+	public:
+		explicit CompressedIntSetIterator() noexcept
+			: mChunk(nullptr),
+			mChunkEnd(nullptr),
+			mIndex(0),
+			mLow(0)
+		{
+		}
+
+		CompressedIntSetIterator& operator++()
+		{
+			MOMO_ASSERT(mChunk != mChunkEnd);
+			switch (mChunk->type)
+			{
+			case Chunk::Type::array:
+				if (++mIndex == mChunk->size)
+					pvNextChunk();
+				break;
+			case Chunk::Type::bitmap:
+				{
+					const uint64_t* words = mChunk->GetWords();
+					size_t low = mLow + 1;
+					size_t wordIndex = low / 64;
+					uint64_t word = (low < Chunk::wordCount * 64)
+						? words[wordIndex] & (~uint64_t{0} << (low % 64)) : 0;
+					while (word == 0 && ++wordIndex < Chunk::wordCount)
+						word = words[wordIndex];
+					if (word != 0)
+						mLow = wordIndex * 64 + Chunk::CountTrailingZeros(word);
+					else
+						pvNextChunk();
+				}
+				break;
+			default:
+				{
+					const uint16_t* runs = mChunk->GetRuns();
+					if (mLow < runs[2 * mIndex + 1])
+						++mLow;
+					else if (++mIndex < mChunk->size)
+						mLow = runs[2 * mIndex];
+					else
+						pvNextChunk();
+				}
+			}
+			return *this;
+		}
+
+		CompressedIntSetIterator operator++(int)
+		{
+			CompressedIntSetIterator tempIter = *this;
+			++*this;
+			return tempIter;
+		}
+
+		Reference operator*() const
+		{
+			MOMO_ASSERT(mChunk != mChunkEnd);
+			size_t low = (mChunk->type == Chunk::Type::array) ? mChunk->GetValues()[mIndex] : mLow;
+			return (uint32_t{mChunk->key} << 16) | static_cast<uint32_t>(low);
+		}
+
+		bool operator==(ConstIterator iter) const noexcept
+		{
+			return mChunk == iter.mChunk && mIndex == iter.mIndex && mLow == iter.mLow;
+		}
+
+		bool operator!=(ConstIterator iter) const noexcept
+		{
+			return !(*this == iter);
+		}
+
+	protected:
+		explicit CompressedIntSetIterator(const Chunk* chunk, const Chunk* chunkEnd) noexcept
+			: mChunk(chunk),
+			mChunkEnd(chunkEnd),
+			mIndex(0),
+			mLow(0)
+		{
+			pvInitChunk();
+		}
+
+	private:
+		void pvNextChunk() noexcept
+		{
+			++mChunk;
+			mIndex = 0;
+			mLow = 0;
+			pvInitChunk();
+		}
+
+		void pvInitChunk() noexcept
+		{
+			if (mChunk == mChunkEnd)
+				return;
+			if (mChunk->type == Chunk::Type::bitmap)
+			{
+				const uint64_t* words = mChunk->GetWords();
+				size_t wordIndex = 0;
+				while (words[wordIndex] == 0)
+					++wordIndex;
+				mLow = wordIndex * 64 + Chunk::CountTrailingZeros(words[wordIndex]);
+			}
+			else if (mChunk->type == Chunk::Type::run)
+			{
+				mLow = mChunk->GetRuns()[0];
+			}
+		}
+
+	private:
+		const Chunk* mChunk;
+		const Chunk* mChunkEnd;
+		size_t mIndex;	// array value or run
+		size_t mLow;	// bitmap or run value
+	};
+}
+
+template<typename TMemManager = MemManagerDefault,
+	typename TSettings = CompressedIntSetSettings>
+class CompressedIntSet
+{
+public:
+	typedef uint32_t Item;
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+
+	typedef internal::CompressedIntSetIterator ConstIterator;
+
+private:
+	typedef internal::CompressedIntChunk Chunk;
+	typedef Chunk::Type ChunkType;
+
+	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	typedef Array<Chunk, MemManager> Chunks;
+
+	typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+
+	template<typename BufferItem>
+	using Buffer = Array<BufferItem, MemManagerPtr, ArrayItemTraits<BufferItem, MemManagerPtr>,
+		internal::NestedArraySettings<>>;
+
+	struct ConstIteratorProxy : public ConstIterator
+	{
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(ConstIterator)
+	};
+
+	static const size_t maxArrayCount = Chunk::maxArrayCount;
+	static const size_t wordCount = Chunk::wordCount;
+
+	static const size_t minArrayCapacity = 4;
+
+public:
+	explicit CompressedIntSet(MemManager&& memManager = MemManager())
+		: mChunks(std::move(memManager)),
+		mCount(0)
+	{
+	}
+
+	template<typename ArgIterator,
+		typename = typename std::iterator_traits<ArgIterator>::iterator_category>
+	explicit CompressedIntSet(ArgIterator begin, ArgIterator end,
+		MemManager&& memManager = MemManager())
+		: CompressedIntSet(std::move(memManager))
+	{
+		Insert(begin, end);
+	}
+
+	CompressedIntSet(std::initializer_list<Item> items)
+		: CompressedIntSet(items.begin(), items.end())
+	{
+	}
+
+	CompressedIntSet(CompressedIntSet&& set) noexcept
+		: mChunks(std::move(set.mChunks)),
+		mCount(set.mCount)
+	{
+		set.mCount = 0;
+	}
+
+	CompressedIntSet(const CompressedIntSet& set)
+		: CompressedIntSet(MemManager(set.GetMemManager()))
+	{
+		mChunks.Reserve(set.mChunks.GetCount());
+		for (const Chunk& chunk : set.mChunks)
+			pvAddBack(pvCopyChunk(chunk));
+	}
+
+	~CompressedIntSet() noexcept
+	{
+		pvDestroyChunks();
+	}
+
+	CompressedIntSet& operator=(CompressedIntSet&& set) noexcept
+	{
+		CompressedIntSet(std::move(set)).Swap(*this);
+		return *this;
+	}
+
+	CompressedIntSet& operator=(const CompressedIntSet& set)
+	{
+		if (this != &set)
+			CompressedIntSet(set).Swap(*this);
+		return *this;
+	}
+
+	void Swap(CompressedIntSet& set) noexcept
+	{
+		mChunks.Swap(set.mChunks);
+		std::swap(mCount, set.mCount);
+	}
+
+	ConstIterator GetBegin() const noexcept
+	{
+		return ConstIteratorProxy(mChunks.GetItems(), mChunks.GetItems() + mChunks.GetCount());
+	}
+
+	ConstIterator GetEnd() const noexcept
+	{
+		const Chunk* chunkEnd = mChunks.GetItems() + mChunks.GetCount();
+		return ConstIteratorProxy(chunkEnd, chunkEnd);
+	}
+
+	MOMO_FRIEND_SWAP(CompressedIntSet)
+	MOMO_FRIENDS_BEGIN_END(const CompressedIntSet&, ConstIterator)
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mChunks.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mChunks.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mCount;
+	}
+
+	MOMO_NODISCARD bool IsEmpty() const noexcept
+	{
+		return mCount == 0;
+	}
+
+	void Clear(bool shrink = true) noexcept
+	{
+		pvDestroyChunks();
+		mChunks.Clear(shrink);
+		mCount = 0;
+	}
+
+	bool ContainsKey(Item item) const noexcept
+	{
+		size_t index = pvFindChunk(pvGetKey(item));
+		return index < mChunks.GetCount() && mChunks[index].key == pvGetKey(item)
+			&& mChunks[index].Contains(pvGetLow(item));
+	}
+
+	bool Insert(Item item)
+	{
+		uint16_t key = pvGetKey(item);
+		uint16_t low = pvGetLow(item);
+		size_t index = pvFindChunk(key);
+		if (index == mChunks.GetCount() || mChunks[index].key != key)
+		{
+			Chunk chunk = pvCreateChunk(key, ChunkType::array, minArrayCapacity);
+			chunk.GetValues()[0] = low;
+			chunk.count = 1;
+			chunk.size = 1;
+			try
+			{
+				mChunks.Insert(index, chunk);
+			}
+			catch (...)
+			{
+				pvDestroyChunk(chunk);
+				throw;
+			}
+			++mCount;
+			return true;
+		}
+		Chunk& chunk = mChunks[index];
+		if (chunk.Contains(low))
+			return false;
+		pvInsert(chunk, low);
+		++mCount;
+		return true;
+	}
+
+	template<typename ArgIterator,
+		typename = typename std::iterator_traits<ArgIterator>::iterator_category>
+	size_t Insert(ArgIterator begin, ArgIterator end)
+	{
+		size_t initCount = GetCount();
+		for (ArgIterator iter = begin; iter != end; ++iter)
+			Insert(static_cast<Item>(*iter));
+		return GetCount() - initCount;
+	}
+
+	size_t Insert(std::initializer_list<Item> items)
+	{
+		return Insert(items.begin(), items.end());
+	}
+
+	bool Remove(Item item)
+	{
+		uint16_t key = pvGetKey(item);
+		uint16_t low = pvGetLow(item);
+		size_t index = pvFindChunk(key);
+		if (index == mChunks.GetCount() || mChunks[index].key != key)
+			return false;
+		Chunk& chunk = mChunks[index];
+		if (!chunk.Contains(low))
+			return false;
+		if (chunk.count == 1)
+		{
+			pvDestroyChunk(chunk);
+			mChunks.Remove(index, 1);
+		}
+		else
+		{
+			pvRemove(chunk, low);
+		}
+		--mCount;
+		return true;
+	}
+
+	// number of items less than `item`
+	size_t GetRank(Item item) const noexcept
+	{
+		size_t index = pvFindChunk(pvGetKey(item));
+		size_t rank = 0;
+		for (size_t i = 0; i < index; ++i)
+			rank += mChunks[i].count;
+		if (index < mChunks.GetCount() && mChunks[index].key == pvGetKey(item))
+			rank += mChunks[index].GetRank(pvGetLow(item));
+		return rank;
+	}
+
+	// item with the rank `index`
+	Item GetItem(size_t index) const
+	{
+		MOMO_CHECK(index < mCount);
+		for (const Chunk& chunk : mChunks)
+		{
+			if (index < chunk.count)
+				return (Item{chunk.key} << 16) | Item{chunk.GetItem(index)};
+			index -= chunk.count;
+		}
+		MOMO_ASSERT(false);
+		return 0;
+	}
+
+	// Converts chunks to runs where they are smaller and releases unused capacity
+	void Optimize()
+	{
+		for (Chunk& chunk : mChunks)
+		{
+			size_t runCount = chunk.GetRunCount();
+			size_t runSize = runCount * 2 * sizeof(uint16_t);
+			size_t unpackedSize = (chunk.count <= maxArrayCount)
+				? chunk.count * sizeof(uint16_t) : wordCount * sizeof(uint64_t);
+			if (runSize < unpackedSize)
+			{
+				if (chunk.type != ChunkType::run)
+				{
+					Chunk newChunk = pvCreateChunk(chunk.key, ChunkType::run, runCount);
+					chunk.CopyRuns(newChunk.GetRuns());
+					newChunk.count = chunk.count;
+					newChunk.size = static_cast<uint32_t>(runCount);
+					pvReplaceChunk(chunk, newChunk);
+				}
+			}
+			else if (chunk.type == ChunkType::run
+				|| (chunk.type == ChunkType::array && chunk.capacity > chunk.size))
+			{
+				pvReplaceChunk(chunk, pvUnpackChunk(chunk, chunk.count));
+			}
+		}
+		mChunks.Shrink();
+	}
+
+	static CompressedIntSet Intersect(const CompressedIntSet& set1, const CompressedIntSet& set2)
+	{
+		auto chunkCombiner = [] (CompressedIntSet& resSet, const Chunk& chunk1,
+			const Chunk& chunk2, Buffers& buffers)
+		{
+			uint16_t* resValues = buffers.values.GetItems();
+			if (chunk1.type == ChunkType::array && chunk2.type == ChunkType::array)
+			{
+				size_t resCount = pvIntersectValues(chunk1.GetValues(), chunk1.size,
+					chunk2.GetValues(), chunk2.size, resValues);
+				resSet.pvAddBackValues(chunk1.key, resValues, resCount);
+			}
+			else if (chunk1.type == ChunkType::array || chunk2.type == ChunkType::array)
+			{
+				const Chunk& arrayChunk = (chunk1.type == ChunkType::array) ? chunk1 : chunk2;
+				const Chunk& otherChunk = (chunk1.type == ChunkType::array) ? chunk2 : chunk1;
+				size_t resCount = pvFilterValues(arrayChunk, otherChunk, true, resValues);
+				resSet.pvAddBackValues(chunk1.key, resValues, resCount);
+			}
+			else
+			{
+				const uint64_t* words1 = pvGetWords(chunk1, buffers.words1.GetItems());
+				const uint64_t* words2 = pvGetWords(chunk2, buffers.words2.GetItems());
+				uint64_t* resWords = buffers.resWords.GetItems();
+				for (size_t i = 0; i < wordCount; ++i)
+					resWords[i] = words1[i] & words2[i];
+				resSet.pvAddBackWords(chunk1.key, resWords);
+			}
+		};
+		return pvCombine(set1, set2, false, false, chunkCombiner);
+	}
+
+	static CompressedIntSet Unite(const CompressedIntSet& set1, const CompressedIntSet& set2)
+	{
+		auto chunkCombiner = [] (CompressedIntSet& resSet, const Chunk& chunk1,
+			const Chunk& chunk2, Buffers& buffers)
+		{
+			if (chunk1.type == ChunkType::array && chunk2.type == ChunkType::array)
+			{
+				uint16_t* resValues = buffers.values.GetItems();
+				size_t resCount = pvUniteValues(chunk1.GetValues(), chunk1.size,
+					chunk2.GetValues(), chunk2.size, resValues);
+				resSet.pvAddBackValues(chunk1.key, resValues, resCount);
+			}
+			else
+			{
+				uint64_t* resWords = buffers.resWords.GetItems();
+				std::fill_n(resWords, wordCount, uint64_t{0});
+				chunk1.FillWords(resWords);
+				chunk2.FillWords(resWords);
+				resSet.pvAddBackWords(chunk1.key, resWords);
+			}
+		};
+		return pvCombine(set1, set2, true, true, chunkCombiner);
+	}
+
+	static CompressedIntSet Subtract(const CompressedIntSet& set1, const CompressedIntSet& set2)
+	{
+		auto chunkCombiner = [] (CompressedIntSet& resSet, const Chunk& chunk1,
+			const Chunk& chunk2, Buffers& buffers)
+		{
+			if (chunk1.type == ChunkType::array)
+			{
+				uint16_t* resValues = buffers.values.GetItems();
+				size_t resCount = pvFilterValues(chunk1, chunk2, false, resValues);
+				resSet.pvAddBackValues(chunk1.key, resValues, resCount);
+			}
+			else
+			{
+				uint64_t* resWords = buffers.resWords.GetItems();
+				std::fill_n(resWords, wordCount, uint64_t{0});
+				chunk1.FillWords(resWords);
+				if (chunk2.type == ChunkType::array)
+				{
+					const uint16_t* values2 = chunk2.GetValues();
+					for (size_t i = 0; i < chunk2.size; ++i)
+						resWords[values2[i] / 64] &= ~(uint64_t{1} << (values2[i] % 64));
+				}
+				else
+				{
+					const uint64_t* words2 = pvGetWords(chunk2, buffers.words2.GetItems());
+					for (size_t i = 0; i < wordCount; ++i)
+						resWords[i] &= ~words2[i];
+				}
+				resSet.pvAddBackWords(chunk1.key, resWords);
+			}
+		};
+		return pvCombine(set1, set2, true, false, chunkCombiner);
+	}
+
+private:
+	struct Buffers
+	{
+		explicit Buffers(MemManager& memManager)
+			: values(2 * maxArrayCount, MemManagerPtr(memManager)),
+			words1(wordCount, MemManagerPtr(memManager)),
+			words2(wordCount, MemManagerPtr(memManager)),
+			resWords(wordCount, MemManagerPtr(memManager))
+		{
+		}
+
+		Buffer<uint16_t> values;
+		Buffer<uint64_t> words1;
+		Buffer<uint64_t> words2;
+		Buffer<uint64_t> resWords;
+	};
+
+private:
+	static uint16_t pvGetKey(Item item) noexcept
+	{
+		return static_cast<uint16_t>(item >> 16);
+	}
+
+	static uint16_t pvGetLow(Item item) noexcept
+	{
+		return static_cast<uint16_t>(item);
+	}
+
+	size_t pvFindChunk(uint16_t key) const noexcept
+	{
+		auto keyComparer = [] (const Chunk& chunk, uint16_t key) { return chunk.key < key; };
+		return static_cast<size_t>(std::lower_bound(mChunks.GetBegin(), mChunks.GetEnd(),
+			key, keyComparer) - mChunks.GetBegin());
+	}
+
+	Chunk pvCreateChunk(uint16_t key, ChunkType type, size_t capacity)
+	{
+		Chunk chunk;
+		chunk.key = key;
+		chunk.type = type;
+		chunk.count = 0;
+		chunk.size = 0;
+		chunk.capacity = static_cast<uint32_t>(capacity);
+		chunk.data = MemManagerProxy::Allocate(GetMemManager(), chunk.GetDataSize());
+		return chunk;
+	}
+
+	void pvDestroyChunk(Chunk& chunk) noexcept
+	{
+		MemManagerProxy::Deallocate(GetMemManager(), chunk.data, chunk.GetDataSize());
+	}
+
+	void pvDestroyChunks() noexcept
+	{
+		for (Chunk& chunk : mChunks)
+			pvDestroyChunk(chunk);
+	}
+
+	void pvReplaceChunk(Chunk& chunk, const Chunk& newChunk) noexcept
+	{
+		pvDestroyChunk(chunk);
+		chunk = newChunk;
+	}
+
+	Chunk pvCopyChunk(const Chunk& chunk)
+	{
+		size_t capacity = (chunk.type == ChunkType::bitmap) ? 0 : chunk.size;
+		Chunk newChunk = pvCreateChunk(chunk.key, chunk.type, capacity);
+		std::memcpy(newChunk.data, chunk.data, newChunk.GetDataSize());
+		newChunk.count = chunk.count;
+		newChunk.size = chunk.size;
+		return newChunk;
+	}
+
+	// array or bitmap with the same values
+	Chunk pvUnpackChunk(const Chunk& chunk, size_t capacity)
+	{
+		if (chunk.count > maxArrayCount || capacity > maxArrayCount)
+		{
+			Chunk newChunk = pvCreateChunk(chunk.key, ChunkType::bitmap, 0);
+			std::fill_n(newChunk.GetWords(), wordCount, uint64_t{0});
+			chunk.FillWords(newChunk.GetWords());
+			newChunk.count = chunk.count;
+			return newChunk;
+		}
+		Chunk newChunk = pvCreateChunk(chunk.key, ChunkType::array, capacity);
+		chunk.CopyValues(newChunk.GetValues());
+		newChunk.count = chunk.count;
+		newChunk.size = chunk.count;
+		return newChunk;
+	}
+
+	void pvInsert(Chunk& chunk, uint16_t low)
+	{
+		if (chunk.type == ChunkType::array && chunk.size == chunk.capacity)
+		{
+			size_t newCapacity = size_t{chunk.capacity} * 2;
+			if (newCapacity > maxArrayCount)
+				newCapacity = maxArrayCount + 1;	// bitmap
+			pvReplaceChunk(chunk, pvUnpackChunk(chunk, newCapacity));
+		}
+		else if (chunk.type == ChunkType::run)
+		{
+			size_t newCapacity = size_t{chunk.count} + 1;
+			if (newCapacity < minArrayCapacity)
+				newCapacity = minArrayCapacity;
+			pvReplaceChunk(chunk, pvUnpackChunk(chunk, newCapacity));
+		}
+		if (chunk.type == ChunkType::array)
+		{
+			uint16_t* values = chunk.GetValues();
+			uint16_t* value = std::lower_bound(values, values + chunk.size, low);
+			std::copy_backward(value, values + chunk.size, values + chunk.size + 1);
+			*value = low;
+			++chunk.size;
+		}
+		else
+		{
+			chunk.GetWords()[low / 64] |= uint64_t{1} << (low % 64);
+		}
+		++chunk.count;
+	}
+
+	void pvRemove(Chunk& chunk, uint16_t low)
+	{
+		if (chunk.type == ChunkType::run)
+			pvReplaceChunk(chunk, pvUnpackChunk(chunk, chunk.count));
+		if (chunk.type == ChunkType::array)
+		{
+			uint16_t* values = chunk.GetValues();
+			uint16_t* value = std::lower_bound(values, values + chunk.size, low);
+			std::copy(value + 1, values + chunk.size, value);
+			--chunk.size;
+			--chunk.count;
+			return;
+		}
+		uint64_t& word = chunk.GetWords()[low / 64];
+		uint64_t mask = uint64_t{1} << (low % 64);
+		word &= ~mask;
+		--chunk.count;
+		if (chunk.count == maxArrayCount)
+		{
+			try
+			{
+				pvReplaceChunk(chunk, pvUnpackChunk(chunk, maxArrayCount));
+			}
+			catch (...)
+			{
+				word |= mask;
+				++chunk.count;
+				throw;
+			}
+		}
+	}
+
+	void pvAddBack(const Chunk& chunk) noexcept
+	{
+		mChunks.AddBackNogrow(chunk);
+		mCount += chunk.count;
+	}
+
+	void pvAddBackValues(uint16_t key, const uint16_t* values, size_t count)
+	{
+		if (count == 0)
+			return;
+		mChunks.Reserve(mChunks.GetCount() + 1);
+		Chunk chunk;
+		if (count <= maxArrayCount)
+		{
+			chunk = pvCreateChunk(key, ChunkType::array, count);
+			std::copy_n(values, count, chunk.GetValues());
+			chunk.size = static_cast<uint32_t>(count);
+		}
+		else
+		{
+			chunk = pvCreateChunk(key, ChunkType::bitmap, 0);
+			uint64_t* words = chunk.GetWords();
+			std::fill_n(words, wordCount, uint64_t{0});
+			for (size_t i = 0; i < count; ++i)
+				words[values[i] / 64] |= uint64_t{1} << (values[i] % 64);
+		}
+		chunk.count = static_cast<uint32_t>(count);
+		pvAddBack(chunk);
+	}
+
+	void pvAddBackWords(uint16_t key, const uint64_t* words)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < wordCount; ++i)
+			count += Chunk::GetPopCount(words[i]);
+		if (count == 0)
+			return;
+		mChunks.Reserve(mChunks.GetCount() + 1);
+		Chunk chunk;
+		if (count <= maxArrayCount)
+		{
+			Chunk wordsChunk;
+			wordsChunk.data = const_cast<uint64_t*>(words);
+			wordsChunk.count = static_cast<uint32_t>(count);
+			wordsChunk.size = 0;
+			wordsChunk.capacity = 0;
+			wordsChunk.key = key;
+			wordsChunk.type = ChunkType::bitmap;
+			chunk = pvUnpackChunk(wordsChunk, count);
+		}
+		else
+		{
+			chunk = pvCreateChunk(key, ChunkType::bitmap, 0);
+			std::copy_n(words, wordCount, chunk.GetWords());
+		}
+		chunk.count = static_cast<uint32_t>(count);
+		pvAddBack(chunk);
+	}
+
+	static const uint64_t* pvGetWords(const Chunk& chunk, uint64_t* words) noexcept
+	{
+		if (chunk.type == ChunkType::bitmap)
+			return chunk.GetWords();
+		std::fill_n(words, wordCount, uint64_t{0});
+		chunk.FillWords(words);
+		return words;
+	}
+
+	static size_t pvIntersectValues(const uint16_t* values1, size_t count1,
+		const uint16_t* values2, size_t count2, uint16_t* resValues) noexcept
+	{
+		if (count1 > count2)
+		{
+			std::swap(values1, values2);
+			std::swap(count1, count2);
+		}
+		size_t resCount = 0;
+		if (count1 * 32 < count2)
+		{
+			const uint16_t* end2 = values2 + count2;
+			for (size_t i = 0; i < count1 && values2 != end2; ++i)
+			{
+				values2 = std::lower_bound(values2, end2, values1[i]);
+				if (values2 != end2 && *values2 == values1[i])
+					resValues[resCount++] = values1[i];
+			}
+			return resCount;
+		}
+		size_t index1 = 0;
+		size_t index2 = 0;
+		while (index1 < count1 && index2 < count2)
+		{
+			uint16_t value1 = values1[index1];
+			uint16_t value2 = values2[index2];
+			resValues[resCount] = value1;
+			resCount += (value1 == value2) ? 1 : 0;
+			index1 += (value1 <= value2) ? 1 : 0;
+			index2 += (value2 <= value1) ? 1 : 0;
+		}
+		return resCount;
+	}
+
+	static size_t pvUniteValues(const uint16_t* values1, size_t count1,
+		const uint16_t* values2, size_t count2, uint16_t* resValues) noexcept
+	{
+		size_t resCount = 0;
+		size_t index1 = 0;
+		size_t index2 = 0;
+		while (index1 < count1 && index2 < count2)
+		{
+			uint16_t value1 = values1[index1];
+			uint16_t value2 = values2[index2];
+			resValues[resCount++] = (value1 < value2) ? value1 : value2;
+			index1 += (value1 <= value2) ? 1 : 0;
+			index2 += (value2 <= value1) ? 1 : 0;
+		}
+		resValues = std::copy(values1 + index1, values1 + count1, resValues + resCount);
+		std::copy(values2 + index2, values2 + count2, resValues);
+		return resCount + (count1 - index1) + (count2 - index2);
+	}
+
+	// values of `arrayChunk`, which are contained (or not) in `chunk`
+	static size_t pvFilterValues(const Chunk& arrayChunk, const Chunk& chunk,
+		bool contained, uint16_t* resValues) noexcept
+	{
+		const uint16_t* values = arrayChunk.GetValues();
+		size_t resCount = 0;
+		if (chunk.type == ChunkType::bitmap)
+		{
+			const uint64_t* words = chunk.GetWords();
+			for (size_t i = 0; i < arrayChunk.size; ++i)
+			{
+				uint16_t value = values[i];
+				resValues[resCount] = value;
+				bool bit = ((words[value / 64] >> (value % 64)) & 1) != 0;
+				resCount += (bit == contained) ? 1 : 0;
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < arrayChunk.size; ++i)
+			{
+				if (chunk.Contains(values[i]) == contained)
+					resValues[resCount++] = values[i];
+			}
+		}
+		return resCount;
+	}
+
+	template<typename ChunkCombiner>
+	static CompressedIntSet pvCombine(const CompressedIntSet& set1, const CompressedIntSet& set2,
+		bool keepChunks1, bool keepChunks2, const ChunkCombiner& chunkCombiner)
+	{
+		CompressedIntSet resSet((MemManager(set1.GetMemManager())));
+		Buffers buffers(resSet.GetMemManager());
+		const Chunks& chunks1 = set1.mChunks;
+		const Chunks& chunks2 = set2.mChunks;
+		size_t index1 = 0;
+		size_t index2 = 0;
+		while (index1 < chunks1.GetCount() || index2 < chunks2.GetCount())
+		{
+			if (index2 == chunks2.GetCount()
+				|| (index1 < chunks1.GetCount() && chunks1[index1].key < chunks2[index2].key))
+			{
+				if (keepChunks1)
+				{
+					resSet.mChunks.Reserve(resSet.mChunks.GetCount() + 1);
+					resSet.pvAddBack(resSet.pvCopyChunk(chunks1[index1]));
+				}
+				++index1;
+			}
+			else if (index1 == chunks1.GetCount() || chunks2[index2].key < chunks1[index1].key)
+			{
+				if (keepChunks2)
+				{
+					resSet.mChunks.Reserve(resSet.mChunks.GetCount() + 1);
+					resSet.pvAddBack(resSet.pvCopyChunk(chunks2[index2]));
+				}
+				++index2;
+			}
+			else
+			{
+				chunkCombiner(resSet, chunks1[index1], chunks2[index2], buffers);
+				++index1;
+				++index2;
+			}
+		}
+		return resSet;
+	}
+
+private:
+	Chunks mChunks;
+	size_t mCount;
+};
+
+} // namespace momo
+
+namespace std
+{
+	template<>
+	struct iterator_traits<momo::internal::CompressedIntSetIterator>
+		: public momo::internal::IteratorTraitsStd<momo::internal::CompressedIntSetIterator,
+			forward_iterator_tag>
+	{
+	};
+} // namespace std
@@ -0,0 +1,286 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/ConcurrentMemPool.h
+
+  namespace momo:
+    class ConcurrentMemPoolSettings
+    class ConcurrentMemPool
+
+  `ConcurrentMemPool` is a thread-safe wrapper over `MemPool`.
+  Functions `Allocate` and `Deallocate` may be called from different
+  threads simultaneously, a block may be released by any thread.
+
+  Each thread is bound to one of `threadCacheCount` caches of free
+  blocks (threads get caches in round-robin order, so the cache is
+  private while the number of threads does not exceed the number of
+  caches). A cache holds up to `Params::cachedFreeBlockCount` blocks and
+  refills itself from the central `MemPool` by batches.
+  When the cache of the releasing thread is full, the block is pushed
+  to a lock-free global free list along with a half of the cache.
+  This list is taken entirely by the next thread with an empty cache,
+  which keeps as many blocks as its cache holds and returns the rest
+  to the central pool. So `Deallocate` never touches the central pool
+  and never blocks on its mutex, but released blocks get back to the
+  central pool only on a later allocation or in destructor.
+  The central pool is locked by a mutex.
+
+  Block size must be at least `sizeof(void*)`.
+
+\**********************************************************/
+
+#pragma once
+
+#include "MemPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace momo
+{
+
+namespace internal
+{
+	class ConcurrentMemPoolSpinMutex
+	{
+	public:
+		explicit ConcurrentMemPoolSpinMutex() noexcept
+		{
+			mFlag.clear();
+		}
+
+		ConcurrentMemPoolSpinMutex(const ConcurrentMemPoolSpinMutex&) = delete;
+
+		~ConcurrentMemPoolSpinMutex() noexcept
+		{
+		}
+
+		ConcurrentMemPoolSpinMutex& operator=(const ConcurrentMemPoolSpinMutex&) = delete;
+
+		void lock() noexcept
+		{
+			while (mFlag.test_and_set(std::memory_order_acquire))
+				std::this_thread::yield();
+		}
+
+		void unlock() noexcept
+		{
+			mFlag.clear(std::memory_order_release);
+		}
+
+	private:
+		std::atomic_flag mFlag;
+	};
+
+	class ConcurrentMemPoolThreadIndex
+	{
+	public:
+		static size_t Get() noexcept
+		{
+			static std::atomic<size_t> nextIndex(0);
+			static thread_local size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+			return index;
+		}
+	};
+}
+
+class ConcurrentMemPoolSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+	static const ExtraCheckMode extraCheckMode = ExtraCheckMode::bydefault;
+
+	static const size_t threadCacheCount = 16;
+};
+
+template<typename TParams = MemPoolParams<>,
+	typename TMemManager = MemManagerDefault,
+	typename TSettings = ConcurrentMemPoolSettings>
+class ConcurrentMemPool
+{
+public:
+	typedef TParams Params;
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+
+	static const size_t threadCacheCount = Settings::threadCacheCount;
+	MOMO_STATIC_ASSERT(threadCacheCount > 0);
+
+private:
+	typedef momo::MemPool<Params, MemManager, internal::NestedMemPoolSettings> CentralMemPool;
+
+	static const size_t cacheCapacity = (Params::cachedFreeBlockCount > 0)
+		? Params::cachedFreeBlockCount : 1;
+
+	typedef internal::ConcurrentMemPoolSpinMutex SpinMutex;
+
+	struct ThreadCache
+	{
+		SpinMutex mutex;
+		size_t blockCount;
+		void* blocks[cacheCapacity];
+		char padding[64];	// against false sharing
+	};
+
+public:
+	explicit ConcurrentMemPool(MemManager&& memManager = MemManager())
+		: ConcurrentMemPool(Params(), std::move(memManager))
+	{
+	}
+
+	explicit ConcurrentMemPool(const Params& params, MemManager&& memManager = MemManager())
+		: mFreeHead(nullptr),
+		mCentralMemPool(params, std::move(memManager))
+	{
+		MOMO_CHECK(mCentralMemPool.GetBlockSize() >= sizeof(void*));
+		for (ThreadCache& cache : mThreadCaches)
+			cache.blockCount = 0;
+	}
+
+	ConcurrentMemPool(const ConcurrentMemPool&) = delete;
+
+	~ConcurrentMemPool() noexcept
+	{
+		for (ThreadCache& cache : mThreadCaches)
+		{
+			for (size_t i = 0; i < cache.blockCount; ++i)
+				mCentralMemPool.Deallocate(cache.blocks[i]);
+			cache.blockCount = 0;
+		}
+		pvDeallocateFreeBlocks(mFreeHead.exchange(nullptr, std::memory_order_acquire));
+		MOMO_EXTRA_CHECK(mCentralMemPool.GetAllocateCount() == 0);
+	}
+
+	ConcurrentMemPool& operator=(const ConcurrentMemPool&) = delete;
+
+	size_t GetBlockSize() const noexcept
+	{
+		return mCentralMemPool.GetBlockSize();
+	}
+
+	size_t GetBlockAlignment() const noexcept
+	{
+		return mCentralMemPool.GetBlockAlignment();
+	}
+
+	size_t GetBlockCount() const noexcept
+	{
+		return mCentralMemPool.GetBlockCount();
+	}
+
+	const Params& GetParams() const noexcept
+	{
+		return mCentralMemPool.GetParams();
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mCentralMemPool.GetMemManager();
+	}
+
+	template<typename ResObject = void>
+	ResObject* Allocate()
+	{
+		ThreadCache& cache = pvGetThreadCache();
+		std::lock_guard<SpinMutex> lock(cache.mutex);
+		if (cache.blockCount == 0)
+			pvFillCache(cache);
+		--cache.blockCount;
+		return static_cast<ResObject*>(cache.blocks[cache.blockCount]);
+	}
+
+	void Deallocate(void* pblock) noexcept
+	{
+		MOMO_ASSERT(pblock != nullptr);
+		void* firstBlock = pblock;
+		{
+			ThreadCache& cache = pvGetThreadCache();
+			std::lock_guard<SpinMutex> lock(cache.mutex);
+			if (cache.blockCount < cacheCapacity)
+			{
+				cache.blocks[cache.blockCount] = pblock;
+				++cache.blockCount;
+				return;
+			}
+			// the upper half of the cache goes to the global list together with the block
+			for (size_t i = cacheCapacity; i > cacheCapacity / 2; --i)
+			{
+				pvSetNextFreeBlock(cache.blocks[i - 1], firstBlock);
+				firstBlock = cache.blocks[i - 1];
+			}
+			cache.blockCount = cacheCapacity / 2;
+		}
+		pvPushFreeBlocks(firstBlock, pblock);
+	}
+
+private:
+	ThreadCache& pvGetThreadCache() noexcept
+	{
+		return mThreadCaches[internal::ConcurrentMemPoolThreadIndex::Get() % threadCacheCount];
+	}
+
+	static void* pvGetNextFreeBlock(void* pblock) noexcept
+	{
+		void* next;
+		memcpy(&next, pblock, sizeof(void*));
+		return next;
+	}
+
+	static void pvSetNextFreeBlock(void* pblock, void* next) noexcept
+	{
+		memcpy(pblock, &next, sizeof(void*));
+	}
+
+	void pvFillCache(ThreadCache& cache)
+	{
+		void* freeHead = mFreeHead.exchange(nullptr, std::memory_order_acquire);
+		while (freeHead != nullptr && cache.blockCount < cacheCapacity)
+		{
+			cache.blocks[cache.blockCount] = freeHead;
+			++cache.blockCount;
+			freeHead = pvGetNextFreeBlock(freeHead);
+		}
+		if (freeHead == nullptr && cache.blockCount > 0)
+			return;
+		std::lock_guard<std::mutex> lock(mCentralMutex);
+		pvDeallocateFreeBlocks(freeHead);
+		while (cache.blockCount < cacheCapacity)
+		{
+			cache.blocks[cache.blockCount] = mCentralMemPool.Allocate();
+			++cache.blockCount;
+		}
+	}
+
+	void pvPushFreeBlocks(void* firstBlock, void* lastBlock) noexcept
+	{
+		void* freeHead = mFreeHead.load(std::memory_order_relaxed);
+		do
+		{
+			pvSetNextFreeBlock(lastBlock, freeHead);
+		}
+		while (!mFreeHead.compare_exchange_weak(freeHead, firstBlock,
+			std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	void pvDeallocateFreeBlocks(void* freeHead) noexcept
+	{
+		while (freeHead != nullptr)
+		{
+			void* next = pvGetNextFreeBlock(freeHead);
+			mCentralMemPool.Deallocate(freeHead);
+			freeHead = next;
+		}
+	}
+
+private:
+	ThreadCache mThreadCaches[threadCacheCount];
+	std::atomic<void*> mFreeHead;
+	std::mutex mCentralMutex;
+	CentralMemPool mCentralMemPool;
+};
+
+} // namespace momo
@@ -0,0 +1,692 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/ConcurrentTreeMap.h
+
+  namespace momo:
+    class ConcurrentTreeMap
+
+  `ConcurrentTreeMap` is a B+ tree with optimistic lock coupling.
+  All functions may be called from different threads simultaneously.
+  Readers do not write to shared memory: they remember node versions
+  and restart the operation if some version has changed. Writers lock
+  only the nodes they modify or split.
+  Keys and values must be trivially copyable.
+  A node with less than half of the capacity is merged with its
+  sibling by the next removal passing through it, if the lock attempts
+  succeed. Nodes removed from the tree are reused by later splits,
+  their memory is released only in destructor.
+  A failed optimistic attempt is retried after a short pause, and
+  after several failures in a row the thread yields.
+
+\**********************************************************/
+
+#pragma once
+
+#include "TreeTraits.h"
+#include "details/TreeCore.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace momo
+{
+
+namespace internal
+{
+	class ConcurrentTreeNodeLatch
+	{
+	public:
+		explicit ConcurrentTreeNodeLatch() noexcept
+			: mVersion(0)
+		{
+		}
+
+		ConcurrentTreeNodeLatch(const ConcurrentTreeNodeLatch&) = delete;
+
+		~ConcurrentTreeNodeLatch() noexcept
+		{
+		}
+
+		ConcurrentTreeNodeLatch& operator=(const ConcurrentTreeNodeLatch&) = delete;
+
+		uint64_t GetStableVersion() const noexcept
+		{
+			while (true)
+			{
+				uint64_t version = mVersion.load(std::memory_order_acquire);
+				if ((version & 1) == 0)
+					return version;
+				std::this_thread::yield();
+			}
+		}
+
+		bool Validate(uint64_t version) const noexcept
+		{
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return mVersion.load(std::memory_order_relaxed) == version;
+		}
+
+		bool TryLock(uint64_t version) noexcept
+		{
+			if (!mVersion.compare_exchange_strong(version, version + 1))
+				return false;
+			std::atomic_thread_fence(std::memory_order_release);
+			return true;
+		}
+
+		void Unlock() noexcept
+		{
+			MOMO_ASSERT((mVersion.load(std::memory_order_relaxed) & 1) == 1);
+			mVersion.fetch_add(1, std::memory_order_release);
+		}
+
+	private:
+		std::atomic<uint64_t> mVersion;
+	};
+
+	class ConcurrentTreeBackoff
+	{
+	public:
+		static const size_t spinCount = 16;
+
+	public:
+		explicit ConcurrentTreeBackoff() noexcept
+			: mAttempt(0)
+		{
+		}
+
+		ConcurrentTreeBackoff(const ConcurrentTreeBackoff&) = delete;
+
+		~ConcurrentTreeBackoff() noexcept
+		{
+		}
+
+		ConcurrentTreeBackoff& operator=(const ConcurrentTreeBackoff&) = delete;
+
+		void Pause() noexcept
+		{
+			if (mAttempt >= spinCount)
+			{
+				std::this_thread::yield();
+				return;
+			}
+			++mAttempt;
+#ifdef MOMO_USE_SSE2
+			for (size_t i = 0; i < mAttempt; ++i)
+				_mm_pause();
+#else
+			std::this_thread::yield();
+#endif
+		}
+
+	private:
+		size_t mAttempt;
+	};
+
+	class ConcurrentTreeNodeHeader
+	{
+	public:
+		explicit ConcurrentTreeNodeHeader() noexcept
+			: mNextFreeNode(nullptr)
+		{
+		}
+
+		ConcurrentTreeNodeHeader(const ConcurrentTreeNodeHeader&) = delete;
+
+		~ConcurrentTreeNodeHeader() noexcept
+		{
+		}
+
+		ConcurrentTreeNodeHeader& operator=(const ConcurrentTreeNodeHeader&) = delete;
+
+		ConcurrentTreeNodeLatch& GetLatch() noexcept
+		{
+			return mLatch;
+		}
+
+		void* GetNextFreeNode() const noexcept
+		{
+			return mNextFreeNode;
+		}
+
+		void SetNextFreeNode(void* node) noexcept
+		{
+			mNextFreeNode = node;
+		}
+
+	private:
+		ConcurrentTreeNodeLatch mLatch;
+		void* mNextFreeNode;	// for nodes removed from the tree only
+	};
+}
+
+template<typename TKey, typename TValue,
+	typename TTreeTraits = TreeTraits<TKey>,
+	typename TMemManager = MemManagerDefault>
+class ConcurrentTreeMap
+{
+public:
+	typedef TKey Key;
+	typedef TValue Value;
+	typedef TTreeTraits TreeTraits;
+	typedef TMemManager MemManager;
+
+	MOMO_STATIC_ASSERT(std::is_trivially_copyable<Key>::value);
+	MOMO_STATIC_ASSERT(std::is_trivially_copyable<Value>::value);
+	MOMO_STATIC_ASSERT(!TreeTraits::multiKey);
+
+private:
+	typedef typename TreeTraits::TreeNode TreeNode;
+
+	static const size_t nodeCapacity = TreeNode::maxCapacity;
+
+	typedef internal::TreeCoreNode<Key, nodeCapacity, internal::ConcurrentTreeNodeHeader> Node;
+	typedef internal::TreeCoreLeafNode<Node, Value> LeafNode;
+	typedef internal::TreeCoreInternalNode<Node> InternalNode;
+
+	typedef internal::TreeCore<LeafNode, InternalNode, TreeTraits, MemManager> TreeCore;
+
+	typedef internal::ConcurrentTreeNodeLatch Latch;
+	typedef internal::ConcurrentTreeBackoff Backoff;
+
+	typedef internal::ObjectBuffer<Key, internal::AlignmentOf<Key>::value> KeyBuffer;
+	typedef internal::ObjectBuffer<Value, internal::AlignmentOf<Value>::value> ValueBuffer;
+
+	typedef typename TreeNode::MemPoolParams MemPoolParams;
+	typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+	typedef momo::MemPool<MemPoolParams, MemManagerPtr, internal::NestedMemPoolSettings> MemPool;
+
+public:
+	explicit ConcurrentTreeMap(const TreeTraits& treeTraits = TreeTraits(),
+		MemManager&& memManager = MemManager())
+		: mTreeTraits(treeTraits),
+		mMemManager(std::move(memManager)),
+		mLeafMemPool(MemPoolParams(sizeof(LeafNode)), MemManagerPtr(mMemManager)),
+		mInternalMemPool(MemPoolParams(sizeof(InternalNode)), MemManagerPtr(mMemManager)),
+		mFreeLeafNodes(nullptr),
+		mFreeInternalNodes(nullptr),
+		mRootNode(pvCreateNode(true)),
+		mCount(0)
+	{
+	}
+
+	ConcurrentTreeMap(const ConcurrentTreeMap&) = delete;
+
+	~ConcurrentTreeMap() noexcept
+	{
+		pvDestroy(mRootNode.load(std::memory_order_relaxed));
+		pvDestroyFreeNodes(mFreeLeafNodes);
+		pvDestroyFreeNodes(mFreeInternalNodes);
+	}
+
+	ConcurrentTreeMap& operator=(const ConcurrentTreeMap&) = delete;
+
+	const TreeTraits& GetTreeTraits() const noexcept
+	{
+		return mTreeTraits;
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mMemManager;
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mMemManager;
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mCount.load(std::memory_order_relaxed);
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return GetCount() == 0;
+	}
+
+	bool Find(const Key& key, Value& value) const
+	{
+		return pvFind(key, &value);
+	}
+
+	bool ContainsKey(const Key& key) const
+	{
+		return pvFind(key, nullptr);
+	}
+
+	bool Insert(const Key& key, const Value& value)
+	{
+		return pvInsert<false>(key, value);
+	}
+
+	bool InsertOrAssign(const Key& key, const Value& value)
+	{
+		return pvInsert<true>(key, value);
+	}
+
+	bool Remove(const Key& key)
+	{
+		Backoff backoff;
+		bool removed;
+		while (!pvTryRemove(key, removed))
+			backoff.Pause();
+		return removed;
+	}
+
+	// pairVisitor(const Key&, const Value&) returns `false` to stop the scan.
+	// It receives only consistent copies of the pairs in ascending key order.
+	template<typename PairVisitor>
+	void Scan(const Key& lowKey, const PairVisitor& pairVisitor) const
+	{
+		KeyBuffer keys[nodeCapacity];
+		ValueBuffer values[nodeCapacity];
+		KeyBuffer startKey, nextKey;
+		memcpy(&startKey, std::addressof(lowKey), sizeof(Key));
+		Backoff backoff;
+		while (true)
+		{
+			size_t count;
+			bool hasNext;
+			if (!pvTryScanLeaf(*&startKey, keys, values, count, nextKey, hasNext))
+			{
+				backoff.Pause();
+				continue;
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (!pairVisitor(static_cast<const Key&>(*&keys[i]),
+					static_cast<const Value&>(*&values[i])))
+				{
+					return;
+				}
+			}
+			if (!hasNext)
+				break;
+			startKey = nextKey;
+		}
+	}
+
+private:
+	static Latch& pvGetLatch(const Node* node) noexcept
+	{
+		return node->GetHeader().GetLatch();
+	}
+
+	Node* pvCreateNode(bool isLeaf)
+	{
+		std::lock_guard<std::mutex> lock(mMemPoolMutex);
+		Node*& freeNodes = isLeaf ? mFreeLeafNodes : mFreeInternalNodes;
+		if (freeNodes != nullptr)
+		{
+			// the latch keeps its version, so optimistic readers of the former node fail
+			Node* node = freeNodes;
+			freeNodes = static_cast<Node*>(node->GetHeader().GetNextFreeNode());
+			node->GetHeader().SetNextFreeNode(nullptr);
+			MOMO_ASSERT(node->GetCount() == 0);
+			return node;
+		}
+		if (isLeaf)
+			return ::new(mLeafMemPool.Allocate()) LeafNode();
+		else
+			return ::new(mInternalMemPool.Allocate()) InternalNode();
+	}
+
+	// Node memory is not released until destruction of the map,
+	// because optimistic readers may still read the node.
+	void pvFreeNode(Node* node) noexcept
+	{
+		std::lock_guard<std::mutex> lock(mMemPoolMutex);
+		node->SetCount(0);
+		Node*& freeNodes = node->IsLeaf() ? mFreeLeafNodes : mFreeInternalNodes;
+		node->GetHeader().SetNextFreeNode(freeNodes);
+		freeNodes = node;
+	}
+
+	void pvDestroyNode(Node* node) noexcept
+	{
+		if (node->IsLeaf())
+		{
+			LeafNode* leafNode = static_cast<LeafNode*>(node);
+			leafNode->~LeafNode();
+			mLeafMemPool.Deallocate(leafNode);
+		}
+		else
+		{
+			InternalNode* internalNode = static_cast<InternalNode*>(node);
+			internalNode->~InternalNode();
+			mInternalMemPool.Deallocate(internalNode);
+		}
+	}
+
+	void pvDestroy(Node* node) noexcept
+	{
+		if (!node->IsLeaf())
+		{
+			InternalNode* internalNode = static_cast<InternalNode*>(node);
+			size_t count = node->GetCount();
+			for (size_t i = 0; i <= count; ++i)
+				pvDestroy(internalNode->GetChild(i));
+		}
+		pvDestroyNode(node);
+	}
+
+	void pvDestroyFreeNodes(Node* node) noexcept
+	{
+		while (node != nullptr)
+		{
+			Node* nextNode = static_cast<Node*>(node->GetHeader().GetNextFreeNode());
+			pvDestroyNode(node);
+			node = nextNode;
+		}
+	}
+
+	bool pvGetRoot(Node*& node, uint64_t& version) const noexcept
+	{
+		node = mRootNode.load(std::memory_order_acquire);
+		version = pvGetLatch(node).GetStableVersion();
+		return node == mRootNode.load(std::memory_order_acquire);
+	}
+
+	bool pvGetChild(Node*& node, uint64_t& version, size_t index) const noexcept
+	{
+		Node* childNode = static_cast<InternalNode*>(node)->GetChild(index);
+		if (!pvGetLatch(node).Validate(version))
+			return false;
+		uint64_t childVersion = pvGetLatch(childNode).GetStableVersion();
+		if (!pvGetLatch(node).Validate(version))
+			return false;
+		node = childNode;
+		version = childVersion;
+		return true;
+	}
+
+	bool pvFind(const Key& key, Value* value) const
+	{
+		Backoff backoff;
+		bool found;
+		while (!pvTryFind(key, value, found))
+			backoff.Pause();
+		return found;
+	}
+
+	bool pvTryFind(const Key& key, Value* value, bool& found) const
+	{
+		Node* node;
+		uint64_t version;
+		if (!pvGetRoot(node, version))
+			return false;
+		while (!node->IsLeaf())
+		{
+			if (!pvGetChild(node, version, TreeCore::GetUpperBound(mTreeTraits, node, key)))
+				return false;
+		}
+		LeafNode* leafNode = static_cast<LeafNode*>(node);
+		size_t index;
+		found = TreeCore::FindItem(mTreeTraits, leafNode, key, index);
+		ValueBuffer valueBuffer;
+		if (found && value != nullptr)
+			memcpy(&valueBuffer, leafNode->GetValuePtr(index), sizeof(Value));
+		if (!pvGetLatch(leafNode).Validate(version))
+			return false;
+		if (found && value != nullptr)
+			memcpy(value, &valueBuffer, sizeof(Value));
+		return true;
+	}
+
+	template<bool assign>
+	bool pvInsert(const Key& key, const Value& value)
+	{
+		Backoff backoff;
+		bool inserted;
+		while (!pvTryInsert<assign>(key, value, inserted))
+			backoff.Pause();
+		return inserted;
+	}
+
+	template<bool assign>
+	bool pvTryInsert(const Key& key, const Value& value, bool& inserted)
+	{
+		Node* node;
+		uint64_t version;
+		if (!pvGetRoot(node, version))
+			return false;
+		InternalNode* parentNode = nullptr;
+		uint64_t parentVersion = 0;
+		size_t index = 0;
+		while (true)
+		{
+			if (node->GetCount() == nodeCapacity)
+			{
+				pvSplit(node, version, parentNode, parentVersion, index);
+				return false;
+			}
+			if (node->IsLeaf())
+				break;
+			if (parentNode != nullptr && !pvGetLatch(parentNode).Validate(parentVersion))
+				return false;
+			parentNode = static_cast<InternalNode*>(node);
+			parentVersion = version;
+			index = TreeCore::GetUpperBound(mTreeTraits, node, key);
+			if (!pvGetChild(node, version, index))
+				return false;
+		}
+		LeafNode* leafNode = static_cast<LeafNode*>(node);
+		if (!pvGetLatch(leafNode).TryLock(version))
+			return false;
+		size_t itemIndex;
+		inserted = !TreeCore::FindItem(mTreeTraits, leafNode, key, itemIndex);
+		if (inserted)
+		{
+			TreeCore::InsertItem(mMemManager, leafNode, itemIndex, key, value);
+			mCount.fetch_add(1, std::memory_order_relaxed);
+		}
+		else if (assign)
+		{
+			memcpy(leafNode->GetValuePtr(itemIndex), std::addressof(value), sizeof(Value));
+		}
+		pvGetLatch(leafNode).Unlock();
+		return true;
+	}
+
+	bool pvTryRemove(const Key& key, bool& removed)
+	{
+		Node* node;
+		uint64_t version;
+		if (!pvGetRoot(node, version))
+			return false;
+		InternalNode* parentNode = nullptr;
+		uint64_t parentVersion = 0;
+		size_t index = 0;
+		while (true)
+		{
+			if (parentNode == nullptr && !node->IsLeaf() && node->GetCount() == 0)
+			{
+				pvCollapseRoot(node, version);
+				return false;
+			}
+			if (parentNode != nullptr && node->GetCount() < TreeCore::minCount
+				&& pvMerge(node, version, parentNode, parentVersion, index))
+			{
+				return false;
+			}
+			if (node->IsLeaf())
+				break;
+			if (parentNode != nullptr && !pvGetLatch(parentNode).Validate(parentVersion))
+				return false;
+			parentNode = static_cast<InternalNode*>(node);
+			parentVersion = version;
+			index = TreeCore::GetUpperBound(mTreeTraits, node, key);
+			if (!pvGetChild(node, version, index))
+				return false;
+		}
+		LeafNode* leafNode = static_cast<LeafNode*>(node);
+		if (!pvGetLatch(leafNode).TryLock(version))
+			return false;
+		size_t itemIndex;
+		removed = TreeCore::FindItem(mTreeTraits, leafNode, key, itemIndex);
+		if (removed)
+		{
+			TreeCore::RemoveItem(mMemManager, leafNode, itemIndex);
+			mCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+		pvGetLatch(leafNode).Unlock();
+		return true;
+	}
+
+	void pvSplit(Node* node, uint64_t version, InternalNode* parentNode, uint64_t parentVersion,
+		size_t index)
+	{
+		if (parentNode != nullptr && !pvGetLatch(parentNode).TryLock(parentVersion))
+			return;
+		if (!pvGetLatch(node).TryLock(version))
+		{
+			if (parentNode != nullptr)
+				pvGetLatch(parentNode).Unlock();
+			return;
+		}
+		try
+		{
+			if (parentNode != nullptr || node == mRootNode.load(std::memory_order_relaxed))
+				pvSplit(node, parentNode, index);
+		}
+		catch (...)
+		{
+			pvGetLatch(node).Unlock();
+			if (parentNode != nullptr)
+				pvGetLatch(parentNode).Unlock();
+			throw;
+		}
+		pvGetLatch(node).Unlock();
+		if (parentNode != nullptr)
+			pvGetLatch(parentNode).Unlock();
+	}
+
+	void pvSplit(Node* node, InternalNode* parentNode, size_t index)
+	{
+		InternalNode* newRootNode = (parentNode == nullptr)
+			? static_cast<InternalNode*>(pvCreateNode(false)) : nullptr;
+		Node* newNode;
+		try
+		{
+			newNode = pvCreateNode(node->IsLeaf());
+		}
+		catch (...)
+		{
+			if (newRootNode != nullptr)
+				pvFreeNode(newRootNode);
+			throw;
+		}
+		if (parentNode == nullptr)
+		{
+			newRootNode->SetChild(0, node);
+			TreeCore::SplitChild(mMemManager, newRootNode, 0, newNode);
+			mRootNode.store(newRootNode, std::memory_order_release);
+		}
+		else
+		{
+			TreeCore::SplitChild(mMemManager, parentNode, index, newNode);
+		}
+	}
+
+	// returns `false` if the node cannot be merged with its sibling
+	bool pvMerge(Node* node, uint64_t version, InternalNode* parentNode, uint64_t parentVersion,
+		size_t index)
+	{
+		size_t parentCount = parentNode->GetCount();
+		size_t siblingIndex = (index > 0) ? index - 1 : index + 1;
+		Node* siblingNode = (parentCount > 0) ? parentNode->GetChild(siblingIndex) : nullptr;
+		if (!pvGetLatch(parentNode).Validate(parentVersion))
+			return true;
+		if (siblingNode == nullptr)
+			return false;
+		uint64_t siblingVersion = pvGetLatch(siblingNode).GetStableVersion();
+		size_t mergeCount = node->GetCount() + siblingNode->GetCount() + (node->IsLeaf() ? 0 : 1);
+		if (!pvGetLatch(siblingNode).Validate(siblingVersion)
+			|| !pvGetLatch(node).Validate(version))
+		{
+			return true;
+		}
+		if (mergeCount > nodeCapacity)
+			return false;
+		if (!pvGetLatch(parentNode).TryLock(parentVersion))
+			return true;
+		if (!pvGetLatch(node).TryLock(version))
+		{
+			pvGetLatch(parentNode).Unlock();
+			return true;
+		}
+		if (!pvGetLatch(siblingNode).TryLock(siblingVersion))
+		{
+			pvGetLatch(node).Unlock();
+			pvGetLatch(parentNode).Unlock();
+			return true;
+		}
+		Node* freeNode = TreeCore::MergeChildren(mMemManager, parentNode,
+			(index > 0) ? index - 1 : index);
+		MOMO_ASSERT(freeNode != nullptr);
+		pvGetLatch(siblingNode).Unlock();
+		pvGetLatch(node).Unlock();
+		pvGetLatch(parentNode).Unlock();
+		pvFreeNode(freeNode);
+		return true;
+	}
+
+	void pvCollapseRoot(Node* node, uint64_t version)
+	{
+		if (!pvGetLatch(node).TryLock(version))
+			return;
+		MOMO_ASSERT(node == mRootNode.load(std::memory_order_relaxed));
+		mRootNode.store(static_cast<InternalNode*>(node)->GetChild(0), std::memory_order_release);
+		pvGetLatch(node).Unlock();
+		pvFreeNode(node);
+	}
+
+	bool pvTryScanLeaf(const Key& key, KeyBuffer* keys, ValueBuffer* values, size_t& count,
+		KeyBuffer& nextKey, bool& hasNext) const
+	{
+		Node* node;
+		uint64_t version;
+		if (!pvGetRoot(node, version))
+			return false;
+		hasNext = false;
+		while (!node->IsLeaf())
+		{
+			size_t index = TreeCore::GetUpperBound(mTreeTraits, node, key);
+			if (index < node->GetCount())
+			{
+				memcpy(&nextKey, node->GetKeyPtr(index), sizeof(Key));
+				hasNext = true;
+			}
+			if (!pvGetChild(node, version, index))
+				return false;
+		}
+		LeafNode* leafNode = static_cast<LeafNode*>(node);
+		size_t leafCount = leafNode->GetCount();
+		size_t index = std::minmax(TreeCore::GetLowerBound(mTreeTraits, leafNode, key),
+			leafCount).first;
+		count = leafCount - index;
+		memcpy(&keys[0], leafNode->GetKeyPtr(index), count * sizeof(Key));
+		memcpy(&values[0], leafNode->GetValuePtr(index), count * sizeof(Value));
+		return pvGetLatch(leafNode).Validate(version);
+	}
+
+private:
+	TreeTraits mTreeTraits;
+	MemManager mMemManager;
+	std::mutex mMemPoolMutex;
+	MemPool mLeafMemPool;
+	MemPool mInternalMemPool;
+	Node* mFreeLeafNodes;
+	Node* mFreeInternalNodes;
+	std::atomic<Node*> mRootNode;
+	std::atomic<size_t> mCount;
+};
+
+} // namespace momo
@@ -673,15 +673,8 @@ namespace internal
 		template<typename RowFilter>
 		void Filter(const RowFilter& rowFilter)
 		{
-			size_t index = 0;
-			for (Raw*& raw : mRaws)
-			{
-				if (!rowFilter(pvMakeConstRowReference(raw)))
-					continue;
-				std::swap(mRaws[index], raw);
-				++index;
-			}
-			mRaws.RemoveBack(mRaws.GetCount() - index);
+			mRaws.RemoveIf([this, &rowFilter] (Raw* raw)
+				{ return !rowFilter(pvMakeConstRowReference(raw)); });
 		}
 
 		DataSelection&& Reverse() && noexcept
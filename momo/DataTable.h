@@ -31,6 +31,9 @@ public:
 
 	static const size_t selectEqualerMaxCount = 6;
 
+	// Number of rows, which are prefetched ahead when `Select` scans rows
+	static const size_t selectPrefetchCount = 8;
+
 public:
 	template<typename Item>
 	static void AccumulateHashCode(size_t& hashCode, const Item& item, size_t /*offset*/)
@@ -1247,11 +1250,12 @@ private:
 	{
 		MemManager memManager = GetMemManager();
 		typename SelectionProxy::Raws selRaws(std::move(memManager));
-		for (Raw* raw : raws)
+		auto rawFunc = [this, &rowFilter, &selRaws] (Raw* raw)
 		{
 			if (rowFilter(pvMakeConstRowReference(raw)))
 				selRaws.AddBack(raw);
-		}
+		};
+		pvScanRaws(raws, rawFunc);
 		return SelectionProxy(&GetColumnList(), std::move(selRaws),
 			VersionKeeper(&mCrew.GetRemoveVersion()));
 	}
@@ -1268,8 +1272,14 @@ private:
 	template<typename Raws, typename RowFilter>
 	size_t pvMakeSelection(const Raws& raws, const RowFilter& rowFilter, size_t*) const
 	{
-		return static_cast<size_t>(std::count_if(raws.GetBegin(), raws.GetEnd(),
-			[this, &rowFilter] (Raw* raw) { return rowFilter(pvMakeConstRowReference(raw)); }));
+		size_t count = 0;
+		auto rawFunc = [this, &rowFilter, &count] (Raw* raw)
+		{
+			if (rowFilter(pvMakeConstRowReference(raw)))
+				++count;
+		};
+		pvScanRaws(raws, rawFunc);
+		return count;
 	}
 
 	template<typename Raws>
@@ -1279,6 +1289,33 @@ private:
 		return internal::UIntMath<>::Dist(raws.GetBegin(), raws.GetEnd());
 	}
 
+	// Rows are separate blocks, so the scan prefetches them a few rows ahead
+	template<typename Raws, typename RawFunc>
+	static void pvScanRaws(const Raws& raws, const RawFunc& rawFunc)
+	{
+		auto rawIter = raws.GetBegin();
+		auto rawEnd = raws.GetEnd();
+#ifdef MOMO_PREFETCH
+		auto prefetchIter = rawIter;
+		for (size_t i = 0; i < DataTraits::selectPrefetchCount && prefetchIter != rawEnd; ++i)
+		{
+			MOMO_PREFETCH(*prefetchIter);
+			++prefetchIter;
+		}
+#endif
+		for (; rawIter != rawEnd; ++rawIter)
+		{
+#ifdef MOMO_PREFETCH
+			if (prefetchIter != rawEnd)
+			{
+				MOMO_PREFETCH(*prefetchIter);
+				++prefetchIter;
+			}
+#endif
+			rawFunc(*rawIter);
+		}
+	}
+
 	RowHashPointer pvFindByUniqueHash(UniqueHashIndex uniqueHashIndex, const Row& row) const
 	{
 		const ColumnList* columnList = &GetColumnList();
@@ -0,0 +1,463 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/FlatMap.h
+
+  namespace momo:
+    class FlatMapSettings
+    class FlatMap
+
+  `FlatMap` is `FlatSet` of key-value pairs: the pairs are stored sorted
+  by key in one `Array`. Function `Insert` receiving many pairs uses the
+  batched merge of `FlatSet`.
+
+  All `FlatMap` functions and constructors have strong exception safety,
+  but not the following cases:
+  1. If the pair is not nothrow relocatable, function `Insert` receiving
+    many pairs has basic exception safety.
+  2. Functions `Insert` and `Remove` receiving one pair have basic
+    exception safety if pair move assignment can throw.
+
+  All iterators and references become invalid after any insertion or
+  removal of the pair.
+
+\**********************************************************/
+
+#pragma once
+
+#include "FlatSet.h"
+#include "MapUtility.h"
+
+namespace momo
+{
+
+namespace internal
+{
+	template<typename TKey, typename TValue>
+	class FlatMapKeyValuePair
+	{
+	public:
+		typedef TKey Key;
+		typedef TValue Value;
+
+	public:
+		template<typename... ValueArgs>
+		explicit FlatMapKeyValuePair(Key&& key, ValueArgs&&... valueArgs)
+			: mKey(std::move(key)),
+			mValue(std::forward<ValueArgs>(valueArgs)...)
+		{
+		}
+
+		template<typename... ValueArgs>
+		explicit FlatMapKeyValuePair(const Key& key, ValueArgs&&... valueArgs)
+			: mKey(key),
+			mValue(std::forward<ValueArgs>(valueArgs)...)
+		{
+		}
+
+		template<typename First, typename Second>
+		explicit FlatMapKeyValuePair(std::pair<First, Second>&& pair)
+			: mKey(std::forward<First>(pair.first)),
+			mValue(std::forward<Second>(pair.second))
+		{
+		}
+
+		template<typename First, typename Second>
+		explicit FlatMapKeyValuePair(const std::pair<First, Second>& pair)
+			: mKey(pair.first),
+			mValue(pair.second)
+		{
+		}
+
+		template<typename Pair,
+			typename = decltype(std::declval<const Pair&>().key),
+			typename = decltype(std::declval<const Pair&>().value)>
+		explicit FlatMapKeyValuePair(const Pair& pair)
+			: mKey(pair.key),
+			mValue(pair.value)
+		{
+		}
+
+		FlatMapKeyValuePair(FlatMapKeyValuePair&&) = default;
+
+		FlatMapKeyValuePair(const FlatMapKeyValuePair&) = default;
+
+		~FlatMapKeyValuePair() = default;
+
+		FlatMapKeyValuePair& operator=(FlatMapKeyValuePair&&) = default;
+
+		FlatMapKeyValuePair& operator=(const FlatMapKeyValuePair&) = default;
+
+		const Key* GetKeyPtr() const noexcept
+		{
+			return &mKey;
+		}
+
+		Value* GetValuePtr() const noexcept
+		{
+			return &mValue;
+		}
+
+	private:
+		Key mKey;
+		mutable Value mValue;
+	};
+
+	template<typename TKey, typename TValue, typename TMemManager>
+	class FlatMapNestedSetItemTraits
+		: public ArrayItemTraits<FlatMapKeyValuePair<TKey, TValue>, TMemManager>
+	{
+	public:
+		typedef TKey Key;
+		typedef FlatMapKeyValuePair<TKey, TValue> Item;
+
+	public:
+		static const Key& GetKey(const Item& item) noexcept
+		{
+			return *item.GetKeyPtr();
+		}
+	};
+}
+
+class FlatMapSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+	static const ExtraCheckMode extraCheckMode = ExtraCheckMode::bydefault;
+
+	typedef ArraySettings<> ItemsSettings;
+};
+
+template<typename TKey, typename TValue,
+	typename TTreeTraits = TreeTraits<TKey>,
+	typename TMemManager = MemManagerDefault,
+	typename TSettings = FlatMapSettings>
+class FlatMap
+{
+public:
+	typedef TKey Key;
+	typedef TValue Value;
+	typedef TTreeTraits TreeTraits;
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+
+private:
+	typedef internal::FlatMapNestedSetItemTraits<Key, Value, MemManager> FlatSetItemTraits;
+	typedef typename FlatSetItemTraits::Item KeyValuePair;
+
+	typedef momo::FlatSet<Key, TreeTraits, MemManager, FlatSetItemTraits, Settings> FlatSet;
+
+	typedef typename FlatSet::ConstIterator FlatSetConstIterator;
+
+	typedef internal::MapReference<Key, Value, const KeyValuePair&> Reference;
+
+public:
+	typedef internal::TreeDerivedIterator<FlatSetConstIterator, Reference> Iterator;
+	typedef typename Iterator::ConstIterator ConstIterator;
+
+	typedef internal::InsertResult<Iterator> InsertResult;
+
+private:
+	template<typename KeyArg>
+	struct IsValidKeyArg : public TreeTraits::template IsValidKeyArg<KeyArg>
+	{
+	};
+
+	struct ConstIteratorProxy : public ConstIterator
+	{
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(ConstIterator)
+		MOMO_DECLARE_PROXY_FUNCTION(ConstIterator, GetBaseIterator, FlatSetConstIterator)
+	};
+
+	struct IteratorProxy : public Iterator
+	{
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(Iterator)
+	};
+
+public:
+	FlatMap()
+		: FlatMap(TreeTraits())
+	{
+	}
+
+	explicit FlatMap(const TreeTraits& treeTraits, MemManager&& memManager = MemManager())
+		: mFlatSet(treeTraits, std::move(memManager))
+	{
+	}
+
+	template<typename Pair = std::pair<Key, Value>>
+	FlatMap(std::initializer_list<Pair> pairs, const TreeTraits& treeTraits = TreeTraits(),
+		MemManager&& memManager = MemManager())
+		: FlatMap(treeTraits, std::move(memManager))
+	{
+		Insert(pairs.begin(), pairs.end());
+	}
+
+	FlatMap(FlatMap&& flatMap) noexcept
+		: mFlatSet(std::move(flatMap.mFlatSet))
+	{
+	}
+
+	FlatMap(const FlatMap& flatMap)
+		: mFlatSet(flatMap.mFlatSet)
+	{
+	}
+
+	FlatMap(const FlatMap& flatMap, MemManager&& memManager)
+		: mFlatSet(flatMap.mFlatSet, std::move(memManager))
+	{
+	}
+
+	~FlatMap() noexcept
+	{
+	}
+
+	FlatMap& operator=(FlatMap&& flatMap) noexcept
+	{
+		FlatMap(std::move(flatMap)).Swap(*this);
+		return *this;
+	}
+
+	FlatMap& operator=(const FlatMap& flatMap)
+	{
+		if (this != &flatMap)
+			FlatMap(flatMap).Swap(*this);
+		return *this;
+	}
+
+	void Swap(FlatMap& flatMap) noexcept
+	{
+		mFlatSet.Swap(flatMap.mFlatSet);
+	}
+
+	ConstIterator GetBegin() const noexcept
+	{
+		return ConstIteratorProxy(mFlatSet.GetBegin());
+	}
+
+	Iterator GetBegin() noexcept
+	{
+		return IteratorProxy(mFlatSet.GetBegin());
+	}
+
+	ConstIterator GetEnd() const noexcept
+	{
+		return ConstIteratorProxy(mFlatSet.GetEnd());
+	}
+
+	Iterator GetEnd() noexcept
+	{
+		return IteratorProxy(mFlatSet.GetEnd());
+	}
+
+	MOMO_FRIEND_SWAP(FlatMap)
+	MOMO_FRIENDS_BEGIN_END(const FlatMap&, ConstIterator)
+	MOMO_FRIENDS_BEGIN_END(FlatMap&, Iterator)
+
+	const TreeTraits& GetTreeTraits() const noexcept
+	{
+		return mFlatSet.GetTreeTraits();
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mFlatSet.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mFlatSet.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mFlatSet.GetCount();
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return mFlatSet.IsEmpty();
+	}
+
+	void Clear(bool shrink = true) noexcept
+	{
+		mFlatSet.Clear(shrink);
+	}
+
+	size_t GetCapacity() const noexcept
+	{
+		return mFlatSet.GetCapacity();
+	}
+
+	void Reserve(size_t capacity)
+	{
+		mFlatSet.Reserve(capacity);
+	}
+
+	void Shrink()
+	{
+		mFlatSet.Shrink();
+	}
+
+	ConstIterator GetLowerBound(const Key& key) const
+	{
+		return ConstIteratorProxy(mFlatSet.GetLowerBound(key));
+	}
+
+	Iterator GetLowerBound(const Key& key)
+	{
+		return IteratorProxy(mFlatSet.GetLowerBound(key));
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, ConstIterator> GetLowerBound(
+		const KeyArg& key) const
+	{
+		return ConstIteratorProxy(mFlatSet.GetLowerBound(key));
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, Iterator> GetLowerBound(const KeyArg& key)
+	{
+		return IteratorProxy(mFlatSet.GetLowerBound(key));
+	}
+
+	ConstIterator GetUpperBound(const Key& key) const
+	{
+		return ConstIteratorProxy(mFlatSet.GetUpperBound(key));
+	}
+
+	Iterator GetUpperBound(const Key& key)
+	{
+		return IteratorProxy(mFlatSet.GetUpperBound(key));
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, ConstIterator> GetUpperBound(
+		const KeyArg& key) const
+	{
+		return ConstIteratorProxy(mFlatSet.GetUpperBound(key));
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, Iterator> GetUpperBound(const KeyArg& key)
+	{
+		return IteratorProxy(mFlatSet.GetUpperBound(key));
+	}
+
+	ConstIterator Find(const Key& key) const
+	{
+		return ConstIteratorProxy(mFlatSet.Find(key));
+	}
+
+	Iterator Find(const Key& key)
+	{
+		return IteratorProxy(mFlatSet.Find(key));
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, ConstIterator> Find(const KeyArg& key) const
+	{
+		return ConstIteratorProxy(mFlatSet.Find(key));
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, Iterator> Find(const KeyArg& key)
+	{
+		return IteratorProxy(mFlatSet.Find(key));
+	}
+
+	bool ContainsKey(const Key& key) const
+	{
+		return mFlatSet.ContainsKey(key);
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, bool> ContainsKey(const KeyArg& key) const
+	{
+		return mFlatSet.ContainsKey(key);
+	}
+
+	template<typename... ValueArgs>
+	InsertResult InsertVar(Key&& key, ValueArgs&&... valueArgs)
+	{
+		return pvInsert(std::move(key), std::forward<ValueArgs>(valueArgs)...);
+	}
+
+	InsertResult Insert(Key&& key, Value&& value)
+	{
+		return InsertVar(std::move(key), std::move(value));
+	}
+
+	InsertResult Insert(Key&& key, const Value& value)
+	{
+		return InsertVar(std::move(key), value);
+	}
+
+	template<typename... ValueArgs>
+	InsertResult InsertVar(const Key& key, ValueArgs&&... valueArgs)
+	{
+		return pvInsert(key, std::forward<ValueArgs>(valueArgs)...);
+	}
+
+	InsertResult Insert(const Key& key, Value&& value)
+	{
+		return InsertVar(key, std::move(value));
+	}
+
+	InsertResult Insert(const Key& key, const Value& value)
+	{
+		return InsertVar(key, value);
+	}
+
+	template<typename ArgIterator,
+		typename = decltype(internal::MapPairConverter<ArgIterator>::Convert(*ArgIterator()))>
+	size_t Insert(ArgIterator begin, ArgIterator end)
+	{
+		return mFlatSet.Insert(begin, end);
+	}
+
+	Iterator Remove(ConstIterator iter)
+	{
+		return IteratorProxy(mFlatSet.Remove(ConstIteratorProxy::GetBaseIterator(iter)));
+	}
+
+	Iterator Remove(ConstIterator begin, ConstIterator end)
+	{
+		return IteratorProxy(mFlatSet.Remove(ConstIteratorProxy::GetBaseIterator(begin),
+			ConstIteratorProxy::GetBaseIterator(end)));
+	}
+
+	size_t Remove(const Key& key)
+	{
+		return mFlatSet.Remove(key);
+	}
+
+	Iterator MakeMutableIterator(ConstIterator iter)
+	{
+		CheckIterator(iter);
+		return IteratorProxy(ConstIteratorProxy::GetBaseIterator(iter));
+	}
+
+	void CheckIterator(ConstIterator iter, bool allowEmpty = true) const
+	{
+		mFlatSet.CheckIterator(ConstIteratorProxy::GetBaseIterator(iter), allowEmpty);
+	}
+
+private:
+	template<typename RKey, typename... ValueArgs>
+	InsertResult pvInsert(RKey&& key, ValueArgs&&... valueArgs)
+	{
+		typename FlatSet::InsertResult res = mFlatSet.InsertVar(static_cast<const Key&>(key),
+			std::forward<RKey>(key), std::forward<ValueArgs>(valueArgs)...);
+		return { IteratorProxy(res.iterator), res.inserted };
+	}
+
+private:
+	FlatSet mFlatSet;
+};
+
+} // namespace momo
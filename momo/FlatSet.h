@@ -0,0 +1,523 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/FlatSet.h
+
+  namespace momo:
+    class FlatSetItemTraits
+    class FlatSetSettings
+    class FlatSet
+
+  `FlatSet` keeps its items sorted in one `Array`. Search is a branchless
+  binary search, iteration is a pass over contiguous memory. Insertion
+  and removal of one item shift the tail of the array, so they are O(n).
+
+  Function `Insert` receiving many items appends them to the array,
+  sorts the appended part (radix sort for integral keys and default
+  comparison, `std::sort` otherwise), drops duplicates and then merges
+  both parts by `Array::InsertSorted` in one backward pass. If items are
+  nothrow relocatable, the merge relocates whole runs of items (`memmove`
+  for trivially relocatable ones), so k items are inserted
+  in O(k log(n + k) + n).
+
+  All `FlatSet` functions and constructors have strong exception safety,
+  but not the following cases:
+  1. If `ItemTraits::isNothrowRelocatable` is false, function `Insert`
+    receiving many items has basic exception safety: the set is cleared
+    if the final merge throws exception.
+  2. Functions `Insert` and `Remove` receiving one item have basic
+    exception safety if item move assignment can throw.
+
+  All iterators and references become invalid after any insertion or
+  removal of the item.
+
+\**********************************************************/
+
+#pragma once
+
+#include "Array.h"
+#include "TreeTraits.h"
+#include "RadixSorter.h"
+
+namespace momo
+{
+
+namespace internal
+{
+	template<typename TTreeTraits>
+	struct FlatSetIsRadixSortable : public std::false_type
+	{
+	};
+
+	template<typename Key, typename TreeNode, bool useLinearSearch>
+	struct FlatSetIsRadixSortable<TreeTraits<Key, false, TreeNode, useLinearSearch>>
+		: public BoolConstant<std::is_integral<Key>::value>
+	{
+	};
+
+	template<typename Key, typename TreeNode>
+	struct FlatSetIsRadixSortable<TreeTraitsStd<Key, std::less<Key>, false, TreeNode>>
+		: public BoolConstant<std::is_integral<Key>::value>
+	{
+	};
+
+	template<typename TItemTraits>
+	class FlatSetRadixCodeGetter
+	{
+	private:
+		typedef TItemTraits ItemTraits;
+		typedef typename ItemTraits::Key Key;
+
+	public:
+		typedef typename UIntSelector<sizeof(Key)>::UInt Code;
+
+	public:
+		template<typename Iterator>
+		Code operator()(Iterator iter) const noexcept
+		{
+			Code code = static_cast<Code>(ItemTraits::GetKey(*iter));
+			if (std::is_signed<Key>::value)
+				code = static_cast<Code>(code ^ (Code{1} << (8 * sizeof(Code) - 1)));
+			return code;
+		}
+	};
+}
+
+template<typename TKey, typename TMemManager>
+class FlatSetItemTraits : public ArrayItemTraits<TKey, TMemManager>
+{
+public:
+	typedef TKey Key;
+	typedef TKey Item;
+
+public:
+	static const Key& GetKey(const Item& item) noexcept
+	{
+		return item;
+	}
+};
+
+class FlatSetSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+	static const ExtraCheckMode extraCheckMode = ExtraCheckMode::bydefault;
+
+	typedef ArraySettings<> ItemsSettings;
+};
+
+template<typename TKey,
+	typename TTreeTraits = TreeTraits<TKey>,
+	typename TMemManager = MemManagerDefault,
+	typename TItemTraits = FlatSetItemTraits<TKey, TMemManager>,
+	typename TSettings = FlatSetSettings>
+class FlatSet
+{
+public:
+	typedef TKey Key;
+	typedef TTreeTraits TreeTraits;
+	typedef TMemManager MemManager;
+	typedef TItemTraits ItemTraits;
+	typedef TSettings Settings;
+	typedef typename ItemTraits::Item Item;
+
+	MOMO_STATIC_ASSERT(!TreeTraits::multiKey);
+
+	typedef const Item* ConstIterator;
+	typedef ConstIterator Iterator;
+
+	typedef internal::InsertResult<ConstIterator> InsertResult;
+
+private:
+	typedef Array<Item, MemManager, ItemTraits,
+		internal::NestedArraySettings<typename Settings::ItemsSettings>> Items;
+
+	typedef internal::UIntMath<> SMath;
+
+	template<typename... ItemArgs>
+	using Creator = typename ItemTraits::template Creator<ItemArgs...>;
+
+	template<typename KeyArg>
+	struct IsValidKeyArg : public TreeTraits::template IsValidKeyArg<KeyArg>
+	{
+	};
+
+	static const bool isNothrowRelocatable = ItemTraits::isNothrowRelocatable;
+
+	static const bool isRadixSortable = internal::FlatSetIsRadixSortable<TreeTraits>::value;
+
+public:
+	FlatSet()
+		: FlatSet(TreeTraits())
+	{
+	}
+
+	explicit FlatSet(const TreeTraits& treeTraits, MemManager&& memManager = MemManager())
+		: mTreeTraits(treeTraits),
+		mItems(std::move(memManager))
+	{
+	}
+
+	FlatSet(std::initializer_list<Item> items, const TreeTraits& treeTraits = TreeTraits(),
+		MemManager&& memManager = MemManager())
+		: FlatSet(treeTraits, std::move(memManager))
+	{
+		Insert(items);
+	}
+
+	FlatSet(FlatSet&& flatSet) noexcept
+		: mTreeTraits(std::move(flatSet.mTreeTraits)),
+		mItems(std::move(flatSet.mItems))
+	{
+	}
+
+	FlatSet(const FlatSet& flatSet)
+		: mTreeTraits(flatSet.mTreeTraits),
+		mItems(flatSet.mItems)
+	{
+	}
+
+	FlatSet(const FlatSet& flatSet, MemManager&& memManager)
+		: mTreeTraits(flatSet.mTreeTraits),
+		mItems(flatSet.mItems, std::move(memManager))
+	{
+	}
+
+	~FlatSet() noexcept
+	{
+	}
+
+	FlatSet& operator=(FlatSet&& flatSet) noexcept
+	{
+		FlatSet(std::move(flatSet)).Swap(*this);
+		return *this;
+	}
+
+	FlatSet& operator=(const FlatSet& flatSet)
+	{
+		if (this != &flatSet)
+			FlatSet(flatSet).Swap(*this);
+		return *this;
+	}
+
+	void Swap(FlatSet& flatSet) noexcept
+	{
+		std::swap(mTreeTraits, flatSet.mTreeTraits);
+		mItems.Swap(flatSet.mItems);
+	}
+
+	ConstIterator GetBegin() const noexcept
+	{
+		return mItems.GetItems();
+	}
+
+	ConstIterator GetEnd() const noexcept
+	{
+		return mItems.GetItems() + mItems.GetCount();
+	}
+
+	MOMO_FRIEND_SWAP(FlatSet)
+	MOMO_FRIENDS_BEGIN_END(const FlatSet&, ConstIterator)
+
+	const TreeTraits& GetTreeTraits() const noexcept
+	{
+		return mTreeTraits;
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mItems.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mItems.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mItems.GetCount();
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return mItems.IsEmpty();
+	}
+
+	void Clear(bool shrink = true) noexcept
+	{
+		mItems.Clear(shrink);
+	}
+
+	size_t GetCapacity() const noexcept
+	{
+		return mItems.GetCapacity();
+	}
+
+	void Reserve(size_t capacity)
+	{
+		mItems.Reserve(capacity);
+	}
+
+	void Shrink()
+	{
+		mItems.Shrink();
+	}
+
+	const Item& operator[](size_t index) const
+	{
+		return mItems[index];
+	}
+
+	ConstIterator GetLowerBound(const Key& key) const
+	{
+		return pvGetLowerBound(GetBegin(), GetCount(), key);
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, ConstIterator> GetLowerBound(
+		const KeyArg& key) const
+	{
+		return pvGetLowerBound(GetBegin(), GetCount(), key);
+	}
+
+	ConstIterator GetUpperBound(const Key& key) const
+	{
+		return pvGetUpperBound(key);
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, ConstIterator> GetUpperBound(
+		const KeyArg& key) const
+	{
+		return pvGetUpperBound(key);
+	}
+
+	ConstIterator Find(const Key& key) const
+	{
+		return pvFind(key);
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, ConstIterator> Find(const KeyArg& key) const
+	{
+		return pvFind(key);
+	}
+
+	bool ContainsKey(const Key& key) const
+	{
+		return pvFind(key) != GetEnd();
+	}
+
+	template<typename KeyArg>
+	internal::EnableIf<IsValidKeyArg<KeyArg>::value, bool> ContainsKey(const KeyArg& key) const
+	{
+		return pvFind(key) != GetEnd();
+	}
+
+	template<typename ItemCreator>
+	InsertResult InsertCrt(const Key& key, ItemCreator&& itemCreator)
+	{
+		ConstIterator iter = GetLowerBound(key);
+		if (!pvIsGreater(iter, key))
+			return { iter, false };
+		size_t index = SMath::Dist(GetBegin(), iter);
+		mItems.InsertCrt(index, std::forward<ItemCreator>(itemCreator));
+		return { GetBegin() + index, true };
+	}
+
+	template<typename... ItemArgs>
+	InsertResult InsertVar(const Key& key, ItemArgs&&... itemArgs)
+	{
+		return InsertCrt(key,
+			Creator<ItemArgs...>(GetMemManager(), std::forward<ItemArgs>(itemArgs)...));
+	}
+
+	InsertResult Insert(Item&& item)
+	{
+		return InsertVar(ItemTraits::GetKey(static_cast<const Item&>(item)), std::move(item));
+	}
+
+	InsertResult Insert(const Item& item)
+	{
+		return InsertVar(ItemTraits::GetKey(item), item);
+	}
+
+	template<typename ArgIterator,
+		typename = typename std::iterator_traits<ArgIterator>::iterator_category>
+	size_t Insert(ArgIterator begin, ArgIterator end)
+	{
+		typedef Creator<typename std::iterator_traits<ArgIterator>::reference> IterCreator;
+		size_t initCount = GetCount();
+		try
+		{
+			for (ArgIterator iter = begin; iter != end; ++iter)
+				mItems.AddBackCrt(IterCreator(GetMemManager(), *iter));
+			pvPrepareBack(initCount);
+		}
+		catch (...)
+		{
+			mItems.RemoveBack(GetCount() - initCount);
+			throw;
+		}
+		size_t addCount = GetCount() - initCount;
+		pvInsertBack(addCount);
+		return addCount;
+	}
+
+	size_t Insert(std::initializer_list<Item> items)
+	{
+		return Insert(items.begin(), items.end());
+	}
+
+	ConstIterator Remove(ConstIterator iter)
+	{
+		MOMO_CHECK(iter != GetEnd());
+		return Remove(iter, std::next(iter));
+	}
+
+	ConstIterator Remove(ConstIterator begin, ConstIterator end)
+	{
+		CheckIterator(begin);
+		CheckIterator(end);
+		MOMO_CHECK(begin <= end);
+		size_t index = SMath::Dist(GetBegin(), begin);
+		if (begin != end)
+			mItems.Remove(index, SMath::Dist(begin, end));
+		return GetBegin() + index;
+	}
+
+	size_t Remove(const Key& key)
+	{
+		ConstIterator iter = Find(key);
+		if (iter == GetEnd())
+			return 0;
+		Remove(iter);
+		return 1;
+	}
+
+	void CheckIterator(ConstIterator iter, bool allowEmpty = true) const
+	{
+		MOMO_CHECK(GetBegin() <= iter && iter <= GetEnd());
+		MOMO_CHECK(allowEmpty || iter != GetEnd());
+	}
+
+private:
+	template<typename KeyArg1, typename KeyArg2>
+	bool pvIsLess(const KeyArg1& key1, const KeyArg2& key2) const
+	{
+		return mTreeTraits.IsLess(key1, key2);
+	}
+
+	template<typename KeyArg>
+	bool pvIsGreater(ConstIterator iter, const KeyArg& key) const
+	{
+		return iter == GetEnd() || pvIsLess(key, ItemTraits::GetKey(*iter));
+	}
+
+	template<typename KeyArg>
+	ConstIterator pvGetLowerBound(ConstIterator begin, size_t count, const KeyArg& key) const
+	{
+		if (count == 0)
+			return begin;
+		while (count > 1)
+		{
+			size_t half = count / 2;
+			begin += pvIsLess(ItemTraits::GetKey(begin[half]), key) ? half : 0;
+			count -= half;
+		}
+		return begin + (pvIsLess(ItemTraits::GetKey(*begin), key) ? 1 : 0);
+	}
+
+	template<typename KeyArg>
+	ConstIterator pvGetUpperBound(const KeyArg& key) const
+	{
+		ConstIterator begin = GetBegin();
+		size_t count = GetCount();
+		if (count == 0)
+			return begin;
+		while (count > 1)
+		{
+			size_t half = count / 2;
+			begin += pvIsLess(key, ItemTraits::GetKey(begin[half])) ? 0 : half;
+			count -= half;
+		}
+		return begin + (pvIsLess(key, ItemTraits::GetKey(*begin)) ? 0 : 1);
+	}
+
+	template<typename KeyArg>
+	ConstIterator pvFind(const KeyArg& key) const
+	{
+		ConstIterator iter = pvGetLowerBound(GetBegin(), GetCount(), key);
+		return pvIsGreater(iter, key) ? GetEnd() : iter;
+	}
+
+	void pvPrepareBack(size_t initCount)
+	{
+		Item* items = mItems.GetItems();
+		size_t count = GetCount();
+		if (count == initCount)
+			return;
+		pvSort(items + initCount, count - initCount, internal::BoolConstant<isRadixSortable>());
+		// duplicates and keys which are already in the set are dropped
+		size_t newCount = initCount;
+		size_t position = 0;
+		for (size_t i = initCount; i < count; ++i)
+		{
+			const Key& key = ItemTraits::GetKey(items[i]);
+			if (newCount > initCount && !pvIsLess(ItemTraits::GetKey(items[newCount - 1]), key))
+				continue;
+			position = SMath::Dist(static_cast<ConstIterator>(items),
+				pvGetLowerBound(items + position, initCount - position, key));
+			if (position < initCount && !pvIsLess(key, ItemTraits::GetKey(items[position])))
+				continue;
+			if (newCount != i)
+				ItemTraits::Assign(GetMemManager(), std::move(items[i]), items[newCount]);
+			++newCount;
+		}
+		mItems.RemoveBack(count - newCount);
+	}
+
+	void pvSort(Item* items, size_t count, std::true_type /*isRadixSortable*/)
+	{
+		internal::RadixSorter<>::Sort(items, count, internal::FlatSetRadixCodeGetter<ItemTraits>());
+	}
+
+	void pvSort(Item* items, size_t count, std::false_type /*isRadixSortable*/)
+	{
+		auto lessFunc = [this] (const Item& item1, const Item& item2)
+			{ return pvIsLess(ItemTraits::GetKey(item1), ItemTraits::GetKey(item2)); };
+		std::sort(items, items + count, lessFunc);
+	}
+
+	void pvInsertBack(size_t addCount)
+	{
+		auto lessFunc = [this] (const Item& item1, const Item& item2)
+			{ return pvIsLess(ItemTraits::GetKey(item1), ItemTraits::GetKey(item2)); };
+		if (isNothrowRelocatable)
+		{
+			// on exception the added items are removed
+			mItems.InsertSorted(addCount, lessFunc);
+			return;
+		}
+		try
+		{
+			mItems.InsertSorted(addCount, lessFunc);
+		}
+		catch (...)
+		{
+			// the order of items is unknown
+			mItems.Clear(false);
+			throw;
+		}
+	}
+
+private:
+	TreeTraits mTreeTraits;
+	Items mItems;
+};
+
+} // namespace momo
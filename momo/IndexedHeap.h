@@ -0,0 +1,488 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/IndexedHeap.h
+
+  namespace momo:
+    class IndexedHeapSettings
+    class IndexedHeap
+
+  `IndexedHeap` is a priority queue based on a d-ary heap (4-ary by
+  default) stored in `Array`. The top item is the least one according
+  to `LessFunc`. Every added item gets a handle, which stays valid
+  until the item is removed, so that the item can be changed (`Update`,
+  both decrease-key and increase-key) or removed in O(log(n)) time.
+  Handles are indexes in a dense array of heap positions, and removed
+  handles are reused.
+  Sift moves an item along its path only once: the other items are
+  relocated into the hole one by one, and all comparisons are made
+  before the first relocation.
+  Function `PushMany` adds the items and then either sifts up each of
+  them or, if the heap grows at least twice, rebuilds the heap in O(n).
+
+  All `IndexedHeap` functions and constructors have strong exception
+  safety, but not the following cases:
+  1. If function `PushMany` throws exception when rebuilding the heap,
+    the heap is cleared.
+  2. If any constructor throws exception, input argument `memManager`
+    may be changed.
+
+  Item type must be nothrow relocatable.
+
+\**********************************************************/
+
+#pragma once
+
+#include "Array.h"
+
+namespace momo
+{
+
+template<size_t tArity = 4>
+class IndexedHeapSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+
+	static const size_t arity = tArity;
+};
+
+template<typename TItem,
+	typename TLessFunc = std::less<TItem>,
+	typename TMemManager = MemManagerDefault,
+	typename TItemTraits = ArrayItemTraits<TItem, TMemManager>,
+	typename TSettings = IndexedHeapSettings<>>
+class IndexedHeap
+{
+public:
+	typedef TItem Item;
+	typedef TLessFunc LessFunc;
+	typedef TMemManager MemManager;
+	typedef TItemTraits ItemTraits;
+	typedef TSettings Settings;
+
+	typedef size_t Handle;
+
+	static const size_t arity = Settings::arity;
+	MOMO_STATIC_ASSERT(arity >= 2);
+
+	MOMO_STATIC_ASSERT(ItemTraits::isNothrowRelocatable);
+
+private:
+	typedef Array<Item, MemManager, ItemTraits, internal::NestedArraySettings<>> Items;
+	typedef Array<size_t, MemManager, ArrayItemTraits<size_t, MemManager>,
+		internal::NestedArraySettings<>> Indexes;
+
+	typedef internal::ObjectBuffer<Item, ItemTraits::alignment> ItemBuffer;
+
+	static const size_t freeMark = ~(SIZE_MAX >> 1);	// in `mPositions` of removed handles
+	static const size_t nullHandle = SIZE_MAX >> 1;
+
+	static const size_t maxDepth = 8 * sizeof(size_t);
+
+public:
+	typedef typename Items::ConstIterator ConstIterator;
+
+public:
+	IndexedHeap()
+		: IndexedHeap(LessFunc())
+	{
+	}
+
+	explicit IndexedHeap(const LessFunc& lessFunc, MemManager&& memManager = MemManager())
+		: mLessFunc(lessFunc),
+		mItems(MemManager(memManager)),
+		mHandles(MemManager(memManager)),
+		mPositions(std::move(memManager)),
+		mFreeHandle(nullHandle)
+	{
+	}
+
+	IndexedHeap(IndexedHeap&& heap) noexcept
+		: mLessFunc(std::move(heap.mLessFunc)),
+		mItems(std::move(heap.mItems)),
+		mHandles(std::move(heap.mHandles)),
+		mPositions(std::move(heap.mPositions)),
+		mFreeHandle(heap.mFreeHandle)
+	{
+		heap.mFreeHandle = nullHandle;
+	}
+
+	IndexedHeap(const IndexedHeap& heap)
+		: mLessFunc(heap.mLessFunc),
+		mItems(heap.mItems),
+		mHandles(heap.mHandles),
+		mPositions(heap.mPositions),
+		mFreeHandle(heap.mFreeHandle)
+	{
+	}
+
+	~IndexedHeap() noexcept
+	{
+	}
+
+	IndexedHeap& operator=(IndexedHeap&& heap) noexcept
+	{
+		IndexedHeap(std::move(heap)).Swap(*this);
+		return *this;
+	}
+
+	IndexedHeap& operator=(const IndexedHeap& heap)
+	{
+		if (this != &heap)
+			IndexedHeap(heap).Swap(*this);
+		return *this;
+	}
+
+	void Swap(IndexedHeap& heap) noexcept
+	{
+		std::swap(mLessFunc, heap.mLessFunc);
+		mItems.Swap(heap.mItems);
+		mHandles.Swap(heap.mHandles);
+		mPositions.Swap(heap.mPositions);
+		std::swap(mFreeHandle, heap.mFreeHandle);
+	}
+
+	ConstIterator GetBegin() const noexcept
+	{
+		return mItems.GetBegin();
+	}
+
+	ConstIterator GetEnd() const noexcept
+	{
+		return mItems.GetEnd();
+	}
+
+	MOMO_FRIEND_SWAP(IndexedHeap)
+	MOMO_FRIENDS_BEGIN_END(const IndexedHeap&, ConstIterator)
+
+	const LessFunc& GetLessFunc() const noexcept
+	{
+		return mLessFunc;
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mItems.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mItems.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mItems.GetCount();
+	}
+
+	MOMO_NODISCARD bool IsEmpty() const noexcept
+	{
+		return mItems.IsEmpty();
+	}
+
+	void Clear(bool shrink = false) noexcept
+	{
+		mItems.Clear(shrink);
+		mHandles.Clear(shrink);
+		mPositions.Clear(shrink);
+		mFreeHandle = nullHandle;
+	}
+
+	void Reserve(size_t capacity)
+	{
+		mItems.Reserve(capacity);
+		mHandles.Reserve(capacity);
+		mPositions.Reserve(capacity);
+	}
+
+	const Item& GetTop() const
+	{
+		MOMO_CHECK(!IsEmpty());
+		return mItems[0];
+	}
+
+	Handle GetTopHandle() const
+	{
+		MOMO_CHECK(!IsEmpty());
+		return mHandles[0];
+	}
+
+	bool ContainsHandle(Handle handle) const noexcept
+	{
+		return handle < mPositions.GetCount() && (mPositions[handle] & freeMark) == 0;
+	}
+
+	const Item& GetItem(Handle handle) const
+	{
+		MOMO_CHECK(ContainsHandle(handle));
+		return mItems[mPositions[handle]];
+	}
+
+	template<typename ItemCreator>
+	Handle PushCrt(ItemCreator&& itemCreator)
+	{
+		Handle handle = pvAddBack(std::forward<ItemCreator>(itemCreator));
+		size_t index = GetCount() - 1;
+		size_t path[maxDepth];
+		size_t depth;
+		try
+		{
+			depth = pvFindUpPath(index, mItems[index], path);
+		}
+		catch (...)
+		{
+			pvRemoveBack();
+			throw;
+		}
+		pvMove(index, path, depth);
+		return handle;
+	}
+
+	template<typename... ItemArgs>
+	Handle PushVar(ItemArgs&&... itemArgs)
+	{
+		return PushCrt(typename ItemTraits::template Creator<ItemArgs...>(GetMemManager(),
+			std::forward<ItemArgs>(itemArgs)...));
+	}
+
+	Handle Push(Item&& item)
+	{
+		return PushVar(std::move(item));
+	}
+
+	Handle Push(const Item& item)
+	{
+		return PushVar(item);
+	}
+
+	template<typename ArgIterator>
+	void PushMany(ArgIterator begin, ArgIterator end)
+	{
+		pvPushMany(begin, end, [] (Handle) {});
+	}
+
+	template<typename ArgIterator, typename HandleIterator>
+	HandleIterator PushMany(ArgIterator begin, ArgIterator end, HandleIterator handles)
+	{
+		pvPushMany(begin, end, [&handles] (Handle handle) { *handles++ = handle; });
+		return handles;
+	}
+
+	template<typename ItemArg>
+	void Update(Handle handle, ItemArg&& itemArg)
+	{
+		MOMO_CHECK(ContainsHandle(handle));
+		size_t index = mPositions[handle];
+		MemManager& memManager = GetMemManager();
+		ItemBuffer itemBuffer;
+		(typename ItemTraits::template Creator<ItemArg>(memManager,
+			std::forward<ItemArg>(itemArg)))(&itemBuffer);
+		size_t path[maxDepth];
+		size_t depth;
+		try
+		{
+			depth = pvFindPath(index, *&itemBuffer, GetCount(), path);
+		}
+		catch (...)
+		{
+			ItemTraits::Destroy(memManager, &itemBuffer, 1);
+			throw;
+		}
+		ItemTraits::Destroy(memManager, mItems.GetItems() + index, 1);
+		pvPlace(pvShift(index, path, depth), &itemBuffer, handle);
+	}
+
+	void Remove(Handle handle)
+	{
+		MOMO_CHECK(ContainsHandle(handle));
+		size_t index = mPositions[handle];
+		size_t lastIndex = GetCount() - 1;
+		if (index < lastIndex)
+		{
+			Item* items = mItems.GetItems();
+			size_t path[maxDepth];
+			size_t depth = pvFindPath(index, items[lastIndex], lastIndex, path);
+			ItemBuffer itemBuffer;
+			ItemTraits::Relocate(GetMemManager(), items + index, &itemBuffer, 1);
+			Handle lastHandle = mHandles[lastIndex];
+			pvPlace(pvShift(index, path, depth), items + lastIndex, lastHandle);
+			ItemTraits::Relocate(GetMemManager(), &itemBuffer, items + lastIndex, 1);
+			mHandles[lastIndex] = handle;
+		}
+		pvRemoveBack();
+	}
+
+	void RemoveTop()
+	{
+		Remove(GetTopHandle());
+	}
+
+private:
+	bool pvIsLess(const Item& item1, const Item& item2) const
+	{
+		return mLessFunc(item1, item2);
+	}
+
+	template<typename ItemCreator>
+	Handle pvAddBack(ItemCreator&& itemCreator)
+	{
+		size_t count = GetCount();
+		mItems.Reserve(count + 1);
+		mHandles.Reserve(count + 1);
+		if (mFreeHandle == nullHandle)
+			mPositions.Reserve(mPositions.GetCount() + 1);
+		mItems.AddBackNogrowCrt(std::forward<ItemCreator>(itemCreator));
+		Handle handle = mFreeHandle;
+		if (handle != nullHandle)
+		{
+			mFreeHandle = mPositions[handle] & ~freeMark;
+			mPositions[handle] = count;
+		}
+		else
+		{
+			handle = mPositions.GetCount();
+			mPositions.AddBackNogrow(count);
+		}
+		mHandles.AddBackNogrow(handle);
+		return handle;
+	}
+
+	void pvRemoveBack() noexcept
+	{
+		Handle handle = mHandles.GetBackItem();
+		mPositions[handle] = mFreeHandle | freeMark;
+		mFreeHandle = handle;
+		mHandles.RemoveBack();
+		mItems.RemoveBack();
+	}
+
+	template<typename ArgIterator, typename HandleFunc>
+	void pvPushMany(ArgIterator begin, ArgIterator end, const HandleFunc& handleFunc)
+	{
+		typedef typename ItemTraits::template Creator<
+			typename std::iterator_traits<ArgIterator>::reference> IterCreator;
+		size_t initCount = GetCount();
+		try
+		{
+			for (ArgIterator iter = begin; iter != end; ++iter)
+				handleFunc(pvAddBack(IterCreator(GetMemManager(), *iter)));
+		}
+		catch (...)
+		{
+			while (GetCount() > initCount)
+				pvRemoveBack();
+			throw;
+		}
+		size_t count = GetCount();
+		try
+		{
+			size_t path[maxDepth];
+			if (count - initCount >= initCount)
+			{
+				for (size_t i = (count > 1) ? (count - 2) / arity + 1 : 0; i > 0; --i)
+					pvMove(i - 1, path, pvFindDownPath(i - 1, mItems[i - 1], count, path));
+			}
+			else
+			{
+				for (size_t i = initCount; i < count; ++i)
+					pvMove(i, path, pvFindUpPath(i, mItems[i], path));
+			}
+		}
+		catch (...)
+		{
+			Clear();
+			throw;
+		}
+	}
+
+	// Path of the hole at `index` for `item` in the heap of `count` items, excluding `item`
+	size_t pvFindPath(size_t index, const Item& item, size_t count, size_t* path) const
+	{
+		size_t depth = pvFindUpPath(index, item, path);
+		if (depth > 0)
+			return depth;
+		return pvFindDownPath(index, item, count, path);
+	}
+
+	size_t pvFindUpPath(size_t index, const Item& item, size_t* path) const
+	{
+		size_t depth = 0;
+		while (index > 0)
+		{
+			size_t parentIndex = (index - 1) / arity;
+			if (!pvIsLess(item, mItems[parentIndex]))
+				break;
+			path[depth++] = parentIndex;
+			index = parentIndex;
+		}
+		MOMO_ASSERT(depth <= maxDepth);
+		return depth;
+	}
+
+	size_t pvFindDownPath(size_t index, const Item& item, size_t count, size_t* path) const
+	{
+		size_t depth = 0;
+		while (count > 1 && index <= (count - 2) / arity)
+		{
+			size_t childIndex = index * arity + 1;
+			size_t childEnd = std::minmax(childIndex + arity, count).first;
+			size_t bestIndex = childIndex;
+			for (++childIndex; childIndex < childEnd; ++childIndex)
+			{
+				if (pvIsLess(mItems[childIndex], mItems[bestIndex]))
+					bestIndex = childIndex;
+			}
+			if (!pvIsLess(mItems[bestIndex], item))
+				break;
+			path[depth++] = bestIndex;
+			index = bestIndex;
+		}
+		MOMO_ASSERT(depth <= maxDepth);
+		return depth;
+	}
+
+	void pvMove(size_t index, const size_t* path, size_t depth) noexcept
+	{
+		if (depth == 0)
+			return;
+		Handle handle = mHandles[index];
+		ItemBuffer itemBuffer;
+		ItemTraits::Relocate(GetMemManager(), mItems.GetItems() + index, &itemBuffer, 1);
+		pvPlace(pvShift(index, path, depth), &itemBuffer, handle);
+	}
+
+	size_t pvShift(size_t holeIndex, const size_t* path, size_t depth) noexcept
+	{
+		Item* items = mItems.GetItems();
+		for (size_t i = 0; i < depth; ++i)
+		{
+			size_t index = path[i];
+			ItemTraits::Relocate(GetMemManager(), items + index, items + holeIndex, 1);
+			Handle handle = mHandles[index];
+			mHandles[holeIndex] = handle;
+			mPositions[handle] = holeIndex;
+			holeIndex = index;
+		}
+		return holeIndex;
+	}
+
+	void pvPlace(size_t holeIndex, Item* item, Handle handle) noexcept
+	{
+		ItemTraits::Relocate(GetMemManager(), item, mItems.GetItems() + holeIndex, 1);
+		mHandles[holeIndex] = handle;
+		mPositions[handle] = holeIndex;
+	}
+
+private:
+	LessFunc mLessFunc;
+	Items mItems;
+	Indexes mHandles;	// by positions
+	Indexes mPositions;	// by handles
+	Handle mFreeHandle;
+};
+
+} // namespace momo
@@ -0,0 +1,698 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/LruCache.h
+
+  namespace momo:
+    enum class LruCachePolicy
+    class LruCacheSettings
+    class LruCache
+    class ClockCache
+    class ConcurrentLruCache
+
+  `LruCache` is a bounded key-value cache. Every entry has a size
+  (1 by default, so the bound is the number of entries, or the size in
+  bytes if the caller passes it). When the total size exceeds
+  `GetMaxSize()`, the entries are evicted in the order of the policy
+  and the eviction function is called for each of them. The entry
+  being inserted is never evicted, even if it is larger than the bound.
+  Entries are nodes of `MemPool`, linked into a ring, and the hash set
+  indexes pointers to them with cached hash codes, so a hit does not
+  allocate memory and the key is stored once. References returned by
+  `Find` and `Insert` stay valid until the entry is removed or evicted.
+  With `LruCachePolicy::lru` a hit moves the entry to the head of the
+  ring. With `LruCachePolicy::clock` (`ClockCache`) a hit only sets
+  the reference bit of the entry, and the clock hand gives a second
+  chance to referenced entries on eviction.
+
+  `ConcurrentLruCache` is a thread-safe wrapper, which splits the
+  entries among `shardCount` caches by the hash code of the key.
+  Each shard has its own mutex and a part of the maximum size.
+  The hash code of the key is computed once: it selects the shard and
+  is passed to the shard cache. Shards are constructed in place.
+  Values are returned by copy.
+
+  Exception safety of `Insert` is strong when a new entry is added
+  and basic when the value of an existing entry is assigned.
+  The eviction function must not throw exceptions.
+
+\**********************************************************/
+
+#pragma once
+
+#include "HashSet.h"
+#include "MemPool.h"
+
+#include <functional>
+#include <mutex>
+
+namespace momo
+{
+
+enum class LruCachePolicy
+{
+	lru = 0,
+	clock = 1,
+};
+
+template<LruCachePolicy tPolicy = LruCachePolicy::lru>
+class LruCacheSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+
+	static const LruCachePolicy policy = tPolicy;
+};
+
+namespace internal
+{
+	template<typename TKey, typename TValue>
+	class LruCacheNode
+	{
+	public:
+		typedef TKey Key;
+		typedef TValue Value;
+
+	public:
+		template<typename KeyArg, typename ValueArg>
+		explicit LruCacheNode(KeyArg&& keyArg, ValueArg&& valueArg, size_t hashCode, size_t size)
+			: prev(nullptr),
+			next(nullptr),
+			hashCode(hashCode),
+			size(size),
+			referenced(false),
+			key(std::forward<KeyArg>(keyArg)),
+			value(std::forward<ValueArg>(valueArg))
+		{
+		}
+
+		LruCacheNode(const LruCacheNode&) = delete;
+
+		LruCacheNode& operator=(const LruCacheNode&) = delete;
+
+	public:
+		LruCacheNode* prev;
+		LruCacheNode* next;
+		size_t hashCode;
+		size_t size;
+		bool referenced;
+		Key key;
+		Value value;
+	};
+
+	template<typename TKey>
+	struct LruCacheKey
+	{
+		const TKey* key;
+		size_t hashCode;
+	};
+
+	template<typename TNode, typename TKeyHashTraits>
+	class LruCacheHashTraits
+		: public HashTraits<TNode*, typename TKeyHashTraits::HashBucket>
+	{
+	public:
+		typedef TNode Node;
+		typedef TKeyHashTraits KeyHashTraits;
+
+		typedef LruCacheKey<typename Node::Key> Key;
+
+		template<typename KeyArg>
+		using IsValidKeyArg = std::is_same<KeyArg, Key>;
+
+		static const bool isFastNothrowHashable = true;
+
+	public:
+		explicit LruCacheHashTraits(const KeyHashTraits& keyHashTraits)
+			: mKeyHashTraits(keyHashTraits)
+		{
+		}
+
+		const KeyHashTraits& GetKeyHashTraits() const noexcept
+		{
+			return mKeyHashTraits;
+		}
+
+		size_t GetHashCode(const Node* node) const noexcept
+		{
+			return node->hashCode;
+		}
+
+		size_t GetHashCode(const Key& key) const noexcept
+		{
+			return key.hashCode;
+		}
+
+		bool IsEqual(const Node* node1, const Node* node2) const noexcept
+		{
+			return node1 == node2;
+		}
+
+		bool IsEqual(const Key& key1, const Node* node2) const
+		{
+			return key1.hashCode == node2->hashCode
+				&& mKeyHashTraits.IsEqual(*key1.key, node2->key);
+		}
+
+	private:
+		KeyHashTraits mKeyHashTraits;
+	};
+}
+
+template<typename TKey, typename TValue,
+	typename THashTraits = HashTraits<TKey>,
+	typename TMemManager = MemManagerDefault,
+	typename TSettings = LruCacheSettings<>>
+class LruCache
+{
+public:
+	typedef TKey Key;
+	typedef TValue Value;
+	typedef THashTraits HashTraits;
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+
+	typedef std::function<void(const Key&, Value&)> EvictFunc;
+
+	static const LruCachePolicy policy = Settings::policy;
+
+private:
+	typedef internal::LruCacheNode<Key, Value> Node;
+	typedef internal::LruCacheHashTraits<Node, HashTraits> NodeHashTraits;
+	typedef typename NodeHashTraits::Key NodeKey;
+
+	typedef HashSet<Node*, NodeHashTraits, MemManager> Nodes;
+
+	typedef MemPool<MemPoolParams<>, MemManager> NodePool;
+
+public:
+	explicit LruCache(size_t maxSize = SIZE_MAX)
+		: LruCache(maxSize, HashTraits())
+	{
+	}
+
+	explicit LruCache(size_t maxSize, const HashTraits& hashTraits,
+		MemManager&& memManager = MemManager())
+		: mNodePool(MemPoolParams<>(sizeof(Node), alignof(Node)), MemManager(memManager)),
+		mNodes(NodeHashTraits(hashTraits), std::move(memManager)),
+		mHand(nullptr),
+		mSize(0),
+		mMaxSize(maxSize)
+	{
+	}
+
+	LruCache(LruCache&& cache)
+		: mNodePool(std::move(cache.mNodePool)),
+		mNodes(std::move(cache.mNodes)),
+		mHand(cache.mHand),
+		mSize(cache.mSize),
+		mMaxSize(cache.mMaxSize),
+		mEvictFunc(std::move(cache.mEvictFunc))
+	{
+		cache.mHand = nullptr;
+		cache.mSize = 0;
+	}
+
+	LruCache(const LruCache&) = delete;
+
+	~LruCache() noexcept
+	{
+		pvDestroyNodes();
+	}
+
+	LruCache& operator=(LruCache&& cache)
+	{
+		if (this != &cache)
+		{
+			Clear();
+			mNodePool = std::move(cache.mNodePool);
+			mNodes = std::move(cache.mNodes);
+			mHand = cache.mHand;
+			mSize = cache.mSize;
+			mMaxSize = cache.mMaxSize;
+			mEvictFunc = std::move(cache.mEvictFunc);
+			cache.mHand = nullptr;
+			cache.mSize = 0;
+		}
+		return *this;
+	}
+
+	LruCache& operator=(const LruCache&) = delete;
+
+	const HashTraits& GetHashTraits() const noexcept
+	{
+		return mNodes.GetHashTraits().GetKeyHashTraits();
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mNodes.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mNodes.GetMemManager();
+	}
+
+	const EvictFunc& GetEvictFunc() const noexcept
+	{
+		return mEvictFunc;
+	}
+
+	void SetEvictFunc(EvictFunc evictFunc)
+	{
+		mEvictFunc = std::move(evictFunc);
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mNodes.GetCount();
+	}
+
+	MOMO_NODISCARD bool IsEmpty() const noexcept
+	{
+		return mNodes.IsEmpty();
+	}
+
+	size_t GetSize() const noexcept
+	{
+		return mSize;
+	}
+
+	size_t GetMaxSize() const noexcept
+	{
+		return mMaxSize;
+	}
+
+	void SetMaxSize(size_t maxSize)
+	{
+		mMaxSize = maxSize;
+		pvEvict(0);
+	}
+
+	void Clear() noexcept
+	{
+		pvDestroyNodes();
+		mNodes.Clear(true);
+		mHand = nullptr;
+		mSize = 0;
+	}
+
+	bool ContainsKey(const Key& key) const
+	{
+		return ptContainsKey(key, GetHashTraits().GetHashCode(key));
+	}
+
+	// Does not change the order of eviction
+	const Value* Peek(const Key& key) const
+	{
+		typename Nodes::ConstPosition pos = mNodes.Find(pvMakeKey(key));
+		return !!pos ? &(*pos)->value : nullptr;
+	}
+
+	Value* Find(const Key& key)
+	{
+		return ptFind(key, GetHashTraits().GetHashCode(key));
+	}
+
+	template<typename ValueArg>
+	Value& Insert(const Key& key, ValueArg&& valueArg, size_t size = 1)
+	{
+		return ptInsert(key, GetHashTraits().GetHashCode(key),
+			std::forward<ValueArg>(valueArg), size);
+	}
+
+	// The eviction function is not called
+	bool Remove(const Key& key)
+	{
+		return ptRemove(key, GetHashTraits().GetHashCode(key));
+	}
+
+protected:
+	// `hashCode` is `GetHashTraits().GetHashCode(key)` computed by the caller
+	bool ptContainsKey(const Key& key, size_t hashCode) const
+	{
+		return !!mNodes.Find(pvMakeKey(key, hashCode));
+	}
+
+	Value* ptFind(const Key& key, size_t hashCode)
+	{
+		typename Nodes::ConstPosition pos = mNodes.Find(pvMakeKey(key, hashCode));
+		if (!pos)
+			return nullptr;
+		Node* node = *pos;
+		pvTouch(node);
+		return &node->value;
+	}
+
+	template<typename ValueArg>
+	Value& ptInsert(const Key& key, size_t hashCode, ValueArg&& valueArg, size_t size)
+	{
+		NodeKey nodeKey = pvMakeKey(key, hashCode);
+		typename Nodes::ConstPosition pos = mNodes.Find(nodeKey);
+		if (!!pos)
+		{
+			Node* node = *pos;
+			node->value = std::forward<ValueArg>(valueArg);
+			pvUnlink(node);
+			mSize -= node->size;
+			node->size = size;
+			pvEvict(size);
+			pvLink(node);
+			mSize += size;
+			return node->value;
+		}
+		Node* node = mNodePool.template Allocate<Node>();
+		try
+		{
+			::new(static_cast<void*>(node)) Node(key, std::forward<ValueArg>(valueArg),
+				nodeKey.hashCode, size);
+		}
+		catch (...)
+		{
+			mNodePool.Deallocate(node);
+			throw;
+		}
+		try
+		{
+			mNodes.Add(pos, node);
+		}
+		catch (...)
+		{
+			pvDestroyNode(node);
+			throw;
+		}
+		pvEvict(size);
+		pvLink(node);
+		mSize += size;
+		return node->value;
+	}
+
+	bool ptRemove(const Key& key, size_t hashCode)
+	{
+		typename Nodes::ConstPosition pos = mNodes.Find(pvMakeKey(key, hashCode));
+		if (!pos)
+			return false;
+		Node* node = *pos;
+		mNodes.Remove(static_cast<typename Nodes::ConstIterator>(pos));
+		pvRemoveNode(node);
+		return true;
+	}
+
+private:
+	NodeKey pvMakeKey(const Key& key) const
+	{
+		return pvMakeKey(key, GetHashTraits().GetHashCode(key));
+	}
+
+	static NodeKey pvMakeKey(const Key& key, size_t hashCode) noexcept
+	{
+		return { std::addressof(key), hashCode };
+	}
+
+	void pvLink(Node* node) noexcept
+	{
+		// the new node is the last one for the clock hand
+		if (mHand == nullptr)
+		{
+			node->prev = node;
+			node->next = node;
+			mHand = node;
+		}
+		else
+		{
+			node->prev = mHand->prev;
+			node->next = mHand;
+			mHand->prev->next = node;
+			mHand->prev = node;
+		}
+	}
+
+	void pvUnlink(Node* node) noexcept
+	{
+		if (node->next == node)
+		{
+			mHand = nullptr;
+			return;
+		}
+		if (mHand == node)
+			mHand = node->next;
+		node->prev->next = node->next;
+		node->next->prev = node->prev;
+	}
+
+	void pvTouch(Node* node) noexcept
+	{
+		if (policy == LruCachePolicy::clock)
+		{
+			if (!node->referenced)
+				node->referenced = true;
+		}
+		else if (node == mHand)
+		{
+			mHand = node->next;
+		}
+		else if (node->next != mHand)
+		{
+			pvUnlink(node);
+			pvLink(node);
+		}
+	}
+
+	void pvEvict(size_t extraSize)
+	{
+		while (mHand != nullptr && (extraSize > mMaxSize || mSize > mMaxSize - extraSize))
+		{
+			Node* node = mHand;
+			if (policy == LruCachePolicy::clock)
+			{
+				while (node->referenced)
+				{
+					node->referenced = false;
+					node = node->next;
+				}
+				mHand = node;
+			}
+			mNodes.Remove(node);
+			if (mEvictFunc)
+				mEvictFunc(node->key, node->value);
+			pvRemoveNode(node);
+		}
+	}
+
+	void pvRemoveNode(Node* node) noexcept
+	{
+		pvUnlink(node);
+		mSize -= node->size;
+		pvDestroyNode(node);
+	}
+
+	void pvDestroyNode(Node* node) noexcept
+	{
+		node->~Node();
+		mNodePool.Deallocate(node);
+	}
+
+	void pvDestroyNodes() noexcept
+	{
+		for (Node* node : mNodes)
+			pvDestroyNode(node);
+	}
+
+private:
+	NodePool mNodePool;
+	Nodes mNodes;
+	Node* mHand;
+	size_t mSize;
+	size_t mMaxSize;
+	EvictFunc mEvictFunc;
+};
+
+template<typename TKey, typename TValue,
+	typename THashTraits = HashTraits<TKey>,
+	typename TMemManager = MemManagerDefault>
+using ClockCache = LruCache<TKey, TValue, THashTraits, TMemManager,
+	LruCacheSettings<LruCachePolicy::clock>>;
+
+template<typename TLruCache,
+	size_t tShardCount = 16>
+class ConcurrentLruCache
+{
+public:
+	typedef TLruCache Cache;
+	typedef typename Cache::Key Key;
+	typedef typename Cache::Value Value;
+	typedef typename Cache::HashTraits HashTraits;
+	typedef typename Cache::MemManager MemManager;
+	typedef typename Cache::EvictFunc EvictFunc;
+
+	static const size_t shardCount = tShardCount;
+	MOMO_STATIC_ASSERT(shardCount > 0);
+
+private:
+	struct Shard
+	{
+		explicit Shard(size_t maxSize, const HashTraits& hashTraits, MemManager&& memManager,
+			const EvictFunc& evictFunc)
+			: cache(maxSize, hashTraits, std::move(memManager))
+		{
+			cache.SetEvictFunc(evictFunc);
+		}
+
+		mutable std::mutex mutex;
+		Cache cache;
+	};
+
+	typedef internal::ObjectBuffer<Shard, internal::AlignmentOf<Shard>::value> ShardBuffer;
+
+	struct CacheProxy : public Cache
+	{
+		MOMO_DECLARE_PROXY_FUNCTION(Cache, ContainsKey, bool)
+		MOMO_DECLARE_PROXY_FUNCTION(Cache, Find, Value*)
+		MOMO_DECLARE_PROXY_FUNCTION(Cache, Remove, bool)
+
+		template<typename ValueArg>
+		static void Insert(Cache& cache, const Key& key, size_t hashCode,
+			ValueArg&& valueArg, size_t size)
+		{
+			typedef Value& (Cache::*InsertFunc)(const Key&, size_t, ValueArg&&, size_t);
+			InsertFunc insertFunc = &CacheProxy::template ptInsert<ValueArg>;
+			(cache.*insertFunc)(key, hashCode, std::forward<ValueArg>(valueArg), size);
+		}
+	};
+
+public:
+	explicit ConcurrentLruCache(size_t maxSize = SIZE_MAX)
+		: ConcurrentLruCache(maxSize, HashTraits())
+	{
+	}
+
+	explicit ConcurrentLruCache(size_t maxSize, const HashTraits& hashTraits,
+		const MemManager& memManager = MemManager(), const EvictFunc& evictFunc = EvictFunc())
+		: mHashTraits(hashTraits)
+	{
+		size_t shardMaxSize = (maxSize == SIZE_MAX) ? maxSize
+			: maxSize / shardCount + ((maxSize % shardCount != 0) ? 1 : 0);
+		size_t shardIndex = 0;
+		try
+		{
+			for (; shardIndex < shardCount; ++shardIndex)
+			{
+				::new(static_cast<void*>(&mShards[shardIndex])) Shard(shardMaxSize, hashTraits,
+					MemManager(memManager), evictFunc);
+			}
+		}
+		catch (...)
+		{
+			pvDestroyShards(shardIndex);
+			throw;
+		}
+	}
+
+	ConcurrentLruCache(const ConcurrentLruCache&) = delete;
+
+	~ConcurrentLruCache() noexcept
+	{
+		pvDestroyShards(shardCount);
+	}
+
+	ConcurrentLruCache& operator=(const ConcurrentLruCache&) = delete;
+
+	const HashTraits& GetHashTraits() const noexcept
+	{
+		return mHashTraits;
+	}
+
+	// The result may be outdated if other threads change the cache
+	size_t GetCount() const
+	{
+		size_t count = 0;
+		for (const ShardBuffer& shardBuffer : mShards)
+		{
+			const Shard& shard = *&shardBuffer;
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			count += shard.cache.GetCount();
+		}
+		return count;
+	}
+
+	void Clear()
+	{
+		for (ShardBuffer& shardBuffer : mShards)
+		{
+			Shard& shard = *&shardBuffer;
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.cache.Clear();
+		}
+	}
+
+	bool ContainsKey(const Key& key) const
+	{
+		size_t hashCode = mHashTraits.GetHashCode(key);
+		const Shard& shard = pvGetShard(hashCode);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		return CacheProxy::ContainsKey(shard.cache, key, hashCode);
+	}
+
+	bool Find(const Key& key, Value& value)
+	{
+		size_t hashCode = mHashTraits.GetHashCode(key);
+		Shard& shard = pvGetShard(hashCode);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		const Value* pvalue = CacheProxy::Find(shard.cache, key, hashCode);
+		if (pvalue == nullptr)
+			return false;
+		value = *pvalue;
+		return true;
+	}
+
+	template<typename ValueArg>
+	void Insert(const Key& key, ValueArg&& valueArg, size_t size = 1)
+	{
+		size_t hashCode = mHashTraits.GetHashCode(key);
+		Shard& shard = pvGetShard(hashCode);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		CacheProxy::Insert(shard.cache, key, hashCode, std::forward<ValueArg>(valueArg), size);
+	}
+
+	bool Remove(const Key& key)
+	{
+		size_t hashCode = mHashTraits.GetHashCode(key);
+		Shard& shard = pvGetShard(hashCode);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		return CacheProxy::Remove(shard.cache, key, hashCode);
+	}
+
+private:
+	static size_t pvGetShardIndex(size_t hashCode) noexcept
+	{
+		// the low bits of the hash code select buckets inside the shard
+		uint64_t mixedCode = uint64_t{hashCode} * 0x9e3779b97f4a7c15;
+		return static_cast<size_t>(mixedCode >> 32) % shardCount;
+	}
+
+	Shard& pvGetShard(size_t hashCode) noexcept
+	{
+		return *&mShards[pvGetShardIndex(hashCode)];
+	}
+
+	const Shard& pvGetShard(size_t hashCode) const noexcept
+	{
+		return *&mShards[pvGetShardIndex(hashCode)];
+	}
+
+	void pvDestroyShards(size_t count) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+			(&mShards[i])->~Shard();
+	}
+
+private:
+	HashTraits mHashTraits;
+	ShardBuffer mShards[shardCount];
+};
+
+} // namespace momo
@@ -10,15 +10,26 @@
     class MemManagerCpp
     class MemManagerC
     class MemManagerWin
+    class MemManagerMmap
     class MemManagerStd
+    class MemManagerPmr
     class MemManagerDefault
 
   MemManagerCpp uses `new` and `delete`.
   MemManagerC uses `malloc`, `free` and `realloc`.
   MemManagerWin uses `HeapAlloc`, `HeapFree` and `HeapReAlloc`.
+  MemManagerMmap uses anonymous `mmap`, `munmap` and `mremap` for blocks
+    of `minMapSize` bytes or more, and `malloc`, `free` and `realloc`
+    for smaller ones. Memory of large blocks is returned to OS at once,
+    reallocation of large blocks remaps pages instead of copying.
+    It is available if `MOMO_USE_MEM_MANAGER_MMAP` is defined.
   MemManagerStd uses `allocator<char>::allocate` and `deallocate`.
+  MemManagerPmr uses `std::pmr::memory_resource::allocate` and
+    `deallocate`. Copies of MemManagerPmr use the same memory resource.
   MemManagerDefault is defined in UserSettings.h.
   MemManagerStd<std::allocator<...>> is same as MemManagerDefault.
+  MemManagerStd<std::pmr::polymorphic_allocator<...>> is based on
+    MemManagerPmr.
 
   // template for user MemManager:
   class UserMemManager
@@ -179,6 +190,131 @@ public:
 };
 #endif
 
+#ifdef MOMO_USE_MEM_MANAGER_MMAP
+template<size_t tMinMapSize = 256 * 1024,
+	bool tUseHugeTlb = false>
+class MemManagerMmap
+{
+public:
+	static const size_t minMapSize = tMinMapSize;
+	MOMO_STATIC_ASSERT(minMapSize > 0);
+
+	static const bool useHugeTlb = tUseHugeTlb;
+
+	static const size_t hugePageSize = size_t{1} << 21;
+
+public:
+	explicit MemManagerMmap() noexcept
+	{
+	}
+
+	MemManagerMmap(MemManagerMmap&& /*memManager*/) noexcept
+	{
+	}
+
+	MemManagerMmap(const MemManagerMmap& /*memManager*/) noexcept
+	{
+	}
+
+	~MemManagerMmap() noexcept
+	{
+	}
+
+	MemManagerMmap& operator=(const MemManagerMmap&) = delete;
+
+	void* Allocate(size_t size)
+	{
+		void* ptr = (size < minMapSize) ? malloc(size) : pvMap(size);
+		if (ptr == nullptr)
+			throw std::bad_alloc();
+		return ptr;
+	}
+
+	void Deallocate(void* ptr, size_t size) noexcept
+	{
+		if (size < minMapSize)
+			free(ptr);
+		else
+			munmap(ptr, pvGetMapSize(size));
+	}
+
+	void* Reallocate(void* ptr, size_t size, size_t newSize)
+	{
+		void* newPtr;
+		if (size < minMapSize && newSize < minMapSize)
+		{
+			newPtr = realloc(ptr, newSize);
+		}
+		else if (size >= minMapSize && newSize >= minMapSize)
+		{
+			newPtr = mremap(ptr, pvGetMapSize(size), pvGetMapSize(newSize), MREMAP_MAYMOVE);
+			if (newPtr == MAP_FAILED)
+				newPtr = nullptr;
+		}
+		else
+		{
+			newPtr = (newSize < minMapSize) ? malloc(newSize) : pvMap(newSize);
+			if (newPtr != nullptr)
+			{
+				memcpy(newPtr, ptr, std::minmax(size, newSize).first);
+				Deallocate(ptr, size);
+			}
+		}
+		if (newPtr == nullptr)
+			throw std::bad_alloc();
+		return newPtr;
+	}
+
+	bool ReallocateInplace(void* ptr, size_t size, size_t newSize) noexcept
+	{
+		if (size < minMapSize || newSize < minMapSize)
+			return false;
+		size_t mapSize = pvGetMapSize(size);
+		size_t newMapSize = pvGetMapSize(newSize);
+		if (mapSize == newMapSize)
+			return true;
+		return mremap(ptr, mapSize, newMapSize, 0) != MAP_FAILED;
+	}
+
+private:
+	static size_t pvGetPageSize() noexcept
+	{
+		static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		return pageSize;
+	}
+
+	static size_t pvGetMapSize(size_t size) noexcept
+	{
+		// a regular mapping gets the same size as a huge one to be unmapped in the same way
+		return internal::UIntMath<>::Ceil(size, useHugeTlb ? hugePageSize : pvGetPageSize());
+	}
+
+	static void* pvMap(size_t size) noexcept
+	{
+		size_t mapSize = pvGetMapSize(size);
+		void* ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+		if (useHugeTlb)
+		{
+			ptr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		}
+#endif
+		if (ptr == MAP_FAILED)
+		{
+			ptr = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (ptr == MAP_FAILED)
+				return nullptr;
+#ifdef MADV_HUGEPAGE
+			if (mapSize >= hugePageSize)
+				madvise(ptr, mapSize, MADV_HUGEPAGE);
+#endif
+		}
+		return ptr;
+	}
+};
+#endif
+
 template<typename TAllocator>
 class MemManagerStd : private std::allocator_traits<TAllocator>::template rebind_alloc<char>
 {
@@ -287,6 +423,110 @@ public:
 	}
 };
 
+#ifdef MOMO_HAS_PMR
+class MemManagerPmr
+{
+public:
+	static const size_t blockAlignment = MOMO_MAX_ALIGNMENT;
+
+public:
+	explicit MemManagerPmr(
+		std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource()) noexcept
+		: mMemoryResource(memoryResource)
+	{
+		MOMO_ASSERT(memoryResource != nullptr);
+	}
+
+	MemManagerPmr(MemManagerPmr&& memManager) noexcept
+		: mMemoryResource(memManager.mMemoryResource)
+	{
+	}
+
+	MemManagerPmr(const MemManagerPmr& memManager) noexcept
+		: mMemoryResource(memManager.mMemoryResource)
+	{
+	}
+
+	~MemManagerPmr() noexcept
+	{
+	}
+
+	MemManagerPmr& operator=(const MemManagerPmr&) = delete;
+
+	void* Allocate(size_t size)
+	{
+		return mMemoryResource->allocate(size, blockAlignment);
+	}
+
+	void Deallocate(void* ptr, size_t size) noexcept
+	{
+		mMemoryResource->deallocate(ptr, size, blockAlignment);
+	}
+
+	bool IsEqual(const MemManagerPmr& memManager) const noexcept
+	{
+		return mMemoryResource->is_equal(*memManager.mMemoryResource);
+	}
+
+	std::pmr::memory_resource* GetMemoryResource() const noexcept
+	{
+		return mMemoryResource;
+	}
+
+private:
+	std::pmr::memory_resource* mMemoryResource;
+};
+
+template<typename Item>
+class MemManagerStd<std::pmr::polymorphic_allocator<Item>>
+	: private std::pmr::polymorphic_allocator<char>, public MemManagerPmr
+{
+public:
+	typedef std::pmr::polymorphic_allocator<Item> Allocator;
+	typedef std::pmr::polymorphic_allocator<char> ByteAllocator;
+
+public:
+	explicit MemManagerStd() noexcept
+		: MemManagerStd(Allocator())
+	{
+	}
+
+	explicit MemManagerStd(const Allocator& alloc) noexcept
+		: ByteAllocator(alloc),
+		MemManagerPmr(alloc.resource())
+	{
+	}
+
+	MemManagerStd(MemManagerStd&& memManager) noexcept
+		: ByteAllocator(memManager.GetByteAllocator()),
+		MemManagerPmr(std::move(memManager))
+	{
+	}
+
+	MemManagerStd(const MemManagerStd& memManager)
+		: MemManagerStd(Allocator(std::allocator_traits<ByteAllocator>
+			::select_on_container_copy_construction(memManager.GetByteAllocator())))
+	{
+	}
+
+	~MemManagerStd() noexcept
+	{
+	}
+
+	MemManagerStd& operator=(const MemManagerStd&) = delete;
+
+	const ByteAllocator& GetByteAllocator() const noexcept
+	{
+		return *this;
+	}
+
+	ByteAllocator& GetByteAllocator() noexcept
+	{
+		return *this;
+	}
+};
+#endif
+
 namespace internal
 {
 	template<typename TMemManager>
@@ -0,0 +1,218 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/MemManagerArena.h
+
+  namespace momo:
+    class MemManagerArena
+
+  `MemManagerArena` is a monotonic memory manager. Blocks are cut from
+  chunks of memory, which are requested from the base memory manager
+  with geometrically increasing sizes. Function `Deallocate` releases
+  nothing unless the block is the last allocated one, all chunks are
+  released in function `Reset` and in destructor.
+  The last allocated block can be enlarged in place.
+
+  A copy of `MemManagerArena` is a new empty arena. To share one arena
+  among several containers, use `MemManagerArena::Ptr`:
+    MemManagerArena<> arena;
+    typedef MemManagerArena<>::Ptr MemManagerPtr;
+    Array<int, MemManagerPtr> array((MemManagerPtr(arena)));
+  The arena must outlive the containers. After `Reset` the containers
+  must not be used.
+
+\**********************************************************/
+
+#pragma once
+
+#include "MemManager.h"
+
+namespace momo
+{
+
+template<typename TBaseMemManager = MemManagerDefault,
+	size_t tMinChunkSize = 1 << 16>
+class MemManagerArena : private TBaseMemManager
+{
+public:
+	typedef TBaseMemManager BaseMemManager;
+
+	typedef internal::MemManagerPtr<MemManagerArena, false> Ptr;
+
+	static const size_t minChunkSize = tMinChunkSize;
+	static const size_t maxChunkSize = minChunkSize << 6;
+
+private:
+	typedef internal::MemManagerProxy<BaseMemManager> BaseMemManagerProxy;
+
+	typedef internal::UIntMath<size_t> SMath;
+
+	struct ChunkHeader
+	{
+		ChunkHeader* prevChunk;
+		size_t size;
+	};
+
+	static const size_t blockAlignment = MOMO_MAX_ALIGNMENT;
+
+	static const size_t headerSize = SMath::Ceil(sizeof(ChunkHeader), blockAlignment);
+	MOMO_STATIC_ASSERT(minChunkSize >= 2 * headerSize);
+
+public:
+	explicit MemManagerArena(BaseMemManager&& baseMemManager = BaseMemManager()) noexcept
+		: BaseMemManager(std::move(baseMemManager)),
+		mChunk(nullptr),
+		mPtr(nullptr),
+		mEnd(nullptr)
+	{
+	}
+
+	MemManagerArena(MemManagerArena&& memManager) noexcept
+		: BaseMemManager(std::move(memManager.GetBaseMemManager())),
+		mChunk(memManager.mChunk),
+		mPtr(memManager.mPtr),
+		mEnd(memManager.mEnd)
+	{
+		memManager.mChunk = nullptr;
+		memManager.mPtr = nullptr;
+		memManager.mEnd = nullptr;
+	}
+
+	MemManagerArena(const MemManagerArena& memManager)
+		: BaseMemManager(memManager.GetBaseMemManager()),
+		mChunk(nullptr),
+		mPtr(nullptr),
+		mEnd(nullptr)
+	{
+	}
+
+	~MemManagerArena() noexcept
+	{
+		pvRelease(nullptr);
+	}
+
+	MemManagerArena& operator=(const MemManagerArena&) = delete;
+
+	const BaseMemManager& GetBaseMemManager() const noexcept
+	{
+		return *this;
+	}
+
+	BaseMemManager& GetBaseMemManager() noexcept
+	{
+		return *this;
+	}
+
+	void* Allocate(size_t size)
+	{
+		size_t blockSize = pvGetBlockSize(size);
+		if (blockSize > static_cast<size_t>(mEnd - mPtr))
+			return pvAllocateChunk(blockSize);
+		char* ptr = mPtr;
+		mPtr += blockSize;
+		return ptr;
+	}
+
+	void Deallocate(void* ptr, size_t size) noexcept
+	{
+		char* block = static_cast<char*>(ptr);
+		if (block + pvGetBlockSize(size) == mPtr)
+			mPtr = block;
+	}
+
+	void* Reallocate(void* ptr, size_t size, size_t newSize)
+	{
+		if (ReallocateInplace(ptr, size, newSize))
+			return ptr;
+		void* newPtr = Allocate(newSize);
+		memcpy(newPtr, ptr, std::minmax(size, newSize).first);
+		Deallocate(ptr, size);
+		return newPtr;
+	}
+
+	bool ReallocateInplace(void* ptr, size_t size, size_t newSize) noexcept
+	{
+		char* block = static_cast<char*>(ptr);
+		size_t blockSize = pvGetBlockSize(size);
+		size_t newBlockSize = pvGetBlockSize(newSize);
+		bool isLast = (block + blockSize == mPtr);
+		if (newBlockSize <= blockSize)
+		{
+			if (isLast)
+				mPtr = block + newBlockSize;
+			return true;
+		}
+		if (!isLast || newBlockSize - blockSize > static_cast<size_t>(mEnd - mPtr))
+			return false;
+		mPtr = block + newBlockSize;
+		return true;
+	}
+
+	bool IsEqual(const MemManagerArena& memManager) const noexcept
+	{
+		return this == &memManager;
+	}
+
+	void Reset() noexcept
+	{
+		if (mChunk == nullptr)
+			return;
+		pvRelease(mChunk);
+		mChunk->prevChunk = nullptr;
+		mPtr = internal::BitCaster::PtrToPtr<char>(mChunk, headerSize);
+		mEnd = internal::BitCaster::PtrToPtr<char>(mChunk, mChunk->size);
+	}
+
+private:
+	static size_t pvGetBlockSize(size_t size) noexcept
+	{
+		return SMath::Ceil(size, blockAlignment);
+	}
+
+	void* pvAllocateChunk(size_t blockSize)
+	{
+		size_t chunkSize = minChunkSize;
+		if (mChunk != nullptr)
+			chunkSize = std::minmax(2 * mChunk->size, size_t{maxChunkSize}).first;
+		bool isDedicated = (blockSize > chunkSize - headerSize);
+		if (isDedicated)
+			chunkSize = headerSize + blockSize;
+		ChunkHeader* header = BaseMemManagerProxy::template Allocate<ChunkHeader>(
+			GetBaseMemManager(), chunkSize);
+		header->size = chunkSize;
+		char* block = internal::BitCaster::PtrToPtr<char>(header, headerSize);
+		if (isDedicated && mChunk != nullptr)
+		{
+			// the current chunk keeps its free space
+			header->prevChunk = mChunk->prevChunk;
+			mChunk->prevChunk = header;
+			return block;
+		}
+		header->prevChunk = mChunk;
+		mChunk = header;
+		mPtr = block + blockSize;
+		mEnd = internal::BitCaster::PtrToPtr<char>(header, chunkSize);
+		return block;
+	}
+
+	void pvRelease(ChunkHeader* lastChunk) noexcept
+	{
+		ChunkHeader* chunk = (lastChunk != nullptr) ? lastChunk->prevChunk : mChunk;
+		while (chunk != nullptr)
+		{
+			ChunkHeader* prevChunk = chunk->prevChunk;
+			BaseMemManagerProxy::Deallocate(GetBaseMemManager(), chunk, chunk->size);
+			chunk = prevChunk;
+		}
+	}
+
+private:
+	ChunkHeader* mChunk;
+	char* mPtr;
+	char* mEnd;
+};
+
+} // namespace momo
@@ -0,0 +1,296 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/MemManagerCounting.h
+
+  namespace momo:
+    struct MemManagerCountingStats
+    class MemManagerCounting
+
+  `MemManagerCounting` passes all requests to the base memory manager
+  and counts them: numbers of allocations, deallocations and
+  reallocations, live and peak sizes in bytes, and a histogram of
+  allocation sizes. With `tUseAtomics` the counters are atomic and one
+  object can be shared among threads through `MemManagerCounting::Ptr`.
+
+  A copy of `MemManagerCounting` starts with zero counters. Function
+  `IsEqual` compares addresses, so containers never pass memory from
+  one counting memory manager to another.
+
+\**********************************************************/
+
+#pragma once
+
+#include "MemManager.h"
+
+#include <atomic>
+
+namespace momo
+{
+
+struct MemManagerCountingStats
+{
+	static const size_t histogramSize = 24;
+
+	size_t allocateCount;
+	size_t deallocateCount;
+	size_t reallocateCount;
+	size_t liveSize;
+	size_t peakSize;
+
+	// `sizeHistogram[i]` is the number of allocations with size in (2^(i-1), 2^i],
+	// the last element also counts all larger allocations
+	size_t sizeHistogram[histogramSize];
+
+	static size_t GetHistogramIndex(size_t size) noexcept
+	{
+		size_t index = 0;
+		for (size_t value = size - 1; value != 0 && index + 1 < histogramSize; value >>= 1)
+			++index;
+		return index;
+	}
+};
+
+namespace internal
+{
+	template<bool tIsAtomic>
+	class MemManagerCountingCounter
+	{
+	public:
+		explicit MemManagerCountingCounter() noexcept
+			: mValue(0)
+		{
+		}
+
+		size_t Get() const noexcept
+		{
+			return mValue;
+		}
+
+		void Set(size_t value) noexcept
+		{
+			mValue = value;
+		}
+
+		size_t Add(size_t value) noexcept
+		{
+			mValue += value;
+			return mValue;
+		}
+
+		void Sub(size_t value) noexcept
+		{
+			mValue -= value;
+		}
+
+		void UpdateMax(size_t value) noexcept
+		{
+			if (mValue < value)
+				mValue = value;
+		}
+
+	private:
+		size_t mValue;
+	};
+
+	template<>
+	class MemManagerCountingCounter<true>
+	{
+	public:
+		explicit MemManagerCountingCounter() noexcept
+			: mValue(0)
+		{
+		}
+
+		size_t Get() const noexcept
+		{
+			return mValue.load(std::memory_order_relaxed);
+		}
+
+		void Set(size_t value) noexcept
+		{
+			mValue.store(value, std::memory_order_relaxed);
+		}
+
+		size_t Add(size_t value) noexcept
+		{
+			return mValue.fetch_add(value, std::memory_order_relaxed) + value;
+		}
+
+		void Sub(size_t value) noexcept
+		{
+			mValue.fetch_sub(value, std::memory_order_relaxed);
+		}
+
+		void UpdateMax(size_t value) noexcept
+		{
+			size_t curValue = mValue.load(std::memory_order_relaxed);
+			while (curValue < value
+				&& !mValue.compare_exchange_weak(curValue, value, std::memory_order_relaxed))
+			{
+			}
+		}
+
+	private:
+		std::atomic<size_t> mValue;
+	};
+}
+
+template<typename TBaseMemManager = MemManagerDefault,
+	bool tUseAtomics = false>
+class MemManagerCounting : private TBaseMemManager
+{
+public:
+	typedef TBaseMemManager BaseMemManager;
+
+	typedef MemManagerCountingStats Stats;
+
+	typedef internal::MemManagerPtr<MemManagerCounting, false> Ptr;
+
+	static const bool useAtomics = tUseAtomics;
+
+private:
+	typedef internal::MemManagerProxy<BaseMemManager> BaseMemManagerProxy;
+
+	typedef internal::MemManagerCountingCounter<useAtomics> Counter;
+
+	static const size_t histogramSize = Stats::histogramSize;
+
+public:
+	static const size_t ptrUsefulBitCount = BaseMemManagerProxy::ptrUsefulBitCount;
+
+public:
+	explicit MemManagerCounting(BaseMemManager&& baseMemManager = BaseMemManager()) noexcept
+		: BaseMemManager(std::move(baseMemManager))
+	{
+	}
+
+	MemManagerCounting(MemManagerCounting&& memManager) noexcept
+		: BaseMemManager(std::move(memManager.GetBaseMemManager()))
+	{
+		pvMoveCounter(mAllocateCount, memManager.mAllocateCount);
+		pvMoveCounter(mDeallocateCount, memManager.mDeallocateCount);
+		pvMoveCounter(mReallocateCount, memManager.mReallocateCount);
+		pvMoveCounter(mLiveSize, memManager.mLiveSize);
+		pvMoveCounter(mPeakSize, memManager.mPeakSize);
+		for (size_t i = 0; i < histogramSize; ++i)
+			pvMoveCounter(mSizeHistogram[i], memManager.mSizeHistogram[i]);
+	}
+
+	MemManagerCounting(const MemManagerCounting& memManager)
+		: BaseMemManager(memManager.GetBaseMemManager())
+	{
+	}
+
+	~MemManagerCounting() noexcept
+	{
+		MOMO_ASSERT(mLiveSize.Get() == 0);
+	}
+
+	MemManagerCounting& operator=(const MemManagerCounting&) = delete;
+
+	const BaseMemManager& GetBaseMemManager() const noexcept
+	{
+		return *this;
+	}
+
+	BaseMemManager& GetBaseMemManager() noexcept
+	{
+		return *this;
+	}
+
+	void* Allocate(size_t size)
+	{
+		void* ptr = BaseMemManagerProxy::Allocate(GetBaseMemManager(), size);
+		mAllocateCount.Add(1);
+		mSizeHistogram[Stats::GetHistogramIndex(size)].Add(1);
+		mPeakSize.UpdateMax(mLiveSize.Add(size));
+		return ptr;
+	}
+
+	void Deallocate(void* ptr, size_t size) noexcept
+	{
+		BaseMemManagerProxy::Deallocate(GetBaseMemManager(), ptr, size);
+		mDeallocateCount.Add(1);
+		mLiveSize.Sub(size);
+	}
+
+	typename std::conditional<BaseMemManagerProxy::canReallocate, void*, void>::type
+	Reallocate(void* ptr, size_t size, size_t newSize)
+	{
+		void* newPtr = BaseMemManagerProxy::Reallocate(GetBaseMemManager(), ptr, size, newSize);
+		pvResize(size, newSize);
+		return newPtr;
+	}
+
+	typename std::conditional<BaseMemManagerProxy::canReallocateInplace, bool, void>::type
+	ReallocateInplace(void* ptr, size_t size, size_t newSize) noexcept
+	{
+		if (!BaseMemManagerProxy::ReallocateInplace(GetBaseMemManager(), ptr, size, newSize))
+			return false;
+		pvResize(size, newSize);
+		return true;
+	}
+
+	bool IsEqual(const MemManagerCounting& memManager) const noexcept
+	{
+		return this == &memManager;
+	}
+
+	Stats GetStats() const noexcept
+	{
+		Stats stats;
+		stats.allocateCount = mAllocateCount.Get();
+		stats.deallocateCount = mDeallocateCount.Get();
+		stats.reallocateCount = mReallocateCount.Get();
+		stats.liveSize = mLiveSize.Get();
+		stats.peakSize = mPeakSize.Get();
+		for (size_t i = 0; i < histogramSize; ++i)
+			stats.sizeHistogram[i] = mSizeHistogram[i].Get();
+		return stats;
+	}
+
+	size_t GetLiveSize() const noexcept
+	{
+		return mLiveSize.Get();
+	}
+
+	size_t GetPeakSize() const noexcept
+	{
+		return mPeakSize.Get();
+	}
+
+	void ResetPeakSize() noexcept
+	{
+		mPeakSize.Set(mLiveSize.Get());
+	}
+
+private:
+	static void pvMoveCounter(Counter& dstCounter, Counter& srcCounter) noexcept
+	{
+		dstCounter.Set(srcCounter.Get());
+		srcCounter.Set(0);
+	}
+
+	void pvResize(size_t size, size_t newSize) noexcept
+	{
+		mReallocateCount.Add(1);
+		if (newSize > size)
+			mPeakSize.UpdateMax(mLiveSize.Add(newSize - size));
+		else
+			mLiveSize.Sub(size - newSize);
+	}
+
+private:
+	Counter mAllocateCount;
+	Counter mDeallocateCount;
+	Counter mReallocateCount;
+	Counter mLiveSize;
+	Counter mPeakSize;
+	Counter mSizeHistogram[histogramSize];
+};
+
+} // namespace momo
@@ -0,0 +1,253 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/MemManagerPooled.h
+
+  namespace momo:
+    class MemManagerPooled
+
+  `MemManagerPooled` routes every allocation up to `maxPooledSize`
+  bytes to a `MemPool` of the corresponding size class. Size classes
+  are multiples of 16 up to 128 bytes, then four classes per doubling.
+  Larger blocks are requested from the base memory manager directly.
+  Pools are created on first use and released in destructor.
+
+  A copy of `MemManagerPooled` is a new empty memory manager. To share
+  one set of pools among several containers, use `MemManagerPooled::Ptr`:
+    MemManagerPooled<> pooled;
+    typedef MemManagerPooled<>::Ptr MemManagerPtr;
+    HashSet<int, HashTraits<int>, MemManagerPtr> set((HashTraits<int>()),
+      MemManagerPtr(pooled));
+  The memory manager must outlive the containers. It is not thread-safe.
+
+\**********************************************************/
+
+#pragma once
+
+#include "MemPool.h"
+
+namespace momo
+{
+
+namespace internal
+{
+	class MemManagerPooledSizeClasses
+	{
+	public:
+		static const size_t smallStep = 16;
+		static const size_t smallCount = 8;
+		static const size_t smallMaxSize = smallStep * smallCount;
+
+	public:
+		static constexpr size_t GetCount(size_t maxSize) noexcept
+		{
+			return smallCount + 4 * (pvLog2(maxSize) - pvLog2(smallMaxSize));
+		}
+
+		static size_t GetIndex(size_t size) noexcept
+		{
+			MOMO_ASSERT(size > 0);
+			if (size <= smallMaxSize)
+				return (size - 1) / smallStep;
+			size_t shift = pvLog2(smallMaxSize);
+			while (((size - 1) >> (shift + 1)) != 0)
+				++shift;
+			return smallCount + 4 * (shift - pvLog2(smallMaxSize))
+				+ ((size - 1) >> (shift - 2)) - 4;
+		}
+
+		static size_t GetSize(size_t index) noexcept
+		{
+			if (index < smallCount)
+				return smallStep * (index + 1);
+			size_t shift = (index - smallCount) / 4;
+			size_t step = (smallMaxSize / 4) << shift;
+			return (smallMaxSize << shift) + step * ((index - smallCount) % 4 + 1);
+		}
+
+	private:
+		static constexpr size_t pvLog2(size_t value) noexcept
+		{
+			return (value > 1) ? pvLog2(value / 2) + 1 : 0;
+		}
+	};
+}
+
+template<typename TBaseMemManager = MemManagerDefault,
+	size_t tMaxPooledSize = 1024,
+	size_t tBlockCount = 128>
+class MemManagerPooled : private TBaseMemManager
+{
+public:
+	typedef TBaseMemManager BaseMemManager;
+
+	typedef internal::MemManagerPtr<MemManagerPooled, false> Ptr;
+
+	static const size_t maxPooledSize = tMaxPooledSize;
+	MOMO_STATIC_ASSERT(maxPooledSize >= 128 && (maxPooledSize & (maxPooledSize - 1)) == 0);
+
+	static const size_t blockCount = tBlockCount;
+
+private:
+	typedef internal::MemManagerProxy<BaseMemManager> BaseMemManagerProxy;
+
+	typedef internal::MemManagerPooledSizeClasses SizeClasses;
+
+	typedef MemPoolParams<blockCount> PoolParams;
+	typedef MemPool<PoolParams, BaseMemManager, internal::NestedMemPoolSettings> Pool;
+
+	static const size_t sizeClassCount = SizeClasses::GetCount(maxPooledSize);
+
+	static const size_t blockAlignment = MOMO_MAX_ALIGNMENT;
+
+public:
+	explicit MemManagerPooled(BaseMemManager&& baseMemManager = BaseMemManager()) noexcept
+		: BaseMemManager(std::move(baseMemManager))
+	{
+		std::fill_n(mPools, sizeClassCount, nullptr);
+	}
+
+	MemManagerPooled(MemManagerPooled&& memManager) noexcept
+		: BaseMemManager(std::move(memManager.GetBaseMemManager()))
+	{
+		std::copy_n(memManager.mPools, sizeClassCount, mPools);
+		std::fill_n(memManager.mPools, sizeClassCount, nullptr);
+	}
+
+	MemManagerPooled(const MemManagerPooled& memManager)
+		: BaseMemManager(memManager.GetBaseMemManager())
+	{
+		std::fill_n(mPools, sizeClassCount, nullptr);
+	}
+
+	~MemManagerPooled() noexcept
+	{
+		for (Pool* pool : mPools)
+		{
+			if (pool == nullptr)
+				continue;
+			pool->~Pool();
+			BaseMemManagerProxy::Deallocate(GetBaseMemManager(), pool, sizeof(Pool));
+		}
+	}
+
+	MemManagerPooled& operator=(const MemManagerPooled&) = delete;
+
+	const BaseMemManager& GetBaseMemManager() const noexcept
+	{
+		return *this;
+	}
+
+	BaseMemManager& GetBaseMemManager() noexcept
+	{
+		return *this;
+	}
+
+	void* Allocate(size_t size)
+	{
+		if (size > maxPooledSize)
+			return BaseMemManagerProxy::Allocate(GetBaseMemManager(), size);
+		size_t index = SizeClasses::GetIndex(size);
+		if (mPools[index] == nullptr)
+			pvCreatePool(index);
+		return mPools[index]->Allocate();
+	}
+
+	void Deallocate(void* ptr, size_t size) noexcept
+	{
+		if (size > maxPooledSize)
+		{
+			BaseMemManagerProxy::Deallocate(GetBaseMemManager(), ptr, size);
+		}
+		else
+		{
+			Pool* pool = mPools[SizeClasses::GetIndex(size)];
+			MOMO_ASSERT(pool != nullptr);
+			pool->Deallocate(ptr);
+		}
+	}
+
+	void* Reallocate(void* ptr, size_t size, size_t newSize)
+	{
+		if (ReallocateInplace(ptr, size, newSize))
+			return ptr;
+		if (size > maxPooledSize && newSize > maxPooledSize)
+		{
+			return pvReallocate(ptr, size, newSize,
+				internal::BoolConstant<BaseMemManagerProxy::canReallocate>());
+		}
+		void* newPtr = Allocate(newSize);
+		memcpy(newPtr, ptr, std::minmax(size, newSize).first);
+		Deallocate(ptr, size);
+		return newPtr;
+	}
+
+	bool ReallocateInplace(void* ptr, size_t size, size_t newSize) noexcept
+	{
+		if (size <= maxPooledSize && newSize <= maxPooledSize)
+			return SizeClasses::GetIndex(size) == SizeClasses::GetIndex(newSize);
+		if (size > maxPooledSize && newSize > maxPooledSize)
+		{
+			return pvReallocateInplace(ptr, size, newSize,
+				internal::BoolConstant<BaseMemManagerProxy::canReallocateInplace>());
+		}
+		return false;
+	}
+
+	bool IsEqual(const MemManagerPooled& memManager) const noexcept
+	{
+		return this == &memManager;
+	}
+
+private:
+	void pvCreatePool(size_t index)
+	{
+		Pool* pool = BaseMemManagerProxy::template Allocate<Pool>(GetBaseMemManager(),
+			sizeof(Pool));
+		try
+		{
+			::new(static_cast<void*>(pool)) Pool(
+				PoolParams(SizeClasses::GetSize(index), blockAlignment),
+				BaseMemManager(GetBaseMemManager()));
+		}
+		catch (...)
+		{
+			BaseMemManagerProxy::Deallocate(GetBaseMemManager(), pool, sizeof(Pool));
+			throw;
+		}
+		mPools[index] = pool;
+	}
+
+	void* pvReallocate(void* ptr, size_t size, size_t newSize, std::true_type /*canReallocate*/)
+	{
+		return BaseMemManagerProxy::Reallocate(GetBaseMemManager(), ptr, size, newSize);
+	}
+
+	void* pvReallocate(void* ptr, size_t size, size_t newSize, std::false_type /*canReallocate*/)
+	{
+		void* newPtr = BaseMemManagerProxy::Allocate(GetBaseMemManager(), newSize);
+		memcpy(newPtr, ptr, std::minmax(size, newSize).first);
+		BaseMemManagerProxy::Deallocate(GetBaseMemManager(), ptr, size);
+		return newPtr;
+	}
+
+	bool pvReallocateInplace(void* ptr, size_t size, size_t newSize,
+		std::true_type /*canReallocateInplace*/) noexcept
+	{
+		return BaseMemManagerProxy::ReallocateInplace(GetBaseMemManager(), ptr, size, newSize);
+	}
+
+	bool pvReallocateInplace(void* /*ptr*/, size_t /*size*/, size_t /*newSize*/,
+		std::false_type /*canReallocateInplace*/) noexcept
+	{
+		return false;
+	}
+
+private:
+	Pool* mPools[sizeClassCount];
+};
+
+} // namespace momo
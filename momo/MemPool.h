@@ -11,8 +11,25 @@
     class MemPoolParams
     class MemPoolParamsStatic
     class MemPoolSettings
+    struct MemPoolStats
     class MemPool
 
+  `MemPool` with `blockCount` less than 128 stores free block lists
+  inside the blocks. Larger values (multiples of 64 up to 4096) switch
+  to large buffers: free blocks of a buffer are tracked by a bitmap at
+  its beginning, and a new block is always taken from the lowest free
+  address, so neighbouring allocations stay close in memory.
+  Function `MergeFrom` does not allocate memory for large buffers: if
+  neither table of buffers has room for the other one, the tables are
+  chained and joined by the next `Allocate` or `Compact`.
+
+  Function `Trim` releases cached free blocks, so all empty buffers
+  return to the memory manager. Function `Compact` moves live blocks
+  out of the sparsest buffers into the free blocks of other ones and
+  releases the emptied buffers. The owner of the blocks passes a
+  relocator `void(void* srcBlock, void* dstBlock) noexcept`, which moves
+  the object and updates all pointers to it.
+
 \**********************************************************/
 
 #pragma once
@@ -30,6 +47,12 @@ public:
 	static const size_t defaultCachedFreeBlockCount = MOMO_DEFAULT_MEM_POOL_CACHED_FREE_BLOCK_COUNT;
 
 public:
+	static constexpr bool IsValidBlockCount(size_t blockCount) noexcept
+	{
+		return (0 < blockCount && blockCount < 128)
+			|| (blockCount % 64 == 0 && blockCount <= 4096);
+	}
+
 	static constexpr size_t GetBlockAlignment(size_t blockSize,
 		size_t maxAlignment = MOMO_MAX_ALIGNMENT) noexcept
 	{
@@ -44,7 +67,7 @@ class MemPoolParams
 {
 public:
 	static const size_t blockCount = tBlockCount;
-	MOMO_STATIC_ASSERT(0 < blockCount && blockCount < 128);
+	MOMO_STATIC_ASSERT(MemPoolConst::IsValidBlockCount(blockCount));
 
 	static const size_t cachedFreeBlockCount = tCachedFreeBlockCount;
 
@@ -79,6 +102,11 @@ private:
 			if (blockSize == 0)
 				blockSize = 1;
 		}
+		else if (blockCount >= 128)
+		{
+			blockSize = (blockSize == 0) ? blockAlignment
+				: internal::UIntMath<>::Ceil(blockSize, blockAlignment);
+		}
 		else
 		{
 			blockSize = (blockSize <= blockAlignment) ? 2 * blockAlignment
@@ -99,13 +127,15 @@ class MemPoolParamsStatic
 {
 public:
 	static const size_t blockCount = tBlockCount;
-	MOMO_STATIC_ASSERT(0 < blockCount && blockCount < 128);
+	MOMO_STATIC_ASSERT(MemPoolConst::IsValidBlockCount(blockCount));
 
 	static const size_t blockAlignment = tBlockAlignment;
 	MOMO_STATIC_ASSERT(0 < blockAlignment && blockAlignment <= 1024);
 
 	static const size_t blockSize = (blockCount == 1)
 		? ((tBlockSize > 0) ? tBlockSize : 1)
+		: (blockCount >= 128)
+			? ((tBlockSize > 0) ? internal::UIntMath<>::Ceil(tBlockSize, blockAlignment) : blockAlignment)
 		: ((tBlockSize <= blockAlignment) ? 2 * blockAlignment
 			: internal::UIntMath<>::Ceil(tBlockSize, blockAlignment));
 
@@ -129,6 +159,20 @@ public:
 	static const ExtraCheckMode extraCheckMode = ExtraCheckMode::bydefault;
 };
 
+struct MemPoolStats
+{
+	static const size_t histogramSize = 8;
+
+	size_t bufferCount;
+	size_t allocateCount;
+	size_t cachedFreeBlockCount;
+	size_t freeBlockCount;	// in buffers, cached blocks are not included
+
+	// `occupancyHistogram[i]` is the number of buffers with occupancy in [i / 8, (i + 1) / 8),
+	// full buffers are counted in the last element
+	size_t occupancyHistogram[histogramSize];
+};
+
 template<typename TParams = MemPoolParams<>,
 	typename TMemManager = MemManagerDefault,
 	typename TSettings = MemPoolSettings>
@@ -139,6 +183,8 @@ public:
 	typedef TMemManager MemManager;
 	typedef TSettings Settings;
 
+	typedef MemPoolStats Stats;
+
 	MOMO_STATIC_ASSERT(std::is_nothrow_move_constructible<Params>::value);
 	MOMO_STATIC_ASSERT(std::is_nothrow_move_assignable<Params>::value);
 
@@ -151,6 +197,12 @@ private:
 	typedef internal::UIntMath<size_t> SMath;
 	typedef internal::UIntMath<uintptr_t> PMath;
 
+	typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+
+	template<typename Item>
+	using TempArray = Array<Item, MemManagerPtr, ArrayItemTraits<Item, MemManagerPtr>,
+		internal::NestedArraySettings<>>;
+
 	struct BufferBytes
 	{
 		int8_t firstFreeBlockIndex;
@@ -164,6 +216,25 @@ private:
 		uintptr_t begin;
 	};
 
+	struct LargeBuffer
+	{
+		uintptr_t begin;	// bitmap of free blocks, then blocks
+		size_t freeBlockCount;
+		size_t firstFreeWordIndex;
+	};
+
+	struct LargeBufferTable
+	{
+		size_t count;
+		size_t capacity;
+		size_t firstFreeIndex;	// lowest buffer with free blocks
+		LargeBufferTable* nextTable;	// after `MergeFrom` only
+		// followed by buffers sorted by address
+	};
+
+	static const bool largeBuffers = (Params::blockCount >= 128);
+	static const size_t largeWordCount = Params::blockCount / 64;
+
 	static const uintptr_t nullPtr = internal::UIntPtrConst::null;
 
 	static const size_t maxAlignment = alignof(std::max_align_t);
@@ -262,7 +333,9 @@ public:
 		}
 		else
 		{
-			if (Params::blockCount > 1)
+			if (largeBuffers)
+				pblock = internal::BitCaster::ToPtr(pvNewBlockLarge());
+			else if (Params::blockCount > 1)
 				pblock = internal::BitCaster::ToPtr(pvNewBlock());
 			else if (maxAlignment % Params::blockAlignment == 0)
 				pblock = MemManagerProxy::Allocate(GetMemManager(), pvGetBufferSize0());
@@ -303,6 +376,8 @@ public:
 		MOMO_CHECK(static_cast<const Params&>(*this).IsEqual(memPool));
 		if (Params::cachedFreeBlockCount > 0)
 			memPool.pvFlushDeallocate();
+		if (largeBuffers && mBufferHead != nullPtr && memPool.mBufferHead != nullPtr)
+			pvMergeLargeBuffers(memPool);
 		mAllocCount += memPool.mAllocCount;
 		memPool.mAllocCount = 0;
 		if (memPool.mBufferHead == nullPtr)
@@ -325,6 +400,96 @@ public:
 		memPool.mBufferHead = nullPtr;
 	}
 
+	Stats GetStats() const noexcept
+	{
+		Stats stats;
+		stats.allocateCount = mAllocCount;
+		stats.cachedFreeBlockCount = mCachedFreeBlocks.GetCount();
+		stats.freeBlockCount = 0;
+		std::fill_n(stats.occupancyHistogram, size_t{Stats::histogramSize}, size_t{0});
+		size_t usedBlockCount = stats.allocateCount + stats.cachedFreeBlockCount;
+		if (Params::blockCount == 1)
+		{
+			stats.bufferCount = usedBlockCount;
+			stats.occupancyHistogram[Stats::histogramSize - 1] = usedBlockCount;
+			return stats;
+		}
+		stats.bufferCount = 0;
+		size_t visitedUsedBlockCount = 0;
+		auto bufferVisitor = [&stats, &visitedUsedBlockCount] (uintptr_t /*buffer*/,
+			size_t freeBlockCount)
+		{
+			size_t usedBlockCount = Params::blockCount - freeBlockCount;
+			size_t histIndex = usedBlockCount * Stats::histogramSize / Params::blockCount;
+			++stats.occupancyHistogram[std::minmax(histIndex, Stats::histogramSize - 1).first];
+			++stats.bufferCount;
+			stats.freeBlockCount += freeBlockCount;
+			visitedUsedBlockCount += usedBlockCount;
+		};
+		pvVisitBuffers(bufferVisitor);
+		size_t fullBufferCount = (usedBlockCount - visitedUsedBlockCount) / Params::blockCount;
+		stats.bufferCount += fullBufferCount;
+		stats.occupancyHistogram[Stats::histogramSize - 1] += fullBufferCount;
+		return stats;
+	}
+
+	void Trim() noexcept
+	{
+		if (Params::cachedFreeBlockCount > 0)
+			pvFlushDeallocate();
+	}
+
+	template<typename BlockRelocator>
+	size_t Compact(BlockRelocator&& blockRelocator)
+	{
+		Trim();
+		if (Params::blockCount == 1 || mBufferHead == nullPtr)
+			return 0;
+		if (largeBuffers)
+			pvJoinLargeTables();
+		TempArray<std::pair<size_t, uintptr_t>> buffers((MemManagerPtr(GetMemManager())));
+		auto bufferVisitor = [&buffers] (uintptr_t buffer, size_t freeBlockCount)
+		{
+			if (freeBlockCount > 0)
+				buffers.AddBack(std::make_pair(Params::blockCount - freeBlockCount, buffer));
+		};
+		pvVisitBuffers(bufferVisitor);
+		std::sort(buffers.GetBegin(), buffers.GetEnd());
+		size_t freeBlockCount = 0;
+		for (const std::pair<size_t, uintptr_t>& pair : buffers)
+			freeBlockCount += Params::blockCount - pair.first;
+		// the sparsest buffers are emptied, if the rest ones have enough free blocks
+		size_t bufferCount = 0;
+		size_t movingBlockCount = 0;
+		for (const std::pair<size_t, uintptr_t>& pair : buffers)
+		{
+			size_t newFreeBlockCount = freeBlockCount - (Params::blockCount - pair.first);
+			if (movingBlockCount + pair.first > newFreeBlockCount)
+				break;
+			freeBlockCount = newFreeBlockCount;
+			movingBlockCount += pair.first;
+			++bufferCount;
+		}
+		if (bufferCount == 0)
+			return 0;
+		TempArray<uintptr_t> blocks((MemManagerPtr(GetMemManager())));
+		blocks.Reserve(movingBlockCount);
+		for (size_t i = 0; i < bufferCount; ++i)
+			pvGetUsedBlocks(buffers[i].second, blocks);
+		for (size_t i = 0; i < bufferCount; ++i)
+			pvDetachBuffer(buffers[i].second);
+		if (largeBuffers)
+			pvUpdateFirstFreeIndex(pvGetLargeTable(), 0);
+		for (uintptr_t block : blocks)
+		{
+			uintptr_t newBlock = largeBuffers ? pvNewBlockLarge() : pvNewBlock();
+			blockRelocator(internal::BitCaster::ToPtr(block), internal::BitCaster::ToPtr(newBlock));
+		}
+		for (size_t i = 0; i < bufferCount; ++i)
+			pvReleaseBuffer(buffers[i].second);
+		return bufferCount;
+	}
+
 private:
 	Params& pvGetParams() noexcept
 	{
@@ -333,13 +498,14 @@ private:
 
 	void pvCheckParams() const
 	{
-		MOMO_CHECK(0 < Params::blockCount && Params::blockCount < 128);
+		MOMO_CHECK(MemPoolConst::IsValidBlockCount(Params::blockCount));
 		MOMO_CHECK(0 < Params::blockAlignment && Params::blockAlignment <= 1024);
 		MOMO_CHECK(Params::blockSize > 0);
 		MOMO_CHECK(Params::blockCount == 1 || Params::blockSize % Params::blockAlignment == 0);
-		MOMO_CHECK(Params::blockCount == 1 || Params::blockSize / Params::blockAlignment >= 2);
-		size_t maxBlockSize =
-			(SIZE_MAX - 2 - 3 * sizeof(void*) - 4 * Params::blockAlignment) / Params::blockCount;
+		MOMO_CHECK(Params::blockCount == 1 || largeBuffers
+			|| Params::blockSize / Params::blockAlignment >= 2);
+		size_t maxBlockSize = (SIZE_MAX - 2 - 3 * sizeof(void*) - 4 * Params::blockAlignment
+			- largeWordCount * sizeof(uint64_t)) / Params::blockCount;
 		if (Params::blockSize > maxBlockSize)
 			throw std::length_error("momo::MemPool length error");
 	}
@@ -353,7 +519,9 @@ private:
 
 	void pvDeleteBlock(void* pblock) noexcept
 	{
-		if (Params::blockCount > 1)
+		if (largeBuffers)
+			pvDeleteBlockLarge(internal::BitCaster::ToUInt(pblock));
+		else if (Params::blockCount > 1)
 			pvDeleteBlock(internal::BitCaster::ToUInt(pblock));
 		else if (maxAlignment % Params::blockAlignment == 0)
 			MemManagerProxy::Deallocate(GetMemManager(), pblock, pvGetBufferSize0());
@@ -530,12 +698,12 @@ private:
 			+ ((Params::blockAlignment <= 2) ? 2 : 0);
 	}
 
-	int8_t& pvGetFirstBlockIndex(uintptr_t buffer) noexcept
+	int8_t& pvGetFirstBlockIndex(uintptr_t buffer) const noexcept
 	{
 		return *internal::BitCaster::ToPtr<int8_t>(buffer);
 	}
 
-	BufferBytes& pvGetBufferBytes(uintptr_t buffer) noexcept
+	BufferBytes& pvGetBufferBytes(uintptr_t buffer) const noexcept
 	{
 		if (Params::blockAlignment > 2)
 		{
@@ -548,7 +716,7 @@ private:
 		}
 	}
 
-	BufferPointers& pvGetBufferPointers(uintptr_t buffer) noexcept
+	BufferPointers& pvGetBufferPointers(uintptr_t buffer) const noexcept
 	{
 		size_t offset = Params::blockCount;
 		offset -= static_cast<size_t>(-pvGetFirstBlockIndex(buffer));	// gcc warning
@@ -557,6 +725,375 @@ private:
 			uintptr_t{sizeof(void*)}));
 	}
 
+	template<typename BufferVisitor>
+	void pvVisitBuffers(const BufferVisitor& bufferVisitor) const noexcept
+	{
+		if (largeBuffers)
+		{
+			for (LargeBufferTable* table = pvGetLargeTable(); table != nullptr;
+				table = table->nextTable)
+			{
+				const LargeBuffer* buffers = pvGetLargeBuffers(table);
+				for (size_t i = 0; i < table->count; ++i)
+					bufferVisitor(buffers[i].begin, buffers[i].freeBlockCount);
+			}
+		}
+		else
+		{
+			for (uintptr_t buffer = mBufferHead; buffer != nullPtr;
+				buffer = pvGetBufferPointers(buffer).nextBuffer)
+			{
+				bufferVisitor(buffer, static_cast<size_t>(pvGetBufferBytes(buffer).freeBlockCount));
+			}
+		}
+	}
+
+	void pvGetUsedBlocks(uintptr_t buffer, TempArray<uintptr_t>& blocks) noexcept
+	{
+		if (largeBuffers)
+		{
+			const uint64_t* words = internal::BitCaster::ToPtr<uint64_t>(buffer);
+			uintptr_t blocksBegin = pvGetLargeBlocksBegin(buffer);
+			for (size_t i = 0; i < Params::blockCount; ++i)
+			{
+				if ((words[i / 64] & (uint64_t{1} << (i % 64))) == 0)
+					blocks.AddBackNogrow(blocksBegin + uintptr_t{i * Params::blockSize});
+			}
+		}
+		else
+		{
+			uint64_t freeMask[2] = { 0, 0 };
+			int8_t firstBlockIndex = pvGetFirstBlockIndex(buffer);
+			const BufferBytes& bytes = pvGetBufferBytes(buffer);
+			int8_t blockIndex = bytes.firstFreeBlockIndex;
+			for (int8_t i = 0; i < bytes.freeBlockCount; ++i)
+			{
+				size_t offset = static_cast<size_t>(blockIndex - firstBlockIndex);
+				freeMask[offset / 64] |= uint64_t{1} << (offset % 64);
+				blockIndex = pvGetNextFreeBlockIndex(pvGetNextFreeBlockIndex(buffer, blockIndex));
+			}
+			for (size_t i = 0; i < Params::blockCount; ++i)
+			{
+				if ((freeMask[i / 64] & (uint64_t{1} << (i % 64))) != 0)
+					continue;
+				blockIndex = static_cast<int8_t>(firstBlockIndex + static_cast<int>(i));
+				blocks.AddBackNogrow(pvGetNextFreeBlockIndex(buffer, blockIndex));
+			}
+		}
+	}
+
+	void pvDetachBuffer(uintptr_t buffer) noexcept
+	{
+		if (largeBuffers)
+		{
+			LargeBuffer& largeBuffer = pvGetLargeBuffers(pvGetLargeTable())[pvFindLargeBuffer(buffer)];
+			largeBuffer.freeBlockCount = 0;
+			uint64_t* words = internal::BitCaster::ToPtr<uint64_t>(buffer);
+			std::fill(words, words + largeWordCount, uint64_t{0});
+		}
+		else
+		{
+			pvRemoveBuffer(buffer, false);
+		}
+	}
+
+	void pvReleaseBuffer(uintptr_t buffer) noexcept
+	{
+		if (largeBuffers)
+		{
+			pvRemoveLargeBuffer(pvGetLargeTable(), pvFindLargeBuffer(buffer));
+		}
+		else
+		{
+			MemManagerProxy::Deallocate(GetMemManager(),
+				internal::BitCaster::ToPtr(pvGetBufferPointers(buffer).begin), pvGetBufferSize());
+		}
+	}
+
+	size_t pvFindLargeBuffer(uintptr_t begin) const noexcept
+	{
+		LargeBufferTable* table = pvGetLargeTable();
+		LargeBuffer* buffers = pvGetLargeBuffers(table);
+		auto bufferPred = [] (const LargeBuffer& buffer, uintptr_t begin)
+			{ return buffer.begin < begin; };
+		size_t bufferIndex = static_cast<size_t>(
+			std::lower_bound(buffers, buffers + table->count, begin, bufferPred) - buffers);
+		MOMO_ASSERT(bufferIndex < table->count && buffers[bufferIndex].begin == begin);
+		return bufferIndex;
+	}
+
+	uintptr_t pvNewBlockLarge()
+	{
+		pvJoinLargeTables();
+		LargeBufferTable* table = pvGetLargeTable();
+		if (table == nullptr || table->firstFreeIndex == table->count)
+			table = pvAddLargeBuffer(table);
+		LargeBuffer& buffer = pvGetLargeBuffers(table)[table->firstFreeIndex];
+		uint64_t* words = internal::BitCaster::ToPtr<uint64_t>(buffer.begin);
+		size_t wordIndex = buffer.firstFreeWordIndex;
+		while (words[wordIndex] == 0)
+			++wordIndex;
+		size_t blockIndex = wordIndex * 64 + pvCountTrailingZeros(words[wordIndex]);
+		words[wordIndex] &= words[wordIndex] - 1;
+		buffer.firstFreeWordIndex = wordIndex;
+		--buffer.freeBlockCount;
+		if (buffer.freeBlockCount == 0)
+			pvUpdateFirstFreeIndex(table, table->firstFreeIndex + 1);
+		return pvGetLargeBlocksBegin(buffer.begin) + uintptr_t{blockIndex * Params::blockSize};
+	}
+
+	void pvDeleteBlockLarge(uintptr_t block) noexcept
+	{
+		LargeBufferTable* table = pvGetLargeTable();
+		MOMO_ASSERT(table != nullptr);
+		auto bufferPred = [] (uintptr_t block, const LargeBuffer& buffer)
+			{ return block < buffer.begin; };
+		LargeBuffer* buffers;
+		size_t bufferIndex;
+		while (true)
+		{
+			buffers = pvGetLargeBuffers(table);
+			bufferIndex = static_cast<size_t>(
+				std::upper_bound(buffers, buffers + table->count, block, bufferPred) - buffers);
+			if (table->nextTable == nullptr || (bufferIndex > 0
+				&& block - buffers[bufferIndex - 1].begin < uintptr_t{pvGetLargeBufferSize()}))
+			{
+				break;
+			}
+			table = table->nextTable;
+		}
+		MOMO_ASSERT(bufferIndex > 0);
+		--bufferIndex;
+		LargeBuffer& buffer = buffers[bufferIndex];
+		size_t blockIndex = static_cast<size_t>(block - pvGetLargeBlocksBegin(buffer.begin))
+			/ Params::blockSize;
+		MOMO_ASSERT(blockIndex < Params::blockCount);
+		size_t wordIndex = blockIndex / 64;
+		uint64_t* words = internal::BitCaster::ToPtr<uint64_t>(buffer.begin);
+		MOMO_ASSERT((words[wordIndex] & (uint64_t{1} << (blockIndex % 64))) == 0);
+		words[wordIndex] |= uint64_t{1} << (blockIndex % 64);
+		if (wordIndex < buffer.firstFreeWordIndex)
+			buffer.firstFreeWordIndex = wordIndex;
+		++buffer.freeBlockCount;
+		if (bufferIndex < table->firstFreeIndex)
+			table->firstFreeIndex = bufferIndex;
+		if (buffer.freeBlockCount == Params::blockCount)
+			pvRemoveLargeBuffer(table, bufferIndex);
+	}
+
+	LargeBufferTable* pvAddLargeBuffer(LargeBufferTable* table)
+	{
+		uintptr_t begin = internal::BitCaster::ToUInt(
+			MemManagerProxy::Allocate(GetMemManager(), pvGetLargeBufferSize()));
+		try
+		{
+			table = pvReserveLargeTable(table);
+		}
+		catch (...)
+		{
+			MemManagerProxy::Deallocate(GetMemManager(), internal::BitCaster::ToPtr(begin),
+				pvGetLargeBufferSize());
+			throw;
+		}
+		LargeBuffer* buffers = pvGetLargeBuffers(table);
+		auto bufferPred = [] (uintptr_t begin, const LargeBuffer& buffer)
+			{ return begin < buffer.begin; };
+		LargeBuffer* buffer = std::upper_bound(buffers, buffers + table->count, begin, bufferPred);
+		std::copy_backward(buffer, buffers + table->count, buffers + table->count + 1);
+		uint64_t* words = internal::BitCaster::ToPtr<uint64_t>(begin);
+		std::fill(words, words + largeWordCount, ~uint64_t{0});
+		buffer->begin = begin;
+		buffer->freeBlockCount = Params::blockCount;
+		buffer->firstFreeWordIndex = 0;
+		++table->count;
+		table->firstFreeIndex = static_cast<size_t>(buffer - buffers);	// other buffers are full
+		return table;
+	}
+
+	void pvRemoveLargeBuffer(LargeBufferTable* table, size_t bufferIndex) noexcept
+	{
+		LargeBuffer* buffers = pvGetLargeBuffers(table);
+		MemManagerProxy::Deallocate(GetMemManager(),
+			internal::BitCaster::ToPtr(buffers[bufferIndex].begin), pvGetLargeBufferSize());
+		std::copy(buffers + bufferIndex + 1, buffers + table->count, buffers + bufferIndex);
+		--table->count;
+		if (table->count == 0)
+		{
+			pvRemoveLargeTable(table);
+		}
+		else if (table->firstFreeIndex > bufferIndex)
+		{
+			--table->firstFreeIndex;
+		}
+		else if (table->firstFreeIndex == bufferIndex)
+		{
+			pvUpdateFirstFreeIndex(table, bufferIndex);
+		}
+	}
+
+	LargeBufferTable* pvReserveLargeTable(LargeBufferTable* table)
+	{
+		if (table != nullptr && table->count < table->capacity)
+			return table;
+		size_t capacity = (table != nullptr) ? 2 * table->capacity : 4;
+		LargeBufferTable* newTable = MemManagerProxy::template Allocate<LargeBufferTable>(
+			GetMemManager(), pvGetLargeTableSize(capacity));
+		newTable->count = 0;
+		newTable->capacity = capacity;
+		newTable->firstFreeIndex = 0;
+		newTable->nextTable = nullptr;
+		if (table != nullptr)
+		{
+			MOMO_ASSERT(table->nextTable == nullptr);
+			newTable->count = table->count;
+			newTable->firstFreeIndex = table->firstFreeIndex;
+			std::copy(pvGetLargeBuffers(table), pvGetLargeBuffers(table) + table->count,
+				pvGetLargeBuffers(newTable));
+			pvDeallocateLargeTable(table);
+		}
+		mBufferHead = internal::BitCaster::ToUInt(newTable);
+		return newTable;
+	}
+
+	void pvMergeLargeBuffers(MemPool& memPool) noexcept
+	{
+		LargeBufferTable* table1 = pvGetLargeTable();
+		LargeBufferTable* table2 = memPool.pvGetLargeTable();
+		memPool.mBufferHead = nullPtr;
+		size_t count = table1->count + table2->count;
+		if (table1->nextTable == nullptr && table2->nextTable == nullptr)
+		{
+			if (table1->capacity < count && table2->capacity >= count)
+				std::swap(table1, table2);
+			if (table1->capacity >= count)
+			{
+				LargeBuffer* buffers1 = pvGetLargeBuffers(table1);
+				LargeBuffer* buffers2 = pvGetLargeBuffers(table2);
+				size_t index1 = table1->count;
+				size_t index2 = table2->count;
+				for (size_t i = count; index2 > 0; )
+				{
+					if (index1 > 0 && buffers1[index1 - 1].begin > buffers2[index2 - 1].begin)
+						buffers1[--i] = buffers1[--index1];
+					else
+						buffers1[--i] = buffers2[--index2];
+				}
+				table1->count = count;
+				pvUpdateFirstFreeIndex(table1, 0);
+				pvDeallocateLargeTable(table2);
+				mBufferHead = internal::BitCaster::ToUInt(table1);
+				return;
+			}
+		}
+		LargeBufferTable* lastTable = table1;
+		while (lastTable->nextTable != nullptr)
+			lastTable = lastTable->nextTable;
+		lastTable->nextTable = table2;
+	}
+
+	void pvJoinLargeTables()
+	{
+		LargeBufferTable* table = pvGetLargeTable();
+		if (table == nullptr || table->nextTable == nullptr)
+			return;
+		size_t count = 0;
+		for (LargeBufferTable* curTable = table; curTable != nullptr; curTable = curTable->nextTable)
+			count += curTable->count;
+		LargeBufferTable* newTable = MemManagerProxy::template Allocate<LargeBufferTable>(
+			GetMemManager(), pvGetLargeTableSize(count));
+		newTable->count = 0;
+		newTable->capacity = count;
+		newTable->nextTable = nullptr;
+		LargeBuffer* newBuffers = pvGetLargeBuffers(newTable);
+		auto bufferPred = [] (const LargeBuffer& buffer1, const LargeBuffer& buffer2)
+			{ return buffer1.begin < buffer2.begin; };
+		while (table != nullptr)
+		{
+			LargeBuffer* buffers = pvGetLargeBuffers(table);
+			std::copy(buffers, buffers + table->count, newBuffers + newTable->count);
+			std::inplace_merge(newBuffers, newBuffers + newTable->count,
+				newBuffers + newTable->count + table->count, bufferPred);
+			newTable->count += table->count;
+			LargeBufferTable* nextTable = table->nextTable;
+			pvDeallocateLargeTable(table);
+			table = nextTable;
+		}
+		pvUpdateFirstFreeIndex(newTable, 0);
+		mBufferHead = internal::BitCaster::ToUInt(newTable);
+	}
+
+	void pvRemoveLargeTable(LargeBufferTable* table) noexcept
+	{
+		LargeBufferTable* headTable = pvGetLargeTable();
+		if (headTable == table)
+		{
+			mBufferHead = (table->nextTable != nullptr)
+				? internal::BitCaster::ToUInt(table->nextTable) : nullPtr;
+		}
+		else
+		{
+			LargeBufferTable* prevTable = headTable;
+			while (prevTable->nextTable != table)
+				prevTable = prevTable->nextTable;
+			prevTable->nextTable = table->nextTable;
+		}
+		pvDeallocateLargeTable(table);
+	}
+
+	void pvUpdateFirstFreeIndex(LargeBufferTable* table, size_t bufferIndex) noexcept
+	{
+		LargeBuffer* buffers = pvGetLargeBuffers(table);
+		while (bufferIndex < table->count && buffers[bufferIndex].freeBlockCount == 0)
+			++bufferIndex;
+		table->firstFreeIndex = bufferIndex;
+	}
+
+	void pvDeallocateLargeTable(LargeBufferTable* table) noexcept
+	{
+		MemManagerProxy::Deallocate(GetMemManager(), table, pvGetLargeTableSize(table->capacity));
+	}
+
+	LargeBufferTable* pvGetLargeTable() const noexcept
+	{
+		return (mBufferHead != nullPtr)
+			? internal::BitCaster::ToPtr<LargeBufferTable>(mBufferHead) : nullptr;
+	}
+
+	static LargeBuffer* pvGetLargeBuffers(LargeBufferTable* table) noexcept
+	{
+		return internal::BitCaster::PtrToPtr<LargeBuffer>(table, sizeof(LargeBufferTable));
+	}
+
+	static size_t pvGetLargeTableSize(size_t capacity) noexcept
+	{
+		return sizeof(LargeBufferTable) + capacity * sizeof(LargeBuffer);
+	}
+
+	size_t pvGetLargeBufferSize() const noexcept
+	{
+		return largeWordCount * sizeof(uint64_t) + Params::blockAlignment - 1
+			+ Params::blockCount * Params::blockSize;
+	}
+
+	uintptr_t pvGetLargeBlocksBegin(uintptr_t begin) const noexcept
+	{
+		return PMath::Ceil(begin + uintptr_t{largeWordCount * sizeof(uint64_t)},
+			uintptr_t{Params::blockAlignment});
+	}
+
+	static size_t pvCountTrailingZeros(uint64_t word) noexcept
+	{
+		MOMO_ASSERT(word != 0);
+#ifdef MOMO_CTZ64
+		return static_cast<size_t>(MOMO_CTZ64(word));
+#else
+		size_t index = 0;
+		for (; (word & 1) == 0; word >>= 1)
+			++index;
+		return index;
+#endif
+	}
+
 private:
 	uintptr_t mBufferHead;
 	size_t mAllocCount;
@@ -27,6 +27,12 @@ struct IsTriviallyRelocatable
 {
 };
 
+template<typename BaseMemManager, bool isEmpty>
+struct IsTriviallyRelocatable<internal::MemManagerPtr<BaseMemManager, isEmpty>>
+	: public std::true_type
+{
+};
+
 template<typename Object, typename MemManager>
 struct IsNothrowMoveConstructible
 	: public std::is_nothrow_move_constructible<Object>
@@ -85,7 +91,8 @@ private:
 	static void pvRelocate(MemManager* /*memManager*/, Object& srcObject, Object* dstObject,
 		std::true_type /*isTriviallyRelocatable*/) noexcept
 	{
-		memcpy(dstObject, std::addressof(srcObject), sizeof(Object));
+		memcpy(static_cast<void*>(dstObject), static_cast<const void*>(std::addressof(srcObject)),
+			sizeof(Object));
 	}
 
 	static void pvRelocate(MemManager* memManager, Object& srcObject, Object* dstObject,
@@ -0,0 +1,658 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/PackedArray.h
+
+  namespace momo:
+    class PackedArraySettings
+    class PackedArray
+    class BitArray
+
+  `PackedArray<bitCount>` stores unsigned integers of `bitCount` bits
+  (from 1 to 64) one after another in an array of 64-bit words.
+  If `bitCount` is 0, the number of bits is passed to the constructor.
+  Values are truncated to `bitCount` bits. Functions `Unpack` and `Pack`
+  convert a range of items to or from an ordinary array of integers
+  word by word; if `bitCount` is a divisor of 64, the inner loop has
+  constant bounds and shifts and can be vectorized by the compiler.
+
+  `BitArray` is a `PackedArray<1>` with the values of type `bool`
+  and functions `GetPopCount` and `GetRank`. `GetRank` takes constant
+  time: it keeps the counts of set bits before every block of
+  `rankWordCount` words. The counts are built lazily by `GetRank` and
+  cut back by the functions changing the bits, so simultaneous calls
+  of `GetRank` on the same array from different threads are not safe.
+
+  All `PackedArray` and `BitArray` functions and constructors have
+  strong exception safety, but not the following case:
+  1. If any constructor throws exception, input argument `memManager`
+    may be changed.
+
+\**********************************************************/
+
+#pragma once
+
+#include "Array.h"
+
+namespace momo
+{
+
+class PackedArraySettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+
+	typedef ArraySettings<> WordsSettings;
+};
+
+namespace internal
+{
+	template<size_t tBitCount>
+	class PackedArrayBitCount
+	{
+	public:
+		explicit PackedArrayBitCount(size_t bitCount = tBitCount) noexcept
+		{
+			(void)bitCount;
+			MOMO_ASSERT(bitCount == tBitCount);
+		}
+
+		static constexpr size_t Get() noexcept
+		{
+			return tBitCount;
+		}
+	};
+
+	template<>
+	class PackedArrayBitCount<0>
+	{
+	public:
+		explicit PackedArrayBitCount(size_t bitCount) noexcept
+			: mBitCount(bitCount)
+		{
+		}
+
+		size_t Get() const noexcept
+		{
+			return mBitCount;
+		}
+
+	private:
+		size_t mBitCount;
+	};
+}
+
+template<size_t tBitCount,
+	typename TMemManager = MemManagerDefault,
+	typename TSettings = PackedArraySettings>
+class PackedArray
+{
+public:
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+
+	typedef uint64_t Word;
+	typedef uint64_t Value;
+
+	static const size_t bitCount = tBitCount;
+	static const size_t wordBitCount = 64;
+	MOMO_STATIC_ASSERT(bitCount <= wordBitCount);
+
+private:
+	typedef internal::NestedArraySettings<typename Settings::WordsSettings> WordsSettings;
+
+	typedef Array<Word, MemManager, ArrayItemTraits<Word, MemManager>, WordsSettings> Words;
+
+	typedef internal::PackedArrayBitCount<bitCount> BitCount;
+
+	typedef internal::BoolConstant<bitCount != 0 && wordBitCount % (bitCount > 0 ? bitCount : 1) == 0>
+		IsWordAligned;
+
+public:
+	explicit PackedArray(MemManager&& memManager = MemManager())
+		: mWords(std::move(memManager)),
+		mCount(0),
+		mBitCount(bitCount)
+	{
+		MOMO_STATIC_ASSERT(bitCount > 0);
+	}
+
+	explicit PackedArray(size_t itemBitCount, MemManager&& memManager = MemManager())
+		: mWords(std::move(memManager)),
+		mCount(0),
+		mBitCount(itemBitCount)
+	{
+		MOMO_CHECK(0 < itemBitCount && itemBitCount <= wordBitCount);
+	}
+
+	PackedArray(PackedArray&& array) noexcept
+		: mWords(std::move(array.mWords)),
+		mCount(array.mCount),
+		mBitCount(array.mBitCount)
+	{
+		array.mCount = 0;
+	}
+
+	PackedArray(const PackedArray& array, bool shrink = true)
+		: mWords(array.mWords, shrink),
+		mCount(array.mCount),
+		mBitCount(array.mBitCount)
+	{
+	}
+
+	~PackedArray() noexcept
+	{
+	}
+
+	PackedArray& operator=(PackedArray&& array) noexcept
+	{
+		PackedArray(std::move(array)).Swap(*this);
+		return *this;
+	}
+
+	PackedArray& operator=(const PackedArray& array)
+	{
+		if (this != &array)
+			PackedArray(array).Swap(*this);
+		return *this;
+	}
+
+	void Swap(PackedArray& array) noexcept
+	{
+		mWords.Swap(array.mWords);
+		std::swap(mCount, array.mCount);
+		std::swap(mBitCount, array.mBitCount);
+	}
+
+	MOMO_FRIEND_SWAP(PackedArray)
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mWords.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mWords.GetMemManager();
+	}
+
+	size_t GetBitCount() const noexcept
+	{
+		return mBitCount.Get();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mCount;
+	}
+
+	void SetCount(size_t count, Value value = 0)
+	{
+		if (count < mCount)
+			return pvDecCount(count);
+		size_t initCount = mCount;
+		mWords.SetCount(pvGetWordCount(count), Word{0});
+		mCount = count;
+		if ((value & pvGetMask()) != 0)
+		{
+			for (size_t i = initCount; i < count; ++i)
+				pvSet(i, value);
+		}
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return mCount == 0;
+	}
+
+	void Clear(bool shrink = false) noexcept
+	{
+		mWords.Clear(shrink);
+		mCount = 0;
+	}
+
+	size_t GetCapacity() const noexcept
+	{
+		return mWords.GetCapacity() * wordBitCount / GetBitCount();
+	}
+
+	void Reserve(size_t capacity)
+	{
+		mWords.Reserve(pvGetWordCount(capacity));
+	}
+
+	void Shrink()
+	{
+		mWords.Shrink();
+	}
+
+	// Words after the last item are zero-filled
+	const Word* GetWords() const noexcept
+	{
+		return mWords.GetItems();
+	}
+
+	size_t GetWordCount() const noexcept
+	{
+		return mWords.GetCount();
+	}
+
+	Value Get(size_t index) const
+	{
+		MOMO_CHECK(index < mCount);
+		return pvGet(index);
+	}
+
+	Value operator[](size_t index) const
+	{
+		return Get(index);
+	}
+
+	Value GetBackItem() const
+	{
+		return Get(mCount - 1);
+	}
+
+	void Set(size_t index, Value value)
+	{
+		MOMO_CHECK(index < mCount);
+		pvSet(index, value);
+	}
+
+	void AddBack(Value value)
+	{
+		size_t wordCount = pvGetWordCount(mCount + 1);
+		if (wordCount > mWords.GetCount())
+			mWords.AddBack(Word{0});
+		pvSet(mCount, value);
+		++mCount;
+	}
+
+	void RemoveBack(size_t count = 1)
+	{
+		MOMO_CHECK(count <= mCount);
+		pvDecCount(mCount - count);
+	}
+
+	template<typename UInt>
+	void Unpack(size_t index, size_t count, UInt* values) const
+	{
+		MOMO_CHECK(index <= mCount && count <= mCount - index);
+		pvUnpack(index, count, values, IsWordAligned());
+	}
+
+	template<typename UInt>
+	void Pack(size_t index, size_t count, const UInt* values)
+	{
+		MOMO_CHECK(index <= mCount && count <= mCount - index);
+		pvPack(index, count, values, IsWordAligned());
+	}
+
+private:
+	Word pvGetMask() const noexcept
+	{
+		size_t itemBitCount = GetBitCount();
+		return (itemBitCount < wordBitCount) ? (Word{1} << itemBitCount) - 1 : ~Word{0};
+	}
+
+	size_t pvGetWordCount(size_t count) const
+	{
+		size_t itemBitCount = GetBitCount();
+		if (count > SIZE_MAX / itemBitCount - wordBitCount)
+			throw std::length_error("momo::PackedArray length error");
+		return (count * itemBitCount + wordBitCount - 1) / wordBitCount;
+	}
+
+	Value pvGet(size_t index) const noexcept
+	{
+		size_t itemBitCount = GetBitCount();
+		size_t bitIndex = index * itemBitCount;
+		const Word* word = mWords.GetItems() + bitIndex / wordBitCount;
+		size_t offset = bitIndex % wordBitCount;
+		Word value = word[0] >> offset;
+		if (offset + itemBitCount > wordBitCount)
+			value |= word[1] << (wordBitCount - offset);
+		return value & pvGetMask();
+	}
+
+	void pvSet(size_t index, Value value) noexcept
+	{
+		size_t itemBitCount = GetBitCount();
+		Word mask = pvGetMask();
+		value &= mask;
+		size_t bitIndex = index * itemBitCount;
+		Word* word = mWords.GetItems() + bitIndex / wordBitCount;
+		size_t offset = bitIndex % wordBitCount;
+		word[0] = (word[0] & ~(mask << offset)) | (value << offset);
+		if (offset + itemBitCount > wordBitCount)
+		{
+			size_t shift = wordBitCount - offset;
+			word[1] = (word[1] & ~(mask >> shift)) | (value >> shift);
+		}
+	}
+
+	void pvDecCount(size_t count) noexcept
+	{
+		MOMO_ASSERT(count <= mCount);
+		size_t bitIndex = count * GetBitCount();
+		mWords.RemoveBack(mWords.GetCount() - (bitIndex + wordBitCount - 1) / wordBitCount);
+		size_t offset = bitIndex % wordBitCount;
+		if (offset > 0)
+			mWords.GetBackItem() &= (Word{1} << offset) - 1;
+		mCount = count;
+	}
+
+	template<typename UInt>
+	void pvUnpack(size_t index, size_t count, UInt* values, std::false_type) const noexcept
+	{
+		size_t itemBitCount = GetBitCount();
+		Word mask = pvGetMask();
+		size_t bitIndex = index * itemBitCount;
+		const Word* word = mWords.GetItems() + bitIndex / wordBitCount;
+		size_t offset = bitIndex % wordBitCount;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Word value = *word >> offset;
+			offset += itemBitCount;
+			if (offset >= wordBitCount)
+			{
+				++word;
+				offset -= wordBitCount;
+				if (offset > 0)
+					value |= *word << (itemBitCount - offset);
+			}
+			values[i] = static_cast<UInt>(value & mask);
+		}
+	}
+
+	template<typename UInt>
+	void pvUnpack(size_t index, size_t count, UInt* values, std::true_type) const noexcept
+	{
+		static const size_t itemCountPerWord = wordBitCount / bitCount;
+		Word mask = pvGetMask();
+		size_t headCount = (itemCountPerWord - index % itemCountPerWord) % itemCountPerWord;
+		if (headCount > count)
+			headCount = count;
+		pvUnpack(index, headCount, values, std::false_type());
+		index += headCount;
+		values += headCount;
+		count -= headCount;
+		const Word* word = mWords.GetItems() + index / itemCountPerWord;
+		for (; count >= itemCountPerWord; count -= itemCountPerWord)
+		{
+			Word value = *word++;
+			for (size_t i = 0; i < itemCountPerWord; ++i)
+				values[i] = static_cast<UInt>((value >> (i * bitCount)) & mask);
+			index += itemCountPerWord;
+			values += itemCountPerWord;
+		}
+		pvUnpack(index, count, values, std::false_type());
+	}
+
+	template<typename UInt>
+	void pvPack(size_t index, size_t count, const UInt* values, std::false_type) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+			pvSet(index + i, static_cast<Value>(values[i]));
+	}
+
+	template<typename UInt>
+	void pvPack(size_t index, size_t count, const UInt* values, std::true_type) noexcept
+	{
+		static const size_t itemCountPerWord = wordBitCount / bitCount;
+		Word mask = pvGetMask();
+		size_t headCount = (itemCountPerWord - index % itemCountPerWord) % itemCountPerWord;
+		if (headCount > count)
+			headCount = count;
+		pvPack(index, headCount, values, std::false_type());
+		index += headCount;
+		values += headCount;
+		count -= headCount;
+		Word* word = mWords.GetItems() + index / itemCountPerWord;
+		for (; count >= itemCountPerWord; count -= itemCountPerWord)
+		{
+			Word value = 0;
+			for (size_t i = 0; i < itemCountPerWord; ++i)
+				value |= (static_cast<Word>(values[i]) & mask) << (i * bitCount);
+			*word++ = value;
+			index += itemCountPerWord;
+			values += itemCountPerWord;
+		}
+		pvPack(index, count, values, std::false_type());
+	}
+
+private:
+	Words mWords;
+	size_t mCount;
+	BitCount mBitCount;
+};
+
+template<typename TMemManager = MemManagerDefault,
+	typename TSettings = PackedArraySettings>
+class BitArray
+{
+public:
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+
+	typedef PackedArray<1, MemManager, Settings> Bits;
+	typedef typename Bits::Word Word;
+	typedef typename Bits::Value Value;
+
+	static const size_t wordBitCount = Bits::wordBitCount;
+
+	static const size_t rankWordCount = 8;
+
+private:
+	typedef Array<size_t, MemManager, ArrayItemTraits<size_t, MemManager>,
+		internal::NestedArraySettings<typename Settings::WordsSettings>> Ranks;
+
+public:
+	explicit BitArray(MemManager&& memManager = MemManager())
+		: mBits(std::move(memManager)),
+		mRanks(MemManager(mBits.GetMemManager()))
+	{
+	}
+
+	explicit BitArray(size_t count, bool value = false, MemManager&& memManager = MemManager())
+		: BitArray(std::move(memManager))
+	{
+		SetCount(count, value);
+	}
+
+	BitArray(BitArray&& array) noexcept
+		: mBits(std::move(array.mBits)),
+		mRanks(std::move(array.mRanks))
+	{
+	}
+
+	BitArray(const BitArray& array, bool shrink = true)
+		: mBits(array.mBits, shrink),
+		mRanks(MemManager(mBits.GetMemManager()))
+	{
+	}
+
+	~BitArray() noexcept
+	{
+	}
+
+	BitArray& operator=(BitArray&& array) noexcept
+	{
+		mBits = std::move(array.mBits);
+		mRanks = std::move(array.mRanks);
+		return *this;
+	}
+
+	BitArray& operator=(const BitArray& array)
+	{
+		mBits = array.mBits;
+		mRanks.Clear();
+		return *this;
+	}
+
+	void Swap(BitArray& array) noexcept
+	{
+		mBits.Swap(array.mBits);
+		mRanks.Swap(array.mRanks);
+	}
+
+	MOMO_FRIEND_SWAP(BitArray)
+
+	const Bits& GetBits() const noexcept
+	{
+		return mBits;
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mBits.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mBits.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mBits.GetCount();
+	}
+
+	void SetCount(size_t count, bool value = false)
+	{
+		size_t initCount = GetCount();
+		mBits.SetCount(count, static_cast<Value>(value));
+		pvCutRanks(std::minmax(count, initCount).first);
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return mBits.IsEmpty();
+	}
+
+	void Clear(bool shrink = false) noexcept
+	{
+		mBits.Clear(shrink);
+		mRanks.Clear(shrink);
+	}
+
+	size_t GetCapacity() const noexcept
+	{
+		return mBits.GetCapacity();
+	}
+
+	void Reserve(size_t capacity)
+	{
+		mBits.Reserve(capacity);
+	}
+
+	void Shrink()
+	{
+		mBits.Shrink();
+		mRanks.Shrink();
+	}
+
+	bool Get(size_t index) const
+	{
+		return mBits.Get(index) != 0;
+	}
+
+	bool operator[](size_t index) const
+	{
+		return Get(index);
+	}
+
+	void Set(size_t index, bool value = true)
+	{
+		mBits.Set(index, static_cast<Value>(value));
+		pvCutRanks(index);
+	}
+
+	void AddBack(bool value)
+	{
+		size_t index = GetCount();
+		mBits.AddBack(static_cast<Value>(value));
+		pvCutRanks(index);
+	}
+
+	void RemoveBack(size_t count = 1)
+	{
+		mBits.RemoveBack(count);
+		pvCutRanks(GetCount());
+	}
+
+	// number of set bits
+	size_t GetPopCount() const noexcept
+	{
+		const Word* words = mBits.GetWords();
+		size_t wordCount = mBits.GetWordCount();
+		size_t popCount = 0;
+		for (size_t i = 0; i < wordCount; ++i)
+			popCount += pvGetPopCount(words[i]);
+		return popCount;
+	}
+
+	// number of set bits before `index`
+	size_t GetRank(size_t index) const
+	{
+		MOMO_CHECK(index <= GetCount());
+		const Word* words = mBits.GetWords();
+		size_t wordCount = index / wordBitCount;
+		size_t blockIndex = wordCount / rankWordCount;
+		if (blockIndex >= mRanks.GetCount())
+			pvBuildRanks(blockIndex);
+		size_t rank = mRanks[blockIndex];
+		for (size_t i = blockIndex * rankWordCount; i < wordCount; ++i)
+			rank += pvGetPopCount(words[i]);
+		size_t offset = index % wordBitCount;
+		if (offset > 0)
+			rank += pvGetPopCount(words[wordCount] & ((Word{1} << offset) - 1));
+		return rank;
+	}
+
+private:
+	void pvBuildRanks(size_t blockIndex) const
+	{
+		const Word* words = mBits.GetWords();
+		mRanks.Reserve(blockIndex + 1);
+		if (mRanks.IsEmpty())
+			mRanks.AddBackNogrow(0);
+		while (mRanks.GetCount() <= blockIndex)
+		{
+			size_t beginWordIndex = (mRanks.GetCount() - 1) * rankWordCount;
+			size_t rank = mRanks.GetBackItem();
+			for (size_t i = beginWordIndex; i < beginWordIndex + rankWordCount; ++i)
+				rank += pvGetPopCount(words[i]);
+			mRanks.AddBackNogrow(rank);
+		}
+	}
+
+	// the counts of blocks after the one containing `index` become invalid
+	void pvCutRanks(size_t index) noexcept
+	{
+		size_t rankCount = index / wordBitCount / rankWordCount + 1;
+		if (mRanks.GetCount() > rankCount)
+			mRanks.RemoveBack(mRanks.GetCount() - rankCount);
+	}
+
+	static size_t pvGetPopCount(Word word) noexcept
+	{
+#ifdef MOMO_POPCOUNT64
+		return static_cast<size_t>(MOMO_POPCOUNT64(word));
+#else
+		word -= (word >> 1) & 0x5555555555555555;
+		word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+		word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0F;
+		return static_cast<size_t>((word * 0x0101010101010101) >> 56);
+#endif
+	}
+
+private:
+	Bits mBits;
+	mutable Ranks mRanks;
+};
+
+} // namespace momo
@@ -0,0 +1,610 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/PersistentTreeMap.h
+
+  namespace momo:
+    class PersistentTreeMapSettings
+    class PersistentTreeMap
+
+  `PersistentTreeMap` is a copy-on-write B+ tree. Its nodes are
+  reference-counted, so copying of the map takes O(1) time and the copy
+  is a consistent snapshot. Insertion and removal copy only the nodes
+  on the path from the root to the leaf, if these nodes are shared with
+  other versions of the map. Insertion of an existing key and removal
+  of an absent key copy nothing. A node with less than half of the
+  capacity is merged with its sibling on removal.
+  Node memory pools are shared between all versions and are protected
+  by a mutex while they are shared.
+  Different versions of the map can be used in different threads.
+
+  All `PersistentTreeMap` functions have strong exception safety
+  if the node splitting does not throw.
+
+\**********************************************************/
+
+#pragma once
+
+#include "TreeTraits.h"
+#include "details/TreeCore.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace momo
+{
+
+namespace internal
+{
+	class PersistentTreeNodeHeader
+	{
+	public:
+		explicit PersistentTreeNodeHeader() noexcept
+			: mRefCount(1)
+		{
+		}
+
+		PersistentTreeNodeHeader(const PersistentTreeNodeHeader&) = delete;
+
+		~PersistentTreeNodeHeader() noexcept
+		{
+		}
+
+		PersistentTreeNodeHeader& operator=(const PersistentTreeNodeHeader&) = delete;
+
+		void AddRef() noexcept
+		{
+			mRefCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		bool RemoveRef() noexcept
+		{
+			return mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1;
+		}
+
+		bool IsShared() const noexcept
+		{
+			return mRefCount.load(std::memory_order_acquire) > 1;
+		}
+
+	private:
+		std::atomic<size_t> mRefCount;
+	};
+
+	template<typename TMemManager, typename TMemPoolParams>
+	class PersistentTreeNodeParams
+	{
+	public:
+		typedef TMemManager MemManager;
+		typedef TMemPoolParams MemPoolParams;
+
+	private:
+		typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+
+		typedef momo::MemPool<MemPoolParams, MemManagerPtr, NestedMemPoolSettings> MemPool;
+
+	public:
+		explicit PersistentTreeNodeParams(MemManager&& memManager, size_t leafNodeSize,
+			size_t internalNodeSize)
+			: mRefCount(1),
+			mMemManager(std::move(memManager))
+		{
+			::new(static_cast<void*>(&mLeafMemPool)) MemPool(MemPoolParams(leafNodeSize),
+				MemManagerPtr(mMemManager));
+			try
+			{
+				::new(static_cast<void*>(&mInternalMemPool)) MemPool(
+					MemPoolParams(internalNodeSize), MemManagerPtr(mMemManager));
+			}
+			catch (...)
+			{
+				(&mLeafMemPool)->~MemPool();
+				throw;
+			}
+		}
+
+		PersistentTreeNodeParams(const PersistentTreeNodeParams&) = delete;
+
+		~PersistentTreeNodeParams() noexcept
+		{
+		}
+
+		PersistentTreeNodeParams& operator=(const PersistentTreeNodeParams&) = delete;
+
+		void AddRef() noexcept
+		{
+			mRefCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		bool RemoveRef() noexcept
+		{
+			return mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1;
+		}
+
+		const MemManager& GetMemManager() const noexcept
+		{
+			return mMemManager;
+		}
+
+		MemManager& GetMemManager() noexcept
+		{
+			return mMemManager;
+		}
+
+		// pools must be destroyed before the memory manager is moved out
+		void DestroyMemPools() noexcept
+		{
+			(&mLeafMemPool)->~MemPool();
+			(&mInternalMemPool)->~MemPool();
+		}
+
+		void* Allocate(bool isLeaf)
+		{
+			MemPool& memPool = pvGetMemPool(isLeaf);
+			if (!pvIsShared())
+				return memPool.Allocate();
+			std::lock_guard<std::mutex> lock(mMutex);
+			return memPool.Allocate();
+		}
+
+		void Deallocate(void* ptr, bool isLeaf) noexcept
+		{
+			MemPool& memPool = pvGetMemPool(isLeaf);
+			if (!pvIsShared())
+				return memPool.Deallocate(ptr);
+			std::lock_guard<std::mutex> lock(mMutex);
+			memPool.Deallocate(ptr);
+		}
+
+	private:
+		MemPool& pvGetMemPool(bool isLeaf) noexcept
+		{
+			return isLeaf ? *&mLeafMemPool : *&mInternalMemPool;
+		}
+
+		bool pvIsShared() const noexcept
+		{
+			return mRefCount.load(std::memory_order_acquire) > 1;
+		}
+
+	private:
+		std::atomic<size_t> mRefCount;
+		MemManager mMemManager;
+		std::mutex mMutex;
+		ObjectBuffer<MemPool, AlignmentOf<MemPool>::value> mLeafMemPool;
+		ObjectBuffer<MemPool, AlignmentOf<MemPool>::value> mInternalMemPool;
+	};
+}
+
+class PersistentTreeMapSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+	static const ExtraCheckMode extraCheckMode = ExtraCheckMode::bydefault;
+};
+
+template<typename TKey, typename TValue,
+	typename TTreeTraits = TreeTraits<TKey>,
+	typename TMemManager = MemManagerDefault,
+	typename TSettings = PersistentTreeMapSettings>
+class PersistentTreeMap
+{
+public:
+	typedef TKey Key;
+	typedef TValue Value;
+	typedef TTreeTraits TreeTraits;
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+
+	MOMO_STATIC_ASSERT(!TreeTraits::multiKey);
+
+private:
+	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	typedef typename TreeTraits::TreeNode TreeNode;
+
+	static const size_t nodeCapacity = TreeNode::maxCapacity;
+
+	typedef internal::TreeCoreNode<Key, nodeCapacity, internal::PersistentTreeNodeHeader> Node;
+	typedef internal::TreeCoreLeafNode<Node, Value> LeafNode;
+	typedef internal::TreeCoreInternalNode<Node> InternalNode;
+
+	typedef internal::TreeCore<LeafNode, InternalNode, TreeTraits, MemManager> TreeCore;
+
+	typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+
+	// indices of the children on the path from the root and index of the item in the leaf
+	typedef internal::NestedArrayIntCap<32, size_t, MemManagerPtr> Path;
+	typedef internal::NestedArrayIntCap<32, InternalNode*, MemManagerPtr> InternalNodes;
+
+	typedef internal::PersistentTreeNodeParams<MemManager,
+		typename TreeNode::MemPoolParams> NodeParams;
+
+public:
+	PersistentTreeMap()
+		: PersistentTreeMap(TreeTraits())
+	{
+	}
+
+	explicit PersistentTreeMap(const TreeTraits& treeTraits, MemManager&& memManager = MemManager())
+		: mTreeTraits(treeTraits),
+		mNodeParams(pvCreateNodeParams(std::move(memManager))),
+		mRootNode(nullptr),
+		mCount(0)
+	{
+	}
+
+	PersistentTreeMap(PersistentTreeMap&& treeMap) noexcept
+		: mTreeTraits(treeMap.mTreeTraits),
+		mNodeParams(treeMap.mNodeParams),
+		mRootNode(treeMap.mRootNode),
+		mCount(treeMap.mCount)
+	{
+		mNodeParams->AddRef();
+		treeMap.mRootNode = nullptr;
+		treeMap.mCount = 0;
+	}
+
+	PersistentTreeMap(const PersistentTreeMap& treeMap) noexcept
+		: mTreeTraits(treeMap.mTreeTraits),
+		mNodeParams(treeMap.mNodeParams),
+		mRootNode(treeMap.mRootNode),
+		mCount(treeMap.mCount)
+	{
+		mNodeParams->AddRef();
+		if (mRootNode != nullptr)
+			mRootNode->GetHeader().AddRef();
+	}
+
+	~PersistentTreeMap() noexcept
+	{
+		Clear();
+		if (mNodeParams->RemoveRef())
+		{
+			mNodeParams->DestroyMemPools();
+			MemManager memManager(std::move(mNodeParams->GetMemManager()));
+			mNodeParams->~NodeParams();
+			MemManagerProxy::Deallocate(memManager, mNodeParams, sizeof(NodeParams));
+		}
+	}
+
+	PersistentTreeMap& operator=(PersistentTreeMap&& treeMap) noexcept
+	{
+		PersistentTreeMap(std::move(treeMap)).Swap(*this);
+		return *this;
+	}
+
+	PersistentTreeMap& operator=(const PersistentTreeMap& treeMap) noexcept
+	{
+		if (this != &treeMap)
+			PersistentTreeMap(treeMap).Swap(*this);
+		return *this;
+	}
+
+	void Swap(PersistentTreeMap& treeMap) noexcept
+	{
+		std::swap(mTreeTraits, treeMap.mTreeTraits);
+		std::swap(mNodeParams, treeMap.mNodeParams);
+		std::swap(mRootNode, treeMap.mRootNode);
+		std::swap(mCount, treeMap.mCount);
+	}
+
+	MOMO_FRIEND_SWAP(PersistentTreeMap)
+
+	const TreeTraits& GetTreeTraits() const noexcept
+	{
+		return mTreeTraits;
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mNodeParams->GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mNodeParams->GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mCount;
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return mCount == 0;
+	}
+
+	void Clear() noexcept
+	{
+		if (mRootNode != nullptr)
+			pvRelease(mRootNode);
+		mRootNode = nullptr;
+		mCount = 0;
+	}
+
+	const Value* Find(const Key& key) const
+	{
+		return TreeCore::Find(mTreeTraits, mRootNode, key);
+	}
+
+	bool ContainsKey(const Key& key) const
+	{
+		return Find(key) != nullptr;
+	}
+
+	bool Insert(const Key& key, const Value& value)
+	{
+		return pvInsert<false>(key, value);
+	}
+
+	bool InsertOrAssign(const Key& key, const Value& value)
+	{
+		return pvInsert<true>(key, value);
+	}
+
+	bool Remove(const Key& key)
+	{
+		Path path((MemManagerPtr(GetMemManager())));
+		if (!pvFindPath(key, path))
+			return false;
+		pvRemove(path);
+		--mCount;
+		MOMO_EXTRA_CHECK(!ContainsKey(key));
+		return true;
+	}
+
+	// pairVisitor(const Key&, const Value&) returns `false` to stop the scan
+	template<typename PairVisitor>
+	void Scan(const PairVisitor& pairVisitor) const
+	{
+		if (mRootNode != nullptr)
+			TreeCore::Scan(mTreeTraits, mRootNode, nullptr, pairVisitor);
+	}
+
+	template<typename PairVisitor>
+	void Scan(const Key& lowKey, const PairVisitor& pairVisitor) const
+	{
+		if (mRootNode != nullptr)
+			TreeCore::Scan(mTreeTraits, mRootNode, std::addressof(lowKey), pairVisitor);
+	}
+
+private:
+	static NodeParams* pvCreateNodeParams(MemManager&& memManager)
+	{
+		NodeParams* nodeParams = MemManagerProxy::template Allocate<NodeParams>(memManager,
+			sizeof(NodeParams));
+		try
+		{
+			::new(static_cast<void*>(nodeParams)) NodeParams(std::move(memManager),
+				sizeof(LeafNode), sizeof(InternalNode));
+		}
+		catch (...)
+		{
+			MemManagerProxy::Deallocate(memManager, nodeParams, sizeof(NodeParams));
+			throw;
+		}
+		return nodeParams;
+	}
+
+	Node* pvCreateNode(bool isLeaf)
+	{
+		void* ptr = mNodeParams->Allocate(isLeaf);
+		if (isLeaf)
+			return ::new(ptr) LeafNode();
+		else
+			return ::new(ptr) InternalNode();
+	}
+
+	void pvFreeNode(Node* node) noexcept
+	{
+		bool isLeaf = node->IsLeaf();
+		if (isLeaf)
+			static_cast<LeafNode*>(node)->~LeafNode();
+		else
+			static_cast<InternalNode*>(node)->~InternalNode();
+		mNodeParams->Deallocate(node, isLeaf);
+	}
+
+	void pvRelease(Node* node) noexcept
+	{
+		if (!node->GetHeader().RemoveRef())
+			return;
+		TreeCore::DestroyItems(GetMemManager(), node);
+		if (!node->IsLeaf())
+		{
+			InternalNode* internalNode = static_cast<InternalNode*>(node);
+			size_t count = node->GetCount();
+			for (size_t i = 0; i <= count; ++i)
+				pvRelease(internalNode->GetChild(i));
+		}
+		pvFreeNode(node);
+	}
+
+	Node* pvCloneNode(Node* node)
+	{
+		Node* newNode = pvCreateNode(node->IsLeaf());
+		try
+		{
+			TreeCore::CopyItems(GetMemManager(), node, newNode);
+		}
+		catch (...)
+		{
+			pvFreeNode(newNode);
+			throw;
+		}
+		if (!node->IsLeaf())
+		{
+			InternalNode* internalNode = static_cast<InternalNode*>(node);
+			InternalNode* newInternalNode = static_cast<InternalNode*>(newNode);
+			size_t count = node->GetCount();
+			for (size_t i = 0; i <= count; ++i)
+			{
+				Node* childNode = internalNode->GetChild(i);
+				childNode->GetHeader().AddRef();
+				newInternalNode->SetChild(i, childNode);
+			}
+		}
+		return newNode;
+	}
+
+	void pvMakeUnique(Node*& node)
+	{
+		if (!node->GetHeader().IsShared())
+			return;
+		Node* newNode = pvCloneNode(node);
+		pvRelease(node);
+		node = newNode;
+	}
+
+	Node* pvGetUniqueChild(InternalNode* node, size_t index)
+	{
+		Node* childNode = node->GetChild(index);
+		pvMakeUnique(childNode);
+		node->SetChild(index, childNode);
+		return childNode;
+	}
+
+	template<bool assign>
+	bool pvInsert(const Key& key, const Value& value)
+	{
+		if (!assign && ContainsKey(key))
+			return false;	// nothing is copied
+		if (mRootNode == nullptr)
+			mRootNode = pvCreateNode(true);
+		pvMakeUnique(mRootNode);
+		if (mRootNode->GetCount() == nodeCapacity)
+		{
+			InternalNode* newRootNode = static_cast<InternalNode*>(pvCreateNode(false));
+			newRootNode->SetChild(0, mRootNode);
+			try
+			{
+				pvSplitChild(newRootNode, 0);
+			}
+			catch (...)
+			{
+				pvFreeNode(newRootNode);
+				throw;
+			}
+			mRootNode = newRootNode;
+		}
+		Node* node = mRootNode;
+		while (!node->IsLeaf())
+		{
+			InternalNode* internalNode = static_cast<InternalNode*>(node);
+			size_t index = TreeCore::GetUpperBound(mTreeTraits, internalNode, key);
+			Node* childNode = pvGetUniqueChild(internalNode, index);
+			if (childNode->GetCount() == nodeCapacity)
+			{
+				pvSplitChild(internalNode, index);
+				if (!mTreeTraits.IsLess(key, *internalNode->GetKeyPtr(index)))
+					++index;
+				childNode = internalNode->GetChild(index);
+			}
+			node = childNode;
+		}
+		LeafNode* leafNode = static_cast<LeafNode*>(node);
+		size_t index;
+		if (TreeCore::FindItem(mTreeTraits, leafNode, key, index))
+		{
+			if (assign)
+				*leafNode->GetValuePtr(index) = value;
+			return false;
+		}
+		TreeCore::InsertItem(GetMemManager(), leafNode, index, key, value);
+		++mCount;
+		MOMO_EXTRA_CHECK(ContainsKey(key));
+		return true;
+	}
+
+	void pvSplitChild(InternalNode* node, size_t index)
+	{
+		Node* newNode = pvCreateNode(node->GetChild(index)->IsLeaf());
+		try
+		{
+			TreeCore::SplitChild(GetMemManager(), node, index, newNode);
+		}
+		catch (...)
+		{
+			pvFreeNode(newNode);
+			throw;
+		}
+	}
+
+	bool pvFindPath(const Key& key, Path& path) const
+	{
+		if (mRootNode == nullptr)
+			return false;
+		const Node* node = mRootNode;
+		while (!node->IsLeaf())
+		{
+			const InternalNode* internalNode = static_cast<const InternalNode*>(node);
+			size_t index = TreeCore::GetUpperBound(mTreeTraits, internalNode, key);
+			path.AddBack(index);
+			node = internalNode->GetChild(index);
+		}
+		size_t index;
+		if (!TreeCore::FindItem(mTreeTraits, static_cast<const LeafNode*>(node), key, index))
+			return false;
+		path.AddBack(index);
+		return true;
+	}
+
+	void pvRemove(const Path& path)
+	{
+		// all nodes, which may be changed, are made unique before the first change
+		size_t depth = path.GetCount() - 1;
+		InternalNodes nodes((MemManagerPtr(GetMemManager())));
+		nodes.Reserve(depth);
+		pvMakeUnique(mRootNode);
+		Node* node = mRootNode;
+		for (size_t i = 0; i < depth; ++i)
+		{
+			InternalNode* internalNode = static_cast<InternalNode*>(node);
+			nodes.AddBackNogrow(internalNode);
+			size_t index = path[i];
+			node = pvGetUniqueChild(internalNode, index);
+			if (node->GetCount() <= TreeCore::minCount && internalNode->GetCount() > 0)
+				pvGetUniqueChild(internalNode, (index > 0) ? index - 1 : index + 1);
+		}
+		MemManager& memManager = GetMemManager();
+		TreeCore::RemoveItem(memManager, static_cast<LeafNode*>(node), path[depth]);
+		for (size_t i = depth; i > 0; --i)
+		{
+			InternalNode* internalNode = nodes[i - 1];
+			size_t index = path[i - 1];
+			if (internalNode->GetChild(index)->GetCount() >= TreeCore::minCount
+				|| internalNode->GetCount() == 0)
+			{
+				continue;
+			}
+			Node* freeNode = TreeCore::MergeChildren(memManager, internalNode,
+				(index > 0) ? index - 1 : index);
+			if (freeNode != nullptr)
+				pvFreeNode(freeNode);
+		}
+		while (!mRootNode->IsLeaf() && mRootNode->GetCount() == 0)
+		{
+			Node* rootNode = mRootNode;
+			mRootNode = static_cast<InternalNode*>(rootNode)->GetChild(0);
+			pvFreeNode(rootNode);
+		}
+		if (mRootNode->GetCount() == 0)
+		{
+			pvFreeNode(mRootNode);
+			mRootNode = nullptr;
+		}
+	}
+
+private:
+	TreeTraits mTreeTraits;
+	NodeParams* mNodeParams;
+	Node* mRootNode;
+	size_t mCount;
+};
+
+} // namespace momo
@@ -0,0 +1,1768 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/RadixTreeMap.h
+
+  namespace momo:
+    class RadixTreeTraits
+    class RadixTreeMapSettings
+    class RadixTreeMap
+
+  `RadixTreeMap` is an adaptive radix tree (ART). Keys are split into
+  bytes (`RadixTreeTraits::GetByteCount`, `RadixTreeTraits::GetByte`)
+  and are ordered lexicographically by these byte sequences. Inner
+  nodes grow and shrink between 4, 16, 48 and 256 children, common
+  key prefixes are compressed into nodes, so the tree height does not
+  depend on the number of items. Search in a node of 16 children
+  uses SSE2. Items are kept in a doubly linked list in key order,
+  so iterator increment and decrement are O(1).
+
+  `RadixTreeTraits` supports integral keys (ordered by value) and
+  `std::basic_string` keys (ordered by characters as unsigned numbers).
+
+  All `RadixTreeMap` functions and constructors have strong exception
+  safety. After each addition or removal of the item all iterators
+  become invalid, but references to items stay valid until the item
+  is removed.
+
+\**********************************************************/
+
+#pragma once
+
+#include "MapUtility.h"
+#include "SetUtility.h"
+#include "MemPool.h"
+
+#include <string>
+
+namespace momo
+{
+
+namespace internal
+{
+	template<typename TKey,
+		bool tIsIntegral = std::is_integral<TKey>::value && !std::is_same<TKey, bool>::value>
+	class RadixTreeKeyBytes;
+
+	template<typename TKey>
+	class RadixTreeKeyBytes<TKey, true>
+	{
+	public:
+		typedef TKey Key;
+
+	private:
+		typedef typename std::make_unsigned<Key>::type UKey;
+
+	public:
+		static size_t GetCount(const Key& /*key*/) noexcept
+		{
+			return sizeof(Key);
+		}
+
+		static uint8_t GetByte(const Key& key, size_t index) noexcept
+		{
+			MOMO_ASSERT(index < sizeof(Key));
+			UKey ukey = static_cast<UKey>(key);
+			if (std::is_signed<Key>::value)
+				ukey = static_cast<UKey>(ukey ^ (UKey{1} << (8 * sizeof(Key) - 1)));
+			return static_cast<uint8_t>(ukey >> (8 * (sizeof(Key) - 1 - index)));
+		}
+	};
+
+	template<typename TChar, typename TCharTraits, typename TAllocator>
+	class RadixTreeKeyBytes<std::basic_string<TChar, TCharTraits, TAllocator>, false>
+	{
+	public:
+		typedef std::basic_string<TChar, TCharTraits, TAllocator> Key;
+
+	private:
+		typedef typename std::make_unsigned<TChar>::type UChar;
+
+	public:
+		static size_t GetCount(const Key& key) noexcept
+		{
+			return key.size() * sizeof(TChar);
+		}
+
+		static uint8_t GetByte(const Key& key, size_t index) noexcept
+		{
+			UChar uchar = static_cast<UChar>(key[index / sizeof(TChar)]);
+			return static_cast<uint8_t>(uchar >> (8 * (sizeof(TChar) - 1 - index % sizeof(TChar))));
+		}
+	};
+
+	class RadixTreeNode
+	{
+	public:
+		static const size_t maxPrefixLength = 8;
+
+	public:
+		explicit RadixTreeNode(size_t type) noexcept
+			: mType(static_cast<uint8_t>(type)),
+			mCount(0),
+			mPrefixLength(0),
+			mTerminal(0)
+		{
+		}
+
+		RadixTreeNode(const RadixTreeNode&) = delete;
+
+		~RadixTreeNode() noexcept
+		{
+		}
+
+		RadixTreeNode& operator=(const RadixTreeNode&) = delete;
+
+		size_t GetType() const noexcept
+		{
+			return size_t{mType};
+		}
+
+		size_t GetCount() const noexcept
+		{
+			return size_t{mCount};
+		}
+
+		size_t GetPrefixLength() const noexcept
+		{
+			return size_t{mPrefixLength};
+		}
+
+		// only the first `maxPrefixLength` bytes of the prefix are stored
+		const uint8_t* GetPrefix() const noexcept
+		{
+			return mPrefix;
+		}
+
+		uint8_t* GetPrefix() noexcept
+		{
+			return mPrefix;
+		}
+
+		void SetPrefixLength(size_t prefixLength) noexcept
+		{
+			MOMO_ASSERT(prefixLength <= size_t{UINT32_MAX});
+			mPrefixLength = static_cast<uint32_t>(prefixLength);
+		}
+
+		void SetPrefix(const uint8_t* prefix, size_t prefixLength) noexcept
+		{
+			SetPrefixLength(prefixLength);
+			std::copy_n(prefix, GetStoredPrefixLength(prefixLength), mPrefix);
+		}
+
+		// leaf with the key, which ends on this node
+		uintptr_t GetTerminal() const noexcept
+		{
+			return mTerminal;
+		}
+
+		void SetTerminal(uintptr_t terminal) noexcept
+		{
+			mTerminal = terminal;
+		}
+
+		static size_t GetStoredPrefixLength(size_t prefixLength) noexcept
+		{
+			if (prefixLength < maxPrefixLength)
+				return prefixLength;
+			return maxPrefixLength;
+		}
+
+	protected:
+		void ptSetCount(size_t count) noexcept
+		{
+			mCount = static_cast<uint16_t>(count);
+		}
+
+	private:
+		uint8_t mType;
+		uint16_t mCount;
+		uint32_t mPrefixLength;
+		uint8_t mPrefix[maxPrefixLength];
+		uintptr_t mTerminal;
+	};
+
+	template<size_t tCapacity>
+	class RadixTreeNodeSorted : public RadixTreeNode
+	{
+	public:
+		static const size_t capacity = tCapacity;
+		MOMO_STATIC_ASSERT(capacity == 4 || capacity == 16);
+
+		static const size_t type = (capacity == 4) ? 0 : 1;
+
+	public:
+		explicit RadixTreeNodeSorted() noexcept
+			: RadixTreeNode(type)
+		{
+		}
+
+		uintptr_t* FindChild(uint8_t byte) noexcept
+		{
+			size_t index = pvFindIndex(byte, BoolConstant<capacity == 16>());
+			return (index < GetCount()) ? &mChildren[index] : nullptr;
+		}
+
+		// first child with the byte not less than `byte`
+		uintptr_t GetNextChild(size_t byte) const noexcept
+		{
+			size_t index = pvGetLowerBound(byte);
+			return (index < GetCount()) ? mChildren[index] : uintptr_t{0};
+		}
+
+		// last child with the byte less than `byte`
+		uintptr_t GetPrevChild(size_t byte) const noexcept
+		{
+			size_t index = pvGetLowerBound(byte);
+			return (index > 0) ? mChildren[index - 1] : uintptr_t{0};
+		}
+
+		void AddChild(uint8_t byte, uintptr_t child) noexcept
+		{
+			size_t count = GetCount();
+			MOMO_ASSERT(count < capacity);
+			size_t index = pvGetLowerBound(byte);
+			for (size_t i = count; i > index; --i)
+			{
+				mBytes[i] = mBytes[i - 1];
+				mChildren[i] = mChildren[i - 1];
+			}
+			mBytes[index] = byte;
+			mChildren[index] = child;
+			ptSetCount(count + 1);
+		}
+
+		void RemoveChild(uint8_t byte) noexcept
+		{
+			size_t count = GetCount();
+			size_t index = pvGetLowerBound(byte);
+			MOMO_ASSERT(index < count && mBytes[index] == byte);
+			for (size_t i = index + 1; i < count; ++i)
+			{
+				mBytes[i - 1] = mBytes[i];
+				mChildren[i - 1] = mChildren[i];
+			}
+			ptSetCount(count - 1);
+		}
+
+		template<typename ChildFunc>
+		void ForEachChild(const ChildFunc& childFunc) const
+		{
+			size_t count = GetCount();
+			for (size_t i = 0; i < count; ++i)
+				childFunc(mBytes[i], mChildren[i]);
+		}
+
+	private:
+		size_t pvGetLowerBound(size_t byte) const noexcept
+		{
+			size_t count = GetCount();
+			size_t index = 0;
+			while (index < count && size_t{mBytes[index]} < byte)
+				++index;
+			return index;
+		}
+
+		size_t pvFindIndex(uint8_t byte, std::false_type /*isNode16*/) const noexcept
+		{
+			size_t count = GetCount();
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (mBytes[i] == byte)
+					return i;
+			}
+			return count;
+		}
+
+		size_t pvFindIndex(uint8_t byte, std::true_type /*isNode16*/) const noexcept
+		{
+#ifdef MOMO_USE_SSE2
+			__m128i bytes = _mm_set1_epi8(static_cast<char>(byte));
+			__m128i thisBytes = _mm_loadu_si128(BitCaster::PtrToPtr<const __m128i>(mBytes, 0));
+			int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, thisBytes));
+			mask &= (1 << GetCount()) - 1;
+			if (mask == 0)
+				return GetCount();
+#ifdef MOMO_CTZ32
+			return static_cast<size_t>(MOMO_CTZ32(static_cast<uint32_t>(mask)));
+#else
+			size_t index = 0;
+			for (; (mask & 1) == 0; mask >>= 1)
+				++index;
+			return index;
+#endif
+#else
+			return pvFindIndex(byte, std::false_type());
+#endif
+		}
+
+	private:
+		uint8_t mBytes[capacity];
+		uintptr_t mChildren[capacity];
+	};
+
+	class RadixTreeNode48 : public RadixTreeNode
+	{
+	public:
+		static const size_t capacity = 48;
+
+		static const size_t type = 2;
+
+	public:
+		explicit RadixTreeNode48() noexcept
+			: RadixTreeNode(type)
+		{
+			std::fill_n(mIndexes, 256, uint8_t{0});
+			std::fill_n(mChildren, capacity, uintptr_t{0});
+		}
+
+		uintptr_t* FindChild(uint8_t byte) noexcept
+		{
+			size_t index = size_t{mIndexes[byte]};
+			return (index > 0) ? &mChildren[index - 1] : nullptr;
+		}
+
+		uintptr_t GetNextChild(size_t byte) const noexcept
+		{
+			for (size_t b = byte; b < 256; ++b)
+			{
+				if (mIndexes[b] > 0)
+					return mChildren[mIndexes[b] - 1];
+			}
+			return 0;
+		}
+
+		uintptr_t GetPrevChild(size_t byte) const noexcept
+		{
+			for (size_t b = byte; b > 0; --b)
+			{
+				if (mIndexes[b - 1] > 0)
+					return mChildren[mIndexes[b - 1] - 1];
+			}
+			return 0;
+		}
+
+		void AddChild(uint8_t byte, uintptr_t child) noexcept
+		{
+			size_t count = GetCount();
+			MOMO_ASSERT(count < capacity && mIndexes[byte] == 0);
+			size_t index = 0;
+			while (mChildren[index] != 0)
+				++index;
+			mChildren[index] = child;
+			mIndexes[byte] = static_cast<uint8_t>(index + 1);
+			ptSetCount(count + 1);
+		}
+
+		void RemoveChild(uint8_t byte) noexcept
+		{
+			MOMO_ASSERT(mIndexes[byte] > 0);
+			mChildren[mIndexes[byte] - 1] = 0;
+			mIndexes[byte] = 0;
+			ptSetCount(GetCount() - 1);
+		}
+
+		template<typename ChildFunc>
+		void ForEachChild(const ChildFunc& childFunc) const
+		{
+			for (size_t b = 0; b < 256; ++b)
+			{
+				if (mIndexes[b] > 0)
+					childFunc(static_cast<uint8_t>(b), mChildren[mIndexes[b] - 1]);
+			}
+		}
+
+	private:
+		uint8_t mIndexes[256];
+		uintptr_t mChildren[capacity];
+	};
+
+	class RadixTreeNode256 : public RadixTreeNode
+	{
+	public:
+		static const size_t capacity = 256;
+
+		static const size_t type = 3;
+
+	public:
+		explicit RadixTreeNode256() noexcept
+			: RadixTreeNode(type)
+		{
+			std::fill_n(mChildren, capacity, uintptr_t{0});
+		}
+
+		uintptr_t* FindChild(uint8_t byte) noexcept
+		{
+			return (mChildren[byte] != 0) ? &mChildren[byte] : nullptr;
+		}
+
+		uintptr_t GetNextChild(size_t byte) const noexcept
+		{
+			for (size_t b = byte; b < 256; ++b)
+			{
+				if (mChildren[b] != 0)
+					return mChildren[b];
+			}
+			return 0;
+		}
+
+		uintptr_t GetPrevChild(size_t byte) const noexcept
+		{
+			for (size_t b = byte; b > 0; --b)
+			{
+				if (mChildren[b - 1] != 0)
+					return mChildren[b - 1];
+			}
+			return 0;
+		}
+
+		void AddChild(uint8_t byte, uintptr_t child) noexcept
+		{
+			MOMO_ASSERT(mChildren[byte] == 0);
+			mChildren[byte] = child;
+			ptSetCount(GetCount() + 1);
+		}
+
+		void RemoveChild(uint8_t byte) noexcept
+		{
+			MOMO_ASSERT(mChildren[byte] != 0);
+			mChildren[byte] = 0;
+			ptSetCount(GetCount() - 1);
+		}
+
+		template<typename ChildFunc>
+		void ForEachChild(const ChildFunc& childFunc) const
+		{
+			for (size_t b = 0; b < 256; ++b)
+			{
+				if (mChildren[b] != 0)
+					childFunc(static_cast<uint8_t>(b), mChildren[b]);
+			}
+		}
+
+	private:
+		uintptr_t mChildren[capacity];
+	};
+
+	class RadixTreeNodeUtility
+	{
+	public:
+		typedef RadixTreeNode Node;
+		typedef RadixTreeNodeSorted<4> Node4;
+		typedef RadixTreeNodeSorted<16> Node16;
+		typedef RadixTreeNode48 Node48;
+		typedef RadixTreeNode256 Node256;
+
+	public:
+		static size_t GetSize(size_t type) noexcept
+		{
+			static const size_t sizes[] = { sizeof(Node4), sizeof(Node16),
+				sizeof(Node48), sizeof(Node256) };
+			return sizes[type];
+		}
+
+		static bool IsFull(const Node* node) noexcept
+		{
+			static const size_t capacities[] = { Node4::capacity, Node16::capacity,
+				Node48::capacity, Node256::capacity };
+			return node->GetCount() == capacities[node->GetType()];
+		}
+
+		// node is replaced by the smaller one, when the count decreases to this value
+		static size_t GetShrinkCount(size_t type) noexcept
+		{
+			static const size_t shrinkCounts[] = { 0, 3, 12, 40 };
+			return shrinkCounts[type];
+		}
+
+		static Node* Create(size_t type, void* ptr) noexcept
+		{
+			switch (type)
+			{
+			case Node4::type:
+				return ::new(ptr) Node4();
+			case Node16::type:
+				return ::new(ptr) Node16();
+			case Node48::type:
+				return ::new(ptr) Node48();
+			default:
+				return ::new(ptr) Node256();
+			}
+		}
+
+		static uintptr_t* FindChild(Node* node, uint8_t byte) noexcept
+		{
+			switch (node->GetType())
+			{
+			case Node4::type:
+				return static_cast<Node4*>(node)->FindChild(byte);
+			case Node16::type:
+				return static_cast<Node16*>(node)->FindChild(byte);
+			case Node48::type:
+				return static_cast<Node48*>(node)->FindChild(byte);
+			default:
+				return static_cast<Node256*>(node)->FindChild(byte);
+			}
+		}
+
+		static uintptr_t GetNextChild(const Node* node, size_t byte) noexcept
+		{
+			switch (node->GetType())
+			{
+			case Node4::type:
+				return static_cast<const Node4*>(node)->GetNextChild(byte);
+			case Node16::type:
+				return static_cast<const Node16*>(node)->GetNextChild(byte);
+			case Node48::type:
+				return static_cast<const Node48*>(node)->GetNextChild(byte);
+			default:
+				return static_cast<const Node256*>(node)->GetNextChild(byte);
+			}
+		}
+
+		static uintptr_t GetPrevChild(const Node* node, size_t byte) noexcept
+		{
+			switch (node->GetType())
+			{
+			case Node4::type:
+				return static_cast<const Node4*>(node)->GetPrevChild(byte);
+			case Node16::type:
+				return static_cast<const Node16*>(node)->GetPrevChild(byte);
+			case Node48::type:
+				return static_cast<const Node48*>(node)->GetPrevChild(byte);
+			default:
+				return static_cast<const Node256*>(node)->GetPrevChild(byte);
+			}
+		}
+
+		static void AddChild(Node* node, uint8_t byte, uintptr_t child) noexcept
+		{
+			switch (node->GetType())
+			{
+			case Node4::type:
+				return static_cast<Node4*>(node)->AddChild(byte, child);
+			case Node16::type:
+				return static_cast<Node16*>(node)->AddChild(byte, child);
+			case Node48::type:
+				return static_cast<Node48*>(node)->AddChild(byte, child);
+			default:
+				return static_cast<Node256*>(node)->AddChild(byte, child);
+			}
+		}
+
+		static void RemoveChild(Node* node, uint8_t byte) noexcept
+		{
+			switch (node->GetType())
+			{
+			case Node4::type:
+				return static_cast<Node4*>(node)->RemoveChild(byte);
+			case Node16::type:
+				return static_cast<Node16*>(node)->RemoveChild(byte);
+			case Node48::type:
+				return static_cast<Node48*>(node)->RemoveChild(byte);
+			default:
+				return static_cast<Node256*>(node)->RemoveChild(byte);
+			}
+		}
+
+		// childFunc(uint8_t byte, uintptr_t child) is called in the byte order
+		template<typename ChildFunc>
+		static void ForEachChild(const Node* node, const ChildFunc& childFunc)
+		{
+			switch (node->GetType())
+			{
+			case Node4::type:
+				return static_cast<const Node4*>(node)->ForEachChild(childFunc);
+			case Node16::type:
+				return static_cast<const Node16*>(node)->ForEachChild(childFunc);
+			case Node48::type:
+				return static_cast<const Node48*>(node)->ForEachChild(childFunc);
+			default:
+				return static_cast<const Node256*>(node)->ForEachChild(childFunc);
+			}
+		}
+	};
+
+	class RadixTreeLeafLinks
+	{
+	public:
+		explicit RadixTreeLeafLinks() noexcept
+			: mPrev(this),
+			mNext(this)
+		{
+		}
+
+		RadixTreeLeafLinks(const RadixTreeLeafLinks&) = delete;
+
+		~RadixTreeLeafLinks() noexcept
+		{
+		}
+
+		RadixTreeLeafLinks& operator=(const RadixTreeLeafLinks&) = delete;
+
+		RadixTreeLeafLinks* GetPrev() const noexcept
+		{
+			return mPrev;
+		}
+
+		RadixTreeLeafLinks* GetNext() const noexcept
+		{
+			return mNext;
+		}
+
+		void Link(RadixTreeLeafLinks* nextLinks) noexcept
+		{
+			mPrev = nextLinks->mPrev;
+			mNext = nextLinks;
+			mPrev->mNext = this;
+			mNext->mPrev = this;
+		}
+
+		void Unlink() noexcept
+		{
+			mPrev->mNext = mNext;
+			mNext->mPrev = mPrev;
+			Reset();
+		}
+
+		void Reset() noexcept
+		{
+			mPrev = this;
+			mNext = this;
+		}
+
+	private:
+		RadixTreeLeafLinks* mPrev;
+		RadixTreeLeafLinks* mNext;
+	};
+
+	template<typename TKeyValueTraits>
+	class RadixTreeLeaf : public RadixTreeLeafLinks
+	{
+	public:
+		typedef TKeyValueTraits KeyValueTraits;
+		typedef typename KeyValueTraits::Key Key;
+		typedef typename KeyValueTraits::Value Value;
+
+		typedef RadixTreeLeafLinks Links;
+
+	private:
+		typedef ObjectBuffer<Key, KeyValueTraits::keyAlignment> KeyBuffer;
+		typedef ObjectBuffer<Value, KeyValueTraits::valueAlignment> ValueBuffer;
+
+	public:
+		explicit RadixTreeLeaf() noexcept
+		{
+		}
+
+		Key* GetKeyPtr() noexcept
+		{
+			return &mKeyBuffer;
+		}
+
+		Value* GetValuePtr() noexcept
+		{
+			return &mValueBuffer;
+		}
+
+	private:
+		KeyBuffer mKeyBuffer;
+		ValueBuffer mValueBuffer;
+	};
+
+	template<typename TLeaf, typename TSettings, bool tIsConst>
+	class RadixTreeMapIterator : private VersionKeeper<TSettings>
+	{
+	protected:
+		typedef TLeaf Leaf;
+		typedef TSettings Settings;
+		typedef typename Leaf::Links Links;
+
+	public:
+		typedef MapReference<typename Leaf::Key,
+			typename std::conditional<tIsConst, const typename Leaf::Value,
+				typename Leaf::Value>::type, Leaf&> Reference;
+
+		typedef IteratorPointer<Reference> Pointer;
+
+		typedef RadixTreeMapIterator<Leaf, Settings, true> ConstIterator;
+
+	private:
+		typedef internal::VersionKeeper<Settings> VersionKeeper;
+
+		struct ConstIteratorProxy : public ConstIterator
+		{
+			MOMO_DECLARE_PROXY_CONSTRUCTOR(ConstIterator)
+			MOMO_DECLARE_PROXY_FUNCTION(ConstIterator, GetLinks, Links*)
+		};
+
+	public:
+		explicit RadixTreeMapIterator() noexcept
+			: mLinks(nullptr)
+		{
+		}
+
+		operator ConstIterator() const noexcept
+		{
+			return ConstIteratorProxy(mLinks, static_cast<const VersionKeeper&>(*this));
+		}
+
+		RadixTreeMapIterator& operator++()
+		{
+			VersionKeeper::Check();
+			MOMO_CHECK(mLinks != nullptr);
+			mLinks = mLinks->GetNext();
+#ifdef MOMO_PREFETCH
+			MOMO_PREFETCH(mLinks->GetNext());
+#endif
+			return *this;
+		}
+
+		RadixTreeMapIterator& operator--()
+		{
+			VersionKeeper::Check();
+			MOMO_CHECK(mLinks != nullptr);
+			mLinks = mLinks->GetPrev();
+			return *this;
+		}
+
+		Pointer operator->() const
+		{
+			VersionKeeper::Check();
+			MOMO_CHECK(mLinks != nullptr);
+			Leaf* leaf = static_cast<Leaf*>(mLinks);
+			return Pointer(Reference(*leaf->GetKeyPtr(), *leaf->GetValuePtr()));
+		}
+
+		bool operator==(ConstIterator iter) const noexcept
+		{
+			return mLinks == ConstIteratorProxy::GetLinks(iter);
+		}
+
+		MOMO_MORE_TREE_ITERATOR_OPERATORS(RadixTreeMapIterator)
+
+	protected:
+		explicit RadixTreeMapIterator(Links* links, const size_t* version) noexcept
+			: VersionKeeper(version),
+			mLinks(links)
+		{
+		}
+
+		explicit RadixTreeMapIterator(Links* links, const VersionKeeper& versionKeeper) noexcept
+			: VersionKeeper(versionKeeper),
+			mLinks(links)
+		{
+		}
+
+		Links* ptGetLinks() const noexcept
+		{
+			return mLinks;
+		}
+
+		void ptCheck(const size_t* version, bool allowEmpty) const
+		{
+			VersionKeeper::Check(version, allowEmpty);
+			MOMO_CHECK(allowEmpty || mLinks != nullptr);
+		}
+
+	private:
+		Links* mLinks;
+	};
+
+	template<typename TMemManager, typename TMemPoolParams>
+	class RadixTreeNodeParams
+	{
+	public:
+		typedef TMemManager MemManager;
+		typedef TMemPoolParams MemPoolParams;
+
+		typedef RadixTreeLeafLinks Links;
+
+	private:
+		typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+
+		typedef momo::MemPool<MemPoolParams, MemManagerPtr, NestedMemPoolSettings> MemPool;
+
+		typedef RadixTreeNodeUtility NodeUtility;
+
+	public:
+		explicit RadixTreeNodeParams(MemManager& memManager, size_t leafSize)
+			: mNode4MemPool(MemPoolParams(NodeUtility::GetSize(0)), MemManagerPtr(memManager)),
+			mNode16MemPool(MemPoolParams(NodeUtility::GetSize(1)), MemManagerPtr(memManager)),
+			mNode48MemPool(MemPoolParams(NodeUtility::GetSize(2)), MemManagerPtr(memManager)),
+			mNode256MemPool(MemPoolParams(NodeUtility::GetSize(3)), MemManagerPtr(memManager)),
+			mLeafMemPool(MemPoolParams(leafSize), MemManagerPtr(memManager))
+		{
+		}
+
+		RadixTreeNodeParams(const RadixTreeNodeParams&) = delete;
+
+		~RadixTreeNodeParams() noexcept
+		{
+		}
+
+		RadixTreeNodeParams& operator=(const RadixTreeNodeParams&) = delete;
+
+		void* AllocateNode(size_t type)
+		{
+			return pvGetNodeMemPool(type).Allocate();
+		}
+
+		void DeallocateNode(void* ptr, size_t type) noexcept
+		{
+			pvGetNodeMemPool(type).Deallocate(ptr);
+		}
+
+		void* AllocateLeaf()
+		{
+			return mLeafMemPool.Allocate();
+		}
+
+		void DeallocateLeaf(void* ptr) noexcept
+		{
+			mLeafMemPool.Deallocate(ptr);
+		}
+
+		Links* GetHead() noexcept
+		{
+			return &mHead;
+		}
+
+	private:
+		MemPool& pvGetNodeMemPool(size_t type) noexcept
+		{
+			switch (type)
+			{
+			case 0:
+				return mNode4MemPool;
+			case 1:
+				return mNode16MemPool;
+			case 2:
+				return mNode48MemPool;
+			default:
+				return mNode256MemPool;
+			}
+		}
+
+	private:
+		MemPool mNode4MemPool;
+		MemPool mNode16MemPool;
+		MemPool mNode48MemPool;
+		MemPool mNode256MemPool;
+		MemPool mLeafMemPool;
+		Links mHead;
+	};
+}
+
+template<typename TKey,
+	typename TMemPoolParams = MemPoolParams<>>
+class RadixTreeTraits
+{
+public:
+	typedef TKey Key;
+	typedef TMemPoolParams MemPoolParams;
+
+private:
+	typedef internal::RadixTreeKeyBytes<Key> KeyBytes;
+
+public:
+	explicit RadixTreeTraits() noexcept
+	{
+	}
+
+	size_t GetByteCount(const Key& key) const noexcept
+	{
+		return KeyBytes::GetCount(key);
+	}
+
+	uint8_t GetByte(const Key& key, size_t index) const noexcept
+	{
+		return KeyBytes::GetByte(key, index);
+	}
+
+	bool IsEqual(const Key& key1, const Key& key2) const
+	{
+		return key1 == key2;
+	}
+};
+
+class RadixTreeMapSettings
+{
+public:
+	static const CheckMode checkMode = CheckMode::bydefault;
+	static const ExtraCheckMode extraCheckMode = ExtraCheckMode::bydefault;
+	static const bool checkVersion = MOMO_CHECK_ITERATOR_VERSION;
+};
+
+template<typename TKey, typename TValue,
+	typename TRadixTreeTraits = RadixTreeTraits<TKey>,
+	typename TMemManager = MemManagerDefault,
+	typename TSettings = RadixTreeMapSettings>
+class RadixTreeMap
+{
+public:
+	typedef TKey Key;
+	typedef TValue Value;
+	typedef TRadixTreeTraits RadixTreeTraits;
+	typedef TMemManager MemManager;
+	typedef TSettings Settings;
+
+	typedef internal::MapKeyValueTraits<Key, Value, MemManager> KeyValueTraits;
+
+private:
+	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	typedef internal::SetCrew<RadixTreeTraits, MemManager, Settings::checkVersion> Crew;
+
+	typedef internal::RadixTreeNode Node;
+	typedef internal::RadixTreeNodeUtility NodeUtility;
+
+	typedef internal::RadixTreeLeaf<KeyValueTraits> Leaf;
+	typedef typename Leaf::Links Links;
+
+	typedef internal::RadixTreeNodeParams<MemManager,
+		typename RadixTreeTraits::MemPoolParams> NodeParams;
+
+	template<typename... ValueArgs>
+	using ValueCreator = typename KeyValueTraits::template ValueCreator<ValueArgs...>;
+
+public:
+	typedef internal::RadixTreeMapIterator<Leaf, Settings, false> Iterator;
+	typedef typename Iterator::ConstIterator ConstIterator;
+
+	typedef internal::InsertResult<Iterator> InsertResult;
+
+private:
+	struct ConstIteratorProxy : public ConstIterator
+	{
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(ConstIterator)
+		MOMO_DECLARE_PROXY_FUNCTION(ConstIterator, GetLinks, Links*)
+		MOMO_DECLARE_PROXY_FUNCTION(ConstIterator, Check, void)
+	};
+
+	struct IteratorProxy : public Iterator
+	{
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(Iterator)
+	};
+
+public:
+	RadixTreeMap()
+		: RadixTreeMap(RadixTreeTraits())
+	{
+	}
+
+	explicit RadixTreeMap(const RadixTreeTraits& radixTreeTraits,
+		MemManager&& memManager = MemManager())
+		: mCrew(radixTreeTraits, std::move(memManager)),
+		mNodeParams(nullptr),
+		mRoot(0),
+		mCount(0)
+	{
+	}
+
+	RadixTreeMap(RadixTreeMap&& treeMap) noexcept
+		: mCrew(std::move(treeMap.mCrew)),
+		mNodeParams(treeMap.mNodeParams),
+		mRoot(treeMap.mRoot),
+		mCount(treeMap.mCount)
+	{
+		treeMap.mNodeParams = nullptr;
+		treeMap.mRoot = 0;
+		treeMap.mCount = 0;
+	}
+
+	RadixTreeMap(const RadixTreeMap& treeMap)
+		: RadixTreeMap(treeMap, MemManager(treeMap.GetMemManager()))
+	{
+	}
+
+	RadixTreeMap(const RadixTreeMap& treeMap, MemManager&& memManager)
+		: RadixTreeMap(treeMap.GetRadixTreeTraits(), std::move(memManager))
+	{
+		if (treeMap.mRoot == 0)
+			return;
+		pvCreateNodeParams();
+		mRoot = pvCopy(treeMap.mRoot);
+		mCount = treeMap.mCount;
+	}
+
+	~RadixTreeMap() noexcept
+	{
+		pvDestroy();
+	}
+
+	RadixTreeMap& operator=(RadixTreeMap&& treeMap) noexcept
+	{
+		RadixTreeMap(std::move(treeMap)).Swap(*this);
+		return *this;
+	}
+
+	RadixTreeMap& operator=(const RadixTreeMap& treeMap)
+	{
+		if (this != &treeMap)
+			RadixTreeMap(treeMap).Swap(*this);
+		return *this;
+	}
+
+	void Swap(RadixTreeMap& treeMap) noexcept
+	{
+		mCrew.Swap(treeMap.mCrew);
+		std::swap(mNodeParams, treeMap.mNodeParams);
+		std::swap(mRoot, treeMap.mRoot);
+		std::swap(mCount, treeMap.mCount);
+	}
+
+	ConstIterator GetBegin() const noexcept
+	{
+		return pvMakeIterator(pvGetBegin());
+	}
+
+	Iterator GetBegin() noexcept
+	{
+		return pvMakeIterator(pvGetBegin());
+	}
+
+	ConstIterator GetEnd() const noexcept
+	{
+		return pvMakeIterator(pvGetHead());
+	}
+
+	Iterator GetEnd() noexcept
+	{
+		return pvMakeIterator(pvGetHead());
+	}
+
+	MOMO_FRIEND_SWAP(RadixTreeMap)
+	MOMO_FRIENDS_BEGIN_END(const RadixTreeMap&, ConstIterator)
+	MOMO_FRIENDS_BEGIN_END(RadixTreeMap&, Iterator)
+
+	const RadixTreeTraits& GetRadixTreeTraits() const noexcept
+	{
+		return mCrew.GetContainerTraits();
+	}
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mCrew.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mCrew.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mCount;
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return mCount == 0;
+	}
+
+	void Clear() noexcept
+	{
+		if (mRoot != 0)
+			pvDestroy(mRoot);
+		if (mNodeParams != nullptr)
+			mNodeParams->GetHead()->Reset();
+		mRoot = 0;
+		mCount = 0;
+		mCrew.IncVersion();
+	}
+
+	ConstIterator GetLowerBound(const Key& key) const
+	{
+		return pvMakeIterator(pvGetLowerBound(key));
+	}
+
+	Iterator GetLowerBound(const Key& key)
+	{
+		return pvMakeIterator(pvGetLowerBound(key));
+	}
+
+	ConstIterator GetUpperBound(const Key& key) const
+	{
+		return pvMakeIterator(pvGetUpperBound(key));
+	}
+
+	Iterator GetUpperBound(const Key& key)
+	{
+		return pvMakeIterator(pvGetUpperBound(key));
+	}
+
+	ConstIterator Find(const Key& key) const
+	{
+		return pvMakeIterator(pvFind(key));
+	}
+
+	Iterator Find(const Key& key)
+	{
+		return pvMakeIterator(pvFind(key));
+	}
+
+	bool ContainsKey(const Key& key) const
+	{
+		return pvFind(key) != pvGetHead();
+	}
+
+	template<typename ValueCreator>
+	InsertResult InsertCrt(Key&& key, ValueCreator&& valueCreator)
+	{
+		return pvInsert(std::move(key), std::forward<ValueCreator>(valueCreator));
+	}
+
+	template<typename... ValueArgs>
+	InsertResult InsertVar(Key&& key, ValueArgs&&... valueArgs)
+	{
+		return pvInsert(std::move(key),
+			ValueCreator<ValueArgs...>(GetMemManager(), std::forward<ValueArgs>(valueArgs)...));
+	}
+
+	InsertResult Insert(Key&& key, Value&& value)
+	{
+		return InsertVar(std::move(key), std::move(value));
+	}
+
+	InsertResult Insert(Key&& key, const Value& value)
+	{
+		return InsertVar(std::move(key), value);
+	}
+
+	template<typename ValueCreator>
+	InsertResult InsertCrt(const Key& key, ValueCreator&& valueCreator)
+	{
+		return pvInsert(key, std::forward<ValueCreator>(valueCreator));
+	}
+
+	template<typename... ValueArgs>
+	InsertResult InsertVar(const Key& key, ValueArgs&&... valueArgs)
+	{
+		return pvInsert(key,
+			ValueCreator<ValueArgs...>(GetMemManager(), std::forward<ValueArgs>(valueArgs)...));
+	}
+
+	InsertResult Insert(const Key& key, Value&& value)
+	{
+		return InsertVar(key, std::move(value));
+	}
+
+	InsertResult Insert(const Key& key, const Value& value)
+	{
+		return InsertVar(key, value);
+	}
+
+	Iterator Remove(ConstIterator iter)
+	{
+		ConstIteratorProxy::Check(iter, mCrew.GetVersion(), false);
+		Links* links = ConstIteratorProxy::GetLinks(iter);
+		MOMO_CHECK(links != pvGetHead());
+		Links* nextLinks = links->GetNext();
+		pvRemove(static_cast<Leaf*>(links));
+		--mCount;
+		mCrew.IncVersion();
+		return pvMakeIterator(nextLinks);
+	}
+
+	size_t Remove(const Key& key)
+	{
+		Links* links = pvFind(key);
+		if (links == pvGetHead())
+			return 0;
+		Remove(pvMakeIterator(links));
+		return 1;
+	}
+
+	Iterator MakeMutableIterator(ConstIterator iter)
+	{
+		CheckIterator(iter);
+		return pvMakeIterator(ConstIteratorProxy::GetLinks(iter));
+	}
+
+	void CheckIterator(ConstIterator iter, bool allowEmpty = true) const
+	{
+		ConstIteratorProxy::Check(iter, mCrew.GetVersion(), allowEmpty);
+	}
+
+private:
+	void pvCreateNodeParams()
+	{
+		if (mNodeParams != nullptr)
+			return;
+		MemManager& memManager = GetMemManager();
+		mNodeParams = MemManagerProxy::template Allocate<NodeParams>(memManager,
+			sizeof(NodeParams));
+		try
+		{
+			::new(static_cast<void*>(mNodeParams)) NodeParams(memManager, sizeof(Leaf));
+		}
+		catch (...)
+		{
+			MemManagerProxy::Deallocate(memManager, mNodeParams, sizeof(NodeParams));
+			mNodeParams = nullptr;
+			throw;
+		}
+	}
+
+	void pvDestroy() noexcept
+	{
+		if (mRoot != 0)
+			pvDestroy(mRoot);
+		mRoot = 0;
+		mCount = 0;
+		if (mNodeParams != nullptr)
+		{
+			mNodeParams->~NodeParams();
+			MemManagerProxy::Deallocate(GetMemManager(), mNodeParams, sizeof(NodeParams));
+			mNodeParams = nullptr;
+		}
+	}
+
+	Links* pvGetHead() const noexcept
+	{
+		return (mNodeParams != nullptr) ? mNodeParams->GetHead() : nullptr;
+	}
+
+	Links* pvGetBegin() const noexcept
+	{
+		return (mNodeParams != nullptr) ? mNodeParams->GetHead()->GetNext() : nullptr;
+	}
+
+	Iterator pvMakeIterator(Links* links) const noexcept
+	{
+		return IteratorProxy(links, mCrew.GetVersion());
+	}
+
+	static bool pvIsLeaf(uintptr_t child) noexcept
+	{
+		return (child & 1) != 0;
+	}
+
+	static Leaf* pvGetLeaf(uintptr_t child) noexcept
+	{
+		MOMO_ASSERT(pvIsLeaf(child));
+		return internal::BitCaster::ToPtr<Leaf>(child - 1);
+	}
+
+	static Node* pvGetNode(uintptr_t child) noexcept
+	{
+		MOMO_ASSERT(!pvIsLeaf(child));
+		return internal::BitCaster::ToPtr<Node>(child);
+	}
+
+	static uintptr_t pvMakeChild(Leaf* leaf) noexcept
+	{
+		uintptr_t child = internal::BitCaster::ToUInt(leaf);
+		MOMO_ASSERT((child & 1) == 0);
+		return child + 1;
+	}
+
+	static uintptr_t pvMakeChild(Node* node) noexcept
+	{
+		return internal::BitCaster::ToUInt(node);
+	}
+
+	size_t pvGetByteCount(const Key& key) const noexcept
+	{
+		return GetRadixTreeTraits().GetByteCount(key);
+	}
+
+	uint8_t pvGetByte(const Key& key, size_t index) const noexcept
+	{
+		return GetRadixTreeTraits().GetByte(key, index);
+	}
+
+	// compares the bytes of keys, starting from `index`
+	int pvCompare(const Key& key1, const Key& key2, size_t index) const noexcept
+	{
+		size_t byteCount1 = pvGetByteCount(key1);
+		size_t byteCount2 = pvGetByteCount(key2);
+		size_t byteCount = std::minmax(byteCount1, byteCount2).first;
+		for (; index < byteCount; ++index)
+		{
+			uint8_t byte1 = pvGetByte(key1, index);
+			uint8_t byte2 = pvGetByte(key2, index);
+			if (byte1 != byte2)
+				return (byte1 < byte2) ? -1 : 1;
+		}
+		return (byteCount1 < byteCount2) ? -1 : (byteCount1 > byteCount2) ? 1 : 0;
+	}
+
+	static Leaf* pvGetMinLeaf(uintptr_t child) noexcept
+	{
+		while (!pvIsLeaf(child))
+		{
+			Node* node = pvGetNode(child);
+			uintptr_t terminal = node->GetTerminal();
+			child = (terminal != 0) ? terminal : NodeUtility::GetNextChild(node, 0);
+		}
+		return pvGetLeaf(child);
+	}
+
+	static Leaf* pvGetMaxLeaf(uintptr_t child) noexcept
+	{
+		while (!pvIsLeaf(child))
+			child = NodeUtility::GetPrevChild(pvGetNode(child), 256);
+		return pvGetLeaf(child);
+	}
+
+	// prefix bytes beyond `Node::maxPrefixLength` are taken from any leaf of the node
+	uint8_t pvGetPrefixByte(uintptr_t child, size_t depth, size_t index,
+		Leaf*& leaf) const noexcept
+	{
+		if (index < Node::maxPrefixLength)
+			return pvGetNode(child)->GetPrefix()[index];
+		if (leaf == nullptr)
+			leaf = pvGetMinLeaf(child);
+		return pvGetByte(*leaf->GetKeyPtr(), depth + index);
+	}
+
+	void pvSetPrefix(Node* node, const Key& key, size_t depth, size_t prefixLength) const noexcept
+	{
+		node->SetPrefixLength(prefixLength);
+		size_t storedPrefixLength = Node::GetStoredPrefixLength(prefixLength);
+		for (size_t i = 0; i < storedPrefixLength; ++i)
+			node->GetPrefix()[i] = pvGetByte(key, depth + i);
+	}
+
+	Links* pvFind(const Key& key) const
+	{
+		size_t byteCount = pvGetByteCount(key);
+		uintptr_t child = mRoot;
+		size_t depth = 0;
+		while (child != 0)
+		{
+			if (pvIsLeaf(child))
+			{
+				Leaf* leaf = pvGetLeaf(child);
+				if (!GetRadixTreeTraits().IsEqual(*leaf->GetKeyPtr(), key))
+					break;
+				return leaf;
+			}
+			Node* node = pvGetNode(child);
+			size_t prefixLength = node->GetPrefixLength();
+			if (depth + prefixLength > byteCount)
+				break;
+			// optimistic check, the rest of the prefix is checked in the leaf
+			const uint8_t* prefix = node->GetPrefix();
+			size_t storedPrefixLength = Node::GetStoredPrefixLength(prefixLength);
+			size_t index = 0;
+			while (index < storedPrefixLength && prefix[index] == pvGetByte(key, depth + index))
+				++index;
+			if (index < storedPrefixLength)
+				break;
+			depth += prefixLength;
+			if (depth == byteCount)
+			{
+				child = node->GetTerminal();
+				continue;
+			}
+			const uintptr_t* childPtr = NodeUtility::FindChild(node, pvGetByte(key, depth));
+			if (childPtr == nullptr)
+				break;
+			child = *childPtr;
+			++depth;
+		}
+		return pvGetHead();
+	}
+
+	Links* pvGetLowerBound(const Key& key) const
+	{
+		if (mRoot == 0)
+			return pvGetHead();
+		size_t byteCount = pvGetByteCount(key);
+		uintptr_t child = mRoot;
+		size_t depth = 0;
+		while (!pvIsLeaf(child))
+		{
+			Node* node = pvGetNode(child);
+			size_t prefixLength = node->GetPrefixLength();
+			Leaf* leaf = nullptr;
+			for (size_t i = 0; i < prefixLength; ++i)
+			{
+				if (depth + i == byteCount)
+					return pvGetMinLeaf(child);
+				uint8_t prefixByte = pvGetPrefixByte(child, depth, i, leaf);
+				uint8_t byte = pvGetByte(key, depth + i);
+				if (byte < prefixByte)
+					return pvGetMinLeaf(child);
+				if (byte > prefixByte)
+					return pvGetMaxLeaf(child)->GetNext();
+			}
+			depth += prefixLength;
+			if (depth == byteCount)
+				return pvGetMinLeaf(child);
+			uint8_t byte = pvGetByte(key, depth);
+			const uintptr_t* childPtr = NodeUtility::FindChild(node, byte);
+			if (childPtr == nullptr)
+			{
+				uintptr_t prevChild = NodeUtility::GetPrevChild(node, byte);
+				if (prevChild != 0)
+					return pvGetMaxLeaf(prevChild)->GetNext();
+				return pvGetMinLeaf(NodeUtility::GetNextChild(node, byte));
+			}
+			child = *childPtr;
+			++depth;
+		}
+		Leaf* leaf = pvGetLeaf(child);
+		return (pvCompare(*leaf->GetKeyPtr(), key, depth) >= 0) ? leaf : leaf->GetNext();
+	}
+
+	Links* pvGetUpperBound(const Key& key) const
+	{
+		Links* links = pvGetLowerBound(key);
+		if (links != pvGetHead()
+			&& GetRadixTreeTraits().IsEqual(*static_cast<Leaf*>(links)->GetKeyPtr(), key))
+		{
+			links = links->GetNext();
+		}
+		return links;
+	}
+
+	template<typename RKey, typename ValueCreator>
+	InsertResult pvInsert(RKey&& key, ValueCreator&& valueCreator)
+	{
+		Links* links = pvFind(static_cast<const Key&>(key));
+		if (links != pvGetHead())
+			return { pvMakeIterator(links), false };
+		pvCreateNodeParams();
+		Leaf* leaf = pvCreateLeaf(std::forward<RKey>(key),
+			std::forward<ValueCreator>(valueCreator));
+		try
+		{
+			pvAdd(leaf);
+		}
+		catch (...)
+		{
+			pvDestroyLeaf(leaf);
+			throw;
+		}
+		++mCount;
+		mCrew.IncVersion();
+		return { pvMakeIterator(leaf), true };
+	}
+
+	template<typename RKey, typename ValueCreator>
+	Leaf* pvCreateLeaf(RKey&& key, ValueCreator&& valueCreator)
+	{
+		Leaf* leaf = ::new(mNodeParams->AllocateLeaf()) Leaf();
+		try
+		{
+			KeyValueTraits::Create(GetMemManager(), std::forward<RKey>(key),
+				std::forward<ValueCreator>(valueCreator), leaf->GetKeyPtr(), leaf->GetValuePtr());
+		}
+		catch (...)
+		{
+			leaf->~Leaf();
+			mNodeParams->DeallocateLeaf(leaf);
+			throw;
+		}
+		return leaf;
+	}
+
+	void pvDestroyLeaf(Leaf* leaf) noexcept
+	{
+		KeyValueTraits::Destroy(&GetMemManager(), *leaf->GetKeyPtr(), *leaf->GetValuePtr());
+		leaf->~Leaf();
+		mNodeParams->DeallocateLeaf(leaf);
+	}
+
+	Node* pvCreateNode(size_t type)
+	{
+		return NodeUtility::Create(type, mNodeParams->AllocateNode(type));
+	}
+
+	void pvFreeNode(Node* node) noexcept
+	{
+		size_t type = node->GetType();
+		node->~Node();
+		mNodeParams->DeallocateNode(node, type);
+	}
+
+	void pvDestroy(uintptr_t child) noexcept
+	{
+		if (pvIsLeaf(child))
+			return pvDestroyLeaf(pvGetLeaf(child));
+		Node* node = pvGetNode(child);
+		if (node->GetTerminal() != 0)
+			pvDestroyLeaf(pvGetLeaf(node->GetTerminal()));
+		NodeUtility::ForEachChild(node,
+			[this] (uint8_t /*byte*/, uintptr_t nodeChild) { pvDestroy(nodeChild); });
+		pvFreeNode(node);
+	}
+
+	uintptr_t pvCopy(uintptr_t child)
+	{
+		Links* head = mNodeParams->GetHead();
+		if (pvIsLeaf(child))
+		{
+			Leaf* leaf = pvGetLeaf(child);
+			Leaf* newLeaf = pvCreateLeaf(static_cast<const Key&>(*leaf->GetKeyPtr()),
+				ValueCreator<const Value&>(GetMemManager(), *leaf->GetValuePtr()));
+			newLeaf->Link(head);
+			return pvMakeChild(newLeaf);
+		}
+		Node* node = pvGetNode(child);
+		Node* newNode = pvCreateNode(node->GetType());
+		newNode->SetPrefix(node->GetPrefix(), node->GetPrefixLength());
+		try
+		{
+			if (node->GetTerminal() != 0)
+				newNode->SetTerminal(pvCopy(node->GetTerminal()));
+			NodeUtility::ForEachChild(node, [this, newNode] (uint8_t byte, uintptr_t nodeChild)
+				{ NodeUtility::AddChild(newNode, byte, pvCopy(nodeChild)); });
+		}
+		catch (...)
+		{
+			pvDestroy(pvMakeChild(newNode));
+			throw;
+		}
+		return pvMakeChild(newNode);
+	}
+
+	void pvAdd(Leaf* leaf)
+	{
+		const Key& key = *leaf->GetKeyPtr();
+		size_t byteCount = pvGetByteCount(key);
+		uintptr_t newChild = pvMakeChild(leaf);
+		uintptr_t* childPtr = &mRoot;
+		size_t depth = 0;
+		while (true)
+		{
+			uintptr_t child = *childPtr;
+			if (child == 0)
+			{
+				*childPtr = newChild;
+				leaf->Link(mNodeParams->GetHead());
+				return;
+			}
+			if (pvIsLeaf(child))
+				return pvSplitLeaf(childPtr, depth, leaf);
+			Node* node = pvGetNode(child);
+			size_t prefixLength = node->GetPrefixLength();
+			Leaf* prefixLeaf = nullptr;
+			for (size_t i = 0; i < prefixLength; ++i)
+			{
+				if (depth + i == byteCount
+					|| pvGetPrefixByte(child, depth, i, prefixLeaf) != pvGetByte(key, depth + i))
+				{
+					return pvSplitPrefix(childPtr, depth, i, leaf);
+				}
+			}
+			depth += prefixLength;
+			if (depth == byteCount)
+			{
+				MOMO_ASSERT(node->GetTerminal() == 0);
+				leaf->Link(pvGetMinLeaf(child));
+				node->SetTerminal(newChild);
+				return;
+			}
+			uint8_t byte = pvGetByte(key, depth);
+			uintptr_t* nextChildPtr = NodeUtility::FindChild(node, byte);
+			if (nextChildPtr == nullptr)
+			{
+				if (NodeUtility::IsFull(node))
+				{
+					node = pvResizeNode(node, node->GetType() + 1);
+					*childPtr = pvMakeChild(node);
+				}
+				uintptr_t prevChild = NodeUtility::GetPrevChild(node, byte);
+				Links* nextLinks = (prevChild != 0) ? pvGetMaxLeaf(prevChild)->GetNext()
+					: pvGetMinLeaf(NodeUtility::GetNextChild(node, byte));
+				NodeUtility::AddChild(node, byte, newChild);
+				leaf->Link(nextLinks);
+				return;
+			}
+			childPtr = nextChildPtr;
+			++depth;
+		}
+	}
+
+	void pvSplitLeaf(uintptr_t* childPtr, size_t depth, Leaf* leaf)
+	{
+		Leaf* oldLeaf = pvGetLeaf(*childPtr);
+		const Key& key = *leaf->GetKeyPtr();
+		const Key& oldKey = *oldLeaf->GetKeyPtr();
+		size_t byteCount = pvGetByteCount(key);
+		size_t oldByteCount = pvGetByteCount(oldKey);
+		size_t commonDepth = depth;
+		while (commonDepth < byteCount && commonDepth < oldByteCount
+			&& pvGetByte(key, commonDepth) == pvGetByte(oldKey, commonDepth))
+		{
+			++commonDepth;
+		}
+		Node* node = pvCreateNode(NodeUtility::Node4::type);
+		pvSetPrefix(node, key, depth, commonDepth - depth);
+		pvAddEntry(node, key, byteCount, commonDepth, pvMakeChild(leaf));
+		pvAddEntry(node, oldKey, oldByteCount, commonDepth, *childPtr);
+		*childPtr = pvMakeChild(node);
+		bool isLess = pvCompare(key, oldKey, commonDepth) < 0;
+		leaf->Link(isLess ? oldLeaf : oldLeaf->GetNext());
+	}
+
+	void pvSplitPrefix(uintptr_t* childPtr, size_t depth, size_t index, Leaf* leaf)
+	{
+		uintptr_t child = *childPtr;
+		Node* node = pvGetNode(child);
+		const Key& key = *leaf->GetKeyPtr();
+		size_t byteCount = pvGetByteCount(key);
+		Leaf* minLeaf = pvGetMinLeaf(child);
+		Leaf* maxLeaf = pvGetMaxLeaf(child);
+		Node* newNode = pvCreateNode(NodeUtility::Node4::type);
+		uint8_t nodeByte = pvGetPrefixByte(child, depth, index, minLeaf);
+		pvSetPrefix(newNode, key, depth, index);
+		size_t prefixLength = node->GetPrefixLength();
+		size_t newPrefixLength = prefixLength - index - 1;
+		if (prefixLength <= Node::maxPrefixLength)
+		{
+			uint8_t* prefix = node->GetPrefix();
+			std::copy(prefix + index + 1, prefix + prefixLength, prefix);
+			node->SetPrefixLength(newPrefixLength);
+		}
+		else
+		{
+			pvSetPrefix(node, *minLeaf->GetKeyPtr(), depth + index + 1, newPrefixLength);
+		}
+		NodeUtility::AddChild(newNode, nodeByte, child);
+		pvAddEntry(newNode, key, byteCount, depth + index, pvMakeChild(leaf));
+		*childPtr = pvMakeChild(newNode);
+		bool isLess = depth + index == byteCount || pvGetByte(key, depth + index) < nodeByte;
+		leaf->Link(isLess ? minLeaf : maxLeaf->GetNext());
+	}
+
+	void pvAddEntry(Node* node, const Key& key, size_t byteCount, size_t depth,
+		uintptr_t child) noexcept
+	{
+		if (depth == byteCount)
+			node->SetTerminal(child);
+		else
+			NodeUtility::AddChild(node, pvGetByte(key, depth), child);
+	}
+
+	Node* pvResizeNode(Node* node, size_t type)
+	{
+		Node* newNode = pvCreateNode(type);
+		newNode->SetPrefix(node->GetPrefix(), node->GetPrefixLength());
+		newNode->SetTerminal(node->GetTerminal());
+		NodeUtility::ForEachChild(node, [newNode] (uint8_t byte, uintptr_t child)
+			{ NodeUtility::AddChild(newNode, byte, child); });
+		pvFreeNode(node);
+		return newNode;
+	}
+
+	void pvRemove(Leaf* leaf) noexcept
+	{
+		const Key& key = *leaf->GetKeyPtr();
+		size_t byteCount = pvGetByteCount(key);
+		uintptr_t leafChild = pvMakeChild(leaf);
+		uintptr_t* nodeChildPtr = nullptr;
+		uintptr_t* childPtr = &mRoot;
+		size_t depth = 0;
+		while (*childPtr != leafChild)
+		{
+			nodeChildPtr = childPtr;
+			Node* node = pvGetNode(*childPtr);
+			depth += node->GetPrefixLength();
+			if (depth == byteCount)
+			{
+				MOMO_ASSERT(node->GetTerminal() == leafChild);
+				childPtr = nullptr;
+				break;
+			}
+			childPtr = NodeUtility::FindChild(node, pvGetByte(key, depth));
+			MOMO_ASSERT(childPtr != nullptr);
+			++depth;
+		}
+		if (nodeChildPtr == nullptr)
+		{
+			mRoot = 0;
+		}
+		else
+		{
+			Node* node = pvGetNode(*nodeChildPtr);
+			if (childPtr == nullptr)
+				node->SetTerminal(0);
+			else
+				NodeUtility::RemoveChild(node, pvGetByte(key, depth - 1));
+			pvCompactNode(nodeChildPtr);
+		}
+		leaf->Unlink();
+		pvDestroyLeaf(leaf);
+	}
+
+	void pvCompactNode(uintptr_t* childPtr) noexcept
+	{
+		Node* node = pvGetNode(*childPtr);
+		size_t count = node->GetCount();
+		uintptr_t terminal = node->GetTerminal();
+		if (count == 0)
+		{
+			MOMO_ASSERT(terminal != 0);
+			*childPtr = terminal;
+			pvFreeNode(node);
+		}
+		else if (count == 1 && terminal == 0)
+		{
+			uint8_t byte = 0;
+			uintptr_t child = 0;
+			NodeUtility::ForEachChild(node, [&byte, &child] (uint8_t nodeByte, uintptr_t nodeChild)
+				{ byte = nodeByte; child = nodeChild; });
+			if (!pvIsLeaf(child))
+				pvMergePrefix(node, byte, pvGetNode(child));
+			*childPtr = child;
+			pvFreeNode(node);
+		}
+		else
+		{
+			size_t type = node->GetType();
+			if (type == 0 || count > NodeUtility::GetShrinkCount(type))
+				return;
+			try
+			{
+				*childPtr = pvMakeChild(pvResizeNode(node, type - 1));
+			}
+			catch (...)
+			{
+				// the node remains large
+			}
+		}
+	}
+
+	// node prefix + byte + child node prefix
+	static void pvMergePrefix(const Node* node, uint8_t byte, Node* childNode) noexcept
+	{
+		uint8_t prefix[Node::maxPrefixLength];
+		size_t prefixLength = node->GetPrefixLength();
+		size_t childPrefixLength = childNode->GetPrefixLength();
+		size_t length = Node::GetStoredPrefixLength(prefixLength);
+		std::copy_n(node->GetPrefix(), length, prefix);
+		if (length < Node::maxPrefixLength)
+			prefix[length++] = byte;
+		std::copy_n(childNode->GetPrefix(),
+			Node::GetStoredPrefixLength(childPrefixLength + length) - length, prefix + length);
+		childNode->SetPrefix(prefix, prefixLength + 1 + childPrefixLength);
+	}
+
+private:
+	Crew mCrew;
+	NodeParams* mNodeParams;
+	uintptr_t mRoot;
+	size_t mCount;
+};
+
+} // namespace momo
+
+namespace std
+{
+	template<typename L, typename S, bool c>
+	struct iterator_traits<momo::internal::RadixTreeMapIterator<L, S, c>>
+		: public momo::internal::IteratorTraitsStd<momo::internal::RadixTreeMapIterator<L, S, c>,
+			bidirectional_iterator_tag>
+	{
+	};
+} // namespace std
@@ -22,12 +22,23 @@
 
   Swap and move operations invalidate all container iterators.
 
+  Functions `GetSegment`, `ForEachSpan` and `ForEachSpanParallel` give
+  access to the items of each segment as one contiguous range, so a
+  scan over the container does not compute indexes for every item.
+  `ForEachSpanParallel` hands out segments to the given number of threads
+  (including the calling one); the first exception thrown by the function
+  is rethrown after all threads are finished.
+
 \**********************************************************/
 
 #pragma once
 
 #include "Array.h"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 namespace momo
 {
 
@@ -167,6 +178,9 @@ public:
 	typedef internal::ArrayIndexIterator<SegmentedArray, Item> Iterator;
 	typedef typename Iterator::ConstIterator ConstIterator;
 
+	typedef internal::ArrayBounds<Item*> SegmentBounds;
+	typedef typename SegmentBounds::ConstBounds ConstSegmentBounds;
+
 private:
 	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
 
@@ -574,6 +588,49 @@ public:
 			[&itemArg, &pred] (const Item& item) { return pred(itemArg, item); }) != end;
 	}
 
+	size_t GetSegmentCount() const noexcept
+	{
+		if (mCount == 0)
+			return 0;
+		size_t segIndex, itemIndex;
+		Settings::GetSegItemIndexes(mCount - 1, segIndex, itemIndex);
+		return segIndex + 1;
+	}
+
+	ConstSegmentBounds GetSegment(size_t segIndex) const
+	{
+		return pvGetSegment<ConstSegmentBounds>(segIndex);
+	}
+
+	SegmentBounds GetSegment(size_t segIndex)
+	{
+		return pvGetSegment<SegmentBounds>(segIndex);
+	}
+
+	template<typename SpanFunc>
+	void ForEachSpan(const SpanFunc& spanFunc) const
+	{
+		pvForEachSpan<ConstSegmentBounds>(spanFunc);
+	}
+
+	template<typename SpanFunc>
+	void ForEachSpan(const SpanFunc& spanFunc)
+	{
+		pvForEachSpan<SegmentBounds>(spanFunc);
+	}
+
+	template<typename SpanFunc>
+	void ForEachSpanParallel(size_t threadCount, const SpanFunc& spanFunc) const
+	{
+		pvForEachSpanParallel<ConstSegmentBounds>(threadCount, spanFunc);
+	}
+
+	template<typename SpanFunc>
+	void ForEachSpanParallel(size_t threadCount, const SpanFunc& spanFunc)
+	{
+		pvForEachSpanParallel<SegmentBounds>(threadCount, spanFunc);
+	}
+
 private:
 	Item* pvGetSegMemory(size_t segIndex)
 	{
@@ -598,6 +655,74 @@ private:
 		return mSegments[segIndex][itemIndex];
 	}
 
+	template<typename Bounds>
+	Bounds pvGetSegment(size_t segIndex) const
+	{
+		MOMO_CHECK(segIndex < GetSegmentCount());
+		size_t count = mCount - Settings::GetIndex(segIndex, 0);
+		return Bounds(mSegments[segIndex],
+			std::minmax(Settings::GetItemCount(segIndex), count).first);
+	}
+
+	template<typename Bounds, typename SpanFunc>
+	void pvForEachSpan(const SpanFunc& spanFunc) const
+	{
+		size_t segCount = GetSegmentCount();
+		for (size_t segIndex = 0; segIndex < segCount; ++segIndex)
+			spanFunc(pvGetSegment<Bounds>(segIndex));
+	}
+
+	template<typename Bounds, typename SpanFunc>
+	void pvForEachSpanParallel(size_t threadCount, const SpanFunc& spanFunc) const
+	{
+		size_t segCount = GetSegmentCount();
+		if (threadCount > segCount)
+			threadCount = segCount;
+		if (threadCount <= 1)
+			return pvForEachSpan<Bounds>(spanFunc);
+		std::atomic<size_t> nextSegIndex(0);
+		std::exception_ptr exception;
+		std::mutex exceptionMutex;
+		auto worker = [this, segCount, &spanFunc, &nextSegIndex, &exception, &exceptionMutex] ()
+		{
+			try
+			{
+				while (true)
+				{
+					size_t segIndex = nextSegIndex.fetch_add(1);
+					if (segIndex >= segCount)
+						break;
+					spanFunc(this->template pvGetSegment<Bounds>(segIndex));
+				}
+			}
+			catch (...)
+			{
+				nextSegIndex.store(segCount);
+				std::lock_guard<std::mutex> lock(exceptionMutex);
+				if (exception == nullptr)
+					exception = std::current_exception();
+			}
+		};
+		Array<std::thread> threads;
+		threads.Reserve(threadCount - 1);
+		for (size_t i = 1; i < threadCount; ++i)
+		{
+			try
+			{
+				threads.AddBackNogrow(std::thread(worker));
+			}
+			catch (const std::system_error&)
+			{
+				break;	// the remaining segments are processed by the started threads
+			}
+		}
+		worker();
+		for (std::thread& thread : threads)
+			thread.join();
+		if (exception != nullptr)
+			std::rethrow_exception(exception);
+	}
+
 	template<typename MultiItemCreator>
 	void pvIncCount(size_t count, const MultiItemCreator& multiItemCreator)
 	{
@@ -0,0 +1,495 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/SegmentedDeque.h
+
+  namespace momo:
+    class SegmentedDequeSettings
+    class SegmentedDeque
+
+  `SegmentedDeque` stores items in segments of equal size, like
+  `SegmentedArray` with `SegmentedArrayItemCountFunc::cnst`. Pointers to
+  segments are kept in a ring, so functions `AddFront`, `RemoveFront`,
+  `AddBack` and `RemoveBack` take O(1) time and never move items:
+  references to items stay valid until the item is removed.
+  Released segments are kept in a small cache and reused by the next
+  additions, so a queue does not allocate memory in the steady state.
+
+  All `SegmentedDeque` functions and constructors have strong exception
+  safety, but not the following case:
+  1. If any constructor throws exception, input argument `memManager`
+    may be changed.
+
+  Iterators become invalid after any addition or removal of the item.
+
+\**********************************************************/
+
+#pragma once
+
+#include "SegmentedArray.h"
+
+#include <array>
+
+namespace momo
+{
+
+template<size_t tLogItemCount = 5,
+	size_t tCachedSegmentCount = 2>
+class SegmentedDequeSettings
+	: public SegmentedArraySettings<SegmentedArrayItemCountFunc::cnst, tLogItemCount>
+{
+public:
+	static const size_t cachedSegmentCount = tCachedSegmentCount;
+};
+
+template<typename TItem,
+	typename TMemManager = MemManagerDefault,
+	typename TItemTraits = SegmentedArrayItemTraits<TItem, TMemManager>,
+	typename TSettings = SegmentedDequeSettings<>>
+class SegmentedDeque
+{
+public:
+	typedef TItem Item;
+	typedef TMemManager MemManager;
+	typedef TItemTraits ItemTraits;
+	typedef TSettings Settings;
+
+	MOMO_STATIC_ASSERT(Settings::itemCountFunc == SegmentedArrayItemCountFunc::cnst);
+
+	typedef internal::ArrayIndexIterator<SegmentedDeque, Item> Iterator;
+	typedef typename Iterator::ConstIterator ConstIterator;
+
+private:
+	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	typedef internal::NestedArraySettings<typename Settings::SegmentsSettings> SegmentsSettings;
+
+	typedef Array<Item*, MemManager, ArrayItemTraits<Item*, MemManager>,
+		SegmentsSettings> Segments;
+
+	static const size_t segItemCount = size_t{1} << Settings::logInitialItemCount;
+	static const size_t cachedSegmentCount = Settings::cachedSegmentCount;
+
+	struct ConstIteratorProxy : public ConstIterator
+	{
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(ConstIterator)
+	};
+
+	struct IteratorProxy : public Iterator
+	{
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(Iterator)
+	};
+
+public:
+	SegmentedDeque() noexcept(noexcept(MemManager()))
+		: SegmentedDeque(MemManager())
+	{
+	}
+
+	explicit SegmentedDeque(MemManager&& memManager) noexcept
+		: mSegments(std::move(memManager)),
+		mSegBegin(0),
+		mFrontIndex(0),
+		mCount(0),
+		mCachedSegmentCount(0)
+	{
+	}
+
+	template<typename ArgIterator,
+		typename = typename std::iterator_traits<ArgIterator>::iterator_category>
+	explicit SegmentedDeque(ArgIterator begin, ArgIterator end,
+		MemManager&& memManager = MemManager())
+		: SegmentedDeque(std::move(memManager))
+	{
+		try
+		{
+			typedef typename ItemTraits::template Creator<
+				typename std::iterator_traits<ArgIterator>::reference> IterCreator;
+			for (ArgIterator iter = begin; iter != end; ++iter)
+				AddBackCrt(IterCreator(GetMemManager(), *iter));
+		}
+		catch (...)
+		{
+			pvDestroy();
+			throw;
+		}
+	}
+
+	SegmentedDeque(std::initializer_list<Item> items, MemManager&& memManager = MemManager())
+		: SegmentedDeque(items.begin(), items.end(), std::move(memManager))
+	{
+	}
+
+	SegmentedDeque(SegmentedDeque&& deque) noexcept
+		: mSegments(std::move(deque.mSegments)),
+		mSegBegin(deque.mSegBegin),
+		mFrontIndex(deque.mFrontIndex),
+		mCount(deque.mCount),
+		mCachedSegments(deque.mCachedSegments),
+		mCachedSegmentCount(deque.mCachedSegmentCount)
+	{
+		deque.mSegBegin = 0;
+		deque.mFrontIndex = 0;
+		deque.mCount = 0;
+		deque.mCachedSegmentCount = 0;
+	}
+
+	SegmentedDeque(const SegmentedDeque& deque)
+		: SegmentedDeque(deque.GetBegin(), deque.GetEnd(), MemManager(deque.GetMemManager()))
+	{
+	}
+
+	SegmentedDeque(const SegmentedDeque& deque, MemManager&& memManager)
+		: SegmentedDeque(deque.GetBegin(), deque.GetEnd(), std::move(memManager))
+	{
+	}
+
+	~SegmentedDeque() noexcept
+	{
+		pvDestroy();
+	}
+
+	SegmentedDeque& operator=(SegmentedDeque&& deque) noexcept
+	{
+		SegmentedDeque(std::move(deque)).Swap(*this);
+		return *this;
+	}
+
+	SegmentedDeque& operator=(const SegmentedDeque& deque)
+	{
+		if (this != &deque)
+			SegmentedDeque(deque).Swap(*this);
+		return *this;
+	}
+
+	void Swap(SegmentedDeque& deque) noexcept
+	{
+		mSegments.Swap(deque.mSegments);
+		std::swap(mSegBegin, deque.mSegBegin);
+		std::swap(mFrontIndex, deque.mFrontIndex);
+		std::swap(mCount, deque.mCount);
+		std::swap(mCachedSegments, deque.mCachedSegments);
+		std::swap(mCachedSegmentCount, deque.mCachedSegmentCount);
+	}
+
+	ConstIterator GetBegin() const noexcept
+	{
+		return ConstIteratorProxy(this, size_t{0});
+	}
+
+	Iterator GetBegin() noexcept
+	{
+		return IteratorProxy(this, size_t{0});
+	}
+
+	ConstIterator GetEnd() const noexcept
+	{
+		return ConstIteratorProxy(this, mCount);
+	}
+
+	Iterator GetEnd() noexcept
+	{
+		return IteratorProxy(this, mCount);
+	}
+
+	MOMO_FRIEND_SWAP(SegmentedDeque)
+	MOMO_FRIENDS_BEGIN_END(const SegmentedDeque&, ConstIterator)
+	MOMO_FRIENDS_BEGIN_END(SegmentedDeque&, Iterator)
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mSegments.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mSegments.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mCount;
+	}
+
+	bool IsEmpty() const noexcept
+	{
+		return mCount == 0;
+	}
+
+	void Clear(bool shrink = false) noexcept
+	{
+		RemoveBack(mCount);
+		if (shrink)
+			Shrink();
+	}
+
+	void Shrink() noexcept
+	{
+		for (size_t i = 0; i < mCachedSegmentCount; ++i)
+			pvFreeSegment(mCachedSegments[i]);
+		mCachedSegmentCount = 0;
+		if (mCount == 0)
+		{
+			mSegments.Clear(true);
+			mSegBegin = 0;
+			mFrontIndex = 0;
+		}
+	}
+
+	const Item& operator[](size_t index) const
+	{
+		return pvGetItem(index);
+	}
+
+	Item& operator[](size_t index)
+	{
+		return pvGetItem(index);
+	}
+
+	const Item& GetFrontItem() const
+	{
+		return pvGetItem(0);
+	}
+
+	Item& GetFrontItem()
+	{
+		return pvGetItem(0);
+	}
+
+	const Item& GetBackItem() const
+	{
+		return pvGetItem(mCount - 1);
+	}
+
+	Item& GetBackItem()
+	{
+		return pvGetItem(mCount - 1);
+	}
+
+	template<typename ItemCreator>
+	void AddBackCrt(ItemCreator&& itemCreator)
+	{
+		size_t segIndex, itemIndex;
+		Settings::GetSegItemIndexes(mFrontIndex + mCount, segIndex, itemIndex);
+		if (segIndex == mSegments.GetCount())
+			pvGrowSegments();
+		Item*& segment = mSegments[pvGetSegSlot(segIndex)];
+		if (segment != nullptr)
+		{
+			std::forward<ItemCreator>(itemCreator)(segment + itemIndex);
+		}
+		else
+		{
+			MOMO_ASSERT(itemIndex == 0 || mCount == 0);
+			Item* newSegment = pvGetSegment();
+			try
+			{
+				std::forward<ItemCreator>(itemCreator)(newSegment + itemIndex);
+			}
+			catch (...)
+			{
+				pvReleaseSegment(newSegment);
+				throw;
+			}
+			segment = newSegment;
+		}
+		++mCount;
+	}
+
+	template<typename... ItemArgs>
+	void AddBackVar(ItemArgs&&... itemArgs)
+	{
+		AddBackCrt(typename ItemTraits::template Creator<ItemArgs...>(GetMemManager(),
+			std::forward<ItemArgs>(itemArgs)...));
+	}
+
+	void AddBack(Item&& item)
+	{
+		AddBackVar(std::move(item));
+	}
+
+	void AddBack(const Item& item)
+	{
+		AddBackVar(item);
+	}
+
+	template<typename ItemCreator>
+	void AddFrontCrt(ItemCreator&& itemCreator)
+	{
+		if (mFrontIndex > 0 && mCount > 0)
+		{
+			std::forward<ItemCreator>(itemCreator)(mSegments[mSegBegin] + mFrontIndex - 1);
+			--mFrontIndex;
+		}
+		else
+		{
+			if (pvGetUsedSegCount() == mSegments.GetCount())
+				pvGrowSegments();
+			Item* newSegment = pvGetSegment();
+			size_t frontIndex = (mCount > 0) ? segItemCount - 1 : segItemCount / 2;
+			try
+			{
+				std::forward<ItemCreator>(itemCreator)(newSegment + frontIndex);
+			}
+			catch (...)
+			{
+				pvReleaseSegment(newSegment);
+				throw;
+			}
+			if (mCount > 0)
+				mSegBegin = pvGetSegSlot(mSegments.GetCount() - 1);
+			mSegments[mSegBegin] = newSegment;
+			mFrontIndex = frontIndex;
+		}
+		++mCount;
+	}
+
+	template<typename... ItemArgs>
+	void AddFrontVar(ItemArgs&&... itemArgs)
+	{
+		AddFrontCrt(typename ItemTraits::template Creator<ItemArgs...>(GetMemManager(),
+			std::forward<ItemArgs>(itemArgs)...));
+	}
+
+	void AddFront(Item&& item)
+	{
+		AddFrontVar(std::move(item));
+	}
+
+	void AddFront(const Item& item)
+	{
+		AddFrontVar(item);
+	}
+
+	void RemoveBack(size_t count = 1)
+	{
+		MOMO_CHECK(count <= mCount);
+		for (; count > 0; --count)
+		{
+			size_t segIndex, itemIndex;
+			Settings::GetSegItemIndexes(mFrontIndex + mCount - 1, segIndex, itemIndex);
+			Item*& segment = mSegments[pvGetSegSlot(segIndex)];
+			ItemTraits::Destroy(GetMemManager(), segment + itemIndex, 1);
+			--mCount;
+			if (itemIndex == 0 || mCount == 0)
+			{
+				pvReleaseSegment(segment);
+				segment = nullptr;
+			}
+		}
+	}
+
+	void RemoveFront(size_t count = 1)
+	{
+		MOMO_CHECK(count <= mCount);
+		for (; count > 0; --count)
+		{
+			Item*& segment = mSegments[mSegBegin];
+			ItemTraits::Destroy(GetMemManager(), segment + mFrontIndex, 1);
+			--mCount;
+			++mFrontIndex;
+			if (mFrontIndex == segItemCount || mCount == 0)
+			{
+				pvReleaseSegment(segment);
+				segment = nullptr;
+				mSegBegin = pvGetSegSlot(1);
+				mFrontIndex = 0;
+			}
+		}
+	}
+
+	template<typename ItemArg,
+		typename Predicate = internal::Equaler<ItemArg, Item>>
+	bool Contains(const ItemArg& itemArg, const Predicate& pred = Predicate()) const
+	{
+		ConstIterator end = GetEnd();
+		return std::find_if(GetBegin(), end,
+			[&itemArg, &pred] (const Item& item) { return pred(itemArg, item); }) != end;
+	}
+
+private:
+	size_t pvGetSegSlot(size_t segIndex) const noexcept
+	{
+		return (mSegBegin + segIndex) & (mSegments.GetCount() - 1);
+	}
+
+	size_t pvGetUsedSegCount() const noexcept
+	{
+		if (mCount == 0)
+			return 0;
+		return ((mFrontIndex + mCount - 1) >> Settings::logInitialItemCount) + 1;
+	}
+
+	Item& pvGetItem(size_t index) const
+	{
+		MOMO_CHECK(index < mCount);
+		size_t segIndex, itemIndex;
+		Settings::GetSegItemIndexes(mFrontIndex + index, segIndex, itemIndex);
+		return mSegments[pvGetSegSlot(segIndex)][itemIndex];
+	}
+
+	void pvGrowSegments()
+	{
+		// the ring is full, its size is a power of two
+		size_t segCount = mSegments.GetCount();
+		size_t newSegCount = (segCount > 0) ? 2 * segCount : 4;
+		mSegments.SetCount(newSegCount, nullptr);
+		for (size_t i = 0; i < mSegBegin; ++i)
+		{
+			mSegments[segCount + i] = mSegments[i];
+			mSegments[i] = nullptr;
+		}
+	}
+
+	Item* pvGetSegment()
+	{
+		if (mCachedSegmentCount > 0)
+		{
+			--mCachedSegmentCount;
+			return mCachedSegments[mCachedSegmentCount];
+		}
+		if (segItemCount > SIZE_MAX / sizeof(Item))
+			throw std::length_error("momo::SegmentedDeque length error");
+		return MemManagerProxy::template Allocate<Item>(GetMemManager(),
+			segItemCount * sizeof(Item));
+	}
+
+	void pvReleaseSegment(Item* segment) noexcept
+	{
+		if (mCachedSegmentCount < cachedSegmentCount)
+		{
+			mCachedSegments[mCachedSegmentCount] = segment;
+			++mCachedSegmentCount;
+		}
+		else
+		{
+			pvFreeSegment(segment);
+		}
+	}
+
+	void pvFreeSegment(Item* segment) noexcept
+	{
+		MemManagerProxy::Deallocate(GetMemManager(), segment, segItemCount * sizeof(Item));
+	}
+
+	void pvDestroy() noexcept
+	{
+		if (mSegments.IsEmpty())
+			return;
+		RemoveBack(mCount);
+		Shrink();
+	}
+
+private:
+	Segments mSegments;
+	size_t mSegBegin;
+	size_t mFrontIndex;
+	size_t mCount;
+	std::array<Item*, cachedSegmentCount> mCachedSegments;
+	size_t mCachedSegmentCount;
+};
+
+} // namespace momo
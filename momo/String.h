@@ -0,0 +1,579 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/String.h
+
+  namespace momo:
+    class String
+    struct IsTriviallyRelocatable<String>
+    struct IsFastNothrowHashable<String>
+    class HashTraits<String>
+
+  `String` is an immutable-by-character string of `char` intended
+  for keys of hash and tree containers. It occupies three pointers
+  when `MemManager` is empty (24 bytes on 64-bit platforms) and keeps
+  up to 23 characters inside the object. Longer strings are placed in
+  one block of the memory manager (for example, `MemPool` based
+  `MemManagerPooled<>::Ptr`), and the block also caches the hash code
+  of the string. The characters are always followed by `'\0'`.
+
+  `String` has no pointers into itself, so it is trivially relocatable
+  and containers move it with `memcpy`. `HashTraits<String>` allows
+  searching by `const char*` without creating the string. Default
+  `TreeTraits<String>` allows it as well by means of the comparison
+  operators, which compare strings bytewise.
+
+  Exception safety of `Append` and `Reserve` is strong.
+
+\**********************************************************/
+
+#pragma once
+
+#include "HashTraits.h"
+
+#include <atomic>
+#include <string>
+
+namespace momo
+{
+
+namespace internal
+{
+	class StringHasher
+	{
+	public:
+		static size_t GetHashCode(const char* chars, size_t count) noexcept
+		{
+			static const uint64_t mult = 0x9e3779b97f4a7c15;
+			uint64_t hashCode = static_cast<uint64_t>(count) * mult;
+			for (; count >= sizeof(uint64_t); count -= sizeof(uint64_t))
+			{
+				uint64_t word;
+				std::memcpy(&word, chars, sizeof(uint64_t));
+				chars += sizeof(uint64_t);
+				hashCode = (hashCode ^ word) * mult;
+				hashCode ^= hashCode >> 32;
+			}
+			if (count > 0)
+			{
+				uint64_t word = 0;
+				std::memcpy(&word, chars, count);
+				hashCode = (hashCode ^ word) * mult;
+			}
+			hashCode ^= hashCode >> 29;
+			hashCode *= 0xbf58476d1ce4e5b9;
+			hashCode ^= hashCode >> 32;
+			return static_cast<size_t>(hashCode);
+		}
+	};
+}
+
+template<typename TMemManager = MemManagerDefault>
+class String : private TMemManager
+{
+public:
+	typedef TMemManager MemManager;
+
+	typedef const char* ConstIterator;
+
+	static const size_t internalCapacity = 3 * sizeof(void*) - 1;
+
+private:
+	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	struct Header
+	{
+		size_t capacity;
+		std::atomic<size_t> hashCode;	// 0 if not calculated
+	};
+
+	static const unsigned char heapMark = 0xFF;
+
+public:
+	String() noexcept(noexcept(MemManager()))
+		: String(MemManager())
+	{
+	}
+
+	explicit String(MemManager&& memManager) noexcept
+		: MemManager(std::move(memManager))
+	{
+		pvSetInternalCount(0);
+	}
+
+	String(const char* chars, MemManager&& memManager = MemManager())
+		: String(chars, std::char_traits<char>::length(chars), std::move(memManager))
+	{
+	}
+
+	String(const char* chars, size_t count, MemManager&& memManager = MemManager())
+		: MemManager(std::move(memManager))
+	{
+		pvCreate(chars, count, 0);
+	}
+
+	explicit String(const std::string& str, MemManager&& memManager = MemManager())
+		: String(str.data(), str.size(), std::move(memManager))
+	{
+	}
+
+	String(String&& str) noexcept
+		: MemManager(std::move(str.GetMemManager()))
+	{
+		std::memcpy(mBuffer, str.mBuffer, sizeof(mBuffer));
+		str.pvSetInternalCount(0);
+	}
+
+	String(const String& str)
+		: MemManager(str.GetMemManager())
+	{
+		pvCreate(str.GetChars(), str.GetCount(), str.pvGetCachedHashCode());
+	}
+
+	String(const String& str, MemManager&& memManager)
+		: MemManager(std::move(memManager))
+	{
+		pvCreate(str.GetChars(), str.GetCount(), str.pvGetCachedHashCode());
+	}
+
+	~String() noexcept
+	{
+		pvDestroy();
+	}
+
+	String& operator=(String&& str) noexcept
+	{
+		if (this != &str)
+			pvAssign(std::move(str));
+		return *this;
+	}
+
+	String& operator=(const String& str)
+	{
+		if (this != &str)
+			pvAssign(String(str));
+		return *this;
+	}
+
+	void Swap(String& str) noexcept
+	{
+		if (this != &str)
+		{
+			String tempStr(std::move(str));
+			str.pvAssign(std::move(*this));
+			pvAssign(std::move(tempStr));
+		}
+	}
+
+	ConstIterator GetBegin() const noexcept
+	{
+		return GetChars();
+	}
+
+	ConstIterator GetEnd() const noexcept
+	{
+		return GetChars() + GetCount();
+	}
+
+	MOMO_FRIEND_SWAP(String)
+	MOMO_FRIENDS_BEGIN_END(const String&, ConstIterator)
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return *this;
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return *this;
+	}
+
+	const char* GetChars() const noexcept
+	{
+		return pvIsInternal() ? reinterpret_cast<const char*>(mBuffer)
+			: pvGetHeapChars(pvGetHeader());
+	}
+
+	size_t GetCount() const noexcept
+	{
+		if (pvIsInternal())
+			return internalCapacity - size_t{mBuffer[internalCapacity]};
+		size_t count;
+		std::memcpy(&count, mBuffer + sizeof(Header*), sizeof(size_t));
+		return count;
+	}
+
+	MOMO_NODISCARD bool IsEmpty() const noexcept
+	{
+		return GetCount() == 0;
+	}
+
+	size_t GetCapacity() const noexcept
+	{
+		return pvIsInternal() ? internalCapacity : pvGetHeader()->capacity;
+	}
+
+	void Reserve(size_t capacity)
+	{
+		if (capacity > GetCapacity())
+			pvGrow(capacity, GetCount());
+	}
+
+	void Clear(bool shrink = false) noexcept
+	{
+		if (shrink || pvIsInternal())
+		{
+			pvDestroy();
+			pvSetInternalCount(0);
+		}
+		else
+		{
+			pvSetHeapCount(pvGetHeader(), 0);
+		}
+	}
+
+	const char& operator[](size_t index) const
+	{
+		MOMO_ASSERT(index < GetCount());
+		return GetChars()[index];
+	}
+
+	void Append(const char* chars, size_t count)
+	{
+		size_t initCount = GetCount();
+		size_t newCount = initCount + count;
+		if (newCount > GetCapacity())
+		{
+			size_t newCapacity = std::minmax(newCount, initCount + initCount / 2).second;
+			pvGrow(newCapacity, initCount, chars, count);	// chars may point into this string
+			return;
+		}
+		if (pvIsInternal())
+		{
+			std::memcpy(mBuffer + initCount, chars, count);
+			pvSetInternalCount(newCount);
+		}
+		else
+		{
+			Header* header = pvGetHeader();
+			std::memcpy(pvGetHeapChars(header) + initCount, chars, count);
+			pvSetHeapCount(header, newCount);
+		}
+	}
+
+	void Append(const char* chars)
+	{
+		Append(chars, std::char_traits<char>::length(chars));
+	}
+
+	String& operator+=(const char* chars)
+	{
+		Append(chars);
+		return *this;
+	}
+
+	String& operator+=(const String& str)
+	{
+		Append(str.GetChars(), str.GetCount());
+		return *this;
+	}
+
+	size_t GetHashCode() const noexcept
+	{
+		if (pvIsInternal())
+			return internal::StringHasher::GetHashCode(GetChars(), GetCount());
+		size_t hashCode = pvGetCachedHashCode();
+		if (hashCode == 0)
+		{
+			hashCode = internal::StringHasher::GetHashCode(GetChars(), GetCount());
+			pvGetHeader()->hashCode.store(hashCode, std::memory_order_relaxed);
+		}
+		return hashCode;
+	}
+
+	int Compare(const char* chars, size_t count) const noexcept
+	{
+		size_t thisCount = GetCount();
+		int res = std::memcmp(GetChars(), chars, std::minmax(thisCount, count).first);
+		if (res != 0)
+			return res;
+		return (thisCount < count) ? -1 : (thisCount > count) ? 1 : 0;
+	}
+
+	int Compare(const String& str) const noexcept
+	{
+		return Compare(str.GetChars(), str.GetCount());
+	}
+
+	int Compare(const char* chars) const noexcept
+	{
+		return Compare(chars, std::char_traits<char>::length(chars));
+	}
+
+	bool IsEqual(const String& str) const noexcept
+	{
+		size_t count = GetCount();
+		if (count != str.GetCount())
+			return false;
+		size_t hashCode1 = pvGetCachedHashCode();
+		size_t hashCode2 = str.pvGetCachedHashCode();
+		if (hashCode1 != 0 && hashCode2 != 0 && hashCode1 != hashCode2)
+			return false;
+		return std::memcmp(GetChars(), str.GetChars(), count) == 0;
+	}
+
+	bool IsEqual(const char* chars) const noexcept
+	{
+		size_t count = GetCount();
+		return std::char_traits<char>::length(chars) == count
+			&& std::memcmp(GetChars(), chars, count) == 0;
+	}
+
+	friend bool operator==(const String& str1, const String& str2) noexcept
+	{
+		return str1.IsEqual(str2);
+	}
+
+	friend bool operator==(const String& str, const char* chars) noexcept
+	{
+		return str.IsEqual(chars);
+	}
+
+	friend bool operator==(const char* chars, const String& str) noexcept
+	{
+		return str.IsEqual(chars);
+	}
+
+	friend bool operator!=(const String& str1, const String& str2) noexcept
+	{
+		return !str1.IsEqual(str2);
+	}
+
+	friend bool operator!=(const String& str, const char* chars) noexcept
+	{
+		return !str.IsEqual(chars);
+	}
+
+	friend bool operator!=(const char* chars, const String& str) noexcept
+	{
+		return !str.IsEqual(chars);
+	}
+
+	friend bool operator<(const String& str1, const String& str2) noexcept
+	{
+		return str1.Compare(str2) < 0;
+	}
+
+	friend bool operator<(const String& str, const char* chars) noexcept
+	{
+		return str.Compare(chars) < 0;
+	}
+
+	friend bool operator<(const char* chars, const String& str) noexcept
+	{
+		return str.Compare(chars) > 0;
+	}
+
+	friend bool operator>(const String& str1, const String& str2) noexcept
+	{
+		return str2 < str1;
+	}
+
+	friend bool operator<=(const String& str1, const String& str2) noexcept
+	{
+		return !(str2 < str1);
+	}
+
+	friend bool operator>=(const String& str1, const String& str2) noexcept
+	{
+		return !(str1 < str2);
+	}
+
+private:
+	bool pvIsInternal() const noexcept
+	{
+		return mBuffer[internalCapacity] != heapMark;
+	}
+
+	Header* pvGetHeader() const noexcept
+	{
+		MOMO_ASSERT(!pvIsInternal());
+		Header* header;
+		std::memcpy(&header, mBuffer, sizeof(Header*));
+		return header;
+	}
+
+	static char* pvGetHeapChars(Header* header) noexcept
+	{
+		return reinterpret_cast<char*>(header + 1);
+	}
+
+	size_t pvGetCachedHashCode() const noexcept
+	{
+		return pvIsInternal() ? 0 : pvGetHeader()->hashCode.load(std::memory_order_relaxed);
+	}
+
+	void pvSetInternalCount(size_t count) noexcept
+	{
+		MOMO_ASSERT(count <= internalCapacity);
+		mBuffer[count] = 0;
+		mBuffer[internalCapacity] = static_cast<unsigned char>(internalCapacity - count);
+	}
+
+	void pvSetHeap(Header* header, size_t count) noexcept
+	{
+		std::memcpy(mBuffer, &header, sizeof(Header*));
+		pvSetHeapCount(header, count);
+		mBuffer[internalCapacity] = heapMark;
+	}
+
+	void pvSetHeapCount(Header* header, size_t count) noexcept
+	{
+		MOMO_ASSERT(count <= header->capacity);
+		std::memcpy(mBuffer + sizeof(Header*), &count, sizeof(size_t));
+		pvGetHeapChars(header)[count] = '\0';
+		header->hashCode.store(0, std::memory_order_relaxed);
+	}
+
+	static size_t pvGetBlockSize(size_t capacity) noexcept
+	{
+		return sizeof(Header) + capacity + 1;
+	}
+
+	Header* pvAllocate(size_t capacity)
+	{
+		Header* header = MemManagerProxy::template Allocate<Header>(GetMemManager(),
+			pvGetBlockSize(capacity));
+		::new(static_cast<void*>(header)) Header();
+		header->capacity = capacity;
+		return header;
+	}
+
+	void pvCreate(const char* chars, size_t count, size_t hashCode)
+	{
+		if (count <= internalCapacity)
+		{
+			std::memcpy(mBuffer, chars, count);
+			pvSetInternalCount(count);
+		}
+		else
+		{
+			Header* header = pvAllocate(count);
+			std::memcpy(pvGetHeapChars(header), chars, count);
+			pvSetHeap(header, count);
+			header->hashCode.store(hashCode, std::memory_order_relaxed);
+		}
+	}
+
+	void pvGrow(size_t capacity, size_t count, const char* chars = nullptr,
+		size_t appendCount = 0)
+	{
+		MOMO_ASSERT(capacity > internalCapacity && capacity >= count + appendCount);
+		Header* header = pvAllocate(capacity);
+		char* newChars = pvGetHeapChars(header);
+		std::memcpy(newChars, GetChars(), count);
+		if (appendCount > 0)
+			std::memcpy(newChars + count, chars, appendCount);
+		size_t hashCode = (appendCount > 0) ? 0 : pvGetCachedHashCode();
+		pvDestroy();
+		pvSetHeap(header, count + appendCount);
+		header->hashCode.store(hashCode, std::memory_order_relaxed);
+	}
+
+	void pvDestroy() noexcept
+	{
+		if (pvIsInternal())
+			return;
+		Header* header = pvGetHeader();
+		MemManagerProxy::Deallocate(GetMemManager(), header, pvGetBlockSize(header->capacity));
+	}
+
+	void pvAssign(String&& str) noexcept
+	{
+		MOMO_ASSERT(this != &str);
+		this->~String();	//?
+		::new(static_cast<void*>(this)) String(std::move(str));
+	}
+
+private:
+	unsigned char mBuffer[internalCapacity + 1];
+};
+
+template<typename MemManager>
+struct IsTriviallyRelocatable<String<MemManager>>
+	: public internal::BoolConstant<std::is_empty<MemManager>::value
+		|| IsTriviallyRelocatable<MemManager>::value>
+{
+};
+
+template<typename MemManager>
+struct IsFastNothrowHashable<String<MemManager>> : public std::true_type
+{
+};
+
+template<typename MemManager, typename THashBucket>
+class HashTraits<String<MemManager>, THashBucket, String<MemManager>>
+{
+public:
+	typedef String<MemManager> Key;
+	typedef THashBucket HashBucket;
+	typedef Key KeyArgBase;
+
+	template<typename KeyArg>
+	using IsValidKeyArg = std::is_convertible<const KeyArg&, const char*>;
+
+	static const bool isFastNothrowHashable = true;
+
+public:
+	explicit HashTraits() noexcept
+	{
+	}
+
+	size_t CalcCapacity(size_t bucketCount, size_t bucketMaxItemCount) const noexcept
+	{
+		return HashBucket::CalcCapacity(bucketCount, bucketMaxItemCount);
+	}
+
+	size_t GetBucketCountShift(size_t bucketCount, size_t bucketMaxItemCount) const noexcept
+	{
+		return HashBucket::GetBucketCountShift(bucketCount, bucketMaxItemCount);
+	}
+
+	size_t GetLogStartBucketCount() const noexcept
+	{
+		return HashBucket::logStartBucketCount;
+	}
+
+	size_t GetHashCode(const Key& key) const noexcept
+	{
+		return key.GetHashCode();
+	}
+
+	size_t GetHashCode(const char* key) const noexcept
+	{
+		return internal::StringHasher::GetHashCode(key, std::char_traits<char>::length(key));
+	}
+
+	template<typename KeyArg1, typename KeyArg2>
+	bool IsEqual(const KeyArg1& key1, const KeyArg2& key2) const noexcept
+	{
+		return key1 == key2;
+	}
+};
+
+} // namespace momo
+
+namespace std
+{
+	template<typename MemManager>
+	struct hash<momo::String<MemManager>>
+	{
+		size_t operator()(const momo::String<MemManager>& str) const noexcept
+		{
+			return str.GetHashCode();
+		}
+	};
+} // namespace std
@@ -0,0 +1,332 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/StringPool.h
+
+  namespace momo:
+    class StringPoolHandle
+    class StringPool
+
+  `StringPool` interns strings: every distinct string is stored once
+  in the chunks of `MemManagerArena` and gets a 32-bit handle. Handles
+  are numbered consecutively from zero, so they can index arrays.
+  Pointers returned by `GetChars` stay valid until `Clear` or
+  destruction of the pool. Equal strings have equal handles and equal
+  pointers, therefore comparison of interned strings takes O(1) time.
+  The length and the hash code of the string are stored in front of
+  its characters.
+
+  `StringPoolHandle` is a 4-byte trivially copyable type, which can be
+  used as a key of hash and tree containers with default traits or as
+  a type of `DataTable` column instead of a string.
+
+  Exception safety of `Intern` is strong.
+
+\**********************************************************/
+
+#pragma once
+
+#include "String.h"
+#include "HashSet.h"
+#include "TreeTraits.h"
+#include "Array.h"
+#include "MemManagerArena.h"
+
+namespace momo
+{
+
+class StringPoolHandle
+{
+public:
+	static const uint32_t nullValue = UINT32_MAX;
+
+public:
+	explicit StringPoolHandle() noexcept
+		: mValue(nullValue)
+	{
+	}
+
+	explicit StringPoolHandle(uint32_t value) noexcept
+		: mValue(value)
+	{
+	}
+
+	uint32_t GetValue() const noexcept
+	{
+		return mValue;
+	}
+
+	bool IsNull() const noexcept
+	{
+		return mValue == nullValue;
+	}
+
+	size_t GetHashCode() const noexcept
+	{
+		uint64_t hashCode = uint64_t{mValue} * 0x9e3779b97f4a7c15;
+		return static_cast<size_t>(hashCode ^ (hashCode >> 32));
+	}
+
+	friend bool operator==(StringPoolHandle handle1, StringPoolHandle handle2) noexcept
+	{
+		return handle1.mValue == handle2.mValue;
+	}
+
+	friend bool operator!=(StringPoolHandle handle1, StringPoolHandle handle2) noexcept
+	{
+		return handle1.mValue != handle2.mValue;
+	}
+
+	friend bool operator<(StringPoolHandle handle1, StringPoolHandle handle2) noexcept
+	{
+		return handle1.mValue < handle2.mValue;
+	}
+
+private:
+	uint32_t mValue;
+};
+
+template<>
+struct IsFastNothrowHashable<StringPoolHandle> : public std::true_type
+{
+};
+
+template<>
+struct IsFastComparable<StringPoolHandle> : public std::true_type
+{
+};
+
+namespace internal
+{
+	struct StringPoolKey
+	{
+		const char* chars;
+		size_t count;
+		size_t hashCode;
+	};
+
+	class StringPoolHeader
+	{
+	public:
+		size_t hashCode;
+		size_t count;
+		uint32_t handleValue;
+
+	public:
+		static StringPoolHeader* Get(const char* chars) noexcept
+		{
+			return reinterpret_cast<StringPoolHeader*>(const_cast<char*>(chars)) - 1;
+		}
+
+		char* GetChars() noexcept
+		{
+			return reinterpret_cast<char*>(this + 1);
+		}
+	};
+
+	class StringPoolHashTraits : public HashTraits<const char*, HashBucketOpenDefault>
+	{
+	public:
+		template<typename KeyArg>
+		using IsValidKeyArg = std::is_same<KeyArg, StringPoolKey>;
+
+		static const bool isFastNothrowHashable = true;
+
+	public:
+		explicit StringPoolHashTraits() noexcept
+		{
+		}
+
+		size_t GetHashCode(const char* key) const noexcept
+		{
+			return StringPoolHeader::Get(key)->hashCode;
+		}
+
+		size_t GetHashCode(const StringPoolKey& key) const noexcept
+		{
+			return key.hashCode;
+		}
+
+		bool IsEqual(const char* key1, const char* key2) const noexcept
+		{
+			return key1 == key2;
+		}
+
+		bool IsEqual(const StringPoolKey& key1, const char* key2) const noexcept
+		{
+			const StringPoolHeader* header2 = StringPoolHeader::Get(key2);
+			return key1.hashCode == header2->hashCode && key1.count == header2->count
+				&& std::memcmp(key1.chars, key2, key1.count) == 0;
+		}
+	};
+}
+
+template<typename TMemManager = MemManagerDefault>
+class StringPool
+{
+public:
+	typedef TMemManager MemManager;
+	typedef StringPoolHandle Handle;
+
+private:
+	typedef internal::StringPoolKey Key;
+	typedef internal::StringPoolHeader Header;
+
+	typedef MemManagerArena<MemManager> Arena;
+
+	typedef HashSet<const char*, internal::StringPoolHashTraits, MemManager> Set;
+	typedef Array<const char*, MemManager> Strings;
+
+public:
+	explicit StringPool(MemManager&& memManager = MemManager())
+		: mArena(MemManager(memManager)),
+		mStrings(MemManager(memManager)),
+		mSet(internal::StringPoolHashTraits(), std::move(memManager))
+	{
+	}
+
+	StringPool(StringPool&& stringPool) noexcept
+		: mArena(std::move(stringPool.mArena)),
+		mStrings(std::move(stringPool.mStrings)),
+		mSet(std::move(stringPool.mSet))
+	{
+	}
+
+	StringPool(const StringPool&) = delete;
+
+	~StringPool() noexcept
+	{
+	}
+
+	StringPool& operator=(const StringPool&) = delete;
+
+	const MemManager& GetMemManager() const noexcept
+	{
+		return mSet.GetMemManager();
+	}
+
+	MemManager& GetMemManager() noexcept
+	{
+		return mSet.GetMemManager();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return mStrings.GetCount();
+	}
+
+	MOMO_NODISCARD bool IsEmpty() const noexcept
+	{
+		return mStrings.IsEmpty();
+	}
+
+	void Clear() noexcept
+	{
+		mSet.Clear(true);
+		mStrings.Clear(true);
+		mArena.Reset();
+	}
+
+	Handle Intern(const char* chars, size_t count)
+	{
+		Key key = { chars, count, internal::StringHasher::GetHashCode(chars, count) };
+		typename Set::ConstPosition pos = mSet.Find(key);
+		if (!!pos)
+			return Handle(Header::Get(*pos)->handleValue);
+		size_t handleValue = mStrings.GetCount();
+		if (handleValue >= size_t{Handle::nullValue})
+			throw std::length_error("momo::StringPool length error");
+		mStrings.Reserve(handleValue + 1);
+		size_t blockSize = sizeof(Header) + count + 1;
+		Header* header = ::new(mArena.Allocate(blockSize)) Header();
+		header->hashCode = key.hashCode;
+		header->count = count;
+		header->handleValue = static_cast<uint32_t>(handleValue);
+		char* newChars = header->GetChars();
+		std::memcpy(newChars, chars, count);
+		newChars[count] = '\0';
+		try
+		{
+			mSet.Add(pos, newChars);
+		}
+		catch (...)
+		{
+			mArena.Deallocate(header, blockSize);
+			throw;
+		}
+		mStrings.AddBackNogrow(newChars);
+		return Handle(static_cast<uint32_t>(handleValue));
+	}
+
+	Handle Intern(const char* str)
+	{
+		return Intern(str, std::char_traits<char>::length(str));
+	}
+
+	Handle Find(const char* chars, size_t count) const
+	{
+		Key key = { chars, count, internal::StringHasher::GetHashCode(chars, count) };
+		typename Set::ConstPosition pos = mSet.Find(key);
+		return !!pos ? Handle(Header::Get(*pos)->handleValue) : Handle();
+	}
+
+	Handle Find(const char* str) const
+	{
+		return Find(str, std::char_traits<char>::length(str));
+	}
+
+	const char* GetChars(Handle handle) const
+	{
+		MOMO_ASSERT(handle.GetValue() < GetCount());
+		return mStrings[handle.GetValue()];
+	}
+
+	size_t GetCount(Handle handle) const
+	{
+		return GetCount(GetChars(handle));
+	}
+
+	size_t GetHashCode(Handle handle) const
+	{
+		return GetHashCode(GetChars(handle));
+	}
+
+	// Functions for pointers returned by `GetChars`
+
+	static size_t GetCount(const char* chars) noexcept
+	{
+		return Header::Get(chars)->count;
+	}
+
+	static size_t GetHashCode(const char* chars) noexcept
+	{
+		return Header::Get(chars)->hashCode;
+	}
+
+	static Handle GetHandle(const char* chars) noexcept
+	{
+		return Handle(Header::Get(chars)->handleValue);
+	}
+
+private:
+	Arena mArena;
+	Strings mStrings;
+	Set mSet;
+};
+
+} // namespace momo
+
+namespace std
+{
+	template<>
+	struct hash<momo::StringPoolHandle>
+	{
+		size_t operator()(momo::StringPoolHandle handle) const noexcept
+		{
+			return handle.GetHashCode();
+		}
+	};
+} // namespace std
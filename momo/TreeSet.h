@@ -19,6 +19,11 @@
   3. If constructor receiving many items throws exception, input argument
     `memManager` may be changed.
 
+  A node type may declare `static const bool isBPlus = true` to switch
+  `TreeSet` to the B+ tree algorithms (see `TreeNodeBPlus`). Node types
+  without this member are treated as B trees. In the B+ mode internal
+  nodes keep copies of keys, so `Key` must be copy constructible.
+
 \**********************************************************/
 
 #pragma once
@@ -32,6 +37,18 @@ namespace momo
 
 namespace internal
 {
+	template<typename Node,
+		typename = void>
+	struct TreeNodeIsBPlus : public std::false_type
+	{
+	};
+
+	template<typename Node>
+	struct TreeNodeIsBPlus<Node, Void<decltype(Node::isBPlus)>>
+		: public BoolConstant<Node::isBPlus>
+	{
+	};
+
 	template<typename TNode, typename TSettings>
 	class TreeSetConstIterator : private VersionKeeper<TSettings>
 	{
@@ -49,6 +66,8 @@ namespace internal
 	private:
 		typedef internal::VersionKeeper<Settings> VersionKeeper;
 
+		typedef TreeNodeIsBPlus<Node> IsBPlus;
+
 	public:
 		explicit TreeSetConstIterator() noexcept
 			: mNode(nullptr),
@@ -62,18 +81,7 @@ namespace internal
 		{
 			VersionKeeper::Check();
 			MOMO_CHECK(mNode != nullptr);
-			if (mNode->IsLeaf())
-			{
-				++mItemIndex;
-			}
-			else
-			{
-				MOMO_CHECK(mItemIndex < mNode->GetCount());
-				mNode = mNode->GetChild(mItemIndex + 1);
-				while (!mNode->IsLeaf())
-					mNode = mNode->GetChild(0);
-				mItemIndex = 0;
-			}
+			pvIncrement(IsBPlus());
 			pvMoveIf();
 			return *this;
 		}
@@ -82,35 +90,7 @@ namespace internal
 		{
 			VersionKeeper::Check();
 			MOMO_CHECK(mNode != nullptr);
-			Node* node = mNode;
-			size_t itemIndex = mItemIndex;
-			if (!node->IsLeaf())
-			{
-				node = node->GetChild(itemIndex);
-				while (!node->IsLeaf())
-					node = node->GetChild(node->GetCount());
-				itemIndex = node->GetCount();
-			}
-			if (itemIndex == 0)
-			{
-				while (true)
-				{
-					Node* childNode = node;
-					node = node->GetParent();
-					MOMO_CHECK(node != nullptr);
-					if (childNode != node->GetChild(0))
-					{
-						itemIndex = node->GetChildIndex(childNode) - 1;
-						break;
-					}
-				}
-			}
-			else
-			{
-				--itemIndex;
-			}
-			mNode = node;
-			mItemIndex = itemIndex;
+			pvDecrement(IsBPlus());
 			return *this;
 		}
 
@@ -157,13 +137,109 @@ namespace internal
 		}
 
 	private:
+		void pvIncrement(std::false_type /*isBPlus*/)
+		{
+			if (mNode->IsLeaf())
+			{
+				++mItemIndex;
+			}
+			else
+			{
+				MOMO_CHECK(mItemIndex < mNode->GetCount());
+				mNode = mNode->GetChild(mItemIndex + 1);
+				while (!mNode->IsLeaf())
+					mNode = mNode->GetChild(0);
+				mItemIndex = 0;
+			}
+		}
+
+		void pvIncrement(std::true_type /*isBPlus*/)
+		{
+			MOMO_CHECK(mItemIndex < mNode->GetCount());
+			++mItemIndex;
+		}
+
+		void pvDecrement(std::false_type /*isBPlus*/)
+		{
+			Node* node = mNode;
+			size_t itemIndex = mItemIndex;
+			if (!node->IsLeaf())
+			{
+				node = node->GetChild(itemIndex);
+				while (!node->IsLeaf())
+					node = node->GetChild(node->GetCount());
+				itemIndex = node->GetCount();
+			}
+			if (itemIndex == 0)
+			{
+				while (true)
+				{
+					Node* childNode = node;
+					node = node->GetParent();
+					MOMO_CHECK(node != nullptr);
+					if (childNode != node->GetChild(0))
+					{
+						itemIndex = node->GetChildIndex(childNode) - 1;
+						break;
+					}
+				}
+			}
+			else
+			{
+				--itemIndex;
+			}
+			mNode = node;
+			mItemIndex = itemIndex;
+		}
+
+		void pvDecrement(std::true_type /*isBPlus*/)
+		{
+			Node* node = mNode;
+			size_t itemIndex = mItemIndex;
+			if (!node->IsLeaf())
+			{
+				while (!node->IsLeaf())
+					node = node->GetChild(node->GetCount());
+				itemIndex = node->GetCount();
+			}
+			while (itemIndex == 0)
+			{
+				node = node->GetPrevLeaf();
+				MOMO_CHECK(node != nullptr);
+				itemIndex = node->GetCount();
+			}
+			mNode = node;
+			mItemIndex = itemIndex - 1;
+		}
+
 		void pvMoveIf() noexcept
 		{
 			if (mItemIndex == mNode->GetCount())
-				pvMove();
+				pvMove(IsBPlus());
 		}
 
-		void pvMove() noexcept
+		void pvMove(std::true_type /*isBPlus*/) noexcept
+		{
+			MOMO_ASSERT(mNode->IsLeaf());
+			while (true)
+			{
+				Node* nextNode = mNode->GetNextLeaf();
+				if (nextNode == nullptr)
+					break;
+				mNode = nextNode;
+				mItemIndex = 0;
+#ifdef MOMO_PREFETCH
+				MOMO_PREFETCH(mNode->GetNextLeaf());
+#endif
+				if (mNode->GetCount() > 0)
+					return;
+			}
+			while (mNode->GetParent() != nullptr)
+				mNode = mNode->GetParent();
+			mItemIndex = mNode->GetCount();
+		}
+
+		void pvMove(std::false_type /*isBPlus*/) noexcept
 		{
 			MOMO_ASSERT(mNode->IsLeaf());
 			while (true)
@@ -232,7 +308,7 @@ namespace internal
 		size_t mItemIndex;
 	};
 
-	template<typename TTreeSetItemTraits>
+	template<typename TTreeSetItemTraits, typename TKey>
 	class TreeSetNodeItemTraits
 	{
 	protected:
@@ -241,10 +317,12 @@ namespace internal
 	public:
 		typedef typename TreeSetItemTraits::Item Item;
 		typedef typename TreeSetItemTraits::MemManager MemManager;
+		typedef TKey Key;
 
 		static const bool isNothrowShiftable = TreeSetItemTraits::isNothrowShiftable;
 
 		static const size_t alignment = TreeSetItemTraits::alignment;
+		static const size_t keyAlignment = ObjectManager<Key, MemManager>::alignment;
 
 	public:
 		static void Destroy(MemManager& memManager, Item& item) noexcept
@@ -320,7 +398,15 @@ private:
 
 	typedef internal::SetCrew<TreeTraits, MemManager, Settings::checkVersion> Crew;
 
-	typedef internal::TreeSetNodeItemTraits<ItemTraits> NodeItemTraits;
+	typedef internal::ObjectManager<Key, MemManager> KeyManager;
+
+	// B+ internal nodes store keys by pointer if they cannot be relocated without exceptions
+	typedef internal::BoolConstant<KeyManager::isNothrowRelocatable> IsInlineNodeKey;
+	typedef typename std::conditional<IsInlineNodeKey::value, Key, Key*>::type NodeKey;
+	typedef internal::ObjectManager<NodeKey, MemManager> NodeKeyManager;
+	typedef internal::ObjectBuffer<NodeKey, NodeKeyManager::alignment> NodeKeyBuffer;
+
+	typedef internal::TreeSetNodeItemTraits<ItemTraits, NodeKey> NodeItemTraits;
 
 	typedef typename TreeTraits::TreeNode TreeNode;
 	typedef typename TreeNode::template Node<NodeItemTraits> Node;
@@ -330,6 +416,8 @@ private:
 	static const size_t nodeMaxCapacity = TreeNode::maxCapacity;
 	MOMO_STATIC_ASSERT(nodeMaxCapacity > 0);
 
+	typedef internal::TreeNodeIsBPlus<Node> IsBPlus;
+
 public:
 	typedef internal::TreeSetConstIterator<Node, Settings> ConstIterator;
 	typedef ConstIterator Iterator;
@@ -456,6 +544,33 @@ private:
 			return splitRes;
 		}
 
+		SplitResult SplitLeafNode(Node* node, size_t itemIndex)
+		{
+			MOMO_ASSERT(node->IsLeaf());
+			mOldNodes.AddBack(node);
+			size_t itemCount = node->GetCount();
+			size_t middleIndex = (itemCount + 1) / 2;
+			if (middleIndex == itemIndex)
+				++middleIndex;	// first item of the second node is an old one
+			Node* newNode1 = CreateNode(true, middleIndex);
+			Node* newNode2 = CreateNode(true, itemCount + 1 - middleIndex);
+			if (itemIndex < middleIndex)
+			{
+				AddSegment(node, 0, newNode1, 0, itemIndex);
+				AddSegment(node, itemIndex, newNode1, itemIndex + 1, middleIndex - itemIndex - 1);
+				AddSegment(node, middleIndex - 1, newNode2, 0, itemCount + 1 - middleIndex);
+				return { newNode1, itemIndex, middleIndex - 1, newNode1, newNode2 };
+			}
+			else
+			{
+				AddSegment(node, 0, newNode1, 0, middleIndex);
+				AddSegment(node, middleIndex, newNode2, 0, itemIndex - middleIndex);
+				AddSegment(node, itemIndex, newNode2, itemIndex - middleIndex + 1,
+					itemCount - itemIndex);
+				return { newNode2, itemIndex - middleIndex, middleIndex, newNode1, newNode2 };
+			}
+		}
+
 		template<typename ItemCreator>
 		void RelocateCreate(ItemCreator&& itemCreator, Item* pitem)
 		{
@@ -920,9 +1035,9 @@ public:
 			}
 			Node* rootNode = nullptr;
 			if (pvIsOrdered(*this, dstTreeSet))
-				rootNode = pvMergeFast(*this, dstTreeSet);
+				rootNode = pvMergeFast(*this, dstTreeSet, IsBPlus());
 			else if (pvIsOrdered(dstTreeSet, *this))
-				rootNode = pvMergeFast(dstTreeSet, *this);
+				rootNode = pvMergeFast(dstTreeSet, *this, IsBPlus());
 			if (rootNode != nullptr)
 			{
 				dstTreeSet.mCount += mCount;
@@ -1005,8 +1120,8 @@ private:
 	ConstIterator pvGetLowerBound(const KeyArg& key) const
 	{
 		const TreeTraits& treeTraits = GetTreeTraits();
-		auto pred = [&treeTraits, &key] (const Item& item)
-			{ return !treeTraits.IsLess(ItemTraits::GetKey(item), key); };
+		auto pred = [&treeTraits, &key] (const Key& itemKey)
+			{ return !treeTraits.IsLess(itemKey, key); };
 		return pvFindFirst(pred);
 	}
 
@@ -1014,8 +1129,8 @@ private:
 	ConstIterator pvGetUpperBound(const KeyArg& key) const
 	{
 		const TreeTraits& treeTraits = GetTreeTraits();
-		auto pred = [&treeTraits, &key] (const Item& item)
-			{ return treeTraits.IsLess(key, ItemTraits::GetKey(item)); };
+		auto pred = [&treeTraits, &key] (const Key& itemKey)
+			{ return treeTraits.IsLess(key, itemKey); };
 		return pvFindFirst(pred);
 	}
 
@@ -1024,6 +1139,12 @@ private:
 	{
 		if (mRootNode == nullptr)
 			return ConstIterator();
+		return pvFindFirst(pred, IsBPlus());
+	}
+
+	template<typename Predicate>
+	ConstIterator pvFindFirst(const Predicate& pred, std::false_type /*isBPlus*/) const
+	{
 		ConstIterator iter = GetEnd();
 		Node* node = mRootNode;
 		while (true)
@@ -1038,6 +1159,36 @@ private:
 		return iter;
 	}
 
+	template<typename Predicate>
+	ConstIterator pvFindFirst(const Predicate& pred, std::true_type /*isBPlus*/) const
+	{
+		Node* node = mRootNode;
+		while (!node->IsLeaf())
+			node = node->GetChild(pvFindFirst(node, pred));
+		// keys in internal nodes only direct the search, so neighboring leaves are checked
+		size_t index = pvFindFirst(node, pred);
+		while (index == 0)
+		{
+			Node* prevNode = node->GetPrevLeaf();
+			if (prevNode == nullptr)
+				break;
+			size_t prevCount = prevNode->GetCount();
+			if (prevCount > 0 && !pred(ItemTraits::GetKey(*prevNode->GetItemPtr(prevCount - 1))))
+				break;
+			node = prevNode;
+			index = pvFindFirst(node, pred);
+		}
+		while (index == node->GetCount())
+		{
+			Node* nextNode = node->GetNextLeaf();
+			if (nextNode == nullptr)
+				break;
+			node = nextNode;
+			index = pvFindFirst(node, pred);
+		}
+		return pvMakeIterator(node, index, true);
+	}
+
 	template<typename Predicate>
 	size_t pvFindFirst(Node* node, const Predicate& pred) const
 	{
@@ -1047,7 +1198,7 @@ private:
 		{
 			for (; leftIndex < rightIndex; ++leftIndex)
 			{
-				if (pred(*node->GetItemPtr(leftIndex)))
+				if (pred(pvGetKey(node, leftIndex)))
 					break;
 			}
 		}
@@ -1056,7 +1207,7 @@ private:
 			while (leftIndex < rightIndex)
 			{
 				size_t middleIndex = (leftIndex + rightIndex) / 2;
-				if (pred(*node->GetItemPtr(middleIndex)))
+				if (pred(pvGetKey(node, middleIndex)))
 					rightIndex = middleIndex;
 				else
 					leftIndex = middleIndex + 1;
@@ -1065,6 +1216,73 @@ private:
 		return leftIndex;
 	}
 
+	static const Key& pvGetKey(Node* node, size_t index) noexcept
+	{
+		return pvGetKey(node, index, IsBPlus());
+	}
+
+	static const Key& pvGetKey(Node* node, size_t index, std::false_type /*isBPlus*/) noexcept
+	{
+		return ItemTraits::GetKey(*node->GetItemPtr(index));
+	}
+
+	static const Key& pvGetKey(Node* node, size_t index, std::true_type /*isBPlus*/) noexcept
+	{
+		if (node->IsLeaf())
+			return ItemTraits::GetKey(*node->GetItemPtr(index));
+		return pvGetNodeKey(*node->GetKeyPtr(index), IsInlineNodeKey());
+	}
+
+	static const Key& pvGetNodeKey(const Key& nodeKey, std::true_type /*isInline*/) noexcept
+	{
+		return nodeKey;
+	}
+
+	static const Key& pvGetNodeKey(Key* nodeKey, std::false_type /*isInline*/) noexcept
+	{
+		return *nodeKey;
+	}
+
+	void pvCreateNodeKey(const Key& key, NodeKey* nodeKey, std::true_type /*isInline*/)
+	{
+		MOMO_STATIC_ASSERT(std::is_copy_constructible<Key>::value);
+		KeyManager::Copy(GetMemManager(), key, nodeKey);
+	}
+
+	void pvCreateNodeKey(const Key& key, NodeKey* nodeKey, std::false_type /*isInline*/)
+	{
+		MOMO_STATIC_ASSERT(std::is_copy_constructible<Key>::value);
+		MemManager& memManager = GetMemManager();
+		Key* pkey = MemManagerProxy::template Allocate<Key>(memManager, sizeof(Key));
+		try
+		{
+			KeyManager::Copy(memManager, key, pkey);
+		}
+		catch (...)
+		{
+			MemManagerProxy::Deallocate(memManager, pkey, sizeof(Key));
+			throw;
+		}
+		*nodeKey = pkey;
+	}
+
+	void pvDestroyNodeKey(NodeKey& nodeKey) noexcept
+	{
+		pvDestroyNodeKey(nodeKey, IsInlineNodeKey());
+	}
+
+	void pvDestroyNodeKey(Key& nodeKey, std::true_type /*isInline*/) noexcept
+	{
+		KeyManager::Destroy(GetMemManager(), nodeKey);
+	}
+
+	void pvDestroyNodeKey(Key* nodeKey, std::false_type /*isInline*/) noexcept
+	{
+		MemManager& memManager = GetMemManager();
+		KeyManager::Destroy(memManager, *nodeKey);
+		MemManagerProxy::Deallocate(memManager, nodeKey, sizeof(Key));
+	}
+
 	template<typename KeyArg>
 	ConstIterator pvFind(const KeyArg& key) const
 	{
@@ -1082,6 +1300,30 @@ private:
 	}
 
 	void pvDestroy(Node* node) noexcept
+	{
+		pvDestroy(node, IsBPlus());
+	}
+
+	void pvDestroy(Node* node, std::true_type /*isBPlus*/) noexcept
+	{
+		MemManager& memManager = GetMemManager();
+		size_t count = node->GetCount();
+		if (node->IsLeaf())
+		{
+			for (size_t i = 0; i < count; ++i)
+				ItemTraits::Destroy(&memManager, *node->GetItemPtr(i));
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+				pvDestroyNodeKey(*node->GetKeyPtr(i));
+			for (size_t i = 0; i <= count; ++i)
+				pvDestroy(node->GetChild(i));
+		}
+		node->Destroy(*mNodeParams);
+	}
+
+	void pvDestroy(Node* node, std::false_type /*isBPlus*/) noexcept
 	{
 		size_t count = node->GetCount();
 		for (size_t i = 0; i < count; ++i)
@@ -1133,9 +1375,14 @@ private:
 		{
 			Relocator relocator(*mNodeParams);
 			if (itemCount < nodeMaxCapacity)
+			{
 				pvAddGrow(relocator, node, itemIndex, std::forward<ItemCreator>(itemCreator));
+			}
 			else
-				pvAddSplit(relocator, node, itemIndex, std::forward<ItemCreator>(itemCreator));
+			{
+				pvAddSplit(relocator, node, itemIndex, std::forward<ItemCreator>(itemCreator),
+					IsBPlus());
+			}
 		}
 		++mCount;
 		mCrew.IncVersion();
@@ -1190,12 +1437,145 @@ private:
 		else
 			parentNode->SetChild(parentNode->GetChildIndex(node), newNode);
 		newNode->SetParent(parentNode);
+		pvReplaceLeaf(node, newNode, IsBPlus());
 		node = newNode;
 	}
 
+	static void pvReplaceLeaf(Node* /*node*/, Node* /*newNode*/,
+		std::false_type /*isBPlus*/) noexcept
+	{
+	}
+
+	static void pvReplaceLeaf(Node* node, Node* newNode, std::true_type /*isBPlus*/) noexcept
+	{
+		pvLinkLeaves(node->GetPrevLeaf(), newNode);
+		pvLinkLeaves(newNode, node->GetNextLeaf());
+	}
+
+	static void pvLinkLeaves(Node* leafNode1, Node* leafNode2) noexcept
+	{
+		if (leafNode1 != nullptr)
+			leafNode1->SetNextLeaf(leafNode2);
+		if (leafNode2 != nullptr)
+			leafNode2->SetPrevLeaf(leafNode1);
+	}
+
+	template<typename ItemCreator>
+	void pvAddSplit(Relocator& relocator, Node*& leafNode, size_t& leafItemIndex,
+		ItemCreator&& itemCreator, std::true_type /*isBPlus*/)
+	{
+		Node* node = leafNode;
+		Node* freeNodes = nullptr;	// internal nodes for splitting, linked by parent pointers
+		Node* parentNode = node->GetParent();
+		while (parentNode == nullptr || parentNode->GetCount() == nodeMaxCapacity)
+		{
+			Node* newNode = relocator.CreateNode(false, 0);
+			newNode->SetParent(freeNodes);
+			freeNodes = newNode;
+			if (parentNode == nullptr)
+				break;
+			parentNode = parentNode->GetParent();
+		}
+		typename Relocator::SplitResult splitRes = relocator.SplitLeafNode(node, leafItemIndex);
+		NodeKeyBuffer keyBuffer;
+		pvCreateNodeKey(ItemTraits::GetKey(*node->GetItemPtr(splitRes.middleIndex)),
+			&keyBuffer, IsInlineNodeKey());
+		try
+		{
+			relocator.RelocateCreate(std::forward<ItemCreator>(itemCreator),
+				splitRes.newNode->GetItemPtr(splitRes.newItemIndex));
+		}
+		catch (...)
+		{
+			pvDestroyNodeKey(*&keyBuffer);
+			throw;
+		}
+		pvLinkLeaves(node->GetPrevLeaf(), splitRes.newNode1);
+		pvLinkLeaves(splitRes.newNode1, splitRes.newNode2);
+		pvLinkLeaves(splitRes.newNode2, node->GetNextLeaf());
+		leafNode = splitRes.newNode;
+		leafItemIndex = splitRes.newItemIndex;
+		pvInsertChild(node, splitRes.newNode1, splitRes.newNode2, *&keyBuffer, freeNodes);
+	}
+
+	void pvInsertChild(Node* oldNode, Node* newNode1, Node* newNode2, NodeKey& key,
+		Node* freeNodes) noexcept
+	{
+		MemManager& memManager = GetMemManager();
+		while (true)
+		{
+			Node* node = oldNode->GetParent();
+			if (node == nullptr)
+			{
+				node = freeNodes;
+				MOMO_ASSERT(node != nullptr && node->GetParent() == nullptr);
+				NodeKeyManager::Relocate(memManager, key, node->GetKeyPtr(0));
+				node->SetCount(1);
+				pvSetChildren(node, 0, newNode1, newNode2);
+				mRootNode = node;
+				break;
+			}
+			size_t index = node->GetChildIndex(oldNode);
+			if (node->GetCount() < nodeMaxCapacity)
+			{
+				pvInsertKey(node, index, key, newNode1, newNode2);
+				break;
+			}
+			Node* newNode = freeNodes;
+			MOMO_ASSERT(newNode != nullptr);
+			freeNodes = newNode->GetParent();
+			size_t middleIndex = nodeMaxCapacity / 2;
+			size_t newCount = nodeMaxCapacity - middleIndex - 1;
+			NodeKeyBuffer middleKeyBuffer;
+			NodeKeyManager::Relocate(memManager, *node->GetKeyPtr(middleIndex), &middleKeyBuffer);
+			NodeKeyManager::Relocate(memManager, node->GetKeyPtr(middleIndex + 1),
+				newNode->GetKeyPtr(0), newCount);
+			newNode->SetCount(newCount);
+			for (size_t i = 0; i <= newCount; ++i)
+			{
+				Node* childNode = node->GetChild(middleIndex + 1 + i);
+				newNode->SetChild(i, childNode);
+				childNode->SetParent(newNode);
+			}
+			node->SetCount(middleIndex);
+			if (index <= middleIndex)
+				pvInsertKey(node, index, key, newNode1, newNode2);
+			else
+				pvInsertKey(newNode, index - middleIndex - 1, key, newNode1, newNode2);
+			NodeKeyManager::Relocate(memManager, *&middleKeyBuffer, &key);
+			oldNode = node;
+			newNode1 = node;
+			newNode2 = newNode;
+		}
+	}
+
+	void pvInsertKey(Node* node, size_t index, NodeKey& key, Node* newNode1,
+		Node* newNode2) noexcept
+	{
+		MemManager& memManager = GetMemManager();
+		size_t count = node->GetCount();
+		MOMO_ASSERT(count < nodeMaxCapacity);
+		NodeKeyManager::Relocate(memManager, key, node->GetKeyPtr(count));
+		NodeKeyManager::ShiftNothrow(memManager,
+			std::reverse_iterator<NodeKey*>(node->GetKeyPtr(count + 1)), count - index);
+		node->SetCount(count + 1);
+		for (size_t i = count; i > index; --i)
+			node->SetChild(i + 1, node->GetChild(i));
+		pvSetChildren(node, index, newNode1, newNode2);
+	}
+
+	static void pvSetChildren(Node* node, size_t index, Node* childNode1,
+		Node* childNode2) noexcept
+	{
+		node->SetChild(index, childNode1);
+		node->SetChild(index + 1, childNode2);
+		childNode1->SetParent(node);
+		childNode2->SetParent(node);
+	}
+
 	template<typename ItemCreator>
 	void pvAddSplit(Relocator& relocator, Node*& leafNode, size_t& leafItemIndex,
-		ItemCreator&& itemCreator)
+		ItemCreator&& itemCreator, std::false_type /*isBPlus*/)
 	{
 		Node* node = leafNode;
 		size_t itemIndex = leafItemIndex;
@@ -1259,6 +1639,16 @@ private:
 		MOMO_CHECK(iter != GetEnd());
 		Node* node = ConstIteratorProxy::GetNode(iter);
 		size_t itemIndex = ConstIteratorProxy::GetItemIndex(iter);
+		pvRemove(node, itemIndex, itemReplacer1, itemReplacer2, IsBPlus());
+		--mCount;
+		mCrew.IncVersion();
+		return pvMakeIterator(node, itemIndex, true);
+	}
+
+	template<typename ItemReplacer1, typename ItemReplacer2>
+	void pvRemove(Node*& node, size_t& itemIndex, ItemReplacer1 itemReplacer1,
+		ItemReplacer2 itemReplacer2, std::false_type /*isBPlus*/)
+	{
 		if (node->IsLeaf())
 		{
 			node->Remove(*mNodeParams, itemIndex, itemReplacer1);
@@ -1269,9 +1659,134 @@ private:
 			node = pvRemoveInternal(node, itemIndex, itemReplacer1, itemReplacer2);
 			itemIndex = 0;
 		}
-		--mCount;
-		mCrew.IncVersion();
-		return pvMakeIterator(node, itemIndex, true);
+	}
+
+	template<typename ItemReplacer1, typename ItemReplacer2>
+	void pvRemove(Node*& node, size_t& itemIndex, ItemReplacer1 itemReplacer1,
+		ItemReplacer2 /*itemReplacer2*/, std::true_type /*isBPlus*/)
+	{
+		MOMO_ASSERT(node->IsLeaf());
+		node->Remove(*mNodeParams, itemIndex, itemReplacer1);
+		try
+		{
+			Node* parentNode = node->GetParent();
+			if (parentNode == nullptr)
+				return;
+			size_t index = parentNode->GetChildIndex(node);
+			if (index > 0)
+			{
+				Node* prevNode = parentNode->GetChild(index - 1);
+				size_t prevCount = prevNode->GetCount();
+				if (pvMergeLeaves(parentNode, index - 1))
+				{
+					node = prevNode;
+					itemIndex += prevCount;
+					pvRebalanceParents(parentNode);
+					return;
+				}
+			}
+			if (index < parentNode->GetCount() && pvMergeLeaves(parentNode, index))
+				pvRebalanceParents(parentNode);
+		}
+		catch (...)
+		{
+			// no throw!
+		}
+	}
+
+	bool pvMergeLeaves(Node* parentNode, size_t index)
+	{
+		Node* node1 = parentNode->GetChild(index);
+		Node* node2 = parentNode->GetChild(index + 1);
+		size_t itemCount1 = node1->GetCount();
+		size_t itemCount2 = node2->GetCount();
+		if (itemCount1 + itemCount2 > node1->GetCapacity())
+			return false;
+		if (itemCount2 > 0)
+		{
+			Relocator relocator(*mNodeParams);
+			relocator.AddSegment(node2, 0, node1, itemCount1, itemCount2 - 1);
+			MemManager& memManager = GetMemManager();
+			Item& lastItem = *node2->GetItemPtr(itemCount2 - 1);
+			auto itemCreator = [&memManager, &lastItem] (Item* newItem)
+				{ ItemTraits::Relocate(&memManager, lastItem, newItem); };
+			relocator.RelocateCreate(itemCreator,
+				node1->GetItemPtr(itemCount1 + itemCount2 - 1));
+			for (size_t i = 0; i < itemCount2; ++i)
+				node1->AcceptBackItem(*mNodeParams, itemCount1 + i);
+		}
+		pvLinkLeaves(node1, node2->GetNextLeaf());
+		pvRemoveChild(parentNode, index);
+		node2->Destroy(*mNodeParams);
+		return true;
+	}
+
+	void pvRebalanceParents(Node* node) noexcept
+	{
+		while (true)
+		{
+			Node* parentNode = node->GetParent();
+			if (parentNode == nullptr)
+			{
+				MOMO_ASSERT(mRootNode == node);
+				if (node->GetCount() == 0)
+				{
+					mRootNode = node->GetChild(0);
+					mRootNode->SetParent(nullptr);
+					node->Destroy(*mNodeParams);
+				}
+				break;
+			}
+			size_t index = parentNode->GetChildIndex(node);
+			bool brk = !(index > 0 && pvMergeInternals(parentNode, index - 1))
+				&& !(index < parentNode->GetCount() && pvMergeInternals(parentNode, index));
+			if (brk)
+				break;
+			node = parentNode;
+		}
+	}
+
+	bool pvMergeInternals(Node* parentNode, size_t index) noexcept
+	{
+		Node* node1 = parentNode->GetChild(index);
+		Node* node2 = parentNode->GetChild(index + 1);
+		size_t count1 = node1->GetCount();
+		size_t count2 = node2->GetCount();
+		if (count1 + count2 + 1 > nodeMaxCapacity)
+			return false;
+		MemManager& memManager = GetMemManager();
+		NodeKeyManager::Relocate(memManager, *parentNode->GetKeyPtr(index),
+			node1->GetKeyPtr(count1));
+		NodeKeyManager::Relocate(memManager, node2->GetKeyPtr(0), node1->GetKeyPtr(count1 + 1),
+			count2);
+		node1->SetCount(count1 + count2 + 1);
+		for (size_t i = 0; i <= count2; ++i)
+		{
+			Node* childNode = node2->GetChild(i);
+			node1->SetChild(count1 + 1 + i, childNode);
+			childNode->SetParent(node1);
+		}
+		size_t parentCount = parentNode->GetCount();
+		for (size_t i = index + 1; i < parentCount; ++i)
+		{
+			NodeKeyManager::Relocate(memManager, *parentNode->GetKeyPtr(i),
+				parentNode->GetKeyPtr(i - 1));
+			parentNode->SetChild(i, parentNode->GetChild(i + 1));
+		}
+		parentNode->SetCount(parentCount - 1);
+		node2->Destroy(*mNodeParams);
+		return true;
+	}
+
+	void pvRemoveChild(Node* node, size_t index) noexcept
+	{
+		MemManager& memManager = GetMemManager();
+		size_t count = node->GetCount();
+		NodeKeyManager::ShiftNothrow(memManager, node->GetKeyPtr(index), count - index - 1);
+		pvDestroyNodeKey(*node->GetKeyPtr(count - 1));
+		for (size_t i = index + 1; i < count; ++i)
+			node->SetChild(i, node->GetChild(i + 1));
+		node->SetCount(count - 1);
 	}
 
 	ConstIterator pvExtract(ConstIterator iter, Item* extItem)
@@ -1437,7 +1952,13 @@ private:
 		}
 	}
 
-	static Node* pvMergeFast(TreeSet& treeSet1, TreeSet& treeSet2)
+	static Node* pvMergeFast(TreeSet& /*treeSet1*/, TreeSet& /*treeSet2*/,
+		std::true_type /*isBPlus*/) noexcept
+	{
+		return nullptr;
+	}
+
+	static Node* pvMergeFast(TreeSet& treeSet1, TreeSet& treeSet2, std::false_type /*isBPlus*/)
 	{
 		size_t height1 = treeSet1.pvGetHeight();
 		size_t height2 = treeSet2.pvGetHeight();
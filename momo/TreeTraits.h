@@ -17,6 +17,7 @@
 #pragma once
 
 #include "details/TreeNode.h"
+#include "details/TreeNodeBPlus.h"
 
 namespace momo
 {
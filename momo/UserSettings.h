@@ -95,6 +95,10 @@
 #define MOMO_DEFAULT_MEM_MANAGER MemManagerCpp
 #endif
 
+// Using of `MemManagerMmap` (Linux only), which includes POSIX headers `<sys/mman.h>`
+// and `<unistd.h>`
+//#define MOMO_USE_MEM_MANAGER_MMAP
+
 // Using of SSE2
 #if defined(_MSC_VER) && !defined(__clang__)
 #if defined(_M_AMD64) || defined(_M_X64)
@@ -110,6 +114,9 @@
 
 #if defined(__GNUC__) || defined(__clang__)
 #define MOMO_CTZ32(value) __builtin_ctz(value)
+#define MOMO_CTZ64(value) __builtin_ctzll(value)
+#define MOMO_POPCOUNT64(value) __builtin_popcountll(value)
+#define MOMO_PREFETCH(addr) __builtin_prefetch(addr)
 #endif
 
 // `nullptr`, converted to the type `uintptr_t`
@@ -129,6 +136,13 @@
 #define MOMO_HAS_DEDUCTION_GUIDES
 #endif
 
+#ifdef __has_include
+#if __has_include(<memory_resource>) \
+	&& (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#define MOMO_HAS_PMR
+#endif
+#endif
+
 #ifdef __cpp_guaranteed_copy_elision
 #define MOMO_HAS_GUARANTEED_COPY_ELISION
 #if defined(_MSC_VER) && !defined(__clang__)	// vs2017
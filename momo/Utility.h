@@ -34,6 +34,15 @@
 #include <Windows.h>
 #endif
 
+#ifdef MOMO_USE_MEM_MANAGER_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef MOMO_HAS_PMR
+#include <memory_resource>
+#endif
+
 #ifdef MOMO_USE_SSE2
 #include <emmintrin.h>
 #include <xmmintrin.h>
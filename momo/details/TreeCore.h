@@ -0,0 +1,512 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/details/TreeCore.h
+
+  Nodes and algorithms of B+ trees `ConcurrentTreeMap`,
+  `PersistentTreeMap` and `AggregateTreeMap`. All items are stored
+  in leaves, internal nodes store copies of separator keys.
+  Each map keeps its own data in the node header (a latch or
+  a reference counter) and in the per-child data of internal nodes.
+
+\**********************************************************/
+
+#pragma once
+
+#include "../ObjectManager.h"
+
+#include <atomic>
+
+namespace momo
+{
+
+namespace internal
+{
+	class TreeCoreEmptyHeader
+	{
+	};
+
+	template<typename TKey, size_t tCapacity, typename THeader>
+	class TreeCoreNode
+	{
+	public:
+		typedef TKey Key;
+		typedef THeader Header;
+
+		static const size_t capacity = tCapacity;
+		MOMO_STATIC_ASSERT(capacity >= 3);
+
+	private:
+		typedef ObjectBuffer<Key, AlignmentOf<Key>::value> KeyBuffer;
+
+	public:
+		explicit TreeCoreNode(bool isLeaf) noexcept
+			: mCount(0),
+			mIsLeaf(isLeaf)
+		{
+		}
+
+		TreeCoreNode(const TreeCoreNode&) = delete;
+
+		~TreeCoreNode() noexcept
+		{
+		}
+
+		TreeCoreNode& operator=(const TreeCoreNode&) = delete;
+
+		Header& GetHeader() const noexcept
+		{
+			return mHeader;
+		}
+
+		bool IsLeaf() const noexcept
+		{
+			return mIsLeaf;
+		}
+
+		size_t GetCount() const noexcept
+		{
+			return mCount.load(std::memory_order_relaxed);
+		}
+
+		void SetCount(size_t count) noexcept
+		{
+			MOMO_ASSERT(count <= capacity);
+			mCount.store(count, std::memory_order_relaxed);
+		}
+
+		const Key* GetKeyPtr(size_t index) const noexcept
+		{
+			return &mKeys[index];
+		}
+
+		Key* GetKeyPtr(size_t index) noexcept
+		{
+			return &mKeys[index];
+		}
+
+	private:
+		mutable Header mHeader;
+		std::atomic<size_t> mCount;	// atomic for optimistic readers of `ConcurrentTreeMap`
+		bool mIsLeaf;
+		KeyBuffer mKeys[capacity];
+	};
+
+	template<typename TNode, typename TValue>
+	class TreeCoreLeafNode : public TNode
+	{
+	public:
+		typedef TNode Node;
+		typedef TValue Value;
+
+	private:
+		typedef ObjectBuffer<Value, AlignmentOf<Value>::value> ValueBuffer;
+
+	public:
+		explicit TreeCoreLeafNode() noexcept
+			: Node(true)
+		{
+		}
+
+		const Value* GetValuePtr(size_t index) const noexcept
+		{
+			return &mValues[index];
+		}
+
+		Value* GetValuePtr(size_t index) noexcept
+		{
+			return &mValues[index];
+		}
+
+	private:
+		ValueBuffer mValues[Node::capacity];
+	};
+
+	template<typename TChildData, size_t tCount>
+	class TreeCoreChildDataArray
+	{
+	public:
+		typedef TChildData ChildData;
+
+	public:
+		const ChildData& GetChildData(size_t index) const noexcept
+		{
+			return mChildData[index];
+		}
+
+		void SetChildData(size_t index, const ChildData& childData) noexcept
+		{
+			mChildData[index] = childData;
+		}
+
+	private:
+		ChildData mChildData[tCount];
+	};
+
+	template<size_t tCount>
+	class TreeCoreChildDataArray<void, tCount>
+	{
+	public:
+		typedef void ChildData;
+	};
+
+	template<typename TNode, typename TChildData = void>
+	class TreeCoreInternalNode : public TNode,
+		public TreeCoreChildDataArray<TChildData, TNode::capacity + 1>
+	{
+	public:
+		typedef TNode Node;
+		typedef TChildData ChildData;
+
+	public:
+		explicit TreeCoreInternalNode()
+			: Node(false)
+		{
+		}
+
+		Node* GetChild(size_t index) const noexcept
+		{
+			MOMO_ASSERT(index <= Node::capacity);
+			return mChildren[index].load(std::memory_order_relaxed);
+		}
+
+		void SetChild(size_t index, Node* child) noexcept
+		{
+			mChildren[index].store(child, std::memory_order_relaxed);
+		}
+
+		// moves the child with its data
+		void MoveChild(size_t srcIndex, TreeCoreInternalNode& dstNode, size_t dstIndex) noexcept
+		{
+			dstNode.SetChild(dstIndex, GetChild(srcIndex));
+			pvMoveChildData(srcIndex, dstNode, dstIndex, std::is_void<ChildData>());
+		}
+
+	private:
+		void pvMoveChildData(size_t /*srcIndex*/, TreeCoreInternalNode& /*dstNode*/,
+			size_t /*dstIndex*/, std::true_type /*isVoid*/) noexcept
+		{
+		}
+
+		void pvMoveChildData(size_t srcIndex, TreeCoreInternalNode& dstNode, size_t dstIndex,
+			std::false_type /*isVoid*/) noexcept
+		{
+			dstNode.SetChildData(dstIndex, this->GetChildData(srcIndex));
+		}
+
+	private:
+		std::atomic<Node*> mChildren[Node::capacity + 1];
+	};
+
+	template<typename TLeafNode, typename TInternalNode, typename TTreeTraits,
+		typename TMemManager>
+	class TreeCore
+	{
+	public:
+		typedef TLeafNode LeafNode;
+		typedef TInternalNode InternalNode;
+		typedef TTreeTraits TreeTraits;
+		typedef TMemManager MemManager;
+
+		typedef typename LeafNode::Node Node;
+		typedef typename Node::Key Key;
+		typedef typename LeafNode::Value Value;
+
+		static const size_t capacity = Node::capacity;
+
+		// a node with fewer items is merged with its sibling, if they fit into one node
+		static const size_t minCount = capacity / 2;
+
+	private:
+		typedef ObjectManager<Key, MemManager> KeyManager;
+		typedef ObjectManager<Value, MemManager> ValueManager;
+
+		MOMO_STATIC_ASSERT(KeyManager::isNothrowRelocatable && ValueManager::isNothrowRelocatable);
+
+	public:
+		// index of the first key which is not less than `key`
+		static size_t GetLowerBound(const TreeTraits& treeTraits, const Node* node, const Key& key)
+		{
+			auto pred = [&treeTraits, &key] (const Key& nodeKey)
+				{ return !treeTraits.IsLess(nodeKey, key); };
+			return pvFindFirst(node, pred);
+		}
+
+		// index of the first key which is greater than `key`
+		static size_t GetUpperBound(const TreeTraits& treeTraits, const Node* node, const Key& key)
+		{
+			auto pred = [&treeTraits, &key] (const Key& nodeKey)
+				{ return treeTraits.IsLess(key, nodeKey); };
+			return pvFindFirst(node, pred);
+		}
+
+		static bool FindItem(const TreeTraits& treeTraits, const LeafNode* leafNode,
+			const Key& key, size_t& index)
+		{
+			index = GetLowerBound(treeTraits, leafNode, key);
+			return index < leafNode->GetCount()
+				&& !treeTraits.IsLess(key, *leafNode->GetKeyPtr(index));
+		}
+
+		static const Value* Find(const TreeTraits& treeTraits, const Node* rootNode,
+			const Key& key)
+		{
+			if (rootNode == nullptr)
+				return nullptr;
+			const Node* node = rootNode;
+			while (!node->IsLeaf())
+			{
+				const InternalNode* internalNode = static_cast<const InternalNode*>(node);
+				node = internalNode->GetChild(GetUpperBound(treeTraits, node, key));
+			}
+			const LeafNode* leafNode = static_cast<const LeafNode*>(node);
+			size_t index;
+			if (!FindItem(treeTraits, leafNode, key, index))
+				return nullptr;
+			return leafNode->GetValuePtr(index);
+		}
+
+		// pairVisitor(const Key&, const Value&) returns `false` to stop the scan
+		template<typename PairVisitor>
+		static bool Scan(const TreeTraits& treeTraits, const Node* node, const Key* lowKey,
+			const PairVisitor& pairVisitor)
+		{
+			size_t count = node->GetCount();
+			if (node->IsLeaf())
+			{
+				const LeafNode* leafNode = static_cast<const LeafNode*>(node);
+				size_t index = (lowKey != nullptr) ? GetLowerBound(treeTraits, node, *lowKey) : 0;
+				for (; index < count; ++index)
+				{
+					if (!pairVisitor(*leafNode->GetKeyPtr(index), *leafNode->GetValuePtr(index)))
+						return false;
+				}
+				return true;
+			}
+			const InternalNode* internalNode = static_cast<const InternalNode*>(node);
+			size_t beginIndex = (lowKey != nullptr) ? GetUpperBound(treeTraits, node, *lowKey) : 0;
+			for (size_t i = beginIndex; i <= count; ++i)
+			{
+				if (!Scan(treeTraits, internalNode->GetChild(i), (i == beginIndex) ? lowKey : nullptr,
+					pairVisitor))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// copies keys and values, but not children
+		static void CopyItems(MemManager& memManager, const Node* srcNode, Node* dstNode)
+		{
+			MOMO_ASSERT(srcNode->IsLeaf() == dstNode->IsLeaf() && dstNode->GetCount() == 0);
+			size_t count = srcNode->GetCount();
+			size_t keyIndex = 0;
+			size_t valueIndex = 0;
+			try
+			{
+				for (; keyIndex < count; ++keyIndex)
+				{
+					KeyManager::Copy(memManager, *srcNode->GetKeyPtr(keyIndex),
+						dstNode->GetKeyPtr(keyIndex));
+				}
+				if (srcNode->IsLeaf())
+				{
+					const LeafNode* srcLeafNode = static_cast<const LeafNode*>(srcNode);
+					LeafNode* dstLeafNode = static_cast<LeafNode*>(dstNode);
+					for (; valueIndex < count; ++valueIndex)
+					{
+						ValueManager::Copy(memManager, *srcLeafNode->GetValuePtr(valueIndex),
+							dstLeafNode->GetValuePtr(valueIndex));
+					}
+				}
+			}
+			catch (...)
+			{
+				KeyManager::Destroy(memManager, dstNode->GetKeyPtr(0), keyIndex);
+				if (dstNode->IsLeaf())
+				{
+					ValueManager::Destroy(memManager,
+						static_cast<LeafNode*>(dstNode)->GetValuePtr(0), valueIndex);
+				}
+				throw;
+			}
+			dstNode->SetCount(count);
+		}
+
+		// destroys keys and values, but not children
+		static void DestroyItems(MemManager& memManager, Node* node) noexcept
+		{
+			size_t count = node->GetCount();
+			KeyManager::Destroy(memManager, node->GetKeyPtr(0), count);
+			if (node->IsLeaf())
+				ValueManager::Destroy(memManager, static_cast<LeafNode*>(node)->GetValuePtr(0), count);
+		}
+
+		static void InsertItem(MemManager& memManager, LeafNode* leafNode, size_t index,
+			const Key& key, const Value& value)
+		{
+			size_t count = leafNode->GetCount();
+			MOMO_ASSERT(index <= count && count < capacity);
+			KeyManager::Copy(memManager, key, leafNode->GetKeyPtr(count));
+			try
+			{
+				ValueManager::Copy(memManager, value, leafNode->GetValuePtr(count));
+			}
+			catch (...)
+			{
+				KeyManager::Destroy(memManager, *leafNode->GetKeyPtr(count));
+				throw;
+			}
+			KeyManager::ShiftNothrow(memManager,
+				std::reverse_iterator<Key*>(leafNode->GetKeyPtr(count) + 1), count - index);
+			ValueManager::ShiftNothrow(memManager,
+				std::reverse_iterator<Value*>(leafNode->GetValuePtr(count) + 1), count - index);
+			leafNode->SetCount(count + 1);
+		}
+
+		static void RemoveItem(MemManager& memManager, LeafNode* leafNode, size_t index) noexcept
+		{
+			size_t count = leafNode->GetCount();
+			MOMO_ASSERT(index < count);
+			KeyManager::Destroy(memManager, *leafNode->GetKeyPtr(index));
+			ValueManager::Destroy(memManager, *leafNode->GetValuePtr(index));
+			for (size_t i = index + 1; i < count; ++i)
+			{
+				KeyManager::Relocate(memManager, *leafNode->GetKeyPtr(i), leafNode->GetKeyPtr(i - 1));
+				ValueManager::Relocate(memManager, *leafNode->GetValuePtr(i),
+					leafNode->GetValuePtr(i - 1));
+			}
+			leafNode->SetCount(count - 1);
+		}
+
+		// Splits the full child `index` of `node` into this child and `newNode`.
+		// `newNode` must be an empty node of the same kind as the child.
+		// Only copying of the separator key of leaves may throw, then nothing is changed.
+		// Per-child data of the children `index` and `index + 1` must be updated by the caller.
+		static void SplitChild(MemManager& memManager, InternalNode* node, size_t index,
+			Node* newNode)
+		{
+			size_t count = node->GetCount();
+			MOMO_ASSERT(index <= count && count < capacity);
+			Node* childNode = node->GetChild(index);
+			MOMO_ASSERT(childNode->GetCount() == capacity);
+			MOMO_ASSERT(newNode->IsLeaf() == childNode->IsLeaf() && newNode->GetCount() == 0);
+			size_t middleIndex = capacity / 2;
+			if (childNode->IsLeaf())
+			{
+				KeyManager::Copy(memManager, *childNode->GetKeyPtr(middleIndex),
+					node->GetKeyPtr(count));
+				size_t newCount = capacity - middleIndex;
+				KeyManager::Relocate(memManager, childNode->GetKeyPtr(middleIndex),
+					newNode->GetKeyPtr(0), newCount);
+				ValueManager::Relocate(memManager,
+					static_cast<LeafNode*>(childNode)->GetValuePtr(middleIndex),
+					static_cast<LeafNode*>(newNode)->GetValuePtr(0), newCount);
+				newNode->SetCount(newCount);
+			}
+			else
+			{
+				InternalNode* internalChildNode = static_cast<InternalNode*>(childNode);
+				InternalNode* internalNewNode = static_cast<InternalNode*>(newNode);
+				size_t newCount = capacity - middleIndex - 1;
+				KeyManager::Relocate(memManager, *childNode->GetKeyPtr(middleIndex),
+					node->GetKeyPtr(count));
+				KeyManager::Relocate(memManager, childNode->GetKeyPtr(middleIndex + 1),
+					newNode->GetKeyPtr(0), newCount);
+				for (size_t i = 0; i <= newCount; ++i)
+					internalChildNode->MoveChild(middleIndex + 1 + i, *internalNewNode, i);
+				newNode->SetCount(newCount);
+			}
+			childNode->SetCount(middleIndex);
+			KeyManager::ShiftNothrow(memManager,
+				std::reverse_iterator<Key*>(node->GetKeyPtr(count) + 1), count - index);
+			for (size_t i = count; i > index; --i)
+				node->MoveChild(i, *node, i + 1);
+			node->SetChild(index + 1, newNode);
+			node->SetCount(count + 1);
+		}
+
+		// Moves all items of the child `index + 1` of `node` to the child `index`
+		// and removes the emptied child from `node`. Returns the emptied child,
+		// which must be released by the caller, or `nullptr`, if the children
+		// do not fit into one node.
+		// Per-child data of the child `index` must be updated by the caller.
+		static Node* MergeChildren(MemManager& memManager, InternalNode* node,
+			size_t index) noexcept
+		{
+			size_t count = node->GetCount();
+			MOMO_ASSERT(index < count);
+			Node* childNode1 = node->GetChild(index);
+			Node* childNode2 = node->GetChild(index + 1);
+			size_t count1 = childNode1->GetCount();
+			size_t count2 = childNode2->GetCount();
+			if (childNode1->IsLeaf())
+			{
+				if (count1 + count2 > capacity)
+					return nullptr;
+				KeyManager::Relocate(memManager, childNode2->GetKeyPtr(0),
+					childNode1->GetKeyPtr(count1), count2);
+				ValueManager::Relocate(memManager,
+					static_cast<LeafNode*>(childNode2)->GetValuePtr(0),
+					static_cast<LeafNode*>(childNode1)->GetValuePtr(count1), count2);
+				childNode1->SetCount(count1 + count2);
+				KeyManager::Destroy(memManager, *node->GetKeyPtr(index));
+			}
+			else
+			{
+				if (count1 + count2 + 1 > capacity)
+					return nullptr;
+				InternalNode* internalChildNode1 = static_cast<InternalNode*>(childNode1);
+				InternalNode* internalChildNode2 = static_cast<InternalNode*>(childNode2);
+				KeyManager::Relocate(memManager, *node->GetKeyPtr(index),
+					childNode1->GetKeyPtr(count1));
+				KeyManager::Relocate(memManager, childNode2->GetKeyPtr(0),
+					childNode1->GetKeyPtr(count1 + 1), count2);
+				for (size_t i = 0; i <= count2; ++i)
+					internalChildNode2->MoveChild(i, *internalChildNode1, count1 + 1 + i);
+				childNode1->SetCount(count1 + count2 + 1);
+			}
+			childNode2->SetCount(0);
+			for (size_t i = index + 1; i < count; ++i)
+				KeyManager::Relocate(memManager, *node->GetKeyPtr(i), node->GetKeyPtr(i - 1));
+			for (size_t i = index + 2; i <= count; ++i)
+				node->MoveChild(i, *node, i - 1);
+			node->SetCount(count - 1);
+			return childNode2;
+		}
+
+	private:
+		template<typename Predicate>
+		static size_t pvFindFirst(const Node* node, const Predicate& pred)
+		{
+			size_t leftIndex = 0;
+			size_t rightIndex = node->GetCount();
+			if (TreeTraits::useLinearSearch)
+			{
+				for (; leftIndex < rightIndex; ++leftIndex)
+				{
+					if (pred(*node->GetKeyPtr(leftIndex)))
+						break;
+				}
+			}
+			else
+			{
+				while (leftIndex < rightIndex)
+				{
+					size_t middleIndex = (leftIndex + rightIndex) / 2;
+					if (pred(*node->GetKeyPtr(middleIndex)))
+						rightIndex = middleIndex;
+					else
+						leftIndex = middleIndex + 1;
+				}
+			}
+			return leftIndex;
+		}
+	};
+}
+
+} // namespace momo
@@ -0,0 +1,401 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/details/TreeNodeBPlus.h
+
+  namespace momo:
+    class TreeNodeBPlus
+
+  B+ tree node. Internal nodes store only copies of keys, all items
+  are stored in leaves. Leaves are linked to each other, so iterator
+  increment is a pointer hop.
+  Keys of containers with this node must be copy constructible,
+  move-only keys are not supported.
+
+\**********************************************************/
+
+#pragma once
+
+#include "TreeNode.h"
+
+namespace momo
+{
+
+namespace internal
+{
+	template<typename TItemTraits, size_t tMaxCapacity, size_t tCapacityStep,
+		typename TMemPoolParams, bool tIsContinuous>
+	class NodeBPlus
+	{
+	protected:
+		typedef TItemTraits ItemTraits;
+		typedef TMemPoolParams MemPoolParams;
+
+		static const size_t maxCapacity = tMaxCapacity;
+		MOMO_STATIC_ASSERT(2 < maxCapacity && maxCapacity < 256);
+
+		static const size_t capacityStep = tCapacityStep;
+		MOMO_STATIC_ASSERT(capacityStep > 0);
+
+		static const bool isContinuous = tIsContinuous;
+		MOMO_STATIC_ASSERT(!isContinuous || ItemTraits::isNothrowShiftable);
+
+	public:
+		typedef typename ItemTraits::Item Item;
+		typedef typename ItemTraits::Key Key;
+		typedef typename ItemTraits::MemManager MemManager;
+
+		static const bool isBPlus = true;
+
+	private:
+		typedef BoolConstant<isContinuous> IsContinuous;
+
+		template<size_t capacity, bool hasIndexes>
+		struct Counter;
+
+		template<size_t capacity>
+		struct Counter<capacity, false>
+		{
+			uint8_t count;
+		};
+
+		template<size_t capacity>
+		struct Counter<capacity, true>
+		{
+			uint8_t count;
+			uint8_t indexes[capacity];
+		};
+
+		typedef ObjectBuffer<Item, ItemTraits::alignment> ItemBuffer;
+
+		typedef internal::MemManagerPtr<MemManager> MemManagerPtr;
+
+		typedef momo::MemPool<MemPoolParams, MemManagerPtr, NestedMemPoolSettings> MemPool;
+
+		static const size_t leafMemPoolCount = maxCapacity / (2 * capacityStep) + 1;
+
+		MOMO_STATIC_ASSERT(ItemTraits::keyAlignment <= MOMO_MAX_ALIGNMENT);
+
+		static const size_t keysSize =
+			UIntMath<>::Ceil(sizeof(Key) * maxCapacity, sizeof(void*));
+
+		static const size_t internalOffset = UIntMath<>::Ceil(
+			keysSize + sizeof(void*) * (maxCapacity + 1), MOMO_MAX_ALIGNMENT);
+
+	public:
+		class Params
+		{
+		private:
+			typedef NestedArrayIntCap<leafMemPoolCount, MemPool, MemManagerDummy> LeafMemPools;
+
+			static const size_t internalNodeSize =
+				sizeof(NodeBPlus) - sizeof(ItemBuffer) + internalOffset;
+
+		public:
+			explicit Params(MemManager& memManager)
+				: mInternalMemPool(MemPoolParams(internalNodeSize), MemManagerPtr(memManager))
+			{
+				for (size_t i = 0; i < leafMemPoolCount; ++i)
+				{
+					size_t capacity = maxCapacity - i * capacityStep;
+					size_t leafNodeSize = sizeof(NodeBPlus) + sizeof(Item) * (capacity - 1);
+					mLeafMemPools.AddBackNogrow(MemPool(MemPoolParams(leafNodeSize),
+						MemManagerPtr(memManager)));
+				}
+			}
+
+			Params(const Params&) = delete;
+
+			~Params() noexcept
+			{
+			}
+
+			Params& operator=(const Params&) = delete;
+
+			MemManager& GetMemManager() noexcept
+			{
+				return mInternalMemPool.GetMemManager().GetBaseMemManager();
+			}
+
+			MemPool& GetInternalMemPool() noexcept
+			{
+				return mInternalMemPool;
+			}
+
+			MemPool& GetLeafMemPool(size_t leafMemPoolIndex) noexcept
+			{
+				return mLeafMemPools[leafMemPoolIndex];
+			}
+
+			void MergeFrom(Params& params) noexcept
+			{
+				mInternalMemPool.MergeFrom(params.mInternalMemPool);
+				for (size_t i = 0; i < leafMemPoolCount; ++i)
+					mLeafMemPools[i].MergeFrom(params.mLeafMemPools[i]);
+			}
+
+		private:
+			MemPool mInternalMemPool;
+			LeafMemPools mLeafMemPools;
+		};
+
+	public:
+		NodeBPlus() = delete;
+
+		NodeBPlus(const NodeBPlus&) = delete;
+
+		~NodeBPlus() = delete;
+
+		NodeBPlus& operator=(const NodeBPlus&) = delete;
+
+		static NodeBPlus* Create(Params& params, bool isLeaf, size_t count)
+		{
+			MOMO_ASSERT(count <= maxCapacity);
+			NodeBPlus* node;
+			if (isLeaf)
+			{
+				size_t leafMemPoolIndex = (maxCapacity - count) / capacityStep;
+				if (leafMemPoolIndex >= leafMemPoolCount)
+					leafMemPoolIndex = leafMemPoolCount - 1;
+				node = params.GetLeafMemPool(leafMemPoolIndex).template Allocate<NodeBPlus>();
+				node->mMemPoolIndex = static_cast<uint8_t>(leafMemPoolIndex);
+			}
+			else
+			{
+				void* ptr = params.GetInternalMemPool().Allocate();
+				node = BitCaster::PtrToPtr<NodeBPlus>(ptr, internalOffset);
+				node->mMemPoolIndex = static_cast<uint8_t>(leafMemPoolCount);
+			}
+			node->mParent = nullptr;
+			node->mPrevLeaf = nullptr;
+			node->mNextLeaf = nullptr;
+			node->mCounter.count = static_cast<uint8_t>(count);
+			node->pvInitIndexes(IsContinuous());
+			return node;
+		}
+
+		void Destroy(Params& params) noexcept
+		{
+			if (IsLeaf())
+			{
+				params.GetLeafMemPool(size_t{mMemPoolIndex}).Deallocate(this);
+			}
+			else
+			{
+				params.GetInternalMemPool().Deallocate(
+					BitCaster::PtrToPtr<void>(this, -static_cast<ptrdiff_t>(internalOffset)));
+			}
+		}
+
+		bool IsLeaf() const noexcept
+		{
+			return size_t{mMemPoolIndex} < leafMemPoolCount;
+		}
+
+		size_t GetCapacity() const noexcept
+		{
+			size_t capacity = maxCapacity;
+			if (IsLeaf())
+				capacity -= capacityStep * size_t{mMemPoolIndex};
+			return capacity;
+		}
+
+		size_t GetCount() const noexcept
+		{
+			return size_t{mCounter.count};
+		}
+
+		void SetCount(size_t count) noexcept
+		{
+			MOMO_ASSERT(!IsLeaf() && count <= maxCapacity);
+			mCounter.count = static_cast<uint8_t>(count);
+		}
+
+		NodeBPlus* GetParent() noexcept
+		{
+			return mParent;
+		}
+
+		void SetParent(NodeBPlus* parent) noexcept
+		{
+			mParent = parent;
+		}
+
+		NodeBPlus* GetPrevLeaf() noexcept
+		{
+			MOMO_ASSERT(IsLeaf());
+			return mPrevLeaf;
+		}
+
+		void SetPrevLeaf(NodeBPlus* prevLeaf) noexcept
+		{
+			MOMO_ASSERT(IsLeaf());
+			mPrevLeaf = prevLeaf;
+		}
+
+		NodeBPlus* GetNextLeaf() noexcept
+		{
+			MOMO_ASSERT(IsLeaf());
+			return mNextLeaf;
+		}
+
+		void SetNextLeaf(NodeBPlus* nextLeaf) noexcept
+		{
+			MOMO_ASSERT(IsLeaf());
+			mNextLeaf = nextLeaf;
+		}
+
+		NodeBPlus* GetChild(size_t index) noexcept
+		{
+			MOMO_ASSERT(index <= GetCount());
+			return pvGetChildren()[index];
+		}
+
+		void SetChild(size_t index, NodeBPlus* child) noexcept
+		{
+			MOMO_ASSERT(index <= GetCount());
+			pvGetChildren()[index] = child;
+		}
+
+		size_t GetChildIndex(const NodeBPlus* child) const noexcept
+		{
+			size_t count = GetCount();
+			NodeBPlus* const* children = &mParent - maxCapacity - 1;
+			size_t index = UIntMath<>::Dist(children,
+				std::find(children, children + count + 1, child));
+			MOMO_ASSERT(index <= count);
+			return index;
+		}
+
+		Key* GetKeyPtr(size_t index) noexcept
+		{
+			MOMO_ASSERT(!IsLeaf());
+			return BitCaster::PtrToPtr<Key>(this, -static_cast<ptrdiff_t>(internalOffset)) + index;
+		}
+
+		Item* GetItemPtr(size_t index) noexcept
+		{
+			MOMO_ASSERT(IsLeaf());
+			return pvGetItemPtr(index, IsContinuous());
+		}
+
+		void AcceptBackItem(Params& params, size_t index) noexcept
+		{
+			size_t count = GetCount();
+			MOMO_ASSERT(count < GetCapacity());
+			MOMO_ASSERT(index <= count);
+			pvAcceptBackItem(params, index, count, IsContinuous());
+			++mCounter.count;
+		}
+
+		template<typename ItemRemover>
+		void Remove(Params& params, size_t index, ItemRemover&& itemRemover)
+		{
+			size_t count = GetCount();
+			MOMO_ASSERT(index < count);
+			pvRemove(params, index, count, std::forward<ItemRemover>(itemRemover), IsContinuous());
+			--mCounter.count;
+		}
+
+	private:
+		NodeBPlus** pvGetChildren() noexcept
+		{
+			MOMO_ASSERT(!IsLeaf());
+			return &mParent - maxCapacity - 1;
+		}
+
+		void pvInitIndexes(std::true_type /*isContinuous*/) noexcept
+		{
+		}
+
+		void pvInitIndexes(std::false_type /*isContinuous*/) noexcept
+		{
+			for (size_t i = 0; i < maxCapacity; ++i)
+				mCounter.indexes[i] = static_cast<uint8_t>(i);
+		}
+
+		Item* pvGetItemPtr(size_t index, std::true_type /*isContinuous*/) noexcept
+		{
+			return &mFirstItem + index;
+		}
+
+		Item* pvGetItemPtr(size_t index, std::false_type /*isContinuous*/) noexcept
+		{
+			return &mFirstItem + mCounter.indexes[index];
+		}
+
+		void pvAcceptBackItem(Params& params, size_t index, size_t count,
+			std::true_type /*isContinuous*/) noexcept
+		{
+			ItemTraits::ShiftNothrow(params.GetMemManager(),
+				std::reverse_iterator<Item*>(GetItemPtr(count + 1)), count - index);
+		}
+
+		void pvAcceptBackItem(Params& /*params*/, size_t index, size_t count,
+			std::false_type /*isContinuous*/) noexcept
+		{
+			uint8_t realIndex = mCounter.indexes[count];
+			std::copy_backward(mCounter.indexes + index, mCounter.indexes + count,
+				mCounter.indexes + count + 1);
+			mCounter.indexes[index] = realIndex;
+		}
+
+		template<typename ItemRemover>
+		void pvRemove(Params& params, size_t index, size_t count, ItemRemover&& itemRemover,
+			std::true_type /*isContinuous*/)
+		{
+			ItemTraits::ShiftNothrow(params.GetMemManager(), GetItemPtr(index), count - index - 1);
+			try
+			{
+				std::forward<ItemRemover>(itemRemover)(*GetItemPtr(count - 1));
+			}
+			catch (...)
+			{
+				ItemTraits::ShiftNothrow(params.GetMemManager(),
+					std::reverse_iterator<Item*>(GetItemPtr(count)), count - index - 1);
+				throw;
+			}
+		}
+
+		template<typename ItemRemover>
+		void pvRemove(Params& /*params*/, size_t index, size_t count, ItemRemover&& itemRemover,
+			std::false_type /*isContinuous*/)
+		{
+			std::forward<ItemRemover>(itemRemover)(*GetItemPtr(index));
+			uint8_t realIndex = mCounter.indexes[index];
+			std::copy(mCounter.indexes + index + 1, mCounter.indexes + count,
+				mCounter.indexes + index);
+			mCounter.indexes[count - 1] = realIndex;
+		}
+
+	private:
+		NodeBPlus* mParent;
+		NodeBPlus* mPrevLeaf;
+		NodeBPlus* mNextLeaf;
+		uint8_t mMemPoolIndex;
+		Counter<maxCapacity, !isContinuous> mCounter;
+		ItemBuffer mFirstItem;
+	};
+}
+
+template<size_t tMaxCapacity, size_t tCapacityStep,
+	typename TMemPoolParams = MemPoolParams<(tMaxCapacity < 64) ? 32 : 1>,
+	bool tIsContinuous = true>
+class TreeNodeBPlus
+{
+public:
+	static const size_t maxCapacity = tMaxCapacity;
+	static const size_t capacityStep = tCapacityStep;
+	static const bool isContinuous = tIsContinuous;
+
+	typedef TMemPoolParams MemPoolParams;
+
+	template<typename ItemTraits>
+	using Node = internal::NodeBPlus<ItemTraits, maxCapacity, capacityStep, MemPoolParams,
+		isContinuous && ItemTraits::isNothrowShiftable>;
+};
+
+} // namespace momo
@@ -0,0 +1,514 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/stdish/flat_map.h
+
+  namespace momo::stdish:
+    class flat_map
+
+  This class is similar to `std::map`, but the pairs are stored sorted
+  in one array (`momo::FlatMap`). Search and iteration are faster and
+  memory usage is lower, but insertion and removal of one pair have
+  linear complexity. Function `insert` receiving many pairs sorts and
+  merges them in one pass.
+
+  Deviations from `std::map`:
+  1. There are no `value_comp`, node handles, `merge` and hinted
+    insertion.
+  2. After each addition or removal of the item all iterators and
+    references to items become invalid and should not be used.
+  3. Type `reference` is not the same as `value_type&`, so
+    `for (auto& p : map)` is illegal, but `for (auto p : map)` or
+    `for (const auto& p : map)` or `for (auto&& p : map)` is allowed.
+  4. Functions `emplace` and `insert_or_assign` receiving the key of
+    other type construct the key before the search.
+
+\**********************************************************/
+
+#pragma once
+
+#include "../FlatMap.h"
+
+namespace momo
+{
+
+namespace stdish
+{
+
+template<typename TKey, typename TMapped,
+	typename TLessFunc = std::less<TKey>,
+	typename TAllocator = std::allocator<std::pair<const TKey, TMapped>>,
+	typename TFlatMap = FlatMap<TKey, TMapped, TreeTraitsStd<TKey, TLessFunc>,
+		MemManagerStd<TAllocator>>>
+class flat_map
+{
+private:
+	typedef TFlatMap FlatMap;
+	typedef typename FlatMap::TreeTraits TreeTraits;
+	typedef typename FlatMap::MemManager MemManager;
+
+	typedef typename FlatMap::Iterator FlatMapIterator;
+
+public:
+	typedef TKey key_type;
+	typedef TMapped mapped_type;
+	typedef TLessFunc key_compare;
+	typedef TAllocator allocator_type;
+
+	typedef FlatMap nested_container_type;
+
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	typedef std::pair<const key_type, mapped_type> value_type;
+
+	typedef momo::internal::MapReferenceStd<key_type, mapped_type,
+		typename FlatMapIterator::Reference> reference;
+	typedef typename reference::ConstReference const_reference;
+
+	typedef momo::internal::TreeDerivedIterator<FlatMapIterator, reference> iterator;
+	typedef typename iterator::ConstIterator const_iterator;
+
+	typedef typename iterator::Pointer pointer;
+	typedef typename const_iterator::Pointer const_pointer;
+
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+	struct ConstIteratorProxy : public const_iterator
+	{
+		typedef const_iterator ConstIterator;
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(ConstIterator)
+		MOMO_DECLARE_PROXY_FUNCTION(ConstIterator, GetBaseIterator,
+			typename ConstIterator::BaseIterator)
+	};
+
+	struct IteratorProxy : public iterator
+	{
+		typedef iterator Iterator;
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(Iterator)
+	};
+
+public:
+	flat_map()
+	{
+	}
+
+	explicit flat_map(const allocator_type& alloc)
+		: mFlatMap(TreeTraits(), MemManager(alloc))
+	{
+	}
+
+	explicit flat_map(const key_compare& lessFunc, const allocator_type& alloc = allocator_type())
+		: mFlatMap(TreeTraits(lessFunc), MemManager(alloc))
+	{
+	}
+
+	template<typename Iterator>
+	flat_map(Iterator first, Iterator last, const allocator_type& alloc = allocator_type())
+		: flat_map(alloc)
+	{
+		insert(first, last);
+	}
+
+	template<typename Iterator>
+	flat_map(Iterator first, Iterator last, const key_compare& lessFunc,
+		const allocator_type& alloc = allocator_type())
+		: flat_map(lessFunc, alloc)
+	{
+		insert(first, last);
+	}
+
+	flat_map(std::initializer_list<value_type> values,
+		const allocator_type& alloc = allocator_type())
+		: flat_map(values.begin(), values.end(), alloc)
+	{
+	}
+
+	flat_map(std::initializer_list<value_type> values, const key_compare& lessFunc,
+		const allocator_type& alloc = allocator_type())
+		: flat_map(values.begin(), values.end(), lessFunc, alloc)
+	{
+	}
+
+	flat_map(flat_map&& right) noexcept
+		: mFlatMap(std::move(right.mFlatMap))
+	{
+	}
+
+	flat_map(const flat_map& right)
+		: mFlatMap(right.mFlatMap)
+	{
+	}
+
+	flat_map(const flat_map& right, const allocator_type& alloc)
+		: mFlatMap(right.mFlatMap, MemManager(alloc))
+	{
+	}
+
+	~flat_map() noexcept
+	{
+	}
+
+	flat_map& operator=(flat_map&& right) noexcept
+	{
+		mFlatMap = std::move(right.mFlatMap);
+		return *this;
+	}
+
+	flat_map& operator=(const flat_map& right)
+	{
+		if (this != &right)
+		{
+			bool propagate = momo::internal::IsAllocatorAlwaysEqual<allocator_type>::value ||
+				std::allocator_traits<allocator_type>::propagate_on_container_copy_assignment::value;
+			allocator_type alloc = (propagate ? &right : this)->get_allocator();
+			mFlatMap = FlatMap(right.mFlatMap, MemManager(alloc));
+		}
+		return *this;
+	}
+
+	flat_map& operator=(std::initializer_list<value_type> values)
+	{
+		flat_map(values, get_allocator()).swap(*this);
+		return *this;
+	}
+
+	void swap(flat_map& right) noexcept
+	{
+		MOMO_ASSERT(std::allocator_traits<allocator_type>::propagate_on_container_swap::value
+			|| get_allocator() == right.get_allocator());
+		mFlatMap.Swap(right.mFlatMap);
+	}
+
+	friend void swap(flat_map& left, flat_map& right) noexcept
+	{
+		left.swap(right);
+	}
+
+	const nested_container_type& get_nested_container() const noexcept
+	{
+		return mFlatMap;
+	}
+
+	nested_container_type& get_nested_container() noexcept
+	{
+		return mFlatMap;
+	}
+
+	iterator begin() noexcept
+	{
+		return IteratorProxy(mFlatMap.GetBegin());
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return ConstIteratorProxy(mFlatMap.GetBegin());
+	}
+
+	iterator end() noexcept
+	{
+		return IteratorProxy(mFlatMap.GetEnd());
+	}
+
+	const_iterator end() const noexcept
+	{
+		return ConstIteratorProxy(mFlatMap.GetEnd());
+	}
+
+	reverse_iterator rbegin() noexcept
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const noexcept
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend() noexcept
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const noexcept
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	const_iterator cbegin() const noexcept
+	{
+		return begin();
+	}
+
+	const_iterator cend() const noexcept
+	{
+		return end();
+	}
+
+	const_reverse_iterator crbegin() const noexcept
+	{
+		return rbegin();
+	}
+
+	const_reverse_iterator crend() const noexcept
+	{
+		return rend();
+	}
+
+	key_compare key_comp() const
+	{
+		return mFlatMap.GetTreeTraits().GetLessFunc();
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return allocator_type(mFlatMap.GetMemManager().GetByteAllocator());
+	}
+
+	size_type max_size() const noexcept
+	{
+		return std::allocator_traits<allocator_type>::max_size(get_allocator());
+	}
+
+	size_type size() const noexcept
+	{
+		return mFlatMap.GetCount();
+	}
+
+	MOMO_NODISCARD bool empty() const noexcept
+	{
+		return mFlatMap.IsEmpty();
+	}
+
+	void clear() noexcept
+	{
+		mFlatMap.Clear();
+	}
+
+	size_type capacity() const noexcept
+	{
+		return mFlatMap.GetCapacity();
+	}
+
+	void reserve(size_type count)
+	{
+		mFlatMap.Reserve(count);
+	}
+
+	void shrink_to_fit()
+	{
+		mFlatMap.Shrink();
+	}
+
+	const_iterator find(const key_type& key) const
+	{
+		return ConstIteratorProxy(mFlatMap.Find(key));
+	}
+
+	iterator find(const key_type& key)
+	{
+		return IteratorProxy(mFlatMap.Find(key));
+	}
+
+	size_type count(const key_type& key) const
+	{
+		return mFlatMap.ContainsKey(key) ? 1 : 0;
+	}
+
+	bool contains(const key_type& key) const
+	{
+		return mFlatMap.ContainsKey(key);
+	}
+
+	const_iterator lower_bound(const key_type& key) const
+	{
+		return ConstIteratorProxy(mFlatMap.GetLowerBound(key));
+	}
+
+	iterator lower_bound(const key_type& key)
+	{
+		return IteratorProxy(mFlatMap.GetLowerBound(key));
+	}
+
+	const_iterator upper_bound(const key_type& key) const
+	{
+		return ConstIteratorProxy(mFlatMap.GetUpperBound(key));
+	}
+
+	iterator upper_bound(const key_type& key)
+	{
+		return IteratorProxy(mFlatMap.GetUpperBound(key));
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+	{
+		const_iterator iter = find(key);
+		if (iter == end())
+			return { iter, iter };
+		return { iter, std::next(iter) };
+	}
+
+	std::pair<iterator, iterator> equal_range(const key_type& key)
+	{
+		iterator iter = find(key);
+		if (iter == end())
+			return { iter, iter };
+		return { iter, std::next(iter) };
+	}
+
+	std::pair<iterator, bool> insert(std::pair<key_type, mapped_type>&& value)
+	{
+		return pvInsert(mFlatMap.Insert(std::move(value.first), std::move(value.second)));
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		return pvInsert(mFlatMap.Insert(value.first, value.second));
+	}
+
+	template<typename First, typename Second>
+	momo::internal::EnableIf<std::is_constructible<key_type, const First&>::value
+		&& std::is_constructible<mapped_type, const Second&>::value, std::pair<iterator, bool>>
+	insert(const std::pair<First, Second>& value)
+	{
+		return emplace(value.first, value.second);
+	}
+
+	template<typename Iterator>
+	void insert(Iterator first, Iterator last)
+	{
+		mFlatMap.Insert(first, last);
+	}
+
+	void insert(std::initializer_list<value_type> values)
+	{
+		mFlatMap.Insert(values.begin(), values.end());
+	}
+
+	template<typename KeyArg, typename MappedArg>
+	std::pair<iterator, bool> emplace(KeyArg&& keyArg, MappedArg&& mappedArg)
+	{
+		return pvInsert(mFlatMap.InsertVar(key_type(std::forward<KeyArg>(keyArg)),
+			std::forward<MappedArg>(mappedArg)));
+	}
+
+	template<typename... MappedArgs>
+	std::pair<iterator, bool> try_emplace(key_type&& key, MappedArgs&&... mappedArgs)
+	{
+		return pvInsert(mFlatMap.InsertVar(std::move(key),
+			std::forward<MappedArgs>(mappedArgs)...));
+	}
+
+	template<typename... MappedArgs>
+	std::pair<iterator, bool> try_emplace(const key_type& key, MappedArgs&&... mappedArgs)
+	{
+		return pvInsert(mFlatMap.InsertVar(key, std::forward<MappedArgs>(mappedArgs)...));
+	}
+
+	template<typename MappedArg>
+	std::pair<iterator, bool> insert_or_assign(key_type&& key, MappedArg&& mappedArg)
+	{
+		return pvInsertOrAssign(std::move(key), std::forward<MappedArg>(mappedArg));
+	}
+
+	template<typename MappedArg>
+	std::pair<iterator, bool> insert_or_assign(const key_type& key, MappedArg&& mappedArg)
+	{
+		return pvInsertOrAssign(key, std::forward<MappedArg>(mappedArg));
+	}
+
+	mapped_type& operator[](key_type&& key)
+	{
+		return try_emplace(std::move(key)).first->second;
+	}
+
+	mapped_type& operator[](const key_type& key)
+	{
+		return try_emplace(key).first->second;
+	}
+
+	const mapped_type& at(const key_type& key) const
+	{
+		const_iterator iter = find(key);
+		if (iter == end())
+			throw std::out_of_range("invalid map key");
+		return iter->second;
+	}
+
+	mapped_type& at(const key_type& key)
+	{
+		iterator iter = find(key);
+		if (iter == end())
+			throw std::out_of_range("invalid map key");
+		return iter->second;
+	}
+
+	iterator erase(const_iterator where)
+	{
+		return IteratorProxy(mFlatMap.Remove(ConstIteratorProxy::GetBaseIterator(where)));
+	}
+
+	iterator erase(iterator where)
+	{
+		return erase(static_cast<const_iterator>(where));
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		return IteratorProxy(mFlatMap.Remove(ConstIteratorProxy::GetBaseIterator(first),
+			ConstIteratorProxy::GetBaseIterator(last)));
+	}
+
+	size_type erase(const key_type& key)
+	{
+		return mFlatMap.Remove(key);
+	}
+
+	bool operator==(const flat_map& right) const
+	{
+		return size() == right.size() && std::equal(begin(), end(), right.begin());
+	}
+
+	bool operator!=(const flat_map& right) const
+	{
+		return !(*this == right);
+	}
+
+private:
+	std::pair<iterator, bool> pvInsert(typename FlatMap::InsertResult res)
+	{
+		return { IteratorProxy(res.iterator), res.inserted };
+	}
+
+	template<typename RKey, typename MappedArg>
+	std::pair<iterator, bool> pvInsertOrAssign(RKey&& key, MappedArg&& mappedArg)
+	{
+		std::pair<iterator, bool> res = try_emplace(std::forward<RKey>(key),
+			std::forward<MappedArg>(mappedArg));
+		if (!res.second)
+			res.first->second = std::forward<MappedArg>(mappedArg);
+		return res;
+	}
+
+private:
+	FlatMap mFlatMap;
+};
+
+#ifdef MOMO_HAS_PMR
+namespace pmr
+{
+	template<typename TKey, typename TMapped,
+		typename TLessFunc = std::less<TKey>>
+	using flat_map = stdish::flat_map<TKey, TMapped, TLessFunc,
+		std::pmr::polymorphic_allocator<std::pair<const TKey, TMapped>>>;
+}
+#endif
+
+} // namespace stdish
+
+} // namespace momo
@@ -0,0 +1,440 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/stdish/flat_set.h
+
+  namespace momo::stdish:
+    class flat_set
+
+  This class is similar to `std::set`, but the items are stored sorted
+  in one array (`momo::FlatSet`). Search and iteration are faster and
+  memory usage is lower, but insertion and removal of one item have
+  linear complexity. Function `insert` receiving many items sorts and
+  merges them in one pass.
+
+  Deviations from `std::set`:
+  1. There are no node handles, `merge` and hinted insertion.
+  2. After each addition or removal of the item all iterators and
+    references to items become invalid and should not be used.
+  3. Iterators are random access.
+  4. Functions `emplace` construct the item before the search.
+
+\**********************************************************/
+
+#pragma once
+
+#include "../FlatSet.h"
+
+namespace momo
+{
+
+namespace stdish
+{
+
+template<typename TKey,
+	typename TLessFunc = std::less<TKey>,
+	typename TAllocator = std::allocator<TKey>,
+	typename TFlatSet = FlatSet<TKey, TreeTraitsStd<TKey, TLessFunc>, MemManagerStd<TAllocator>>>
+class flat_set
+{
+private:
+	typedef TFlatSet FlatSet;
+	typedef typename FlatSet::TreeTraits TreeTraits;
+	typedef typename FlatSet::MemManager MemManager;
+
+public:
+	typedef TKey key_type;
+	typedef TLessFunc key_compare;
+	typedef TAllocator allocator_type;
+
+	typedef FlatSet nested_container_type;
+
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	typedef key_type value_type;
+	typedef key_compare value_compare;
+
+	typedef typename FlatSet::ConstIterator const_iterator;
+	typedef typename FlatSet::Iterator iterator;
+
+	typedef const value_type& reference;
+	typedef const value_type& const_reference;
+
+	typedef const value_type* pointer;
+	typedef const value_type* const_pointer;
+
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+	template<typename KeyArg>
+	struct IsValidKeyArg : public TreeTraits::template IsValidKeyArg<KeyArg>
+	{
+	};
+
+public:
+	flat_set()
+	{
+	}
+
+	explicit flat_set(const allocator_type& alloc)
+		: mFlatSet(TreeTraits(), MemManager(alloc))
+	{
+	}
+
+	explicit flat_set(const key_compare& lessFunc, const allocator_type& alloc = allocator_type())
+		: mFlatSet(TreeTraits(lessFunc), MemManager(alloc))
+	{
+	}
+
+	template<typename Iterator>
+	flat_set(Iterator first, Iterator last, const allocator_type& alloc = allocator_type())
+		: flat_set(alloc)
+	{
+		insert(first, last);
+	}
+
+	template<typename Iterator>
+	flat_set(Iterator first, Iterator last, const key_compare& lessFunc,
+		const allocator_type& alloc = allocator_type())
+		: flat_set(lessFunc, alloc)
+	{
+		insert(first, last);
+	}
+
+	flat_set(std::initializer_list<value_type> values,
+		const allocator_type& alloc = allocator_type())
+		: mFlatSet(values, TreeTraits(), MemManager(alloc))
+	{
+	}
+
+	flat_set(std::initializer_list<value_type> values, const key_compare& lessFunc,
+		const allocator_type& alloc = allocator_type())
+		: mFlatSet(values, TreeTraits(lessFunc), MemManager(alloc))
+	{
+	}
+
+	flat_set(flat_set&& right) noexcept
+		: mFlatSet(std::move(right.mFlatSet))
+	{
+	}
+
+	flat_set(const flat_set& right)
+		: mFlatSet(right.mFlatSet)
+	{
+	}
+
+	flat_set(const flat_set& right, const allocator_type& alloc)
+		: mFlatSet(right.mFlatSet, MemManager(alloc))
+	{
+	}
+
+	~flat_set() noexcept
+	{
+	}
+
+	flat_set& operator=(flat_set&& right) noexcept
+	{
+		mFlatSet = std::move(right.mFlatSet);
+		return *this;
+	}
+
+	flat_set& operator=(const flat_set& right)
+	{
+		if (this != &right)
+		{
+			bool propagate = momo::internal::IsAllocatorAlwaysEqual<allocator_type>::value ||
+				std::allocator_traits<allocator_type>::propagate_on_container_copy_assignment::value;
+			allocator_type alloc = (propagate ? &right : this)->get_allocator();
+			mFlatSet = FlatSet(right.mFlatSet, MemManager(alloc));
+		}
+		return *this;
+	}
+
+	flat_set& operator=(std::initializer_list<value_type> values)
+	{
+		mFlatSet = FlatSet(values, mFlatSet.GetTreeTraits(), MemManager(get_allocator()));
+		return *this;
+	}
+
+	void swap(flat_set& right) noexcept
+	{
+		MOMO_ASSERT(std::allocator_traits<allocator_type>::propagate_on_container_swap::value
+			|| get_allocator() == right.get_allocator());
+		mFlatSet.Swap(right.mFlatSet);
+	}
+
+	friend void swap(flat_set& left, flat_set& right) noexcept
+	{
+		left.swap(right);
+	}
+
+	const nested_container_type& get_nested_container() const noexcept
+	{
+		return mFlatSet;
+	}
+
+	nested_container_type& get_nested_container() noexcept
+	{
+		return mFlatSet;
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return mFlatSet.GetBegin();
+	}
+
+	const_iterator end() const noexcept
+	{
+		return mFlatSet.GetEnd();
+	}
+
+	const_reverse_iterator rbegin() const noexcept
+	{
+		return const_reverse_iterator(end());
+	}
+
+	const_reverse_iterator rend() const noexcept
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	const_iterator cbegin() const noexcept
+	{
+		return begin();
+	}
+
+	const_iterator cend() const noexcept
+	{
+		return end();
+	}
+
+	const_reverse_iterator crbegin() const noexcept
+	{
+		return rbegin();
+	}
+
+	const_reverse_iterator crend() const noexcept
+	{
+		return rend();
+	}
+
+	key_compare key_comp() const
+	{
+		return mFlatSet.GetTreeTraits().GetLessFunc();
+	}
+
+	value_compare value_comp() const
+	{
+		return key_comp();
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return allocator_type(mFlatSet.GetMemManager().GetByteAllocator());
+	}
+
+	size_type max_size() const noexcept
+	{
+		return std::allocator_traits<allocator_type>::max_size(get_allocator());
+	}
+
+	size_type size() const noexcept
+	{
+		return mFlatSet.GetCount();
+	}
+
+	MOMO_NODISCARD bool empty() const noexcept
+	{
+		return mFlatSet.IsEmpty();
+	}
+
+	void clear() noexcept
+	{
+		mFlatSet.Clear();
+	}
+
+	size_type capacity() const noexcept
+	{
+		return mFlatSet.GetCapacity();
+	}
+
+	void reserve(size_type count)
+	{
+		mFlatSet.Reserve(count);
+	}
+
+	void shrink_to_fit()
+	{
+		mFlatSet.Shrink();
+	}
+
+	const_iterator find(const key_type& key) const
+	{
+		return mFlatSet.Find(key);
+	}
+
+	template<typename KeyArg>
+	momo::internal::EnableIf<IsValidKeyArg<KeyArg>::value, const_iterator> find(
+		const KeyArg& key) const
+	{
+		return mFlatSet.Find(key);
+	}
+
+	size_type count(const key_type& key) const
+	{
+		return contains(key) ? 1 : 0;
+	}
+
+	template<typename KeyArg>
+	momo::internal::EnableIf<IsValidKeyArg<KeyArg>::value, size_type> count(
+		const KeyArg& key) const
+	{
+		return contains(key) ? 1 : 0;
+	}
+
+	bool contains(const key_type& key) const
+	{
+		return mFlatSet.ContainsKey(key);
+	}
+
+	template<typename KeyArg>
+	momo::internal::EnableIf<IsValidKeyArg<KeyArg>::value, bool> contains(const KeyArg& key) const
+	{
+		return mFlatSet.ContainsKey(key);
+	}
+
+	const_iterator lower_bound(const key_type& key) const
+	{
+		return mFlatSet.GetLowerBound(key);
+	}
+
+	template<typename KeyArg>
+	momo::internal::EnableIf<IsValidKeyArg<KeyArg>::value, const_iterator> lower_bound(
+		const KeyArg& key) const
+	{
+		return mFlatSet.GetLowerBound(key);
+	}
+
+	const_iterator upper_bound(const key_type& key) const
+	{
+		return mFlatSet.GetUpperBound(key);
+	}
+
+	template<typename KeyArg>
+	momo::internal::EnableIf<IsValidKeyArg<KeyArg>::value, const_iterator> upper_bound(
+		const KeyArg& key) const
+	{
+		return mFlatSet.GetUpperBound(key);
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+	{
+		const_iterator iter = find(key);
+		if (iter == end())
+			return { iter, iter };
+		return { iter, std::next(iter) };
+	}
+
+	template<typename KeyArg>
+	momo::internal::EnableIf<IsValidKeyArg<KeyArg>::value,
+		std::pair<const_iterator, const_iterator>>
+	equal_range(const KeyArg& key) const
+	{
+		return { lower_bound(key), upper_bound(key) };
+	}
+
+	std::pair<iterator, bool> insert(value_type&& value)
+	{
+		typename FlatSet::InsertResult res = mFlatSet.Insert(std::move(value));
+		return { res.iterator, res.inserted };
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		typename FlatSet::InsertResult res = mFlatSet.Insert(value);
+		return { res.iterator, res.inserted };
+	}
+
+	template<typename Iterator>
+	void insert(Iterator first, Iterator last)
+	{
+		mFlatSet.Insert(first, last);
+	}
+
+	void insert(std::initializer_list<value_type> values)
+	{
+		mFlatSet.Insert(values);
+	}
+
+	template<typename... ValueArgs>
+	std::pair<iterator, bool> emplace(ValueArgs&&... valueArgs)
+	{
+		return insert(value_type(std::forward<ValueArgs>(valueArgs)...));
+	}
+
+	iterator erase(const_iterator where)
+	{
+		return mFlatSet.Remove(where);
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		return mFlatSet.Remove(first, last);
+	}
+
+	size_type erase(const key_type& key)
+	{
+		return mFlatSet.Remove(key);
+	}
+
+	bool operator==(const flat_set& right) const
+	{
+		return size() == right.size() && std::equal(begin(), end(), right.begin());
+	}
+
+	bool operator!=(const flat_set& right) const
+	{
+		return !(*this == right);
+	}
+
+	bool operator<(const flat_set& right) const
+	{
+		return std::lexicographical_compare(begin(), end(), right.begin(), right.end());
+	}
+
+	bool operator>(const flat_set& right) const
+	{
+		return right < *this;
+	}
+
+	bool operator<=(const flat_set& right) const
+	{
+		return !(right < *this);
+	}
+
+	bool operator>=(const flat_set& right) const
+	{
+		return right <= *this;
+	}
+
+private:
+	FlatSet mFlatSet;
+};
+
+#ifdef MOMO_HAS_PMR
+namespace pmr
+{
+	template<typename TKey,
+		typename TLessFunc = std::less<TKey>>
+	using flat_set = stdish::flat_set<TKey, TLessFunc, std::pmr::polymorphic_allocator<TKey>>;
+}
+#endif
+
+} // namespace stdish
+
+} // namespace momo
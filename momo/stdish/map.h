@@ -1096,6 +1096,21 @@ MOMO_DECLARE_DEDUCTION_GUIDES(multimap)
 
 #endif
 
+#ifdef MOMO_HAS_PMR
+namespace pmr
+{
+	template<typename TKey, typename TMapped,
+		typename TLessFunc = std::less<TKey>>
+	using map = stdish::map<TKey, TMapped, TLessFunc,
+		std::pmr::polymorphic_allocator<std::pair<const TKey, TMapped>>>;
+
+	template<typename TKey, typename TMapped,
+		typename TLessFunc = std::less<TKey>>
+	using multimap = stdish::multimap<TKey, TMapped, TLessFunc,
+		std::pmr::polymorphic_allocator<std::pair<const TKey, TMapped>>>;
+}
+#endif
+
 } // namespace stdish
 
 } // namespace momo
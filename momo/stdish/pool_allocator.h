@@ -8,6 +8,7 @@
 
   namespace momo::stdish:
     class unsynchronized_pool_allocator
+    class synchronized_pool_allocator
 
   Allocator with a pool of memory for containers like `std::list`,
   `std::forward_list`, `std::map`, `std::unordered_map`.
@@ -17,11 +18,20 @@
   Memory is released not only after destruction of the object,
   but also in case of removal sufficient number of items.
 
+  `synchronized_pool_allocator` is a thread-safe analogue based on
+  `ConcurrentMemPool`. Copies of the container (and the container
+  itself) may be used from different threads, an item may be
+  deallocated by any thread. The pool is created on the first
+  allocation of a single object and serves only objects of that size,
+  other requests are passed to the base allocator, which must be
+  thread-safe.
+
 \**********************************************************/
 
 #pragma once
 
 #include "../MemPool.h"
+#include "../ConcurrentMemPool.h"
 
 namespace momo
 {
@@ -29,6 +39,82 @@ namespace momo
 namespace stdish
 {
 
+namespace internal
+{
+	template<typename TBaseAllocator, typename TMemPoolParams>
+	class synchronized_mem_pool
+	{
+	public:
+		typedef TBaseAllocator base_allocator_type;
+		typedef TMemPoolParams mem_pool_params;
+
+		typedef MemManagerStd<base_allocator_type> MemManager;
+		typedef momo::ConcurrentMemPool<mem_pool_params, MemManager> MemPool;
+
+	private:
+		typedef momo::internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	public:
+		explicit synchronized_mem_pool(const base_allocator_type& alloc)
+			: mMemManager(alloc),
+			mMemPool(nullptr)
+		{
+		}
+
+		synchronized_mem_pool(const synchronized_mem_pool&) = delete;
+
+		~synchronized_mem_pool() noexcept
+		{
+			MemPool* memPool = mMemPool.load(std::memory_order_relaxed);
+			if (memPool == nullptr)
+				return;
+			memPool->~MemPool();
+			MemManagerProxy::Deallocate(mMemManager, memPool, sizeof(MemPool));
+		}
+
+		synchronized_mem_pool& operator=(const synchronized_mem_pool&) = delete;
+
+		MemManager& GetMemManager() noexcept
+		{
+			return mMemManager;
+		}
+
+		MemPool* GetMemPool() const noexcept
+		{
+			return mMemPool.load(std::memory_order_acquire);
+		}
+
+		MemPool* GetMemPool(const mem_pool_params& memPoolParams)
+		{
+			MemPool* memPool = mMemPool.load(std::memory_order_acquire);
+			if (memPool != nullptr)
+				return memPool;
+			std::lock_guard<std::mutex> lock(mMutex);
+			memPool = mMemPool.load(std::memory_order_relaxed);
+			if (memPool == nullptr)
+			{
+				memPool = MemManagerProxy::template Allocate<MemPool>(mMemManager, sizeof(MemPool));
+				try
+				{
+					::new(static_cast<void*>(memPool)) MemPool(memPoolParams, MemManager(mMemManager));
+				}
+				catch (...)
+				{
+					MemManagerProxy::Deallocate(mMemManager, memPool, sizeof(MemPool));
+					throw;
+				}
+				mMemPool.store(memPool, std::memory_order_release);
+			}
+			return memPool;
+		}
+
+	private:
+		MemManager mMemManager;
+		std::atomic<MemPool*> mMemPool;
+		std::mutex mMutex;
+	};
+}
+
 template<typename TValue,
 	typename TBaseAllocator = std::allocator<char>,
 	typename TMemPoolParams = MemPoolParams<>>
@@ -52,7 +138,7 @@ public:
 
 private:
 	typedef MemManagerStd<base_allocator_type> MemManager;
-	typedef internal::MemManagerProxy<MemManager> MemManagerProxy;
+	typedef momo::internal::MemManagerProxy<MemManager> MemManagerProxy;
 
 	typedef mem_pool_params MemPoolParams;
 	typedef momo::MemPool<MemPoolParams, MemManager> MemPool;
@@ -161,13 +247,159 @@ protected:
 private:
 	static MemPoolParams pvGetMemPoolParams() noexcept
 	{
-		return MemPoolParams(sizeof(value_type), internal::AlignmentOf<value_type>::value);
+		return MemPoolParams(sizeof(value_type), momo::internal::AlignmentOf<value_type>::value);
 	}
 
 private:
 	std::shared_ptr<MemPool> mMemPool;
 };
 
+template<typename TValue,
+	typename TBaseAllocator = std::allocator<char>,
+	typename TMemPoolParams = MemPoolParams<>>
+class synchronized_pool_allocator
+{
+public:
+	typedef TValue value_type;
+
+	typedef TBaseAllocator base_allocator_type;
+	typedef TMemPoolParams mem_pool_params;
+
+	typedef value_type* pointer;
+	typedef const value_type* const_pointer;
+
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+private:
+	typedef internal::synchronized_mem_pool<base_allocator_type, mem_pool_params> MemPoolHolder;
+
+	typedef typename MemPoolHolder::MemManager MemManager;
+	typedef momo::internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+	typedef mem_pool_params MemPoolParams;
+	typedef typename MemPoolHolder::MemPool MemPool;
+
+	template<typename Value>
+	struct PoolAllocatorProxy
+		: public synchronized_pool_allocator<Value, base_allocator_type, mem_pool_params>
+	{
+		typedef synchronized_pool_allocator<Value, base_allocator_type, mem_pool_params> PoolAllocator;
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(PoolAllocator)
+	};
+
+public:
+	explicit synchronized_pool_allocator(const base_allocator_type& alloc = base_allocator_type())
+		: mMemPoolHolder(std::allocate_shared<MemPoolHolder>(alloc, alloc))
+	{
+	}
+
+	synchronized_pool_allocator(const synchronized_pool_allocator& alloc) noexcept
+		: mMemPoolHolder(alloc.mMemPoolHolder)
+	{
+	}
+
+	~synchronized_pool_allocator() noexcept
+	{
+	}
+
+	synchronized_pool_allocator& operator=(const synchronized_pool_allocator& alloc) noexcept
+	{
+		mMemPoolHolder = alloc.mMemPoolHolder;
+		return *this;
+	}
+
+	template<class Value>
+	operator synchronized_pool_allocator<Value, base_allocator_type, mem_pool_params>() const
+		noexcept
+	{
+		return PoolAllocatorProxy<Value>(mMemPoolHolder);
+	}
+
+	base_allocator_type get_base_allocator() const noexcept
+	{
+		return base_allocator_type(mMemPoolHolder->GetMemManager().GetByteAllocator());
+	}
+
+	synchronized_pool_allocator select_on_container_copy_construction() const noexcept
+	{
+		return synchronized_pool_allocator(get_base_allocator());
+	}
+
+	MOMO_NODISCARD pointer allocate(size_type count)
+	{
+		if (count == 1)
+		{
+			MemPoolParams memPoolParams = pvGetMemPoolParams();
+			MemPool* memPool = mMemPoolHolder->GetMemPool(memPoolParams);
+			if (memPool->GetParams().IsEqual(memPoolParams))
+				return memPool->template Allocate<value_type>();
+		}
+		return MemManagerProxy::template Allocate<value_type>(pvGetMemManager(),
+			count * sizeof(value_type));
+	}
+
+	void deallocate(pointer ptr, size_type count) noexcept
+	{
+		if (count == 1)
+		{
+			MemPool* memPool = mMemPoolHolder->GetMemPool();
+			if (memPool != nullptr && memPool->GetParams().IsEqual(pvGetMemPoolParams()))
+				return memPool->Deallocate(ptr);
+		}
+		MemManagerProxy::Deallocate(pvGetMemManager(), ptr, count * sizeof(value_type));
+	}
+
+	template<typename Value, typename... ValueArgs>
+	void construct(Value* ptr, ValueArgs&&... valueArgs)
+	{
+		typedef typename momo::internal::ObjectManager<Value, MemManager>
+			::template Creator<ValueArgs...> ValueCreator;
+		ValueCreator(pvGetMemManager(), std::forward<ValueArgs>(valueArgs)...)(ptr);
+	}
+
+	template<class Value>
+	void destroy(Value* ptr) noexcept
+	{
+		momo::internal::ObjectManager<Value, MemManager>::Destroy(pvGetMemManager(), *ptr);
+	}
+
+	bool operator==(const synchronized_pool_allocator& alloc) const noexcept
+	{
+		return mMemPoolHolder == alloc.mMemPoolHolder;
+	}
+
+	bool operator!=(const synchronized_pool_allocator& alloc) const noexcept
+	{
+		return !(*this == alloc);
+	}
+
+protected:
+	explicit synchronized_pool_allocator(const std::shared_ptr<MemPoolHolder>& memPoolHolder) noexcept
+		: mMemPoolHolder(memPoolHolder)
+	{
+	}
+
+private:
+	static MemPoolParams pvGetMemPoolParams() noexcept
+	{
+		return MemPoolParams(std::minmax(sizeof(value_type), sizeof(void*)).second,
+			momo::internal::AlignmentOf<value_type>::value);
+	}
+
+	MemManager& pvGetMemManager() const noexcept
+	{
+		return mMemPoolHolder->GetMemManager();
+	}
+
+private:
+	std::shared_ptr<MemPoolHolder> mMemPoolHolder;
+};
+
 } // namespace stdish
 
 } // namespace momo
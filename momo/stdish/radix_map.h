@@ -0,0 +1,478 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  momo/stdish/radix_map.h
+
+  namespace momo::stdish:
+    class radix_map
+
+  This class is similar to `std::map`, but it is based on an adaptive
+  radix tree (`momo::RadixTreeMap`). Keys are ordered by their byte
+  sequences (`RadixTreeTraits`), which is the same as `std::less`
+  for integral and `std::string` keys.
+
+  Deviations from `std::map`:
+  1. There are no `key_comp`, `value_comp`, node handles, `merge`
+    and hinted insertion.
+  2. After each addition or removal of the item all iterators become
+    invalid and should not be used. References to items stay valid
+    until the item is removed.
+  3. Type `reference` is not the same as `value_type&`, so
+    `for (auto& p : map)` is illegal, but `for (auto p : map)` or
+    `for (const auto& p : map)` or `for (auto&& p : map)` is allowed.
+  4. Functions `emplace` and `insert_or_assign` receiving the key of
+    other type construct the key before the search.
+
+\**********************************************************/
+
+#pragma once
+
+#include "../RadixTreeMap.h"
+
+namespace momo
+{
+
+namespace stdish
+{
+
+template<typename TKey, typename TMapped,
+	typename TAllocator = std::allocator<std::pair<const TKey, TMapped>>,
+	typename TRadixTreeMap = RadixTreeMap<TKey, TMapped, RadixTreeTraits<TKey>,
+		MemManagerStd<TAllocator>>>
+class radix_map
+{
+private:
+	typedef TRadixTreeMap RadixTreeMap;
+	typedef typename RadixTreeMap::RadixTreeTraits RadixTreeTraits;
+	typedef typename RadixTreeMap::MemManager MemManager;
+
+	typedef typename RadixTreeMap::Iterator RadixTreeMapIterator;
+
+public:
+	typedef TKey key_type;
+	typedef TMapped mapped_type;
+	typedef TAllocator allocator_type;
+
+	typedef RadixTreeMap nested_container_type;
+
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	typedef std::pair<const key_type, mapped_type> value_type;
+
+	typedef momo::internal::MapReferenceStd<key_type, mapped_type,
+		typename RadixTreeMapIterator::Reference> reference;
+	typedef typename reference::ConstReference const_reference;
+
+	typedef momo::internal::TreeDerivedIterator<RadixTreeMapIterator, reference> iterator;
+	typedef typename iterator::ConstIterator const_iterator;
+
+	typedef typename iterator::Pointer pointer;
+	typedef typename const_iterator::Pointer const_pointer;
+
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+	struct ConstIteratorProxy : public const_iterator
+	{
+		typedef const_iterator ConstIterator;
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(ConstIterator)
+		MOMO_DECLARE_PROXY_FUNCTION(ConstIterator, GetBaseIterator,
+			typename ConstIterator::BaseIterator)
+	};
+
+	struct IteratorProxy : public iterator
+	{
+		typedef iterator Iterator;
+		MOMO_DECLARE_PROXY_CONSTRUCTOR(Iterator)
+	};
+
+public:
+	radix_map()
+	{
+	}
+
+	explicit radix_map(const allocator_type& alloc)
+		: mTreeMap(RadixTreeTraits(), MemManager(alloc))
+	{
+	}
+
+	template<typename Iterator>
+	radix_map(Iterator first, Iterator last, const allocator_type& alloc = allocator_type())
+		: radix_map(alloc)
+	{
+		insert(first, last);
+	}
+
+	radix_map(std::initializer_list<value_type> values,
+		const allocator_type& alloc = allocator_type())
+		: radix_map(values.begin(), values.end(), alloc)
+	{
+	}
+
+	radix_map(radix_map&& right) noexcept
+		: mTreeMap(std::move(right.mTreeMap))
+	{
+	}
+
+	radix_map(const radix_map& right)
+		: mTreeMap(right.mTreeMap)
+	{
+	}
+
+	radix_map(const radix_map& right, const allocator_type& alloc)
+		: mTreeMap(right.mTreeMap, MemManager(alloc))
+	{
+	}
+
+	~radix_map() noexcept
+	{
+	}
+
+	radix_map& operator=(radix_map&& right) noexcept
+	{
+		mTreeMap = std::move(right.mTreeMap);
+		return *this;
+	}
+
+	radix_map& operator=(const radix_map& right)
+	{
+		if (this != &right)
+		{
+			bool propagate = momo::internal::IsAllocatorAlwaysEqual<allocator_type>::value ||
+				std::allocator_traits<allocator_type>::propagate_on_container_copy_assignment::value;
+			allocator_type alloc = (propagate ? &right : this)->get_allocator();
+			mTreeMap = RadixTreeMap(right.mTreeMap, MemManager(alloc));
+		}
+		return *this;
+	}
+
+	radix_map& operator=(std::initializer_list<value_type> values)
+	{
+		radix_map(values, get_allocator()).swap(*this);
+		return *this;
+	}
+
+	void swap(radix_map& right) noexcept
+	{
+		MOMO_ASSERT(std::allocator_traits<allocator_type>::propagate_on_container_swap::value
+			|| get_allocator() == right.get_allocator());
+		mTreeMap.Swap(right.mTreeMap);
+	}
+
+	friend void swap(radix_map& left, radix_map& right) noexcept
+	{
+		left.swap(right);
+	}
+
+	const nested_container_type& get_nested_container() const noexcept
+	{
+		return mTreeMap;
+	}
+
+	nested_container_type& get_nested_container() noexcept
+	{
+		return mTreeMap;
+	}
+
+	iterator begin() noexcept
+	{
+		return IteratorProxy(mTreeMap.GetBegin());
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return ConstIteratorProxy(mTreeMap.GetBegin());
+	}
+
+	iterator end() noexcept
+	{
+		return IteratorProxy(mTreeMap.GetEnd());
+	}
+
+	const_iterator end() const noexcept
+	{
+		return ConstIteratorProxy(mTreeMap.GetEnd());
+	}
+
+	reverse_iterator rbegin() noexcept
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const noexcept
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend() noexcept
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const noexcept
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	const_iterator cbegin() const noexcept
+	{
+		return begin();
+	}
+
+	const_iterator cend() const noexcept
+	{
+		return end();
+	}
+
+	const_reverse_iterator crbegin() const noexcept
+	{
+		return rbegin();
+	}
+
+	const_reverse_iterator crend() const noexcept
+	{
+		return rend();
+	}
+
+	allocator_type get_allocator() const noexcept
+	{
+		return allocator_type(mTreeMap.GetMemManager().GetByteAllocator());
+	}
+
+	size_type max_size() const noexcept
+	{
+		return std::allocator_traits<allocator_type>::max_size(get_allocator());
+	}
+
+	size_type size() const noexcept
+	{
+		return mTreeMap.GetCount();
+	}
+
+	MOMO_NODISCARD bool empty() const noexcept
+	{
+		return mTreeMap.IsEmpty();
+	}
+
+	void clear() noexcept
+	{
+		mTreeMap.Clear();
+	}
+
+	const_iterator find(const key_type& key) const
+	{
+		return ConstIteratorProxy(mTreeMap.Find(key));
+	}
+
+	iterator find(const key_type& key)
+	{
+		return IteratorProxy(mTreeMap.Find(key));
+	}
+
+	size_type count(const key_type& key) const
+	{
+		return mTreeMap.ContainsKey(key) ? 1 : 0;
+	}
+
+	bool contains(const key_type& key) const
+	{
+		return mTreeMap.ContainsKey(key);
+	}
+
+	const_iterator lower_bound(const key_type& key) const
+	{
+		return ConstIteratorProxy(mTreeMap.GetLowerBound(key));
+	}
+
+	iterator lower_bound(const key_type& key)
+	{
+		return IteratorProxy(mTreeMap.GetLowerBound(key));
+	}
+
+	const_iterator upper_bound(const key_type& key) const
+	{
+		return ConstIteratorProxy(mTreeMap.GetUpperBound(key));
+	}
+
+	iterator upper_bound(const key_type& key)
+	{
+		return IteratorProxy(mTreeMap.GetUpperBound(key));
+	}
+
+	std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+	{
+		const_iterator iter = find(key);
+		if (iter == end())
+			return { iter, iter };
+		return { iter, std::next(iter) };
+	}
+
+	std::pair<iterator, iterator> equal_range(const key_type& key)
+	{
+		iterator iter = find(key);
+		if (iter == end())
+			return { iter, iter };
+		return { iter, std::next(iter) };
+	}
+
+	std::pair<iterator, bool> insert(std::pair<key_type, mapped_type>&& value)
+	{
+		return pvInsert(mTreeMap.Insert(std::move(value.first), std::move(value.second)));
+	}
+
+	template<typename First, typename Second>
+	momo::internal::EnableIf<std::is_constructible<key_type, const First&>::value
+		&& std::is_constructible<mapped_type, const Second&>::value, std::pair<iterator, bool>>
+	insert(const std::pair<First, Second>& value)
+	{
+		return emplace(value.first, value.second);
+	}
+
+	template<typename First, typename Second>
+	momo::internal::EnableIf<std::is_constructible<key_type, First&&>::value
+		&& std::is_constructible<mapped_type, Second&&>::value, std::pair<iterator, bool>>
+	insert(std::pair<First, Second>&& value)
+	{
+		return emplace(std::forward<First>(value.first), std::forward<Second>(value.second));
+	}
+
+	template<typename Iterator>
+	void insert(Iterator first, Iterator last)
+	{
+		for (Iterator iter = first; iter != last; ++iter)
+			insert(*iter);
+	}
+
+	void insert(std::initializer_list<value_type> values)
+	{
+		insert(values.begin(), values.end());
+	}
+
+	template<typename KeyArg, typename MappedArg>
+	std::pair<iterator, bool> emplace(KeyArg&& keyArg, MappedArg&& mappedArg)
+	{
+		return pvInsert(mTreeMap.InsertVar(key_type(std::forward<KeyArg>(keyArg)),
+			std::forward<MappedArg>(mappedArg)));
+	}
+
+	template<typename... MappedArgs>
+	std::pair<iterator, bool> try_emplace(key_type&& key, MappedArgs&&... mappedArgs)
+	{
+		return pvInsert(mTreeMap.InsertVar(std::move(key),
+			std::forward<MappedArgs>(mappedArgs)...));
+	}
+
+	template<typename... MappedArgs>
+	std::pair<iterator, bool> try_emplace(const key_type& key, MappedArgs&&... mappedArgs)
+	{
+		return pvInsert(mTreeMap.InsertVar(key, std::forward<MappedArgs>(mappedArgs)...));
+	}
+
+	template<typename MappedArg>
+	std::pair<iterator, bool> insert_or_assign(key_type&& key, MappedArg&& mappedArg)
+	{
+		return pvInsertOrAssign(std::move(key), std::forward<MappedArg>(mappedArg));
+	}
+
+	template<typename MappedArg>
+	std::pair<iterator, bool> insert_or_assign(const key_type& key, MappedArg&& mappedArg)
+	{
+		return pvInsertOrAssign(key, std::forward<MappedArg>(mappedArg));
+	}
+
+	mapped_type& operator[](key_type&& key)
+	{
+		return try_emplace(std::move(key)).first->second;
+	}
+
+	mapped_type& operator[](const key_type& key)
+	{
+		return try_emplace(key).first->second;
+	}
+
+	const mapped_type& at(const key_type& key) const
+	{
+		const_iterator iter = find(key);
+		if (iter == end())
+			throw std::out_of_range("invalid map key");
+		return iter->second;
+	}
+
+	mapped_type& at(const key_type& key)
+	{
+		iterator iter = find(key);
+		if (iter == end())
+			throw std::out_of_range("invalid map key");
+		return iter->second;
+	}
+
+	iterator erase(const_iterator where)
+	{
+		return IteratorProxy(mTreeMap.Remove(ConstIteratorProxy::GetBaseIterator(where)));
+	}
+
+	iterator erase(iterator where)
+	{
+		return erase(static_cast<const_iterator>(where));
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		while (first != last)
+			first = erase(first);
+		return IteratorProxy(mTreeMap.MakeMutableIterator(
+			ConstIteratorProxy::GetBaseIterator(first)));
+	}
+
+	size_type erase(const key_type& key)
+	{
+		return mTreeMap.Remove(key);
+	}
+
+	bool operator==(const radix_map& right) const
+	{
+		return size() == right.size() && std::equal(begin(), end(), right.begin());
+	}
+
+	bool operator!=(const radix_map& right) const
+	{
+		return !(*this == right);
+	}
+
+private:
+	std::pair<iterator, bool> pvInsert(typename RadixTreeMap::InsertResult res)
+	{
+		return { IteratorProxy(res.iterator), res.inserted };
+	}
+
+	template<typename RKey, typename MappedArg>
+	std::pair<iterator, bool> pvInsertOrAssign(RKey&& key, MappedArg&& mappedArg)
+	{
+		std::pair<iterator, bool> res = try_emplace(std::forward<RKey>(key),
+			std::forward<MappedArg>(mappedArg));
+		if (!res.second)
+			res.first->second = std::forward<MappedArg>(mappedArg);
+		return res;
+	}
+
+private:
+	RadixTreeMap mTreeMap;
+};
+
+#ifdef MOMO_HAS_PMR
+namespace pmr
+{
+	template<typename TKey, typename TMapped>
+	using radix_map = stdish::radix_map<TKey, TMapped,
+		std::pmr::polymorphic_allocator<std::pair<const TKey, TMapped>>>;
+}
+#endif
+
+} // namespace stdish
+
+} // namespace momo
@@ -679,6 +679,19 @@ MOMO_DECLARE_DEDUCTION_GUIDES(multiset)
 
 #endif
 
+#ifdef MOMO_HAS_PMR
+namespace pmr
+{
+	template<typename TKey,
+		typename TLessFunc = std::less<TKey>>
+	using set = stdish::set<TKey, TLessFunc, std::pmr::polymorphic_allocator<TKey>>;
+
+	template<typename TKey,
+		typename TLessFunc = std::less<TKey>>
+	using multiset = stdish::multiset<TKey, TLessFunc, std::pmr::polymorphic_allocator<TKey>>;
+}
+#endif
+
 } // namespace stdish
 
 } // namespace momo
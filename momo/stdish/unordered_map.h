@@ -1041,6 +1041,23 @@ MOMO_DECLARE_DEDUCTION_GUIDES(unordered_map_open)
 
 #endif
 
+#ifdef MOMO_HAS_PMR
+namespace pmr
+{
+	template<typename TKey, typename TMapped,
+		typename THashFunc = HashCoder<TKey>,
+		typename TEqualFunc = std::equal_to<TKey>>
+	using unordered_map = stdish::unordered_map<TKey, TMapped, THashFunc, TEqualFunc,
+		std::pmr::polymorphic_allocator<std::pair<const TKey, TMapped>>>;
+
+	template<typename TKey, typename TMapped,
+		typename THashFunc = HashCoder<TKey>,
+		typename TEqualFunc = std::equal_to<TKey>>
+	using unordered_map_open = stdish::unordered_map_open<TKey, TMapped, THashFunc, TEqualFunc,
+		std::pmr::polymorphic_allocator<std::pair<const TKey, TMapped>>>;
+}
+#endif
+
 } // namespace stdish
 
 } // namespace momo
@@ -724,6 +724,23 @@ MOMO_DECLARE_DEDUCTION_GUIDES(unordered_set_open)
 
 #endif
 
+#ifdef MOMO_HAS_PMR
+namespace pmr
+{
+	template<typename TKey,
+		typename THashFunc = HashCoder<TKey>,
+		typename TEqualFunc = std::equal_to<TKey>>
+	using unordered_set = stdish::unordered_set<TKey, THashFunc, TEqualFunc,
+		std::pmr::polymorphic_allocator<TKey>>;
+
+	template<typename TKey,
+		typename THashFunc = HashCoder<TKey>,
+		typename TEqualFunc = std::equal_to<TKey>>
+	using unordered_set_open = stdish::unordered_set_open<TKey, THashFunc, TEqualFunc,
+		std::pmr::polymorphic_allocator<TKey>>;
+}
+#endif
+
 } // namespace stdish
 
 } // namespace momo
@@ -21,6 +21,10 @@
   But in case of the function `insert`, receiving pair of iterators, it's
   not allowed to pass iterators pointing to the items within the container.
 
+  Non-standard functions `remove_if`, `insert_sorted` and `apply_edits`
+  remove or insert many items in one pass (see `Array::RemoveIf`,
+  `Array::InsertSorted` and `Array::ApplyEdits`).
+
 \**********************************************************/
 
 #pragma once
@@ -421,6 +425,26 @@ public:
 		return SMath::Next(begin(), index);
 	}
 
+	template<typename Predicate>
+	size_type remove_if(const Predicate& pred)
+	{
+		return mArray.RemoveIf(pred);
+	}
+
+	template<typename Iterator,
+		typename LessFunc = std::less<value_type>>
+	void insert_sorted(Iterator first, Iterator last, const LessFunc& lessFunc = LessFunc())
+	{
+		mArray.InsertSorted(first, last, lessFunc);
+	}
+
+	template<typename RemoveIterator, typename InsertIterator>
+	void apply_edits(RemoveIterator removeFirst, RemoveIterator removeLast,
+		InsertIterator insertFirst, InsertIterator insertLast)
+	{
+		mArray.ApplyEdits(removeFirst, removeLast, insertFirst, insertLast);
+	}
+
 	void assign(size_type count, const value_type& value)
 	{
 		mArray = Array(count, value, MemManager(get_allocator()));
@@ -495,6 +519,18 @@ template<size_t tInternalCapacity, typename TValue,
 using vector_intcap = vector<TValue, TAllocator,
 	ArrayIntCap<tInternalCapacity, TValue, MemManagerStd<TAllocator>>>;
 
+#ifdef MOMO_HAS_PMR
+namespace pmr
+{
+	template<typename TValue>
+	using vector = stdish::vector<TValue, std::pmr::polymorphic_allocator<TValue>>;
+
+	template<size_t tInternalCapacity, typename TValue>
+	using vector_intcap = stdish::vector_intcap<tInternalCapacity, TValue,
+		std::pmr::polymorphic_allocator<TValue>>;
+}
+#endif
+
 } // namespace stdish
 
 } // namespace momo
@@ -28,9 +28,11 @@ LIBCXX_TEST_BEGIN(access_index_key)
 #include "libcxx/map/map.access/index_key.pass.cpp"
 LIBCXX_TEST_END
 
+#ifndef LIBCXX_TEST_COPYABLE_KEY
 LIBCXX_TEST_BEGIN(access_index_rv_key)
 #include "libcxx/map/map.access/index_rv_key.pass.cpp"
 LIBCXX_TEST_END
+#endif
 
 LIBCXX_TEST_BEGIN(access_iterator)
 #include "libcxx/map/map.access/iterator.pass.cpp"
@@ -128,13 +130,17 @@ LIBCXX_TEST_BEGIN(cons_move)
 #include "libcxx/map/map.cons/move.pass.cpp"
 LIBCXX_TEST_END
 
+#ifndef LIBCXX_TEST_COPYABLE_KEY
 LIBCXX_TEST_BEGIN(cons_move_alloc)
 #include "libcxx/map/map.cons/move_alloc.pass.cpp"
 LIBCXX_TEST_END
+#endif
 
+#ifndef LIBCXX_TEST_COPYABLE_KEY
 LIBCXX_TEST_BEGIN(cons_move_assign)
 #include "libcxx/map/map.cons/move_assign.pass.cpp"
 LIBCXX_TEST_END
+#endif
 
 //LIBCXX_TEST_BEGIN(cons_move_assign_noexcept)
 //#include "libcxx/map/map.cons/move_assign_noexcept.pass.cpp"
@@ -208,9 +214,11 @@ LIBCXX_TEST_BEGIN(modifiers_insert_node_type_hint)
 #include "libcxx/map/map.modifiers/insert_node_type_hint.pass.cpp"
 LIBCXX_TEST_END
 
+#ifndef LIBCXX_TEST_COPYABLE_KEY
 LIBCXX_TEST_BEGIN(modifiers_insert_or_assign)
 #include "libcxx/map/map.modifiers/insert_or_assign.pass.cpp"
 LIBCXX_TEST_END
+#endif
 
 LIBCXX_TEST_BEGIN(modifiers_insert_rv)
 #include "libcxx/map/map.modifiers/insert_rv.pass.cpp"
@@ -220,9 +228,11 @@ LIBCXX_TEST_BEGIN(modifiers_merge)
 #include "libcxx/map/map.modifiers/merge.pass.cpp"
 LIBCXX_TEST_END
 
+#ifndef LIBCXX_TEST_COPYABLE_KEY
 LIBCXX_TEST_BEGIN(modifiers_try_emplace)
 #include "libcxx/map/map.modifiers/try.emplace.pass.cpp"
 LIBCXX_TEST_END
+#endif
 
 LIBCXX_TEST_BEGIN(ops_count)
 #include "libcxx/map/map.ops/count.pass.cpp"
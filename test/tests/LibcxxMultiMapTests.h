@@ -116,13 +116,17 @@ LIBCXX_TEST_BEGIN(cons_move)
 #include "libcxx/multimap/multimap.cons/move.pass.cpp"
 LIBCXX_TEST_END
 
+#ifndef LIBCXX_TEST_COPYABLE_KEY
 LIBCXX_TEST_BEGIN(cons_move_alloc)
 #include "libcxx/multimap/multimap.cons/move_alloc.pass.cpp"
 LIBCXX_TEST_END
+#endif
 
+#ifndef LIBCXX_TEST_COPYABLE_KEY
 LIBCXX_TEST_BEGIN(cons_move_assign)
 #include "libcxx/multimap/multimap.cons/move_assign.pass.cpp"
 LIBCXX_TEST_END
+#endif
 
 //LIBCXX_TEST_BEGIN(cons_move_assign_noexcept)
 //#include "libcxx/multimap/multimap.cons/move_assign_noexcept.pass.cpp"
@@ -0,0 +1,44 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  tests/LibcxxTreeMapTesterBPlus.cpp
+
+\**********************************************************/
+
+#include "pch.h"
+#include "TestSettings.h"
+
+#ifdef TEST_LIBCXX_TREE_MAP
+
+#undef NDEBUG
+
+#include "../../momo/Utility.h"
+
+#include "LibcxxTester.h"
+
+#include "../../momo/stdish/map.h"
+
+namespace
+{
+
+#define LIBCXX_TEST_PREFIX "libcxx_test_map_bplus"
+#define LIBCXX_TEST_COPYABLE_KEY	// keys of TreeNodeBPlus must be copy constructible
+template<typename TKey, typename TMapped,
+	typename TLessFunc = std::less<TKey>,
+	typename TAllocator = std::allocator<std::pair<const TKey, TMapped>>>
+using map = momo::stdish::map<TKey, TMapped, TLessFunc, TAllocator,
+	momo::TreeMap<TKey, TMapped, momo::TreeTraitsStd<TKey, TLessFunc, false,
+		momo::TreeNodeBPlus<32, 4, momo::MemPoolParams<>, true>>,
+		momo::MemManagerStd<TAllocator>,
+		momo::TreeMapKeyValueTraits<TKey, TMapped, momo::MemManagerStd<TAllocator>>,
+		momo::TreeMapSettings>>;
+#include "LibcxxMapTests.h"
+#undef LIBCXX_TEST_COPYABLE_KEY
+#undef LIBCXX_TEST_PREFIX
+
+} // namespace
+
+#endif // TEST_LIBCXX_TREE_MAP
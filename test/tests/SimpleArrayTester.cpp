@@ -17,12 +17,74 @@
 
 #include "../../momo/Array.h"
 #include "../../momo/SegmentedArray.h"
+#include "../../momo/SegmentedDeque.h"
+#include "../../momo/PackedArray.h"
+#include "../../momo/IndexedHeap.h"
+#include "../../momo/CompressedIntSet.h"
+#include "../../momo/stdish/vector.h"
+#include "../../momo/MemManagerArena.h"
 
 #include <string>
 #include <iostream>
+#include <deque>
+#include <random>
+#include <atomic>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <iterator>
 
 class SimpleArrayTester
 {
+private:
+	class ThrowingMoveItem
+	{
+	public:
+		ThrowingMoveItem(int value = 0)
+			: mValue(value)
+		{
+		}
+
+		ThrowingMoveItem(ThrowingMoveItem&& item) noexcept(false)
+			: mValue(item.mValue)
+		{
+		}
+
+		ThrowingMoveItem(const ThrowingMoveItem& item)
+			: mValue(item.mValue)
+		{
+		}
+
+		~ThrowingMoveItem() noexcept
+		{
+		}
+
+		ThrowingMoveItem& operator=(const ThrowingMoveItem& item)
+		{
+			mValue = item.mValue;
+			return *this;
+		}
+
+		bool operator==(const ThrowingMoveItem& item) const
+		{
+			return mValue == item.mValue;
+		}
+
+		bool operator<(const ThrowingMoveItem& item) const
+		{
+			return mValue < item.mValue;
+		}
+
+		int GetValue() const
+		{
+			return mValue;
+		}
+
+	private:
+		int mValue;
+	};
+
 public:
 	static void TestAll()
 	{
@@ -38,6 +100,19 @@ public:
 		TestStrArray<Array2>();
 		std::cout << "ok" << std::endl;
 
+		std::cout << "momo::Array (3): " << std::flush;
+		typedef momo::Array<std::string, momo::MemManagerArena<>> Array3;
+		TestStrArray<Array3>();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::Array edits: " << std::flush;
+		TestEdits<momo::Array<int>>();
+		TestEdits<momo::Array<std::string>>();
+		TestEdits<momo::ArrayIntCap<4, std::string>>();
+		TestEdits<momo::Array<ThrowingMoveItem>>();
+		TestEdits<momo::stdish::vector<std::string>>();
+		std::cout << "ok" << std::endl;
+
 		std::cout << "momo::SegmentedArray: " << std::flush;
 		typedef momo::SegmentedArray<std::string> SegmentedArray;
 		TestStrArray<SegmentedArray>();
@@ -47,6 +122,602 @@ public:
 		typedef momo::SegmentedArraySqrt<std::string> SegmentedArraySqrt;
 		TestStrArray<SegmentedArraySqrt>();
 		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::SegmentedArray spans: " << std::flush;
+		TestSpans<momo::SegmentedArray<size_t>>();
+		TestSpans<momo::SegmentedArraySqrt<size_t>>();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::PackedArray: " << std::flush;
+		TestPackedArray(momo::PackedArray<3>());
+		TestPackedArray(momo::PackedArray<8>());
+		TestPackedArray(momo::PackedArray<20>());
+		TestPackedArray(momo::PackedArray<64>());
+		TestPackedArray(momo::PackedArray<0>(13));
+		TestPackedArray(momo::PackedArray<0>(1));
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::BitArray: " << std::flush;
+		TestBitArray();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::CompressedIntSet: " << std::flush;
+		TestCompressedIntSet();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::SegmentedDeque: " << std::flush;
+		TestStrDeque<momo::SegmentedDeque<std::string>>();
+		TestStrDeque<momo::SegmentedDeque<std::string, momo::MemManagerDefault,
+			momo::SegmentedArrayItemTraits<std::string, momo::MemManagerDefault>,
+			momo::SegmentedDequeSettings<0, 0>>>();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::IndexedHeap: " << std::flush;
+		TestStrIndexedHeap<momo::IndexedHeap<std::string>>();
+		TestStrIndexedHeap<momo::IndexedHeap<std::string, std::less<std::string>,
+			momo::MemManagerDefault, momo::ArrayItemTraits<std::string, momo::MemManagerDefault>,
+			momo::IndexedHeapSettings<2>>>();
+		std::cout << "ok" << std::endl;
+	}
+
+	template<typename Heap>
+	static void TestStrIndexedHeap()
+	{
+		typedef typename Heap::Handle Handle;
+		std::mt19937 mt;
+		Heap heap;
+		std::map<Handle, std::string> refItems;
+		auto getRefIter = [&mt, &refItems] ()
+		{
+			auto refIter = refItems.begin();
+			std::advance(refIter, mt() % refItems.size());
+			return refIter;
+		};
+		for (size_t i = 0; i < 8192; ++i)
+		{
+			std::string s = std::to_string(mt() % 1000);
+			switch (mt() % 6)
+			{
+			case 0:
+			case 1:
+				{
+					Handle handle = heap.Push(s);
+					assert(refItems.count(handle) == 0);
+					refItems[handle] = s;
+				}
+				break;
+			case 2:
+				if (!refItems.empty())
+				{
+					auto refIter = getRefIter();
+					heap.Update(refIter->first, s);
+					refIter->second = s;
+				}
+				break;
+			case 3:
+				if (!refItems.empty())
+				{
+					auto refIter = getRefIter();
+					heap.Remove(refIter->first);
+					refItems.erase(refIter);
+				}
+				break;
+			case 4:
+				if (!heap.IsEmpty())
+				{
+					Handle handle = heap.GetTopHandle();
+					for (const auto& pair : refItems)
+						assert(!(pair.second < heap.GetTop()));
+					assert(refItems[handle] == heap.GetTop());
+					heap.RemoveTop();
+					refItems.erase(handle);
+				}
+				break;
+			default:
+				if (mt() % 16 == 0)
+				{
+					std::vector<std::string> items(mt() % (refItems.size() < 64 ? 128 : 16));
+					for (std::string& item : items)
+						item = std::to_string(mt() % 1000);
+					std::vector<Handle> handles;
+					heap.PushMany(items.begin(), items.end(), std::back_inserter(handles));
+					for (size_t j = 0; j < items.size(); ++j)
+						refItems[handles[j]] = items[j];
+				}
+				break;
+			}
+			assert(heap.GetCount() == refItems.size());
+			for (const auto& pair : refItems)
+				assert(heap.ContainsHandle(pair.first) && heap.GetItem(pair.first) == pair.second);
+			const std::string* items = &*heap.GetBegin();
+			for (size_t j = 1; j < heap.GetCount(); ++j)
+				assert(!(items[j] < items[(j - 1) / Heap::Settings::arity]));
+		}
+		Heap heap2 = heap;
+		assert(std::equal(heap.GetBegin(), heap.GetEnd(), heap2.GetBegin()));
+		heap.Clear();
+		assert(heap.IsEmpty());
+	}
+
+	template<typename Deque>
+	static void TestStrDeque()
+	{
+		std::mt19937 mt;
+		Deque deq;
+		std::deque<std::string> sdeq;
+		for (size_t i = 0; i < 8192; ++i)
+		{
+			std::string s = std::to_string(i);
+			switch (mt() % 5)
+			{
+			case 0:
+				deq.AddBack(s);
+				sdeq.push_back(s);
+				break;
+			case 1:
+				deq.AddFront(s);
+				sdeq.push_front(s);
+				break;
+			case 2:
+				if (!deq.IsEmpty())
+				{
+					deq.AddFrontVar(deq.GetBackItem());
+					sdeq.push_front(sdeq.back());
+				}
+				break;
+			case 3:
+				if (!deq.IsEmpty())
+				{
+					deq.RemoveBack();
+					sdeq.pop_back();
+				}
+				break;
+			default:
+				if (!deq.IsEmpty())
+				{
+					deq.RemoveFront();
+					sdeq.pop_front();
+				}
+				break;
+			}
+			assert(deq.GetCount() == sdeq.size());
+			if (!deq.IsEmpty())
+			{
+				assert(deq.GetFrontItem() == sdeq.front() && deq.GetBackItem() == sdeq.back());
+				size_t index = mt() % deq.GetCount();
+				assert(deq[index] == sdeq[index]);
+			}
+		}
+		assert(std::equal(deq.GetBegin(), deq.GetEnd(), sdeq.begin()));
+
+		const std::string* front = &deq.GetFrontItem();
+		for (size_t i = 0; i < 1000; ++i)
+			deq.AddBack("s");
+		assert(front == &deq.GetFrontItem());
+
+		Deque deq2(deq);
+		assert(std::equal(deq2.GetBegin(), deq2.GetEnd(), deq.GetBegin()));
+		deq2.RemoveFront(deq2.GetCount() / 2);
+		deq = std::move(deq2);
+		deq2 = deq;
+		deq.Clear(true);
+		assert(deq.IsEmpty());
+		deq = { "s1", "s2" };
+		deq.AddFront("s0");
+		assert(deq.Contains("s0") && deq[1] == "s1" && deq.GetBackItem() == "s2");
+	}
+
+	static int GetEditValue(int value)
+	{
+		return value;
+	}
+
+	static int GetEditValue(const std::string& value)
+	{
+		return std::stoi(value);
+	}
+
+	static int GetEditValue(const ThrowingMoveItem& value)
+	{
+		return value.GetValue();
+	}
+
+	template<typename Item>
+	static Item MakeEditItem(int value)
+	{
+		return MakeEditItem(value, static_cast<Item*>(nullptr));
+	}
+
+	static int MakeEditItem(int value, int*)
+	{
+		return value;
+	}
+
+	static std::string MakeEditItem(int value, std::string*)
+	{
+		return std::to_string(value);
+	}
+
+	static ThrowingMoveItem MakeEditItem(int value, ThrowingMoveItem*)
+	{
+		return ThrowingMoveItem(value);
+	}
+
+	template<typename Array>
+	static void TestEdits(std::false_type /*isVector*/, Array& ar)
+	{
+		typedef typename Array::Item Item;
+		std::mt19937 random;
+		for (size_t t = 0; t < 200; ++t)
+		{
+			ar.Clear();
+			std::vector<int> values;
+			size_t count = random() % 40;
+			for (size_t i = 0; i < count; ++i)
+			{
+				int value = static_cast<int>(random() % 100);
+				values.push_back(value);
+				ar.AddBack(MakeEditItem<Item>(value));
+			}
+			std::vector<size_t> removes;
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (random() % 3 == 0)
+					removes.push_back(i);
+			}
+			std::vector<std::pair<size_t, Item>> inserts;
+			size_t insertCount = random() % 10;
+			for (size_t i = 0; i < insertCount; ++i)
+				inserts.emplace_back(random() % (count + 1), MakeEditItem<Item>(1000 + static_cast<int>(i)));
+			std::stable_sort(inserts.begin(), inserts.end(),
+				[] (const std::pair<size_t, Item>& p1, const std::pair<size_t, Item>& p2)
+					{ return p1.first < p2.first; });
+			std::vector<int> result;
+			auto insertIter = inserts.begin();
+			auto removeIter = removes.begin();
+			for (size_t i = 0; i <= count; ++i)
+			{
+				for (; insertIter != inserts.end() && insertIter->first == i; ++insertIter)
+					result.push_back(GetEditValue(insertIter->second));
+				if (i == count)
+					break;
+				if (removeIter != removes.end() && *removeIter == i)
+					++removeIter;
+				else
+					result.push_back(values[i]);
+			}
+			ar.ApplyEdits(removes.begin(), removes.end(), inserts.begin(), inserts.end());
+			assert(ar.GetCount() == result.size());
+			for (size_t i = 0; i < result.size(); ++i)
+				assert(GetEditValue(ar[i]) == result[i]);
+
+			size_t removeCount = ar.RemoveIf([] (const Item& item) { return GetEditValue(item) % 2 == 0; });
+			result.erase(std::remove_if(result.begin(), result.end(),
+				[] (int value) { return value % 2 == 0; }), result.end());
+			assert(removeCount + result.size() == inserts.size() + count - removes.size());
+			assert(ar.GetCount() == result.size());
+			for (size_t i = 0; i < result.size(); ++i)
+				assert(GetEditValue(ar[i]) == result[i]);
+
+			ar.RemoveIf([] (const Item& item) { return GetEditValue(item) >= 1000; });
+			std::sort(ar.GetBegin(), ar.GetEnd());
+			std::vector<Item> addItems;
+			for (size_t i = 0; i < insertCount; ++i)
+				addItems.push_back(MakeEditItem<Item>(static_cast<int>(random() % 100)));
+			result.clear();
+			for (const Item& item : ar)
+				result.push_back(GetEditValue(item));
+			for (const Item& item : addItems)
+				result.push_back(GetEditValue(item));
+			ar.InsertSorted(addItems.begin(), addItems.end());
+			assert(std::is_sorted(ar.GetBegin(), ar.GetEnd()));
+			std::vector<int> sortedValues;
+			for (const Item& item : ar)
+				sortedValues.push_back(GetEditValue(item));
+			std::sort(result.begin(), result.end());
+			std::sort(sortedValues.begin(), sortedValues.end());
+			assert(sortedValues == result);
+		}
+	}
+
+	template<typename Vector>
+	static void TestEdits(std::true_type /*isVector*/, Vector& vec)
+	{
+		vec = { "5", "3", "1", "4" };
+		assert(vec.remove_if([] (const std::string& s) { return s == "3"; }) == 1);
+		std::sort(vec.begin(), vec.end());
+		std::string strs[] = { "2", "0", "6" };
+		vec.insert_sorted(strs, strs + 3);
+		assert((vec == Vector{ "0", "1", "2", "4", "5", "6" }));
+		size_t removes[] = { 0, 5 };
+		std::pair<size_t, std::string> inserts[] = { { 1, "a" }, { 6, "b" } };
+		vec.apply_edits(removes, removes + 2, std::make_move_iterator(inserts),
+			std::make_move_iterator(inserts + 2));
+		assert((vec == Vector{ "a", "1", "2", "4", "5", "b" }));
+	}
+
+	template<typename Container>
+	static void TestEdits()
+	{
+		Container cont;
+		TestEdits(momo::internal::BoolConstant<std::is_same<Container,
+			momo::stdish::vector<std::string>>::value>(), cont);
+	}
+
+	template<typename PackedArray>
+	static void TestPackedArray(PackedArray&& ar)
+	{
+		typedef typename PackedArray::Value Value;
+		size_t bitCount = ar.GetBitCount();
+		Value mask = (bitCount < 64) ? (Value{1} << bitCount) - 1 : ~Value{0};
+		std::mt19937_64 random;
+		momo::Array<Value> values;
+		for (size_t i = 0; i < 1000; ++i)
+		{
+			Value value = random() & mask;
+			ar.AddBack(value | ~mask);
+			values.AddBack(value);
+		}
+		assert(ar.GetCount() == 1000 && ar.GetCapacity() >= 1000);
+		for (size_t i = 0; i < 1000; ++i)
+			assert(ar[i] == values[i]);
+		for (size_t i = 0; i < 300; ++i)
+		{
+			size_t index = static_cast<size_t>(random() % 1000);
+			values[index] = random() & mask;
+			ar.Set(index, values[index]);
+		}
+		momo::Array<Value> unpacked(1000);
+		for (size_t index : { size_t{0}, size_t{1}, size_t{37}, size_t{999} })
+		{
+			size_t count = static_cast<size_t>(random() % (1000 - index + 1));
+			ar.Unpack(index, count, unpacked.GetItems());
+			for (size_t i = 0; i < count; ++i)
+				assert(unpacked[i] == values[index + i]);
+		}
+		momo::Array<uint32_t> packed;
+		for (size_t i = 0; i < 500; ++i)
+			packed.AddBack(static_cast<uint32_t>(random()));
+		ar.Pack(5, 500, packed.GetItems());
+		for (size_t i = 0; i < 500; ++i)
+			values[5 + i] = packed[i] & mask;
+		for (size_t i = 0; i < 1000; ++i)
+			assert(ar[i] == values[i]);
+		ar.RemoveBack(999);
+		assert(ar.GetCount() == 1 && ar[0] == values[0]);
+		ar.SetCount(300, mask);
+		PackedArray ar2 = ar;
+		ar.Clear();
+		assert(ar.IsEmpty() && ar2.GetCount() == 300 && ar2[0] == values[0]);
+		for (size_t i = 1; i < 300; ++i)
+			assert(ar2[i] == mask);
+		ar = std::move(ar2);
+		ar.SetCount(5);
+		ar.Shrink();
+		ar.SetCount(10);
+		assert(ar[4] == mask && ar[5] == 0 && ar.GetBackItem() == 0);
+	}
+
+	static void TestBitArray()
+	{
+		momo::BitArray<> ar(100, true);
+		assert(ar.GetPopCount() == 100);
+		ar.RemoveBack(30);
+		ar.AddBack(false);
+		ar.AddBack(true);
+		assert(ar.GetCount() == 72 && ar.GetPopCount() == 71);
+		for (size_t i = 0; i < 72; i += 3)
+			ar.Set(i, false);
+		assert(!ar[0] && ar[1] && !ar[69] && ar[71]);
+		size_t rank = 0;
+		for (size_t i = 0; i < 72; ++i)
+		{
+			assert(ar.GetRank(i) == rank);
+			if (ar.Get(i))
+				++rank;
+		}
+		assert(ar.GetRank(72) == rank && ar.GetPopCount() == rank);
+		ar.SetCount(200);
+		assert(ar.GetPopCount() == rank);
+		TestBitArrayRank();
+	}
+
+	static void TestBitArrayRank()
+	{
+		// the ranks cover several blocks and are cut back by every kind of change
+		std::mt19937 mt;
+		momo::BitArray<> ar;
+		std::vector<bool> refAr;
+		auto checkRanks = [&ar, &refAr] ()
+		{
+			assert(ar.GetCount() == refAr.size());
+			size_t rank = 0;
+			for (size_t i = 0; i < refAr.size(); i += 37)
+			{
+				assert(ar.GetRank(i) == rank);
+				rank += static_cast<size_t>(std::count(refAr.begin() + static_cast<ptrdiff_t>(i),
+					refAr.begin() + static_cast<ptrdiff_t>(std::minmax(i + 37, refAr.size()).first), true));
+			}
+			assert(ar.GetRank(refAr.size()) == rank && ar.GetPopCount() == rank);
+		};
+		for (size_t i = 0; i < 3000; ++i)
+		{
+			bool value = mt() % 3 == 0;
+			ar.AddBack(value);
+			refAr.push_back(value);
+		}
+		checkRanks();
+		for (size_t i = 0; i < 200; ++i)
+		{
+			size_t index = mt() % refAr.size();
+			ar.Set(index, !refAr[index]);
+			refAr[index] = !refAr[index];
+			assert(ar.GetRank(refAr.size()) == static_cast<size_t>(std::count(refAr.begin(), refAr.end(), true)));
+		}
+		checkRanks();
+		ar.RemoveBack(1000);
+		refAr.resize(2000);
+		ar.SetCount(2600, true);
+		refAr.resize(2600, true);
+		checkRanks();
+		momo::BitArray<> ar2(ar);
+		std::vector<bool> refAr2 = refAr;
+		ar.SetCount(700);
+		refAr.resize(700);
+		checkRanks();
+		ar.Swap(ar2);
+		refAr.swap(refAr2);
+		checkRanks();
+		ar = ar2;
+		refAr = refAr2;
+		checkRanks();
+		ar.Clear();
+		refAr.clear();
+		checkRanks();
+	}
+
+	static void TestCompressedIntSet()
+	{
+		typedef momo::CompressedIntSet<> CompressedIntSet;
+		std::mt19937 mt;
+		for (size_t i = 0; i < 12; ++i)
+		{
+			std::set<uint32_t> refSet1 = GetRandomIntSet(mt, i % 3);
+			std::set<uint32_t> refSet2 = GetRandomIntSet(mt, (i / 3) % 3);
+			CompressedIntSet set1(refSet1.begin(), refSet1.end());
+			CompressedIntSet set2;
+			for (uint32_t item : refSet2)
+				assert(set2.Insert(item));
+			if (i % 2 == 1)
+				set1.Optimize();
+			if (i % 4 < 2)
+				set2.Optimize();
+			CheckCompressedIntSet(set1, refSet1);
+			CheckCompressedIntSet(set2, refSet2);
+
+			std::set<uint32_t> refSet;
+			std::set_intersection(refSet1.begin(), refSet1.end(), refSet2.begin(), refSet2.end(),
+				std::inserter(refSet, refSet.end()));
+			CheckCompressedIntSet(CompressedIntSet::Intersect(set1, set2), refSet);
+			refSet.clear();
+			std::set_union(refSet1.begin(), refSet1.end(), refSet2.begin(), refSet2.end(),
+				std::inserter(refSet, refSet.end()));
+			CheckCompressedIntSet(CompressedIntSet::Unite(set1, set2), refSet);
+			refSet.clear();
+			std::set_difference(refSet1.begin(), refSet1.end(), refSet2.begin(), refSet2.end(),
+				std::inserter(refSet, refSet.end()));
+			CheckCompressedIntSet(CompressedIntSet::Subtract(set1, set2), refSet);
+
+			std::vector<uint32_t> refItems(refSet1.begin(), refSet1.end());
+			for (size_t j = 0; j < 256 && !refItems.empty(); ++j)
+			{
+				size_t index = mt() % refItems.size();
+				assert(set1.GetItem(index) == refItems[index]);
+				assert(set1.GetRank(refItems[index]) == index);
+				uint32_t item = mt() % (uint32_t{4} << 16);
+				assert(set1.GetRank(item) == static_cast<size_t>(std::lower_bound(refItems.begin(),
+					refItems.end(), item) - refItems.begin()));
+				assert(set1.ContainsKey(item) == (refSet1.count(item) > 0));
+			}
+
+			for (size_t j = 0; j < 4096; ++j)
+			{
+				uint32_t item = ((mt() % 4) << 16) | (mt() % 65536);
+				if (mt() % 2 == 0)
+					assert(set1.Insert(item) == refSet1.insert(item).second);
+				else
+					assert(set1.Remove(item) == (refSet1.erase(item) > 0));
+			}
+			CheckCompressedIntSet(set1, refSet1);
+
+			CompressedIntSet set3 = set1;
+			set1.Clear();
+			CheckCompressedIntSet(set3, refSet1);
+			for (uint32_t item : refSet1)
+				assert(set3.Remove(item));
+			assert(set3.IsEmpty());
+		}
+	}
+
+	static std::set<uint32_t> GetRandomIntSet(std::mt19937& mt, size_t kind)
+	{
+		// sparse, dense or clustered chunks
+		std::set<uint32_t> refSet;
+		size_t count = mt() % 20000;
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint32_t low = (kind == 0) ? mt() % 65536
+				: (kind == 1) ? mt() % 3000 : (mt() % 20) * 1000 + mt() % 300;
+			refSet.insert(((mt() % 4) << 16) | low);
+		}
+		return refSet;
+	}
+
+	template<typename CompressedIntSet>
+	static void CheckCompressedIntSet(const CompressedIntSet& set, const std::set<uint32_t>& refSet)
+	{
+		assert(set.GetCount() == refSet.size());
+		assert(std::equal(refSet.begin(), refSet.end(), set.GetBegin()));
+		assert(static_cast<size_t>(std::distance(set.GetBegin(), set.GetEnd())) == refSet.size());
+	}
+
+	template<typename Array>
+	static void TestSpans()
+	{
+		Array ar;
+		assert(ar.GetSegmentCount() == 0);
+		ar.ForEachSpan([] (typename Array::SegmentBounds) { assert(false); });
+		for (size_t count : { size_t{1}, size_t{31}, size_t{32}, size_t{33}, size_t{1000} })
+		{
+			ar.SetCount(count);
+			for (size_t i = 0; i < count; ++i)
+				ar[i] = i;
+			size_t segCount = ar.GetSegmentCount();
+			size_t index = 0;
+			for (size_t i = 0; i < segCount; ++i)
+			{
+				typename Array::ConstSegmentBounds segment = ar.GetSegment(i);
+				assert(segment.GetCount() > 0);
+				for (size_t item : segment)
+					assert(item == index++);
+			}
+			assert(index == count);
+			const Array& car = ar;
+			index = 0;
+			car.ForEachSpan([&index] (typename Array::ConstSegmentBounds segment)
+				{ index += segment.GetCount(); });
+			assert(index == count);
+			size_t shift = 0;
+			for (size_t threadCount : { size_t{1}, size_t{4} })
+			{
+				++shift;
+				ar.ForEachSpanParallel(threadCount, [] (typename Array::SegmentBounds segment)
+					{ for (size_t& item : segment) ++item; });
+				std::atomic<size_t> sum(0);
+				car.ForEachSpanParallel(threadCount, [&sum] (typename Array::ConstSegmentBounds segment)
+				{
+					size_t segSum = 0;
+					for (size_t item : segment)
+						segSum += item;
+					sum += segSum;
+				});
+				assert(sum == count * (count - 1) / 2 + count * shift);
+			}
+			bool thrown = false;
+			try
+			{
+				car.ForEachSpanParallel(4, [] (typename Array::ConstSegmentBounds segment)
+				{
+					if (segment[0] % 2 == 0)
+						throw std::runtime_error("span");
+				});
+			}
+			catch (const std::runtime_error&)
+			{
+				thrown = true;
+			}
+			assert(thrown);
+		}
 	}
 
 	template<typename Array>
@@ -94,6 +765,8 @@ public:
 		ar.Clear();
 		assert(ar.IsEmpty());
 		ar.AddBack(std::move(s1));
+		for (size_t i = 0; i < 16; ++i)
+			ar.AddBackVar(ar[i]);
 		for (std::string& s : ar)
 			assert(s == "s1");
 	}
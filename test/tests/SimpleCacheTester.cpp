@@ -0,0 +1,227 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  tests/SimpleCacheTester.cpp
+
+\**********************************************************/
+
+#include "pch.h"
+#include "TestSettings.h"
+
+#ifdef TEST_SIMPLE_CACHE
+
+#undef NDEBUG
+
+#include "../../momo/LruCache.h"
+
+#include <string>
+#include <iostream>
+#include <random>
+#include <list>
+#include <vector>
+#include <thread>
+
+class SimpleCacheTester
+{
+public:
+	static void TestAll()
+	{
+		std::mt19937 mt;
+
+		std::cout << "momo::LruCache: " << std::flush;
+		TestLruCache();
+		TestStrLruCache(mt, 1);
+		TestStrLruCache(mt, 7);
+		TestStrLruCache(mt, 64);
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::ClockCache: " << std::flush;
+		TestClockCache(mt);
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::ConcurrentLruCache: " << std::flush;
+		TestConcurrentLruCache();
+		TestConcurrentLruCacheHashing();
+		std::cout << "ok" << std::endl;
+	}
+
+	static void TestLruCache()
+	{
+		momo::LruCache<int, std::string> cache(3);
+		std::vector<int> evictedKeys;
+		cache.SetEvictFunc([&evictedKeys] (const int& key, std::string& /*value*/)
+			{ evictedKeys.push_back(key); });
+		cache.Insert(1, "a");
+		cache.Insert(2, "b");
+		cache.Insert(3, "c");
+		assert(*cache.Find(1) == "a");
+		cache.Insert(4, "d");
+		assert(evictedKeys == std::vector<int>({ 2 }));
+		assert(*cache.Peek(3) == "c");
+		cache.Insert(5, "e", 2);
+		assert(evictedKeys == std::vector<int>({ 2, 3, 1 }));
+		assert(cache.GetCount() == 2 && cache.GetSize() == 3);
+		cache.Insert(4, "dd", 2);
+		assert(evictedKeys == std::vector<int>({ 2, 3, 1, 5 }));
+		assert(*cache.Find(4) == "dd");
+		cache.Insert(6, "f", 10);
+		assert(cache.GetCount() == 1 && cache.GetSize() == 10);
+		assert(!cache.Remove(4));
+		assert(cache.Remove(6));
+		assert(cache.IsEmpty() && cache.GetSize() == 0);
+		assert(evictedKeys.size() == 5);
+	}
+
+	static void TestStrLruCache(std::mt19937& mt, size_t maxCount)
+	{
+		typedef momo::LruCache<std::string, std::string> LruCache;
+		LruCache cache(maxCount);
+		std::list<std::pair<std::string, std::string>> refList;	// most recent first
+		for (size_t i = 0; i < 10000; ++i)
+		{
+			std::string key = std::to_string(mt() % 100);
+			auto refIter = refList.begin();
+			while (refIter != refList.end() && refIter->first != key)
+				++refIter;
+			bool found = refIter != refList.end();
+			switch (mt() % 4)
+			{
+			case 0:
+				{
+					std::string* value = cache.Find(key);
+					assert((value != nullptr) == found);
+					if (found)
+					{
+						assert(*value == refIter->second);
+						refList.splice(refList.begin(), refList, refIter);
+					}
+				}
+				break;
+			case 1:
+				assert(cache.Remove(key) == found);
+				if (found)
+					refList.erase(refIter);
+				break;
+			default:
+				{
+					std::string value = key + std::string(mt() % 32, 'v');
+					cache.Insert(key, value);
+					if (found)
+						refList.erase(refIter);
+					refList.emplace_front(key, value);
+					if (refList.size() > maxCount)
+						refList.pop_back();
+				}
+			}
+			assert(cache.GetCount() == refList.size());
+			assert(cache.GetSize() == refList.size());
+			for (const auto& pair : refList)
+				assert(*cache.Peek(pair.first) == pair.second);
+		}
+		LruCache cache2(std::move(cache));
+		cache = std::move(cache2);
+		cache.SetMaxSize(1);
+		assert(cache.GetCount() == 1);
+		assert(cache.ContainsKey(refList.front().first));
+		cache.Clear();
+		assert(cache.IsEmpty());
+	}
+
+	static void TestClockCache(std::mt19937& mt)
+	{
+		momo::ClockCache<int, int> cache(4);
+		std::vector<int> evictedKeys;
+		cache.SetEvictFunc([&evictedKeys] (const int& key, int& /*value*/)
+			{ evictedKeys.push_back(key); });
+		for (int i = 0; i < 4; ++i)
+			cache.Insert(i, i);
+		cache.Find(0);
+		cache.Find(2);
+		cache.Insert(4, 4);
+		cache.Insert(5, 5);
+		cache.Insert(6, 6);
+		assert(evictedKeys == std::vector<int>({ 1, 3, 0 }));
+		for (size_t i = 0; i < 10000; ++i)
+		{
+			int key = static_cast<int>(mt() % 16);
+			int* value = cache.Find(key);
+			if (value != nullptr)
+				assert(*value == key);
+			else
+				cache.Insert(key, key);
+			assert(cache.GetCount() == 4);
+		}
+	}
+
+	static void TestConcurrentLruCache()
+	{
+		typedef momo::ConcurrentLruCache<momo::LruCache<int, int>, 8> ConcurrentLruCache;
+		ConcurrentLruCache cache(800);
+		std::vector<std::thread> threads;
+		for (unsigned int t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&cache, t] ()
+			{
+				std::mt19937 mt(t);
+				for (size_t i = 0; i < 20000; ++i)
+				{
+					int key = static_cast<int>(mt() % 2000);
+					int value;
+					if (cache.Find(key, value))
+						assert(value == 3 * key);
+					else
+						cache.Insert(key, 3 * key);
+					if (i % 97 == 0)
+						cache.Remove(key);
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		assert(cache.GetCount() <= 800);
+		cache.Clear();
+		assert(cache.GetCount() == 0);
+	}
+
+	class CountingHashTraits : public momo::HashTraits<int>
+	{
+	public:
+		explicit CountingHashTraits(size_t& hashCount) noexcept
+			: mHashCount(&hashCount)
+		{
+		}
+
+		size_t GetHashCode(int key) const
+		{
+			++*mHashCount;
+			return momo::HashTraits<int>::GetHashCode(key);
+		}
+
+	private:
+		size_t* mHashCount;
+	};
+
+	static void TestConcurrentLruCacheHashing()
+	{
+		typedef momo::ConcurrentLruCache<momo::LruCache<int, int, CountingHashTraits>, 4> ConcurrentLruCache;
+		size_t hashCount = 0;
+		ConcurrentLruCache cache(100, CountingHashTraits(hashCount));
+		for (int key = 0; key < 200; ++key)
+			cache.Insert(key, key);
+		assert(hashCount == 200);
+		int value;
+		assert(cache.Find(199, value) && value == 199);
+		assert(cache.ContainsKey(199));
+		assert(cache.Remove(199));
+		assert(!cache.ContainsKey(199));
+		assert(hashCount == 204);
+		assert(cache.GetCount() <= 100);
+	}
+};
+
+static int testSimpleCache = (SimpleCacheTester::TestAll(), 0);
+
+#endif // TEST_SIMPLE_CACHE
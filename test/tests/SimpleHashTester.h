@@ -11,6 +11,8 @@
 #include "../../momo/HashSet.h"
 #include "../../momo/HashMap.h"
 #include "../../momo/HashMultiMap.h"
+#include "../../momo/String.h"
+#include "../../momo/MemManagerPooled.h"
 
 #include <string>
 #include <iostream>
@@ -112,6 +114,67 @@ public:
 		std::cout << "ok" << std::endl;
 	}
 
+	template<typename HashBucket>
+	static void TestMomoStrHash(const char* bucketName)
+	{
+		std::cout << bucketName << ": momo::String: " << std::flush;
+		TestMomoStrHashSet<momo::MemManagerDefault, HashBucket>(momo::MemManagerDefault());
+		momo::MemManagerPooled<> memManager;
+		typedef momo::MemManagerPooled<>::Ptr MemManagerPtr;
+		TestMomoStrHashSet<MemManagerPtr, HashBucket>(MemManagerPtr(memManager));
+		std::cout << "ok" << std::endl;
+	}
+
+	template<typename MemManager, typename HashBucket>
+	static void TestMomoStrHashSet(const MemManager& memManager)
+	{
+		typedef momo::String<MemManager> String;
+		MOMO_STATIC_ASSERT(momo::IsTriviallyRelocatable<String>::value);
+
+		typedef momo::HashTraits<String, HashBucket> HashTraits;
+		typedef momo::HashSet<String, HashTraits> HashSet;
+		MOMO_STATIC_ASSERT(HashTraits::isFastNothrowHashable);
+
+		static const size_t count = 1 << 10;
+		std::string refStrs[count];
+		HashSet set;
+		for (size_t i = 0; i < count; ++i)
+		{
+			std::string& refStr = refStrs[i];
+			refStr = std::to_string(i) + std::string(i % 40, static_cast<char>('a' + i % 26));
+			String str(refStr, MemManager(memManager));
+			assert(str.GetCount() == refStr.size());
+			assert(str.GetCapacity() >= String::internalCapacity);
+			assert(std::string(str.GetChars()) == refStr);
+			assert(str.GetHashCode() == HashTraits().GetHashCode(refStr.c_str()));
+			assert(set.Insert(std::move(str)).inserted);
+		}
+		for (const std::string& refStr : refStrs)
+		{
+			assert(set.ContainsKey(refStr.c_str()));
+			assert(*set.Find(refStr.c_str()) == refStr.c_str());
+		}
+		assert(!set.ContainsKey("a"));
+
+		String str(std::string(String::internalCapacity, 'x'), MemManager(memManager));
+		assert(str.GetCapacity() == String::internalCapacity);
+		size_t hashCode = str.GetHashCode();
+		str.Append(str.GetChars(), str.GetCount());
+		assert(str.GetCount() == 2 * String::internalCapacity);
+		assert(str.GetHashCode() != hashCode);
+		str = String(str.GetChars(), String::internalCapacity, MemManager(memManager));
+		assert(str.GetHashCode() == hashCode);
+		str += str;
+		String str2 = str;
+		assert(str2 == str && !(str2 < str) && str.GetHashCode() == str2.GetHashCode());
+		str2.Clear();
+		assert(str2.IsEmpty() && str2 < str && str2 == "");
+		str2.Clear(true);
+		assert(str2.GetCapacity() == String::internalCapacity);
+		str.Swap(str2);
+		assert(str.IsEmpty() && str2.GetCount() == 2 * String::internalCapacity);
+	}
+
 	template<typename HashTraits>
 	static void TestStrHashSet()
 	{
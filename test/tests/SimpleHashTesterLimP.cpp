@@ -26,6 +26,7 @@
 static int testSimpleHash = []
 {
 	SimpleHashTester::TestStrHash<momo::HashBucketLimP<sizeof(void*), momo::MemPoolParams<>, false>>("momo::HashBucketLimP<..., false>");
+	SimpleHashTester::TestMomoStrHash<momo::HashBucketLimP<sizeof(void*), momo::MemPoolParams<>, false>>("momo::HashBucketLimP<..., false>");
 	SimpleHashTester::TestStrHash<momo::HashBucketLimP<sizeof(void*), momo::MemPoolParams<>,  true>>("momo::HashBucketLimP<...,  true>");
 	SimpleHashTester::TestStrHash<momo::HashBucketLimP<1, momo::MemPoolParams<>, false>>("momo::HashBucketLimP<1, ..., false>");
 	SimpleHashTester::TestStrHash<momo::HashBucketLimP<1, momo::MemPoolParams<>,  true>>("momo::HashBucketLimP<1, ...,  true>");
@@ -23,6 +23,7 @@
 static int testSimpleHash = []
 {
 	SimpleHashTester::TestStrHash<momo::HashBucketOneI1>("momo::HashBucketOneI1");
+	SimpleHashTester::TestMomoStrHash<momo::HashBucketOneI1>("momo::HashBucketOneI1");
 
 	SimpleHashTester::TestTemplHashSet<momo::HashBucketOneI1, 1, 1>("momo::HashBucketOneI1");
 	SimpleHashTester::TestTemplHashSet<momo::HashBucketOneI1, 4, 2>("momo::HashBucketOneI1");
@@ -23,6 +23,7 @@
 static int testSimpleHash = []
 {
 	SimpleHashTester::TestStrHash<momo::HashBucketOneIA<>>("momo::HashBucketOneIA<>");
+	SimpleHashTester::TestMomoStrHash<momo::HashBucketOneIA<>>("momo::HashBucketOneIA<>");
 	SimpleHashTester::TestStrHash<momo::HashBucketOneIA<1>>("momo::HashBucketOneIA<1>");
 
 	SimpleHashTester::TestTemplHashSet<momo::HashBucketOneIA<0>, 1, 1>("momo::HashBucketOneIA<0>");
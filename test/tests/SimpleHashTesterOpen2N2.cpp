@@ -22,6 +22,7 @@
 static int testSimpleHash = []
 {
 	SimpleHashTester::TestStrHash<momo::HashBucketOpen2N2<>>("momo::HashBucketOpen2N2<>");
+	SimpleHashTester::TestMomoStrHash<momo::HashBucketOpen2N2<>>("momo::HashBucketOpen2N2<>");
 	SimpleHashTester::TestStrHash<momo::HashBucketOpen2N2<1>>("momo::HashBucketOpen2N2<1>");
 
 	SimpleHashTester::TestTemplHashSet<momo::HashBucketOpen2N2<1>, 4, 2>("momo::HashBucketOpen2N2<1>");
@@ -22,6 +22,7 @@
 static int testSimpleHash = []
 {
 	SimpleHashTester::TestStrHash<momo::HashBucketOpen8>("momo::HashBucketOpen8");
+	SimpleHashTester::TestMomoStrHash<momo::HashBucketOpen8>("momo::HashBucketOpen8");
 
 	SimpleHashTester::TestTemplHashSet<momo::HashBucketOpen8, 4, 2>("momo::HashBucketOpen8");
 	SimpleHashTester::TestTemplHashSet<momo::HashBucketOpen8, 1, 1>("momo::HashBucketOpen8");
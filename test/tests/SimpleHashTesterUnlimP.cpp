@@ -26,6 +26,7 @@
 static int testSimpleHash = []
 {
 	SimpleHashTester::TestStrHash<momo::HashBucketUnlimP<>>("momo::HashBucketUnlimP<>");
+	SimpleHashTester::TestMomoStrHash<momo::HashBucketUnlimP<>>("momo::HashBucketUnlimP<>");
 	SimpleHashTester::TestStrHash<momo::HashBucketUnlimP<1>>("momo::HashBucketUnlimP<1>");
 
 	SimpleHashTester::TestTemplHashSet<BUCKET( 1, 32),  1, 1>("momo::HashBucketUnlimP< 1, 32>");
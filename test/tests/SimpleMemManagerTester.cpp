@@ -0,0 +1,364 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  tests/SimpleMemManagerTester.cpp
+
+\**********************************************************/
+
+#include "pch.h"
+#include "TestSettings.h"
+
+#ifdef TEST_SIMPLE_MEM_MANAGER
+
+#undef NDEBUG
+
+#include "../../momo/MemManagerArena.h"
+#include "../../momo/MemManagerCounting.h"
+#include "../../momo/MemManagerPooled.h"
+#include "../../momo/StringPool.h"
+#include "../../momo/Array.h"
+#include "../../momo/HashSet.h"
+#include "../../momo/HashMap.h"
+#include "../../momo/TreeSet.h"
+#include "../../momo/stdish/vector.h"
+#include "../../momo/stdish/set.h"
+#include "../../momo/stdish/map.h"
+#include "../../momo/stdish/unordered_set.h"
+#include "../../momo/stdish/unordered_map.h"
+#include "../../momo/stdish/unordered_multimap.h"
+#include "../../momo/stdish/radix_map.h"
+
+#include <string>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+class SimpleMemManagerTester
+{
+public:
+	static void TestAll()
+	{
+#ifdef MOMO_USE_MEM_MANAGER_MMAP
+		std::cout << "momo::MemManagerMmap: " << std::flush;
+		TestMemManager<momo::MemManagerMmap<4096>>();
+		TestMemManager<momo::MemManagerMmap<4096, true>>();
+		std::cout << "ok" << std::endl;
+#endif
+
+		std::cout << "momo::MemManagerArena: " << std::flush;
+		TestMemManager<momo::MemManagerArena<momo::MemManagerDefault, 4096>>();
+		TestArenaPtr();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::MemManagerPooled: " << std::flush;
+		TestPooledSizeClasses();
+		TestMemManager<momo::MemManagerPooled<>>();
+		TestMemManager<momo::MemManagerPooled<momo::MemManagerC, 256, 32>>();
+		TestPooledPtr();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::MemManagerCounting: " << std::flush;
+		TestMemManager<momo::MemManagerCounting<momo::MemManagerPooled<>>>();
+		TestMemManager<momo::MemManagerCounting<momo::MemManagerArena<>>>();
+		TestCounting<momo::MemManagerCounting<>>();
+		TestCounting<momo::MemManagerCounting<momo::MemManagerStd<std::allocator<char>>, true>>();
+		TestCountingThreads();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::StringPool: " << std::flush;
+		TestStringPool<momo::MemManagerDefault>(momo::MemManagerDefault());
+		{
+			momo::MemManagerPooled<> pooled;
+			typedef momo::MemManagerPooled<>::Ptr MemManagerPtr;
+			TestStringPool<MemManagerPtr>(MemManagerPtr(pooled));
+		}
+		std::cout << "ok" << std::endl;
+
+#ifdef MOMO_HAS_PMR
+		std::cout << "momo::MemManagerPmr: " << std::flush;
+		TestPmr();
+		std::cout << "ok" << std::endl;
+#endif
+	}
+
+	template<typename MemManager>
+	static void TestMemManager()
+	{
+		typedef momo::internal::MemManagerProxy<MemManager> MemManagerProxy;
+
+		MemManager memManager;
+
+		static const size_t sizes[] = { 24, 1000, 4096, 6000, 1 << 20, 3 << 20, 100, 1 << 16 };
+		size_t size = sizes[0];
+		char* ptr = MemManagerProxy::template Allocate<char>(memManager, size);
+		memset(ptr, 1, size);
+		for (size_t newSize : sizes)
+		{
+			if (!MemManagerProxy::ReallocateInplace(memManager, ptr, size, newSize))
+				ptr = MemManagerProxy::template Reallocate<char>(memManager, ptr, size, newSize);
+			for (size_t i = 0; i < std::minmax(size, newSize).first; ++i)
+				assert(ptr[i] == 1);
+			if (newSize > size)
+				memset(ptr + size, 1, newSize - size);
+			size = newSize;
+		}
+		MemManagerProxy::Deallocate(memManager, ptr, size);
+
+		{
+			momo::Array<uint32_t, MemManager> array;
+			for (uint32_t i = 0; i < (1 << 18); ++i)
+				array.AddBack(i);
+			for (uint32_t i = 0; i < (1 << 18); ++i)
+				assert(array[i] == i);
+			array.Shrink();
+			array.SetCount(16);
+			array.Shrink();
+			assert(array.GetCount() == 16 && array[15] == 15);
+		}
+
+		{
+			momo::HashSet<std::string, momo::HashTraits<std::string>, MemManager> set;
+			for (size_t i = 0; i < (1 << 14); ++i)
+				set.Insert(std::to_string(i));
+			assert(set.GetCount() == (1 << 14));
+			for (size_t i = 0; i < (1 << 14); i += 2)
+				assert(set.Remove(std::to_string(i)));
+			assert(set.ContainsKey("1") && !set.ContainsKey("0"));
+		}
+	}
+
+	static void TestArenaPtr()
+	{
+		typedef momo::MemManagerArena<momo::MemManagerC, 4096> MemManagerArena;
+		typedef MemManagerArena::Ptr MemManagerPtr;
+
+		MemManagerArena arena;
+		for (size_t r = 0; r < 4; ++r)
+		{
+			TestMemManagerPtr<MemManagerPtr>(MemManagerPtr(arena), 1024 * (r + 1));
+			arena.Reset();
+		}
+	}
+
+	static void TestPooledSizeClasses()
+	{
+		typedef momo::internal::MemManagerPooledSizeClasses SizeClasses;
+
+		const size_t maxSize = 1 << 16;
+		assert(SizeClasses::GetIndex(maxSize) + 1 == SizeClasses::GetCount(maxSize));
+		for (size_t size = 1; size <= maxSize; ++size)
+		{
+			size_t index = SizeClasses::GetIndex(size);
+			assert(SizeClasses::GetSize(index) >= size);
+			assert(index == 0 || SizeClasses::GetSize(index - 1) < size);
+			assert(SizeClasses::GetSize(index) % 16 == 0);
+		}
+	}
+
+	static void TestPooledPtr()
+	{
+		typedef momo::MemManagerPooled<> MemManagerPooled;
+		typedef MemManagerPooled::Ptr MemManagerPtr;
+
+		MemManagerPooled pooled;
+		for (size_t r = 0; r < 4; ++r)
+			TestMemManagerPtr<MemManagerPtr>(MemManagerPtr(pooled), 1024 * (r + 1));
+		MemManagerPooled pooled2(std::move(pooled));
+		TestMemManagerPtr<MemManagerPtr>(MemManagerPtr(pooled2), 1024);
+	}
+
+	template<typename MemManager>
+	static void TestStringPool(const MemManager& memManager)
+	{
+		typedef momo::StringPool<MemManager> StringPool;
+		typedef typename StringPool::Handle Handle;
+		MOMO_STATIC_ASSERT(sizeof(Handle) == 4 && std::is_trivially_copyable<Handle>::value);
+
+		StringPool pool((MemManager(memManager)));
+		Handle handle1 = pool.Intern("host1");
+		Handle handle2 = pool.Intern(std::string("host1").c_str());
+		assert(handle1 == handle2 && handle1.GetValue() == 0);
+		const char* chars1 = pool.GetChars(handle1);
+		assert(pool.Intern("host", 4) != handle1);
+		assert(pool.Intern("ho\0st", 5) != pool.Intern("ho"));
+		assert(pool.Find("host2").IsNull());
+
+		static const size_t count = 1 << 12;
+		for (size_t i = 0; i < count; ++i)
+			pool.Intern(std::to_string(i).c_str());
+		assert(pool.GetCount() == count + 4);
+		assert(pool.GetChars(handle1) == chars1 && std::string(chars1) == "host1");
+		for (size_t i = 0; i < count; ++i)
+		{
+			std::string str = std::to_string(i);
+			Handle handle = pool.Find(str.c_str(), str.size());
+			assert(handle.GetValue() == i + 4);
+			const char* chars = pool.GetChars(handle);
+			assert(chars == str && StringPool::GetCount(chars) == str.size());
+			assert(StringPool::GetHandle(chars) == handle);
+			assert(pool.GetHashCode(handle) == momo::String<>(str).GetHashCode());
+		}
+
+		momo::HashMap<Handle, size_t> hashMap;
+		hashMap[handle1] = 1;
+		hashMap[pool.Find("0")] = 2;
+		assert(hashMap[pool.Intern("host1")] == 1);
+		momo::TreeSet<Handle> treeSet = { pool.Find("1"), handle1 };
+		assert(*treeSet.GetBegin() == handle1);
+
+		StringPool pool2(std::move(pool));
+		assert(pool.IsEmpty() && pool2.Find("host1") == handle1);
+		pool2.Clear();
+		assert(pool2.IsEmpty() && pool2.Find("host1").IsNull());
+		assert(pool2.Intern("host2").GetValue() == 0);
+	}
+
+	template<typename MemManager>
+	static void TestCounting()
+	{
+		typedef momo::internal::MemManagerProxy<MemManager> MemManagerProxy;
+		typedef typename MemManager::Stats Stats;
+
+		MemManager memManager;
+		void* ptr1 = MemManagerProxy::Allocate(memManager, 1);
+		void* ptr2 = MemManagerProxy::Allocate(memManager, 100);
+		void* ptr3 = MemManagerProxy::Allocate(memManager, 1 << 30);
+		MemManagerProxy::Deallocate(memManager, ptr3, 1 << 30);
+		Stats stats = memManager.GetStats();
+		assert(stats.allocateCount == 3 && stats.deallocateCount == 1);
+		assert(stats.liveSize == 101 && stats.peakSize == 101 + (1 << 30));
+		assert(stats.sizeHistogram[0] == 1 && stats.sizeHistogram[7] == 1);
+		assert(stats.sizeHistogram[Stats::histogramSize - 1] == 1);
+		memManager.ResetPeakSize();
+		assert(memManager.GetPeakSize() == 101);
+		MemManagerProxy::Deallocate(memManager, ptr1, 1);
+		MemManagerProxy::Deallocate(memManager, ptr2, 100);
+		assert(memManager.GetLiveSize() == 0);
+
+		typedef momo::HashMap<size_t, std::string, momo::HashTraits<size_t>, MemManager> HashMap;
+		HashMap map;
+		for (size_t i = 0; i < 1024; ++i)
+			map.Insert(i, std::to_string(i));
+		size_t liveSize = map.GetMemManager().GetLiveSize();
+		assert(liveSize >= 1024 * (sizeof(size_t) + sizeof(std::string)));
+		HashMap map2(std::move(map));
+		assert(map2.GetMemManager().GetLiveSize() == liveSize);
+		HashMap map3(map2);
+		assert(map3.GetMemManager().GetLiveSize() > 0);
+		map2.Clear(true);
+		assert(map2.GetMemManager().GetLiveSize() < liveSize);
+		assert(map2.GetMemManager().GetPeakSize() >= liveSize);
+	}
+
+	static void TestCountingThreads()
+	{
+		typedef momo::MemManagerCounting<momo::MemManagerDefault, true> MemManagerCounting;
+		typedef MemManagerCounting::Ptr MemManagerPtr;
+
+		static const size_t threadCount = 4;
+		static const size_t count = 1 << 12;
+
+		MemManagerCounting memManager;
+		auto worker = [&memManager] ()
+		{
+			momo::Array<uint64_t, MemManagerPtr> array((MemManagerPtr(memManager)));
+			for (size_t i = 0; i < count; ++i)
+				array.AddBack(uint64_t{i});
+		};
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back(worker);
+		for (std::thread& thread : threads)
+			thread.join();
+		MemManagerCounting::Stats stats = memManager.GetStats();
+		assert(stats.liveSize == 0);
+		assert(stats.allocateCount == stats.deallocateCount);
+		assert(stats.peakSize >= count * sizeof(uint64_t));
+	}
+
+#ifdef MOMO_HAS_PMR
+	static void TestPmr()
+	{
+		// all memory comes from the buffer, the upstream resource throws on any request
+		static char buffer[1 << 22];
+		std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer),
+			std::pmr::null_memory_resource());
+
+		{
+			typedef momo::HashMap<size_t, std::string, momo::HashTraits<size_t>,
+				momo::MemManagerPmr> HashMap;
+			HashMap map((momo::HashTraits<size_t>()), momo::MemManagerPmr(&resource));
+			for (size_t i = 0; i < 1024; ++i)
+				map.Insert(i, std::to_string(i));
+			HashMap map2(map);
+			assert(map2.GetMemManager().GetMemoryResource() == &resource);
+			assert(map2.GetCount() == 1024 && map2.Find(1000)->value == "1000");
+		}
+
+		{
+			momo::stdish::pmr::vector<int> vector(&resource);
+			momo::stdish::pmr::set<int> set(&resource);
+			momo::stdish::pmr::multiset<int> multiset(&resource);
+			momo::stdish::pmr::map<int, int> map(&resource);
+			momo::stdish::pmr::multimap<int, int> multimap(&resource);
+			momo::stdish::pmr::unordered_set<int> unorderedSet(&resource);
+			momo::stdish::pmr::unordered_map<int, int> unorderedMap(&resource);
+			momo::stdish::pmr::unordered_multimap<int, int> unorderedMultiMap(&resource);
+			momo::stdish::pmr::radix_map<int, int> radixMap(&resource);
+			for (int i = 0; i < 1024; ++i)
+			{
+				vector.push_back(i);
+				set.insert(i);
+				multiset.insert(i);
+				map.emplace(i, i);
+				multimap.emplace(i, i);
+				unorderedSet.insert(i);
+				unorderedMap.emplace(i, i);
+				unorderedMultiMap.emplace(i, i);
+				radixMap.emplace(i, i);
+			}
+			assert(vector.get_allocator().resource() == &resource);
+			assert(unorderedMap.get_allocator().resource() == &resource);
+			assert(vector.size() == 1024 && set.size() == 1024 && multiset.size() == 1024);
+			assert(map.size() == 1024 && multimap.size() == 1024 && unorderedSet.size() == 1024);
+			assert(unorderedMap.size() == 1024 && unorderedMultiMap.size() == 1024);
+			assert(radixMap.size() == 1024 && radixMap[1000] == 1000);
+
+			// copy construction selects the default resource, as in `std::pmr` containers
+			momo::stdish::pmr::unordered_map<int, int> unorderedMap2(unorderedMap);
+			assert(unorderedMap2.get_allocator().resource() == std::pmr::get_default_resource());
+			assert(unorderedMap2 == unorderedMap);
+		}
+	}
+#endif
+
+	template<typename MemManagerPtr>
+	static void TestMemManagerPtr(const MemManagerPtr& memManagerPtr, size_t count)
+	{
+		momo::Array<std::string, MemManagerPtr> array((MemManagerPtr(memManagerPtr)));
+		momo::HashMap<size_t, std::string, momo::HashTraits<size_t>, MemManagerPtr> map(
+			(momo::HashTraits<size_t>()), MemManagerPtr(memManagerPtr));
+		momo::TreeSet<size_t, momo::TreeTraits<size_t>, MemManagerPtr> set(
+			(momo::TreeTraits<size_t>()), MemManagerPtr(memManagerPtr));
+		for (size_t i = 0; i < count; ++i)
+		{
+			array.AddBack(std::to_string(i));
+			map.Insert(i, array.GetBackItem());
+			set.Insert(i);
+		}
+		for (size_t i = 0; i < array.GetCount(); ++i)
+		{
+			assert(map.Find(i)->value == array[i]);
+			assert(set.ContainsKey(i));
+		}
+		auto map2 = map;
+		assert(map2.GetCount() == map.GetCount());
+	}
+};
+
+static int testSimpleMemManager = (SimpleMemManagerTester::TestAll(), 0);
+
+#endif // TEST_SIMPLE_MEM_MANAGER
@@ -0,0 +1,382 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  tests/SimpleMemPoolTester.cpp
+
+\**********************************************************/
+
+#include "pch.h"
+#include "TestSettings.h"
+
+#ifdef TEST_SIMPLE_MEM_POOL
+
+#undef NDEBUG
+
+#include "../../momo/ConcurrentMemPool.h"
+#include "../../momo/stdish/pool_allocator.h"
+#include "../../momo/HashSet.h"
+#include "../../momo/TreeSet.h"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SimpleMemPoolTester
+{
+public:
+	static void TestAll()
+	{
+		std::cout << "momo::MemPool (large buffers): " << std::flush;
+		TestLargeMemPool<momo::MemPoolParams<512, 0>>(8, 8);
+		TestLargeMemPool<momo::MemPoolParams<1024>>(24, 8);
+		TestLargeMemPool<momo::MemPoolParams<4096, 4>>(1, 1);
+		TestLargeMemPool<momo::MemPoolParams<128, 0>>(48, 64);
+		TestLargeContainers();
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::MemPool (stats and compaction): " << std::flush;
+		TestCompact<momo::MemPoolParams<32>>(24, 8);
+		TestCompact<momo::MemPoolParams<127, 0>>(8, 8);
+		TestCompact<momo::MemPoolParams<512, 0>>(16, 8);
+		TestCompact<momo::MemPoolParams<1, 0>>(16, 8);
+		std::cout << "ok" << std::endl;
+
+		TestConcurrentAll();
+	}
+
+	template<typename MemPoolParams>
+	static void TestLargeMemPool(size_t blockSize, size_t blockAlignment)
+	{
+		typedef momo::MemPool<MemPoolParams> MemPool;
+
+		MemPool memPool((MemPoolParams(blockSize, blockAlignment)));
+		assert(memPool.GetBlockSize() == momo::internal::UIntMath<>::Ceil(blockSize, blockAlignment));
+
+		const size_t bufferBlockCount = MemPoolParams::blockCount;
+		std::mt19937 mt;
+		std::vector<unsigned char*> blocks;
+		for (size_t i = 0; i < 8 * bufferBlockCount; ++i)
+		{
+			if (!blocks.empty() && mt() % 3 == 0)
+			{
+				size_t index = mt() % blocks.size();
+				unsigned char* block = blocks[index];
+				assert(*block == static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block)));
+				memPool.Deallocate(block);
+				blocks[index] = blocks.back();
+				blocks.pop_back();
+			}
+			unsigned char* block = memPool.template Allocate<unsigned char>();
+			assert(reinterpret_cast<uintptr_t>(block) % blockAlignment == 0);
+			*block = static_cast<unsigned char>(reinterpret_cast<uintptr_t>(block));
+			blocks.push_back(block);
+		}
+		assert(memPool.GetAllocateCount() == blocks.size());
+		std::sort(blocks.begin(), blocks.end());
+		assert(std::adjacent_find(blocks.begin(), blocks.end()) == blocks.end());
+		for (size_t i = 1; i < blocks.size(); ++i)
+			assert(static_cast<size_t>(blocks[i] - blocks[i - 1]) >= memPool.GetBlockSize());
+
+		if (MemPoolParams::cachedFreeBlockCount == 0)
+		{
+			// fill up all buffers, then freed blocks are reused in address order
+			while (blocks.size() % bufferBlockCount != 0)
+				blocks.push_back(memPool.template Allocate<unsigned char>());
+			std::vector<unsigned char*> freeBlocks;
+			for (size_t i = 0; i < 16; ++i)
+			{
+				size_t index = mt() % blocks.size();
+				freeBlocks.push_back(blocks[index]);
+				memPool.Deallocate(blocks[index]);
+				blocks.erase(blocks.begin() + static_cast<ptrdiff_t>(index));
+			}
+			std::sort(freeBlocks.begin(), freeBlocks.end());
+			for (unsigned char* freeBlock : freeBlocks)
+			{
+				unsigned char* block = memPool.template Allocate<unsigned char>();
+				assert(block == freeBlock);
+				blocks.push_back(block);
+			}
+		}
+
+		MemPool memPool2((MemPoolParams(blockSize, blockAlignment)));
+		std::vector<void*> blocks2;
+		for (size_t i = 0; i < 3 * bufferBlockCount / 2; ++i)
+			blocks2.push_back(memPool2.Allocate());
+		memPool.MergeFrom(memPool2);
+		assert(memPool2.GetAllocateCount() == 0);
+		assert(memPool.GetAllocateCount() == blocks.size() + blocks2.size());
+
+		// merging does not allocate, the tables of buffers may be chained
+		MemPool memPool3((MemPoolParams(blockSize, blockAlignment)));
+		std::vector<void*> blocks3;
+		for (size_t i = 0; i < 9 * bufferBlockCount; ++i)
+			blocks3.push_back(memPool3.Allocate());
+		memPool.MergeFrom(memPool3);
+		for (size_t i = 0; i < blocks3.size(); i += 2)
+			memPool.Deallocate(blocks3[i]);
+		assert(memPool.GetStats().allocateCount == blocks.size() + blocks2.size()
+			+ blocks3.size() / 2);
+		for (size_t i = 0; i < blocks3.size(); i += 2)
+			blocks3[i] = memPool.Allocate();
+		for (void* block : blocks3)
+			memPool.Deallocate(block);
+
+		for (void* block : blocks2)
+			memPool.Deallocate(block);
+
+		for (unsigned char* block : blocks)
+			memPool.Deallocate(block);
+		assert(memPool.GetAllocateCount() == 0);
+	}
+
+	template<typename MemPoolParams>
+	static void TestCompact(size_t blockSize, size_t blockAlignment)
+	{
+		typedef momo::MemPool<MemPoolParams> MemPool;
+		typedef momo::MemPoolStats MemPoolStats;
+
+		MemPool memPool((MemPoolParams(blockSize, blockAlignment)));
+		const size_t bufferBlockCount = MemPoolParams::blockCount;
+
+		// every block keeps its index in `blocks`
+		std::mt19937 mt;
+		std::vector<size_t*> blocks;
+		for (size_t i = 0; i < 16 * bufferBlockCount; ++i)
+		{
+			size_t* block = memPool.template Allocate<size_t>();
+			*block = blocks.size();
+			blocks.push_back(block);
+		}
+		for (size_t i = 0; i < 14 * bufferBlockCount; ++i)
+		{
+			size_t index = mt() % blocks.size();
+			memPool.Deallocate(blocks[index]);
+			blocks[index] = blocks.back();
+			blocks.pop_back();
+			if (index < blocks.size())
+				*blocks[index] = index;
+		}
+
+		auto checkStats = [&memPool, &blocks, bufferBlockCount] (const MemPoolStats& stats)
+		{
+			assert(stats.allocateCount == blocks.size());
+			assert(stats.allocateCount == memPool.GetAllocateCount());
+			assert(stats.bufferCount * bufferBlockCount
+				== stats.allocateCount + stats.cachedFreeBlockCount + stats.freeBlockCount);
+			size_t histBufferCount = 0;
+			for (size_t count : stats.occupancyHistogram)
+				histBufferCount += count;
+			assert(histBufferCount == stats.bufferCount);
+		};
+
+		MemPoolStats stats = memPool.GetStats();
+		checkStats(stats);
+
+		memPool.Trim();
+		MemPoolStats trimStats = memPool.GetStats();
+		checkStats(trimStats);
+		assert(trimStats.cachedFreeBlockCount == 0);
+		assert(trimStats.bufferCount <= stats.bufferCount);
+
+		auto blockRelocator = [&blocks] (void* srcBlock, void* dstBlock) noexcept
+		{
+			size_t index = *static_cast<size_t*>(srcBlock);
+			assert(blocks[index] == srcBlock);
+			*static_cast<size_t*>(dstBlock) = index;
+			blocks[index] = static_cast<size_t*>(dstBlock);
+		};
+		size_t releasedBufferCount = memPool.Compact(blockRelocator);
+		MemPoolStats compactStats = memPool.GetStats();
+		checkStats(compactStats);
+		assert(compactStats.bufferCount + releasedBufferCount == trimStats.bufferCount);
+		if (bufferBlockCount > 1)
+		{
+			assert(releasedBufferCount > 0);
+			assert(compactStats.freeBlockCount < bufferBlockCount * 2);
+		}
+
+		std::vector<size_t*> sortedBlocks(blocks);
+		std::sort(sortedBlocks.begin(), sortedBlocks.end());
+		assert(std::adjacent_find(sortedBlocks.begin(), sortedBlocks.end()) == sortedBlocks.end());
+		for (size_t i = 0; i < blocks.size(); ++i)
+			assert(*blocks[i] == i);
+
+		assert(memPool.Compact(blockRelocator) == 0);
+
+		for (size_t* block : blocks)
+			memPool.Deallocate(block);
+		memPool.Trim();
+		assert(memPool.GetStats().bufferCount == 0);
+	}
+
+	static void TestLargeContainers()
+	{
+		typedef momo::MemPoolParams<1024> MemPoolParams;
+		typedef momo::TreeSet<uint32_t, momo::TreeTraits<uint32_t, false,
+			momo::TreeNode<32, 4, MemPoolParams>>> TreeSet;
+		typedef momo::HashSet<uint32_t, momo::HashTraits<uint32_t,
+			momo::HashBucketLimP4<4, MemPoolParams>>> HashSet;
+
+		static const uint32_t count = 1 << 16;
+
+		TreeSet treeSet;
+		HashSet hashSet;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			uint32_t key = (i * 2654435761u) % count;
+			treeSet.Insert(key);
+			hashSet.Insert(key);
+		}
+		assert(treeSet.GetCount() == count && hashSet.GetCount() == count);
+		for (uint32_t i = 0; i < count; i += 2)
+		{
+			assert(treeSet.Remove(i));
+			assert(hashSet.Remove(i));
+		}
+		uint32_t key = 1;
+		for (uint32_t k : treeSet)
+		{
+			assert(k == key && hashSet.ContainsKey(k));
+			key += 2;
+		}
+	}
+
+	static void TestConcurrentAll()
+	{
+		std::cout << "momo::ConcurrentMemPool: " << std::flush;
+		TestConcurrentMemPool<momo::MemPoolParams<>>(24);
+		TestConcurrentMemPool<momo::MemPoolParams<1, 4>>(40);
+		TestConcurrentMemPool<momo::MemPoolParams<8, 0>>(8);
+		std::cout << "ok" << std::endl;
+
+		std::cout << "momo::stdish::synchronized_pool_allocator: " << std::flush;
+		TestSynchronizedPoolAllocator();
+		std::cout << "ok" << std::endl;
+	}
+
+	template<typename MemPoolParams>
+	static void TestConcurrentMemPool(size_t blockSize)
+	{
+		typedef momo::ConcurrentMemPool<MemPoolParams> ConcurrentMemPool;
+
+		static const size_t threadCount = 4;
+		static const size_t blockCount = 4096;
+
+		ConcurrentMemPool memPool((MemPoolParams(blockSize)));
+
+		// each thread allocates blocks and releases the blocks of the previous thread
+		std::vector<uint64_t*> blocks[threadCount];
+		std::mutex mutexes[threadCount];
+		auto worker = [&] (size_t thread)
+		{
+			std::mt19937 mt(static_cast<unsigned int>(thread));
+			size_t prevThread = (thread + threadCount - 1) % threadCount;
+			for (size_t i = 0; i < blockCount; ++i)
+			{
+				uint64_t* block = memPool.template Allocate<uint64_t>();
+				*block = uint64_t{thread};
+				{
+					std::lock_guard<std::mutex> lock(mutexes[thread]);
+					blocks[thread].push_back(block);
+				}
+				if (mt() % 2 == 0)
+				{
+					std::lock_guard<std::mutex> lock(mutexes[prevThread]);
+					if (!blocks[prevThread].empty())
+					{
+						block = blocks[prevThread].back();
+						blocks[prevThread].pop_back();
+						assert(*block == uint64_t{prevThread});
+						memPool.Deallocate(block);
+					}
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back(worker, t);
+		for (std::thread& thread : threads)
+			thread.join();
+
+		for (size_t t = 0; t < threadCount; ++t)
+		{
+			for (uint64_t* block : blocks[t])
+			{
+				assert(*block == uint64_t{t});
+				memPool.Deallocate(block);
+			}
+		}
+	}
+
+	static void TestSynchronizedPoolAllocator()
+	{
+		typedef momo::stdish::synchronized_pool_allocator<int> Allocator;
+		typedef std::list<int, Allocator> List;
+		typedef std::map<int, int, std::less<int>,
+			momo::stdish::synchronized_pool_allocator<std::pair<const int, int>>> Map;
+
+		static const size_t threadCount = 4;
+		static const int itemCount = 1024;
+
+		Allocator alloc;
+
+		{
+			Map map(alloc);
+			for (int i = 0; i < itemCount; ++i)
+				map[i] = i;
+			Map map2(map);
+			assert(map2 == map);
+			map.clear();
+			assert(map2.size() == static_cast<size_t>(itemCount));
+		}
+
+		// producers allocate list nodes, the consumer (main thread) releases them
+		Allocator listAlloc;
+		List queue(listAlloc);
+		std::mutex mutex;
+		auto producer = [&] (size_t thread)
+		{
+			Map map(alloc);
+			for (int i = 0; i < itemCount; ++i)
+			{
+				map.emplace(i, i);
+				List list(listAlloc);
+				list.push_back(static_cast<int>(thread) * itemCount + i);
+				std::lock_guard<std::mutex> lock(mutex);
+				queue.splice(queue.end(), list);
+			}
+			assert(map.size() == static_cast<size_t>(itemCount));
+		};
+
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back(producer, t);
+		size_t count = 0;
+		while (count < threadCount * itemCount)
+		{
+			List list(listAlloc);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				list.splice(list.end(), queue);
+			}
+			count += list.size();
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		assert(queue.empty());
+	}
+};
+
+static int testSimpleMemPool = (SimpleMemPoolTester::TestAll(), 0);
+
+#endif // TEST_SIMPLE_MEM_POOL
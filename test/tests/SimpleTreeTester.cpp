@@ -17,12 +17,21 @@
 
 #include "../../momo/TreeSet.h"
 #include "../../momo/TreeMap.h"
+#include "../../momo/ConcurrentTreeMap.h"
+#include "../../momo/PersistentTreeMap.h"
+#include "../../momo/AggregateTreeMap.h"
+#include "../../momo/stdish/radix_map.h"
+#include "../../momo/stdish/flat_set.h"
+#include "../../momo/stdish/flat_map.h"
 #include "../../momo/stdish/pool_allocator.h"
 
 #include <string>
 #include <iostream>
 #include <random>
 #include <set>
+#include <map>
+#include <thread>
+#include <vector>
 
 class SimpleTreeTester
 {
@@ -57,6 +66,14 @@ public:
 		TestCharTreeNode3<104,  33,   3>(mt);
 		TestCharTreeNode3<204, 100,   2>(mt);
 		TestCharTreeNode3<255, 127,   1>(mt);
+
+		TestCharTreeNodeBPlus<  3,   1, 127,  true>(mt);
+		TestCharTreeNodeBPlus<  4,   1,  15, false>(mt);
+		TestCharTreeNodeBPlus<  5,   2,  66,  true>(mt);
+		TestCharTreeNodeBPlus<  7,   3,   1, false>(mt);
+		TestCharTreeNodeBPlus< 32,   4,  32, false>(mt);
+		TestCharTreeNodeBPlus<101,   7,   2,  true>(mt);
+		TestCharTreeNodeBPlus<255, 127,   1,  true>(mt);
 	}
 
 	template<size_t maxCapacity, size_t capacityStep, size_t memPoolBlockCount>
@@ -74,6 +91,27 @@ public:
 
 		typedef momo::TreeNode<maxCapacity, capacityStep,
 			momo::MemPoolParams<memPoolBlockCount>, useSwap> TreeNode;
+		TestCharTreeSet<TreeNode>(maxCapacity, mt);
+
+		std::cout << "ok" << std::endl;
+	}
+
+	template<size_t maxCapacity, size_t capacityStep, size_t memPoolBlockCount, bool isContinuous>
+	static void TestCharTreeNodeBPlus(std::mt19937& mt)
+	{
+		std::cout << "momo::TreeNodeBPlus<" << maxCapacity << ", " << capacityStep << ", "
+			<< memPoolBlockCount << ", " << (isContinuous ? "true" : "false") << ">: " << std::flush;
+
+		typedef momo::TreeNodeBPlus<maxCapacity, capacityStep,
+			momo::MemPoolParams<memPoolBlockCount>, isContinuous> TreeNode;
+		TestCharTreeSet<TreeNode>(maxCapacity, mt);
+
+		std::cout << "ok" << std::endl;
+	}
+
+	template<typename TreeNode>
+	static void TestCharTreeSet(size_t maxCapacity, std::mt19937& mt)
+	{
 		typedef momo::TreeSet<unsigned char, momo::TreeTraits<unsigned char, false, TreeNode>> TreeSet;
 
 		static const size_t count = 256;
@@ -131,7 +169,25 @@ public:
 			assert(mset.GetCount() == 1);
 		}
 
-		std::cout << "ok" << std::endl;
+		{
+			TreeSet mset;
+			std::shuffle(array, array + count, mt);
+			for (unsigned char c : array)
+			{
+				if (c % 2 == 0)
+					mset.Insert(c);
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				unsigned char c = static_cast<unsigned char>(i);
+				auto lowerIter = mset.GetLowerBound(c);
+				assert(lowerIter == mset.GetEnd() || *lowerIter == c + c % 2);
+				auto upperIter = mset.GetUpperBound(c);
+				assert(upperIter == mset.GetEnd() || *upperIter == c + 2 - c % 2);
+				if (lowerIter != mset.GetBegin())
+					assert(*std::prev(lowerIter) == c - 1 - (c + 1) % 2);
+			}
+		}
 	}
 
 	static void TestStrAll()
@@ -223,8 +279,574 @@ public:
 		map.Clear();
 		assert(map.IsEmpty());
 	}
+
+	static void TestConcurrentAll()
+	{
+		std::cout << "momo::ConcurrentTreeMap: " << std::flush;
+		TestConcurrentTreeMap<momo::TreeNode<3, 1>>();
+		TestConcurrentTreeMap<momo::TreeNode<32, 4>>();
+		TestConcurrentTreeMapThreads();
+		std::cout << "ok" << std::endl;
+	}
+
+	template<typename TreeNode>
+	static void TestConcurrentTreeMap()
+	{
+		typedef momo::ConcurrentTreeMap<uint32_t, uint64_t,
+			momo::TreeTraits<uint32_t, false, TreeNode>> ConcurrentTreeMap;
+
+		std::mt19937 mt;
+		ConcurrentTreeMap cmap;
+		std::map<uint32_t, uint64_t> smap;
+
+		for (size_t i = 0; i < 4096; ++i)
+		{
+			uint32_t key = mt() % 1024;
+			uint64_t value = mt();
+			switch (mt() % 4)
+			{
+			case 0:
+				assert(cmap.InsertOrAssign(key, value) == (smap.count(key) == 0));
+				smap[key] = value;
+				break;
+			case 1:
+				assert(cmap.Insert(key, value) == smap.insert({ key, value }).second);
+				break;
+			case 2:
+				assert(cmap.Remove(key) == (smap.erase(key) > 0));
+				break;
+			default:
+				{
+					uint64_t res = 0;
+					auto iter = smap.find(key);
+					assert(cmap.Find(key, res) == (iter != smap.end()));
+					assert(iter == smap.end() || res == iter->second);
+				}
+			}
+			assert(cmap.GetCount() == smap.size());
+		}
+
+		for (uint32_t key = 0; key <= 1024; key += 7)
+		{
+			auto iter = smap.lower_bound(key);
+			auto pairVisitor = [&smap, &iter] (uint32_t k, uint64_t v)
+			{
+				assert(iter != smap.end() && iter->first == k && iter->second == v);
+				++iter;
+				return true;
+			};
+			cmap.Scan(key, pairVisitor);
+			assert(iter == smap.end());
+		}
+
+		size_t scanCount = 0;
+		cmap.Scan(0, [&scanCount] (uint32_t, uint64_t) { return ++scanCount < 10; });
+		assert(scanCount == std::minmax(size_t{10}, smap.size()).first);
+	}
+
+	static void TestConcurrentTreeMapThreads()
+	{
+		typedef momo::ConcurrentTreeMap<uint32_t, uint32_t,
+			momo::TreeTraits<uint32_t, false, momo::TreeNode<4, 1>>> ConcurrentTreeMap;
+
+		static const uint32_t threadCount = 4;
+		static const uint32_t keyCount = 1 << 14;
+
+		ConcurrentTreeMap cmap;
+		auto writer = [&cmap] (uint32_t thread)
+		{
+			for (uint32_t i = thread; i < keyCount; i += threadCount)
+				assert(cmap.Insert(i * 2, i));
+		};
+		auto remover = [&cmap] (uint32_t thread)
+		{
+			for (uint32_t i = thread; i < keyCount; i += threadCount)
+			{
+				if (i % 4 != 0)
+					assert(cmap.Remove(i * 2));
+			}
+		};
+		auto reader = [&cmap] ()
+		{
+			for (uint32_t i = 0; i < keyCount; ++i)
+			{
+				uint32_t value;
+				if (cmap.Find(i * 2, value))
+					assert(value == i);
+				assert(!cmap.ContainsKey(i * 2 + 1));
+			}
+			uint32_t prevKey = 0;
+			cmap.Scan(0, [&prevKey] (uint32_t key, uint32_t value)
+			{
+				assert(key == 0 || key > prevKey);
+				assert(key == value * 2);
+				prevKey = key;
+				return true;
+			});
+		};
+
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < threadCount; ++t)
+		{
+			threads.emplace_back(writer, t);
+			threads.emplace_back(reader);
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+
+		assert(cmap.GetCount() == keyCount);
+		uint32_t scanCount = 0;
+		cmap.Scan(0, [&scanCount] (uint32_t key, uint32_t value)
+		{
+			assert(key == scanCount * 2 && value == scanCount);
+			++scanCount;
+			return true;
+		});
+		assert(scanCount == keyCount);
+
+		threads.clear();
+		for (uint32_t t = 0; t < threadCount; ++t)
+		{
+			threads.emplace_back(remover, t);
+			threads.emplace_back(reader);
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+
+		assert(cmap.GetCount() == keyCount / 4);
+		scanCount = 0;
+		cmap.Scan(0, [&scanCount] (uint32_t key, uint32_t value)
+		{
+			assert(key == scanCount * 8 && value == scanCount * 4);
+			++scanCount;
+			return true;
+		});
+		assert(scanCount == keyCount / 4);
+	}
+
+	static void TestPersistentAll()
+	{
+		std::cout << "momo::PersistentTreeMap: " << std::flush;
+		TestPersistentTreeMap<momo::TreeNode<3, 1>>();
+		TestPersistentTreeMap<momo::TreeNode<32, 4>>();
+		std::cout << "ok" << std::endl;
+	}
+
+	template<typename TreeNode>
+	static void TestPersistentTreeMap()
+	{
+		typedef momo::PersistentTreeMap<uint32_t, std::string,
+			momo::TreeTraits<uint32_t, false, TreeNode>> PersistentTreeMap;
+		typedef std::map<uint32_t, std::string> StdMap;
+
+		auto check = [] (const PersistentTreeMap& pmap, const StdMap& smap)
+		{
+			assert(pmap.GetCount() == smap.size());
+			auto iter = smap.begin();
+			pmap.Scan([&smap, &iter] (uint32_t key, const std::string& value)
+			{
+				assert(iter != smap.end() && iter->first == key && iter->second == value);
+				++iter;
+				return true;
+			});
+			assert(iter == smap.end());
+		};
+
+		std::mt19937 mt;
+		PersistentTreeMap pmap;
+		StdMap smap;
+		std::vector<std::pair<PersistentTreeMap, StdMap>> snapshots;
+
+		for (size_t i = 0; i < 4096; ++i)
+		{
+			uint32_t key = mt() % 512;
+			std::string value = std::to_string(mt());
+			switch (mt() % 4)
+			{
+			case 0:
+				assert(pmap.InsertOrAssign(key, value) == (smap.count(key) == 0));
+				smap[key] = value;
+				break;
+			case 1:
+				assert(pmap.Insert(key, value) == smap.insert({ key, value }).second);
+				break;
+			case 2:
+				assert(pmap.Remove(key) == (smap.erase(key) > 0));
+				break;
+			default:
+				{
+					const std::string* res = pmap.Find(key);
+					auto iter = smap.find(key);
+					assert((res != nullptr) == (iter != smap.end()));
+					assert(res == nullptr || *res == iter->second);
+				}
+			}
+			assert(pmap.GetCount() == smap.size());
+			if (i % 256 == 0)
+				snapshots.emplace_back(pmap, smap);
+		}
+		check(pmap, smap);
+
+		for (const auto& snapshot : snapshots)
+			check(snapshot.first, snapshot.second);
+
+		for (uint32_t key = 0; key <= 512; key += 7)
+		{
+			auto iter = smap.lower_bound(key);
+			pmap.Scan(key, [&smap, &iter] (uint32_t k, const std::string& v)
+			{
+				assert(iter != smap.end() && iter->first == k && iter->second == v);
+				++iter;
+				return true;
+			});
+			assert(iter == smap.end());
+		}
+
+		PersistentTreeMap pmap2 = snapshots.back().first;
+		std::thread thread([&snapshots] () { snapshots.clear(); });
+		while (!pmap2.IsEmpty())
+		{
+			uint32_t key = 0;
+			pmap2.Scan([&key] (uint32_t k, const std::string&) { key = k; return false; });
+			assert(pmap2.Remove(key));
+		}
+		thread.join();
+		check(pmap, smap);
+
+		pmap = PersistentTreeMap();
+		assert(pmap.IsEmpty());
+	}
+
+	static void TestAggregateAll()
+	{
+		std::cout << "momo::AggregateTreeMap: " << std::flush;
+		TestAggregateTreeMap<momo::TreeNode<3, 1>>();
+		TestAggregateTreeMap<momo::TreeNode<4, 1>>();
+		TestAggregateTreeMap<momo::TreeNode<32, 4>>();
+		std::cout << "ok" << std::endl;
+	}
+
+	struct MinFunc
+	{
+		int64_t operator()(int64_t value1, int64_t value2) const
+		{
+			return std::min(value1, value2);
+		}
+	};
+
+	template<typename TreeNode>
+	static void TestAggregateTreeMap()
+	{
+		typedef momo::TreeTraits<uint32_t, false, TreeNode> TreeTraits;
+		typedef momo::AggregateTreeMap<uint32_t, int64_t,
+			momo::AggregateTreeMonoid<int64_t>, TreeTraits> SumTreeMap;
+		typedef momo::AggregateTreeMonoid<int64_t, MinFunc> MinMonoid;
+		typedef momo::AggregateTreeMap<uint32_t, int64_t, MinMonoid, TreeTraits> MinTreeMap;
+		typedef std::map<uint32_t, int64_t> StdMap;
+
+		static const int64_t maxValue = std::numeric_limits<int64_t>::max();
+
+		std::mt19937 mt;
+		SumTreeMap sumMap;
+		MinTreeMap minMap((MinMonoid(maxValue)));
+		StdMap smap;
+
+		for (size_t i = 0; i < 8192; ++i)
+		{
+			uint32_t key = mt() % 1024;
+			int64_t value = static_cast<int64_t>(mt() % 2001) - 1000;
+			if (mt() % 3 == 0)
+			{
+				bool removed = smap.erase(key) > 0;
+				assert(sumMap.Remove(key) == removed);
+				assert(minMap.Remove(key) == removed);
+			}
+			else
+			{
+				bool inserted = smap.insert({ key, value }).second;
+				smap[key] = value;
+				assert(sumMap.InsertOrAssign(key, value) == inserted);
+				assert(minMap.InsertOrAssign(key, value) == inserted);
+			}
+			assert(sumMap.GetCount() == smap.size());
+			assert(minMap.GetCount() == smap.size());
+			uint32_t lowKey = mt() % 1100;
+			uint32_t highKey = lowKey + mt() % 300;
+			int64_t sum = 0;
+			int64_t min = maxValue;
+			for (auto iter = smap.lower_bound(lowKey); iter != smap.lower_bound(highKey); ++iter)
+			{
+				sum += iter->second;
+				min = std::min(min, iter->second);
+			}
+			assert(sumMap.GetAggregate(lowKey, highKey) == sum);
+			assert(minMap.GetAggregate(lowKey, highKey) == min);
+			assert(sumMap.GetAggregate(highKey, lowKey) == 0);
+			const int64_t* pvalue = sumMap.Find(key);
+			assert((pvalue != nullptr) == (smap.count(key) > 0));
+			assert(pvalue == nullptr || *pvalue == smap[key]);
+		}
+
+		int64_t sum = 0;
+		for (const auto& pair : smap)
+			sum += pair.second;
+		assert(sumMap.GetAggregate() == sum);
+
+		SumTreeMap sumMap2(sumMap);
+		assert(sumMap2.GetAggregate() == sum);
+		SumTreeMap sumMap3(std::move(sumMap));
+		assert(sumMap.IsEmpty() && sumMap.GetAggregate() == 0);
+		assert(sumMap3.GetAggregate() == sum);
+		sumMap3.Clear();
+		assert(sumMap3.GetAggregate() == 0);
+		auto iter = smap.begin();
+		sumMap2.Scan([&iter] (uint32_t key, int64_t value)
+		{
+			assert(iter->first == key && iter->second == value);
+			++iter;
+			return true;
+		});
+		assert(iter == smap.end());
+	}
+
+	static void TestRadixAll()
+	{
+		std::cout << "momo::RadixTreeMap: " << std::flush;
+		std::mt19937 mt;
+		TestRadixTreeMap<int32_t>([&mt] () { return static_cast<int32_t>(mt() % 4096) - 2048; });
+		TestRadixTreeMap<uint64_t>([&mt] () { return uint64_t{mt()} << (mt() % 33); });
+		TestRadixTreeMap<std::string>([&mt] ()
+		{
+			static const char* prefixes[] = { "", "a", "ab", "abcdefghijklmno", "abcdefghijklmnz" };
+			std::string key = prefixes[mt() % 5];
+			for (size_t len = mt() % 4; len > 0; --len)
+				key += static_cast<char>('a' + mt() % 4 + (mt() % 8 == 0 ? 120 : 0));
+			return key;
+		});
+		std::cout << "ok" << std::endl;
+	}
+
+	template<typename Key, typename KeyGenerator>
+	static void TestRadixTreeMap(const KeyGenerator& keyGenerator)
+	{
+		typedef momo::stdish::radix_map<Key, size_t> RadixMap;
+		typedef std::map<Key, size_t> StdMap;
+
+		std::mt19937 mt;
+		RadixMap rmap;
+		StdMap smap;
+
+		for (size_t i = 0; i < 16384; ++i)
+		{
+			Key key = keyGenerator();
+			if (mt() % 3 == 0)
+			{
+				assert(rmap.erase(key) == smap.erase(key));
+			}
+			else
+			{
+				auto res = rmap.insert(std::make_pair(key, i));
+				assert(res.second == smap.insert(std::make_pair(key, i)).second);
+				assert(res.first->first == key && res.first->second == smap[key]);
+			}
+			assert(rmap.size() == smap.size());
+			Key boundKey = keyGenerator();
+			auto lowerBound = rmap.lower_bound(boundKey);
+			auto upperBound = rmap.upper_bound(boundKey);
+			if (smap.lower_bound(boundKey) == smap.end())
+				assert(lowerBound == rmap.end());
+			else
+				assert(lowerBound->first == smap.lower_bound(boundKey)->first);
+			if (smap.upper_bound(boundKey) == smap.end())
+				assert(upperBound == rmap.end());
+			else
+				assert(upperBound->first == smap.upper_bound(boundKey)->first);
+			assert(rmap.count(boundKey) == smap.count(boundKey));
+			if (i % 1024 == 0)
+			{
+				assert(std::equal(rmap.begin(), rmap.end(), smap.begin()));
+				assert(std::equal(rmap.rbegin(), rmap.rend(), smap.rbegin()));
+			}
+		}
+
+		assert(std::equal(rmap.begin(), rmap.end(), smap.begin()));
+		for (auto iter = rmap.begin(); iter != rmap.end(); )
+		{
+			if (mt() % 2 == 0)
+			{
+				smap.erase(iter->first);
+				iter = rmap.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+		assert(rmap.size() == smap.size());
+		assert(std::equal(rmap.begin(), rmap.end(), smap.begin()));
+
+		RadixMap rmap2(rmap);
+		assert(rmap2 == rmap);
+		RadixMap rmap3(std::move(rmap));
+		rmap = rmap2;
+		assert(rmap3 == rmap2 && rmap == rmap2);
+		rmap3.clear();
+		assert(rmap3.empty() && rmap3.begin() == rmap3.end());
+		rmap3[keyGenerator()] = 1;
+		assert(rmap3.size() == 1 && rmap3.begin()->second == 1);
+		assert(!rmap3.insert({ rmap3.begin()->first, 2 }).second);
+		assert(!rmap3.insert(*rmap3.begin()).second && rmap3.begin()->second == 1);
+		rmap2.erase(rmap2.begin(), rmap2.end());
+		assert(rmap2.empty());
+	}
+
+	static void TestFlatAll()
+	{
+		std::cout << "momo::FlatSet, momo::FlatMap: " << std::flush;
+		std::mt19937 mt;
+		TestFlatSet<int32_t>([&mt] () { return static_cast<int32_t>(mt() % 4096) - 2048; });
+		TestFlatSet<uint64_t>([&mt] () { return uint64_t{mt()} << (mt() % 33); });
+		TestFlatSet<std::string>([&mt] () { return std::to_string(mt() % 4096); });
+		TestFlatMap<int32_t>([&mt] () { return static_cast<int32_t>(mt() % 4096) - 2048; });
+		TestFlatMap<std::string>([&mt] () { return std::to_string(mt() % 4096); });
+		std::cout << "ok" << std::endl;
+	}
+
+	template<typename Key, typename KeyGenerator>
+	static void TestFlatSet(const KeyGenerator& keyGenerator)
+	{
+		typedef momo::stdish::flat_set<Key> FlatSet;
+		typedef std::set<Key> StdSet;
+
+		std::mt19937 mt;
+		FlatSet fset;
+		StdSet sset;
+
+		for (size_t i = 0; i < 1024; ++i)
+		{
+			std::vector<Key> keys;
+			for (size_t j = mt() % 64; j > 0; --j)
+				keys.push_back(keyGenerator());
+			if (mt() % 4 == 0)
+			{
+				for (const Key& key : keys)
+					assert(fset.erase(key) == sset.erase(key));
+			}
+			else if (mt() % 2 == 0)
+			{
+				fset.insert(keys.begin(), keys.end());
+				sset.insert(keys.begin(), keys.end());
+			}
+			else
+			{
+				for (const Key& key : keys)
+					assert(fset.insert(key).second == sset.insert(key).second);
+			}
+			assert(fset.size() == sset.size());
+			Key boundKey = keyGenerator();
+			assert(static_cast<size_t>(fset.lower_bound(boundKey) - fset.begin())
+				== static_cast<size_t>(std::distance(sset.begin(), sset.lower_bound(boundKey))));
+			assert(static_cast<size_t>(fset.upper_bound(boundKey) - fset.begin())
+				== static_cast<size_t>(std::distance(sset.begin(), sset.upper_bound(boundKey))));
+			assert(fset.count(boundKey) == sset.count(boundKey));
+			if (i % 64 == 0)
+				assert(std::equal(fset.begin(), fset.end(), sset.begin()));
+		}
+		assert(std::equal(fset.begin(), fset.end(), sset.begin()));
+
+		std::vector<Key> keys(sset.begin(), sset.end());
+		FlatSet fset2;
+		fset2.insert(keys.rbegin(), keys.rend());
+		fset2.insert(keys.begin(), keys.end());
+		assert(fset2 == fset);
+		fset2.erase(fset2.begin() + static_cast<ptrdiff_t>(fset2.size() / 4),
+			fset2.begin() + static_cast<ptrdiff_t>(fset2.size() / 2));
+		fset2.insert(keys.begin(), keys.end());
+		assert(fset2 == fset);
+	}
+
+	template<typename Key, typename KeyGenerator>
+	static void TestFlatMap(const KeyGenerator& keyGenerator)
+	{
+		typedef momo::stdish::flat_map<Key, size_t> FlatMap;
+		typedef std::map<Key, size_t> StdMap;
+
+		std::mt19937 mt;
+		FlatMap fmap;
+		StdMap smap;
+
+		for (size_t i = 0; i < 1024; ++i)
+		{
+			std::vector<std::pair<Key, size_t>> pairs;
+			for (size_t j = mt() % 64; j > 0; --j)
+			{
+				Key key = keyGenerator();
+				// the map must not depend on which of the equal keys is taken
+				if (smap.count(key) == 0 && std::none_of(pairs.begin(), pairs.end(),
+					[&key] (const std::pair<Key, size_t>& pair) { return pair.first == key; }))
+				{
+					pairs.emplace_back(key, i);
+				}
+			}
+			if (mt() % 4 == 0)
+			{
+				for (const auto& pair : pairs)
+					assert(fmap.erase(pair.first) == smap.erase(pair.first));
+			}
+			else if (mt() % 2 == 0)
+			{
+				fmap.insert(pairs.begin(), pairs.end());
+				smap.insert(pairs.begin(), pairs.end());
+			}
+			else
+			{
+				for (const auto& pair : pairs)
+				{
+					auto res = fmap.insert(pair);
+					assert(res.second == smap.insert(pair).second);
+					assert(res.first->first == pair.first && res.first->second == smap[pair.first]);
+				}
+			}
+			assert(fmap.size() == smap.size());
+			Key boundKey = keyGenerator();
+			auto lowerBound = fmap.lower_bound(boundKey);
+			if (smap.lower_bound(boundKey) == smap.end())
+				assert(lowerBound == fmap.end());
+			else
+				assert(lowerBound->first == smap.lower_bound(boundKey)->first);
+			assert(fmap.count(boundKey) == smap.count(boundKey));
+			if (i % 64 == 0)
+				assert(std::equal(fmap.begin(), fmap.end(), smap.begin()));
+		}
+		assert(std::equal(fmap.begin(), fmap.end(), smap.begin()));
+
+		for (auto iter = fmap.begin(); iter != fmap.end(); )
+		{
+			if (mt() % 2 == 0)
+			{
+				smap.erase(iter->first);
+				iter = fmap.erase(iter);
+			}
+			else
+			{
+				++iter->second;
+				++smap[iter->first];
+				++iter;
+			}
+		}
+		assert(std::equal(fmap.begin(), fmap.end(), smap.begin()));
+
+		FlatMap fmap2(smap.rbegin(), smap.rend());
+		assert(fmap2 == fmap);
+		fmap2[keyGenerator()] = 1;
+		fmap2.erase(fmap2.begin(), fmap2.end());
+		assert(fmap2.empty());
+	}
 };
 
-static int testSimpleTree = (SimpleTreeTester::TestStrAll(), SimpleTreeTester::TestCharAll(), 0);
+static int testSimpleTree = (SimpleTreeTester::TestStrAll(), SimpleTreeTester::TestCharAll(),
+	SimpleTreeTester::TestConcurrentAll(), SimpleTreeTester::TestPersistentAll(),
+	SimpleTreeTester::TestAggregateAll(), SimpleTreeTester::TestRadixAll(),
+	SimpleTreeTester::TestFlatAll(), 0);
 
 #endif // TEST_SIMPLE_TREE
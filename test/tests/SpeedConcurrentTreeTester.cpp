@@ -0,0 +1,139 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  tests/SpeedConcurrentTreeTester.cpp
+
+\**********************************************************/
+
+#include "pch.h"
+#include "TestSettings.h"
+
+#ifdef TEST_SPEED_CONCURRENT_TREE
+
+#include "../../momo/TreeMap.h"
+#include "../../momo/ConcurrentTreeMap.h"
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SpeedConcurrentTreeTester
+{
+public:
+	typedef uint64_t Key;
+	typedef uint64_t Value;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	class LockedTreeMap
+	{
+	public:
+		bool Find(Key key, Value& value) const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto iter = mTreeMap.Find(key);
+			if (iter == mTreeMap.GetEnd())
+				return false;
+			value = iter->value;
+			return true;
+		}
+
+		bool Insert(Key key, Value value)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mTreeMap.Insert(key, value).inserted;
+		}
+
+	private:
+		mutable std::mutex mMutex;
+		momo::TreeMap<Key, Value> mTreeMap;
+	};
+
+public:
+	explicit SpeedConcurrentTreeTester(size_t keyCount, size_t opCount, std::ostream& resStream)
+		: mKeyCount(keyCount),
+		mOpCount(opCount),
+		mResStream(resStream)
+	{
+	}
+
+	void TestAll()
+	{
+		mResStream << "title;threads;find 90% insert 10% (ms)" << std::endl;
+		for (size_t threadCount = 1; threadCount <= 8; threadCount *= 2)
+		{
+			TestTreeMap<LockedTreeMap>("momo::TreeMap + std::mutex", threadCount);
+			TestTreeMap<momo::ConcurrentTreeMap<Key, Value>>("momo::ConcurrentTreeMap", threadCount);
+		}
+	}
+
+	template<typename TreeMap>
+	void TestTreeMap(const std::string& mapTitle, size_t threadCount)
+	{
+		TreeMap map;
+		std::mt19937_64 random;
+		for (size_t i = 0; i < mKeyCount; ++i)
+			map.Insert(random() % (4 * mKeyCount), 0);
+
+		auto worker = [&map, this] (size_t thread)
+		{
+			std::mt19937_64 random(thread);
+			Value value = 0;
+			for (size_t i = 0; i < mOpCount; ++i)
+			{
+				Key key = random() % (4 * mKeyCount);
+				if (i % 10 == 0)
+					map.Insert(key, i);
+				else if (map.Find(key, value))
+					value += key;
+			}
+			if (value == 1)
+				std::cout << "";
+		};
+
+		std::cout << mapTitle << " (" << threadCount << " threads): " << std::flush;
+		auto start = Clock::now();
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back(worker, t);
+		for (std::thread& thread : threads)
+			thread.join();
+		auto time = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+		std::cout << time.count() << " ms" << std::endl;
+		mResStream << mapTitle << ";" << threadCount << ";" << time.count() << std::endl;
+	}
+
+private:
+	size_t mKeyCount;
+	size_t mOpCount;
+	std::ostream& mResStream;
+};
+
+void TestSpeedConcurrentTree()
+{
+	std::cout << "TestSpeedConcurrentTree started" << std::endl;
+
+#ifdef NDEBUG
+	const size_t keyCount = 1 << 20;
+	const size_t opCount = 1 << 20;
+#else
+	const size_t keyCount = 1 << 12;
+	const size_t opCount = 1 << 14;
+#endif
+
+	std::stringstream resStream;
+	SpeedConcurrentTreeTester(keyCount, opCount, resStream).TestAll();
+	std::cout << resStream.str() << std::endl;
+}
+
+static int testSpeedConcurrentTree = (TestSpeedConcurrentTree(), 0);
+
+#endif // TEST_SPEED_CONCURRENT_TREE
@@ -15,6 +15,8 @@
 
 #include "../../momo/stdish/unordered_map.h"
 #include "../../momo/stdish/map.h"
+#include "../../momo/stdish/radix_map.h"
+#include "../../momo/MemManagerCounting.h"
 
 #include "../../momo/details/HashBucketLimP4.h"
 #include "../../momo/details/HashBucketOpen2N2.h"
@@ -166,6 +168,58 @@ public:
 	}
 };
 
+momo::MemManagerCounting<>& GetSpeedMapMemManager()
+{
+	static momo::MemManagerCounting<> memManager;
+	return memManager;
+}
+
+template<typename TValue>
+class SpeedMapAllocator
+{
+public:
+	typedef TValue value_type;
+
+	typedef momo::MemManagerCounting<> MemManager;
+
+public:
+	SpeedMapAllocator() noexcept
+	{
+	}
+
+	template<typename Value>
+	SpeedMapAllocator(const SpeedMapAllocator<Value>& /*alloc*/) noexcept
+	{
+	}
+
+	value_type* allocate(size_t count)
+	{
+		return momo::internal::MemManagerProxy<MemManager>::template Allocate<value_type>(
+			GetMemManager(), count * sizeof(value_type));
+	}
+
+	void deallocate(value_type* ptr, size_t count) noexcept
+	{
+		momo::internal::MemManagerProxy<MemManager>::Deallocate(GetMemManager(), ptr,
+			count * sizeof(value_type));
+	}
+
+	bool operator==(const SpeedMapAllocator& /*alloc*/) const noexcept
+	{
+		return true;
+	}
+
+	bool operator!=(const SpeedMapAllocator& /*alloc*/) const noexcept
+	{
+		return false;
+	}
+
+	static MemManager& GetMemManager()
+	{
+		return GetSpeedMapMemManager();
+	}
+};
+
 template<typename TKey>
 class SpeedMapTester
 {
@@ -176,6 +230,8 @@ public:
 private:
 	typedef SpeedMapKeys<Key> Keys;
 
+	typedef SpeedMapAllocator<std::pair<const Key, Value>> Allocator;
+
 	typedef std::chrono::steady_clock Clock;
 	typedef std::chrono::time_point<Clock> TimePoint;
 	typedef int64_t TickCount;
@@ -186,6 +242,7 @@ private:
 		Time insertTime;
 		Time findExistingTime;
 		Time findRandomTime;
+		Time iterateTime;
 		Time eraseTime;
 	};
 
@@ -203,8 +260,9 @@ public:
 		mResStream << std::ctime(&now) << " " << Keys::GetKeyTitle() << " "
 			<< sizeof(void*) * 8 << "bit" << std::endl;
 		mResStream << "title;count;"
-			<< "insert (norm);find existing (norm);find random (norm);erase (norm);"
-			<< "insert (real);find existing (real);find random (real);erase (real)"
+			<< "insert (norm);find existing (norm);find random (norm);iterate (norm);erase (norm);"
+			<< "insert (real);find existing (real);find random (real);iterate (real);erase (real);"
+			<< "memory (bytes per item)"
 			<< std::endl;
 
 		mProcStream << "key title: " << Keys::GetKeyTitle() << "\n" << std::endl;
@@ -213,7 +271,6 @@ public:
 	template<typename HashBucket>
 	void TestHashBucket(const std::string& mapTitle, float maxLoadFactor = 0.0, bool reserve = false)
 	{
-		typedef std::allocator<std::pair<const Key, Value>> Allocator;
 		typedef momo::stdish::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>, Allocator,
 			momo::HashMap<Key, Value, momo::HashTraitsStd<Key, std::hash<Key>, std::equal_to<Key>, HashBucket>,
 			momo::MemManagerStd<Allocator>>> HashMap;
@@ -227,8 +284,8 @@ public:
 		if (maxLoadFactor == 0)
 			trueMaxLoadFactor = HashMap().max_load_factor();
 
-		TestResult<double> maxNormRes = { 0.0, 0.0, 0.0, 0.0 };
-		TestResult<double> avgNormRes = { 0.0, 0.0, 0.0, 0.0 };
+		TestResult<double> maxNormRes = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+		TestResult<double> avgNormRes = { 0.0, 0.0, 0.0, 0.0, 0.0 };
 
 		for (size_t i = 9; i <= 16; ++i)
 		{
@@ -239,24 +296,27 @@ public:
 			maxNormRes.insertTime = std::minmax(maxNormRes.insertTime, normRes.insertTime).second;
 			maxNormRes.findExistingTime = std::minmax(maxNormRes.findExistingTime, normRes.findExistingTime).second;
 			maxNormRes.findRandomTime = std::minmax(maxNormRes.findRandomTime, normRes.findRandomTime).second;
+			maxNormRes.iterateTime = std::minmax(maxNormRes.iterateTime, normRes.iterateTime).second;
 			maxNormRes.eraseTime = std::minmax(maxNormRes.eraseTime, normRes.eraseTime).second;
 
 			avgNormRes.insertTime += normRes.insertTime / 8.0;
 			avgNormRes.findExistingTime += normRes.findExistingTime / 8.0;
 			avgNormRes.findRandomTime += normRes.findRandomTime / 8.0;
+			avgNormRes.iterateTime += normRes.iterateTime / 8.0;
 			avgNormRes.eraseTime += normRes.eraseTime / 8.0;
 		}
 
 		mResStream << ";max;" << maxNormRes.insertTime << ";" << maxNormRes.findExistingTime << ";"
-			<< maxNormRes.findRandomTime << ";" << maxNormRes.eraseTime << ";;;;" << std::endl;
+			<< maxNormRes.findRandomTime << ";" << maxNormRes.iterateTime << ";"
+			<< maxNormRes.eraseTime << ";;;;;;" << std::endl;
 		mResStream << ";avg;" << avgNormRes.insertTime << ";" << avgNormRes.findExistingTime << ";"
-			<< avgNormRes.findRandomTime << ";" << avgNormRes.eraseTime << ";;;;" << std::endl;
+			<< avgNormRes.findRandomTime << ";" << avgNormRes.iterateTime << ";"
+			<< avgNormRes.eraseTime << ";;;;;;" << std::endl;
 	}
 
 	template<typename TreeNode>
 	void TestTreeNode(const std::string& mapTitle)
 	{
-		typedef std::allocator<std::pair<const Key, Value>> Allocator;
 		typedef momo::stdish::map<Key, Value, std::less<Key>, Allocator,
 			momo::TreeMap<Key, Value, momo::TreeTraitsStd<Key, std::less<Key>, false, TreeNode>,
 			momo::MemManagerStd<Allocator>>> TreeMap;
@@ -272,7 +332,8 @@ public:
 
 	void TestAll()
 	{
-		TestHashMap<std::unordered_map<Key, Value>>("std::unordered_map");
+		TestHashMap<std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>, Allocator>>(
+			"std::unordered_map");
 		TestHashBucket<momo::HashBucketLimP4<>>("momo::HashBucketLimP4<>");
 		TestHashBucket<momo::HashBucketOpen2N2<>>("momo::HashBucketOpen2N2<>");
 		TestHashBucket<momo::HashBucketOpen8>("momo::HashBucketOpen8");
@@ -286,12 +347,26 @@ public:
 		TestHashBucket<momo::HashBucketOpenN1<>>("momo::HashBucketOpenN1<>");
 #endif
 
-		TestTreeMap<std::map<Key, Value>>("std::map");
+		TestTreeMap<std::map<Key, Value, std::less<Key>, Allocator>>("std::map");
 		TestTreeNode<momo::TreeNode<32, 4, momo::MemPoolParams<>, true>>("momo::TreeNode<32, 4, <>, true>");
 		TestTreeNode<momo::TreeNode<32, 4, momo::MemPoolParams<>, false>>("momo::TreeNode<32, 4, <>, false>");
+		TestTreeNode<momo::TreeNodeBPlus<32, 4, momo::MemPoolParams<>, true>>(
+			"momo::TreeNodeBPlus<32, 4, <>, true>");
+		TestTreeNode<momo::TreeNodeBPlus<64, 8, momo::MemPoolParams<1>, true>>(
+			"momo::TreeNodeBPlus<64, 8, <1>, true>");
+		pvTestRadixTreeMap(std::is_integral<Key>());
 	}
 
 private:
+	void pvTestRadixTreeMap(std::true_type /*isIntegral*/)
+	{
+		TestTreeMap<momo::stdish::radix_map<Key, Value, Allocator>>("momo::stdish::radix_map");
+	}
+
+	void pvTestRadixTreeMap(std::false_type /*isIntegral*/)
+	{
+	}
+
 	template<typename HashMap>
 	TestResult<double> pvTestHashMap(const std::string& mapTitle, size_t keyCount, float maxLoadFactor, bool reserve)
 	{
@@ -308,12 +383,13 @@ private:
 			sstream << " rsrv";
 		std::string trueMapTitle = sstream.str();
 
-		TestResult<> res = pvTestMap<HashMap>(trueMapTitle, keyCount, afterCreate);
+		double itemMemorySize;
+		TestResult<> res = pvTestMap<HashMap>(trueMapTitle, keyCount, afterCreate, itemMemorySize);
 
 		double norm = static_cast<double>(keyCount) / 1e3;
 		TestResult<double> normRes = pvMakeNormResult(res, norm);
 
-		pvOutputResult(trueMapTitle, keyCount, res, normRes);
+		pvOutputResult(trueMapTitle, keyCount, res, normRes, itemMemorySize);
 
 		return normRes;
 	}
@@ -323,26 +399,29 @@ private:
 	{
 		auto afterCreate = [] (TreeMap&) { };
 
-		TestResult<> res = pvTestMap<TreeMap>(mapTitle, keyCount, afterCreate);
+		double itemMemorySize;
+		TestResult<> res = pvTestMap<TreeMap>(mapTitle, keyCount, afterCreate, itemMemorySize);
 
 		double norm = static_cast<double>(keyCount) * log2(static_cast<double>(keyCount)) / 1e3;
 		TestResult<double> normRes = pvMakeNormResult(res, norm);
 
-		pvOutputResult(mapTitle, keyCount, res, normRes);
+		pvOutputResult(mapTitle, keyCount, res, normRes, itemMemorySize);
 
 		return normRes;
 	}
 
 	template<typename Map, typename AfterCreate>
-	TestResult<> pvTestMap(const std::string& mapTitle, size_t keyCount, AfterCreate afterCreate)
+	TestResult<> pvTestMap(const std::string& mapTitle, size_t keyCount, AfterCreate afterCreate,
+		double& itemMemorySize)
 	{
 		mProcStream << "key count: " << keyCount << std::endl;
-		TestResult<> res = { LLONG_MAX, LLONG_MAX, LLONG_MAX, LLONG_MAX };
+		TestResult<> res = { LLONG_MAX, LLONG_MAX, LLONG_MAX, LLONG_MAX, LLONG_MAX };
 
 		for (size_t t = 1; t <= mRunCount; ++t)
 		{
 			TimePoint start;
 
+			size_t liveSize = Allocator::GetMemManager().GetLiveSize();
 			Map map;
 			afterCreate(map);
 
@@ -352,6 +431,8 @@ private:
 				map.emplace(mKeys[i], 0);
 			TickCount insertTime = pvFinish(start);
 			res.insertTime = std::minmax(res.insertTime, insertTime).first;
+			itemMemorySize = static_cast<double>(Allocator::GetMemManager().GetLiveSize() - liveSize)
+				/ static_cast<double>(keyCount);
 
 			std::shuffle(mKeys.GetBegin(), mKeys.GetBegin() + keyCount, mRandom);
 			start = pvStart(t, mapTitle + " find existing: ");
@@ -372,6 +453,15 @@ private:
 			TickCount findRandomTime = pvFinish(start);
 			res.findRandomTime = std::minmax(res.findRandomTime, findRandomTime).first;
 
+			start = pvStart(t, mapTitle + " iterate: ");
+			Value valueSum = 0;
+			for (const auto& pair : map)
+				valueSum += pair.second;
+			if (valueSum != 0)
+				mProcStream << "";
+			TickCount iterateTime = pvFinish(start);
+			res.iterateTime = std::minmax(res.iterateTime, iterateTime).first;
+
 			std::shuffle(mKeys.GetBegin(), mKeys.GetBegin() + keyCount, mRandom);
 			start = pvStart(t, mapTitle + " erase: ");
 			for (size_t i = 0; i < keyCount; ++i)
@@ -400,22 +490,27 @@ private:
 	TestResult<double> pvMakeNormResult(TestResult<> res, double norm)
 	{
 		return { res.insertTime / norm, res.findExistingTime / norm,
-			res.findRandomTime / norm, res.eraseTime / norm };
+			res.findRandomTime / norm, res.iterateTime / norm, res.eraseTime / norm };
 	}
 
 	void pvOutputResult(const std::string& mapTitle, size_t keyCount, TestResult<> testRes,
-		TestResult<double> normTestRes)
+		TestResult<double> normTestRes, double itemMemorySize)
 	{
 		mResStream << mapTitle << ";" << keyCount << ";"
 			<< normTestRes.insertTime << ";" << normTestRes.findExistingTime << ";"
-			<< normTestRes.findRandomTime << ";" << normTestRes.eraseTime << ";"
+			<< normTestRes.findRandomTime << ";" << normTestRes.iterateTime << ";"
+			<< normTestRes.eraseTime << ";"
 			<< testRes.insertTime << ";" << testRes.findExistingTime << ";"
-			<< testRes.findRandomTime << ";" << testRes.eraseTime << std::endl;
+			<< testRes.findRandomTime << ";" << testRes.iterateTime << ";"
+			<< testRes.eraseTime << ";"
+			<< itemMemorySize << std::endl;
 
 		mProcStream << "insert time: " << normTestRes.insertTime << std::endl;
 		mProcStream << "find existing time: " << normTestRes.findExistingTime << std::endl;
 		mProcStream << "find random time: " << normTestRes.findRandomTime << std::endl;
+		mProcStream << "iterate time: " << normTestRes.iterateTime << std::endl;
 		mProcStream << "erase time: " << normTestRes.eraseTime << std::endl;
+		mProcStream << "memory: " << itemMemorySize << " bytes per item" << std::endl;
 		mProcStream << std::endl;
 	}
 
@@ -0,0 +1,261 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  tests/SpeedMemManagerTester.cpp
+
+\**********************************************************/
+
+#include "pch.h"
+#include "TestSettings.h"
+
+#ifdef TEST_SPEED_MEM_MANAGER
+
+#include "../../momo/MemManagerArena.h"
+#include "../../momo/MemManagerPooled.h"
+#include "../../momo/Array.h"
+#include "../../momo/HashMap.h"
+#include "../../momo/TreeSet.h"
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <random>
+
+class SpeedMemManagerTester
+{
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	typedef momo::MemManagerArena<> MemManagerArena;
+	typedef momo::MemManagerPooled<> MemManagerPooled;
+
+	// not trivially relocatable, so arrays of it grow only in place or by relocation
+	class AppendItem
+	{
+	public:
+		explicit AppendItem(uint64_t value) noexcept
+			: mValue(value)
+		{
+		}
+
+		AppendItem(AppendItem&& item) noexcept
+			: mValue(item.mValue)
+		{
+		}
+
+		AppendItem(const AppendItem& item) noexcept
+			: mValue(item.mValue)
+		{
+		}
+
+		~AppendItem() noexcept
+		{
+		}
+
+		AppendItem& operator=(const AppendItem&) = delete;
+
+		explicit operator uint64_t() const noexcept
+		{
+			return mValue;
+		}
+
+	private:
+		uint64_t mValue;
+	};
+
+	class DefaultFactory
+	{
+	public:
+		typedef momo::MemManagerDefault MemManager;
+
+	public:
+		MemManager GetMemManager()
+		{
+			return MemManager();
+		}
+
+		void Reset()
+		{
+		}
+	};
+
+	class ArenaFactory
+	{
+	public:
+		typedef MemManagerArena::Ptr MemManager;
+
+	public:
+		MemManager GetMemManager()
+		{
+			return MemManager(mArena);
+		}
+
+		void Reset()
+		{
+			mArena.Reset();
+		}
+
+	private:
+		MemManagerArena mArena;
+	};
+
+	class PooledFactory
+	{
+	public:
+		typedef MemManagerPooled::Ptr MemManager;
+
+	public:
+		MemManager GetMemManager()
+		{
+			return MemManager(mPooled);
+		}
+
+		void Reset()
+		{
+		}
+
+	private:
+		MemManagerPooled mPooled;
+	};
+
+public:
+	explicit SpeedMemManagerTester(size_t itemCount, size_t containerCount, size_t runCount,
+		std::ostream& resStream)
+		: mItemCount(itemCount),
+		mContainerCount(containerCount),
+		mRunCount(runCount),
+		mResStream(resStream)
+	{
+	}
+
+	void TestAll()
+	{
+		mResStream << "title;build and discard (ms)" << std::endl;
+		TestBuildDiscard<DefaultFactory>("momo::MemManagerDefault");
+		TestBuildDiscard<ArenaFactory>("momo::MemManagerArena");
+		TestBuildDiscard<PooledFactory>("momo::MemManagerPooled");
+		mResStream << std::endl;
+
+		mResStream << "title;append uint64_t (ms);append AppendItem (ms)" << std::endl;
+		TestAppend<momo::MemManagerC>("momo::MemManagerC");
+#ifdef MOMO_USE_MEM_MANAGER_MMAP
+		TestAppend<momo::MemManagerMmap<>>("momo::MemManagerMmap");
+#endif
+	}
+
+	template<typename MemManager>
+	void TestAppend(const std::string& title)
+	{
+		std::cout << title << ": " << std::flush;
+		mResStream << title;
+		pvTestAppend<uint64_t, MemManager>();
+		pvTestAppend<AppendItem, MemManager>();
+		std::cout << std::endl;
+		mResStream << std::endl;
+	}
+
+	template<typename Factory>
+	void TestBuildDiscard(const std::string& title)
+	{
+		typedef typename Factory::MemManager MemManager;
+		typedef momo::Array<uint64_t, MemManager> Array;
+		typedef momo::HashMap<uint64_t, uint64_t, momo::HashTraits<uint64_t>, MemManager> HashMap;
+		typedef momo::TreeSet<uint64_t, momo::TreeTraits<uint64_t>, MemManager> TreeSet;
+
+		Factory factory;
+		std::mt19937_64 random;
+		uint64_t sum = 0;
+
+		std::cout << title << ": " << std::flush;
+		auto start = Clock::now();
+		for (size_t r = 0; r < mRunCount; ++r)
+		{
+			{
+				// a request builds many small containers and destroys all of them at the end
+				momo::Array<Array> arrays;
+				momo::Array<HashMap> hashMaps;
+				momo::Array<TreeSet> treeSets;
+				for (size_t c = 0; c < mContainerCount; ++c)
+				{
+					Array array(factory.GetMemManager());
+					HashMap hashMap(momo::HashTraits<uint64_t>(), factory.GetMemManager());
+					TreeSet treeSet(momo::TreeTraits<uint64_t>(), factory.GetMemManager());
+					for (size_t i = 0; i < mItemCount; ++i)
+					{
+						uint64_t key = random();
+						array.AddBack(key);
+						hashMap.Insert(key, i);
+						treeSet.Insert(key);
+					}
+					sum += array.GetCount() + hashMap.GetCount() + treeSet.GetCount();
+					arrays.AddBack(std::move(array));
+					hashMaps.AddBack(std::move(hashMap));
+					treeSets.AddBack(std::move(treeSet));
+				}
+			}
+			factory.Reset();
+		}
+		auto time = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+		std::cout << time.count() << " ms" << std::endl;
+		mResStream << title << ";" << time.count() << std::endl;
+		if (sum == 0)
+			std::cout << "";
+	}
+
+private:
+	template<typename Item, typename MemManager>
+	void pvTestAppend()
+	{
+		typedef momo::Array<Item, MemManager> Array;
+
+		// a few long arrays grow side by side, so realloc cannot always extend a block
+		const size_t arrayCount = 4;
+		const size_t appendCount = mItemCount * mContainerCount * 64;
+		uint64_t sum = 0;
+
+		auto start = Clock::now();
+		for (size_t r = 0; r < mRunCount / 16; ++r)
+		{
+			momo::Array<Array> arrays;
+			for (size_t a = 0; a < arrayCount; ++a)
+				arrays.AddBack(Array());
+			for (size_t i = 0; i < appendCount; ++i)
+				arrays[i % arrayCount].AddBackVar(uint64_t{i});
+			for (const Array& array : arrays)
+				sum += static_cast<uint64_t>(array[array.GetCount() - 1]);
+		}
+		auto time = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+		std::cout << time.count() << " ms " << std::flush;
+		mResStream << ";" << time.count();
+		if (sum == 0)
+			std::cout << "";
+	}
+
+private:
+	size_t mItemCount;
+	size_t mContainerCount;
+	size_t mRunCount;
+	std::ostream& mResStream;
+};
+
+void TestSpeedMemManager()
+{
+	std::cout << "TestSpeedMemManager started" << std::endl;
+
+#ifdef NDEBUG
+	const size_t runCount = 1 << 10;
+#else
+	const size_t runCount = 1 << 4;
+#endif
+
+	std::stringstream resStream;
+	SpeedMemManagerTester(64, 64, runCount, resStream).TestAll();
+	std::cout << resStream.str() << std::endl;
+}
+
+static int testSpeedMemManager = (TestSpeedMemManager(), 0);
+
+#endif // TEST_SPEED_MEM_MANAGER
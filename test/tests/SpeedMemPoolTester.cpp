@@ -0,0 +1,191 @@
+/**********************************************************\
+
+  This file is distributed under the MIT License.
+  See https://github.com/morzhovets/momo/blob/master/LICENSE
+  for details.
+
+  tests/SpeedMemPoolTester.cpp
+
+\**********************************************************/
+
+#include "pch.h"
+#include "TestSettings.h"
+
+#ifdef TEST_SPEED_MEM_POOL
+
+#include "../../momo/MemPool.h"
+#include "../../momo/ConcurrentMemPool.h"
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SpeedMemPoolTester
+{
+public:
+	static const size_t blockSize = 32;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	class MallocPool
+	{
+	public:
+		void* Allocate()
+		{
+			return malloc(blockSize);
+		}
+
+		void Deallocate(void* pblock) noexcept
+		{
+			free(pblock);
+		}
+	};
+
+	template<typename MemPoolParams>
+	class LockedMemPool
+	{
+	public:
+		LockedMemPool()
+			: mMemPool(MemPoolParams(blockSize))
+		{
+		}
+
+		void* Allocate()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mMemPool.Allocate();
+		}
+
+		void Deallocate(void* pblock) noexcept
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mMemPool.Deallocate(pblock);
+		}
+
+	private:
+		std::mutex mMutex;
+		momo::MemPool<MemPoolParams> mMemPool;
+	};
+
+	class ConcurrentMemPool : public momo::ConcurrentMemPool<>
+	{
+	public:
+		ConcurrentMemPool()
+			: momo::ConcurrentMemPool<>(momo::MemPoolParams<>(blockSize))
+		{
+		}
+	};
+
+public:
+	explicit SpeedMemPoolTester(size_t blockCount, size_t runCount, std::ostream& resStream)
+		: mBlockCount(blockCount),
+		mRunCount(runCount),
+		mResStream(resStream)
+	{
+	}
+
+	void TestAll()
+	{
+		mResStream << "title;threads;local (ms);cross-thread (ms)" << std::endl;
+		for (size_t threadCount = 1; threadCount <= 8; threadCount *= 2)
+		{
+			TestMemPool<MallocPool>("malloc", threadCount);
+			TestMemPool<LockedMemPool<momo::MemPoolParams<>>>("momo::MemPool + std::mutex",
+				threadCount);
+			TestMemPool<LockedMemPool<momo::MemPoolParams<1024>>>(
+				"momo::MemPool (large buffers) + std::mutex", threadCount);
+			TestMemPool<ConcurrentMemPool>("momo::ConcurrentMemPool", threadCount);
+		}
+	}
+
+	template<typename MemPool>
+	void TestMemPool(const std::string& poolTitle, size_t threadCount)
+	{
+		MemPool memPool;
+		std::vector<std::vector<void*>> blocks(threadCount);
+
+		// every thread allocates and releases its own blocks
+		auto localWorker = [&memPool, &blocks, this] (size_t thread)
+		{
+			std::vector<void*>& threadBlocks = blocks[thread];
+			for (size_t r = 0; r < mRunCount; ++r)
+			{
+				for (size_t i = 0; i < mBlockCount; ++i)
+					threadBlocks.push_back(memPool.Allocate());
+				for (void* pblock : threadBlocks)
+					memPool.Deallocate(pblock);
+				threadBlocks.clear();
+			}
+		};
+
+		// every thread releases the blocks allocated by another thread
+		auto allocWorker = [&memPool, &blocks, this] (size_t thread)
+		{
+			for (size_t i = 0; i < mBlockCount; ++i)
+				blocks[thread].push_back(memPool.Allocate());
+		};
+		auto freeWorker = [&memPool, &blocks, threadCount] (size_t thread)
+		{
+			std::vector<void*>& threadBlocks = blocks[(thread + 1) % threadCount];
+			for (void* pblock : threadBlocks)
+				memPool.Deallocate(pblock);
+			threadBlocks.clear();
+		};
+
+		std::cout << poolTitle << " (" << threadCount << " threads): " << std::flush;
+		auto localTime = pvRun(threadCount, localWorker);
+		auto crossTime = Clock::duration::zero();
+		for (size_t r = 0; r < mRunCount; ++r)
+		{
+			crossTime += pvRun(threadCount, allocWorker);
+			crossTime += pvRun(threadCount, freeWorker);
+		}
+		auto localMs = std::chrono::duration_cast<std::chrono::milliseconds>(localTime).count();
+		auto crossMs = std::chrono::duration_cast<std::chrono::milliseconds>(crossTime).count();
+		std::cout << localMs << " ms, " << crossMs << " ms" << std::endl;
+		mResStream << poolTitle << ";" << threadCount << ";" << localMs << ";" << crossMs << std::endl;
+	}
+
+private:
+	template<typename Worker>
+	static Clock::duration pvRun(size_t threadCount, const Worker& worker)
+	{
+		auto start = Clock::now();
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back(worker, t);
+		for (std::thread& thread : threads)
+			thread.join();
+		return Clock::now() - start;
+	}
+
+private:
+	size_t mBlockCount;
+	size_t mRunCount;
+	std::ostream& mResStream;
+};
+
+void TestSpeedMemPool()
+{
+	std::cout << "TestSpeedMemPool started" << std::endl;
+
+#ifdef NDEBUG
+	const size_t blockCount = 1 << 16;
+	const size_t runCount = 64;
+#else
+	const size_t blockCount = 1 << 12;
+	const size_t runCount = 4;
+#endif
+
+	std::stringstream resStream;
+	SpeedMemPoolTester(blockCount, runCount, resStream).TestAll();
+	std::cout << resStream.str() << std::endl;
+}
+
+static int testSpeedMemPool = (TestSpeedMemPool(), 0);
+
+#endif // TEST_SPEED_MEM_POOL
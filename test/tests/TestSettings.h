@@ -11,6 +11,9 @@
 #pragma once
 
 //#define TEST_SPEED_MAP
+//#define TEST_SPEED_CONCURRENT_TREE
+//#define TEST_SPEED_MEM_POOL
+//#define TEST_SPEED_MEM_MANAGER
 
 #ifndef TEST_SPEED_MAP
 #define TEST_SIMPLE_ARRAY
@@ -18,6 +21,9 @@
 #define TEST_SIMPLE_HASH_SORT
 #define TEST_SIMPLE_HASH
 #define TEST_SIMPLE_TREE
+#define TEST_SIMPLE_MEM_POOL
+#define TEST_SIMPLE_MEM_MANAGER
+#define TEST_SIMPLE_CACHE
 #define TEST_LIBCXX_ARRAY
 #define TEST_LIBCXX_HASH_SET
 #define TEST_LIBCXX_HASH_MAP
@@ -27,3 +33,7 @@
 #endif
 
 #define TEST_OLD_HASH_BUCKETS
+
+#ifdef __linux__
+#define MOMO_USE_MEM_MANAGER_MMAP
+#endif